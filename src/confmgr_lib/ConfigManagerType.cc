@@ -49,6 +49,26 @@
 
 #include "ConfigManagerType.h"
 
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sstream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+// The number of slots the hash table starts out with, a power of two.
+#define CONFIG_MIN_SLOTS 16
+
+// Marks a slot of the hash table which is empty.
+#define CONFIG_SLOT_EMPTY -1
+
+// Marks a slot of the hash table whose item was deleted.
+#define CONFIG_SLOT_DELETED -2
+
 /**
  * Constructs a default ConfigManagerType object.
  *
@@ -57,48 +77,30 @@
  * config starts out as an empty config file.
  */
 ConfigManagerType::ConfigManagerType(void) {
-    // Since I am implimenting this as a double linked list I need to set the
-    // list control variables to their inital values ot state that the list is
-    // empty.
-    pFirstConfigItem = NULL;
-    pLastConfigItem = NULL;
+    slots.assign(CONFIG_MIN_SLOTS, CONFIG_SLOT_EMPTY);
+    numItems = 0;
+    watchFD = -1;
+    watchWD = -1;
+    generation = 0;
 }
 
 /**
  * Destructs the ConfigManagerType object.
  *
- * Destructs the ConfigManagerType object by deallocating any dynamically
- * allocated memory.
+ * Destructs the ConfigManagerType object by closing the watch of the config
+ * file, if any.
  */
 ConfigManagerType::~ConfigManagerType(void) {
-    struct ConfigItemType *pCurConfigItem, *pTempConfigItem;
-
-    // Set the current config item pointer to the head of the list.
-    pCurConfigItem = pFirstConfigItem;
-
-    // Loop through the entire linked list deallocating all the dynamically
-    // allocated config items.
-    while (pCurConfigItem) {
-	// Set the temp config item pointer to the next item in the list.
-	pTempConfigItem = pCurConfigItem->pNextConfigItem;
-
-	D_CONFMANAGER("ConfigManagerType: Destructor():: Removing title = %s" \
-		      ", value = %s\n", pCurConfigItem->title,
-		      pCurConfigItem->value);
-
-	// Deallocated the current config item.
-	delete pCurConfigItem;
-
-	// Set the current config item pointer to the temp.
-	pCurConfigItem = pTempConfigItem;
-    }
+    if (watchFD >= 0)
+	close(watchFD);
 }
 
 /**
  * Open a config file in the appropriate format.
  *
  * Open a config file in the appropriate format, loading its contents into the
- * ConfigManagerType object.
+ * ConfigManagerType object. The path is remembered as the one Reload() and
+ * Watch() use.
  * @param pConfigPath A pointer to a character array that is the config path.
  * @return An integer representing success (zero) or failure (non-zero).
  * @retval 0 Successfully opened and loaded the config.
@@ -106,81 +108,42 @@ ConfigManagerType::~ConfigManagerType(void) {
  * @retval -2 Failed to find an equals on a non comment line, but continued
  * loading what it could.
  */
-int ConfigManagerType::Open(char *pConfigPath) {
-    std::fstream inFile;
-    char tmpFilePath[PATH_MAX];
-    char value[256];
-    char *pEquals;
-    int retval;
-
-    retval = 0;
+int ConfigManagerType::Open(const char *pConfigPath) {
+    std::ifstream inFile;
+    std::ostringstream contents;
+    std::string data;
 
     // Attempt to open the file at path pConfigPath for reading so I can
     // load the config data into the object.
-    inFile.open(pConfigPath, std::ios::in);
+    inFile.open(pConfigPath, std::ios::in | std::ios::binary);
     if (!inFile.is_open()) {
-	    D_CONFMANAGER("ConfigManager: Open():: Failed to open config(%s)" \
+	D_CONFMANAGER("ConfigManager: Open():: Failed to open config(%s)" \
 		      " for reading.\n", pConfigPath);
-	    return -1;
-    }
-
-    while (!inFile.eof()) {
-	// Here I read the first line of the config filein.
-	inFile.getline(tmpFilePath, PATH_MAX, '\n');
-
-	if (tmpFilePath[0] != '#') {
-	    // Well, if I am here I know that the line is not a comment so I
-	    // want to find the fist equals sign because I know that any valid
-	    // line in the config has to have a equals sign.
-	    pEquals = index(tmpFilePath, (int)'=');
-
-	    if (pEquals) {
-		// Here I copy the value associated with the line into its own
-		// character array so I can null terminate at pEquals and make
-		// the name a string of its own.
-		strcpy(value, pEquals+1);
-
-		// Here, I null terminate at pEquals making it a c-string of
-		// the name of the config option.
-		*pEquals = '\0';
-
-		D_CONFMANAGER("ConfigManagerType: Open():: Name = %s, " \
-			      "Value = %s.\n", tmpFilePath, (pEquals + 1));
-
-		AddItem(tmpFilePath, (pEquals + 1));
-	    } else {
-		if (strcmp(tmpFilePath, "") != 0) {
-		    D_CONFMANAGER("ConfigManagerType: Open():: Failed to" \
-				  " find the equals sign in the line read in" \
-				  " entry.\n");
-
-		    retval = -2;
-		}
-	    }
-	}
+	return -1;
     }
 
-    // Here I close the opened playlist file.
+    contents << inFile.rdbuf();
     inFile.close();
 
-    // Return in success.
-    return retval;
+    configPath.assign(pConfigPath);
+
+    data = contents.str();
+    return Parse(data.data(), data.size());
 }
 
 /**
  * Save the object to a config file.
  *
  * Save the config items of the object to a simple formatted (easy to edit)
- * file for later loading.
+ * file for later loading, in the order they were read or added. The items
+ * belonging to no section are written first, followed by those of the
+ * sections, each run of items of a section below a line naming it.
  * @return An integer representing success (zero), failure (non-zero).
  * @retval 0 Successfully wrote the config file.
  * @retval -1 Failed to open pSavePath for writing.
  */
-int ConfigManagerType::Save(char *pSavePath) {
+int ConfigManagerType::Save(const char *pSavePath) {
     std::fstream outFile;
-    struct ConfigItemType *pCurConfigItem;
-
-    char buff[513];
 
     // Attempt to open the file at path pSavePath for writing so I can
     // save the data from the object into a config file.
@@ -191,17 +154,8 @@ int ConfigManagerType::Save(char *pSavePath) {
 	return -1;
     }
 
-    pCurConfigItem = GetFirstItem();
-
-    // Loop through writing each items data to the file.
-    while (pCurConfigItem) {
-	snprintf(buff, 512, "%s=%s\n", pCurConfigItem->title,
-		 pCurConfigItem->value);
-
-	outFile.write(buff, strlen(buff));
-
-	pCurConfigItem = pCurConfigItem->pNextConfigItem;
-    }
+    SaveItems(outFile, false);
+    SaveItems(outFile, true);
 
     outFile.close();
 
@@ -218,37 +172,37 @@ int ConfigManagerType::Save(char *pSavePath) {
  * @param pValue A pointer to a character array containing the item value.
  * @return An integer representing success (zero) or failure (non-zero).
  * @retval 0 Success.
- * @retval X Any return value other than 0 consult AddItem() docs.
  */
-int ConfigManagerType::SetValue(char *pTitle, char *pValue) {
-    struct ConfigItemType *pCurConfigItem;
+int ConfigManagerType::SetValue(const char *pTitle, const char *pValue) {
+    long int slot;
+    size_t len;
+    uint32_t hash;
 
-    pCurConfigItem = GetFirstItem();
+    len = strlen(pTitle);
+    hash = Hash(pTitle, len);
 
-    while (pCurConfigItem) {
-	if (strcmp(pTitle, pCurConfigItem->title) == 0) {
-	    D_CONFMANAGER("ConfigManagerType: SetValue():: Found a matching" \
-			  " item.\n");
+    slot = FindSlot(pTitle, len, hash);
+    if (slot >= 0) {
+	D_CONFMANAGER("ConfigManagerType: SetValue():: Found a matching" \
+		      " item.\n");
 
-	    strncpy(pCurConfigItem->value, pValue, 256);
+	items[slots[slot]].value.assign(pValue);
 
-	    // Return in success.
-	    return 0;
-	}
-
-	pCurConfigItem = pCurConfigItem->pNextConfigItem;
+	// Return in success.
+	return 0;
     }
 
     // If I hit this point I know that it failed to find a matching titled
     // item so I want to add one and return the return value of it.
-    return AddItem(pTitle, pValue);
+    return AddItem(pTitle, len, pValue, strlen(pValue));
 }
 
 /**
  * Get the value of a config item.
  *
  * Obtain the value of a config item given the title of the item and a
- * character array to store the result in.
+ * character array to store the result in. A value longer than the array is
+ * cut short.
  * @param pTitle A pointer to a character array containing the item title.
  * @param pValue A pointer to a charactor array to store the value in.
  * @param maxlen The maximum len of characters to write to pValue.
@@ -256,28 +210,48 @@ int ConfigManagerType::SetValue(char *pTitle, char *pValue) {
  * @retval 0 Success.
  * @retval -1 Failed to find matching titled item.
  */
-int ConfigManagerType::GetValue(char *pTitle, char *pValue, int maxlen) {
-    struct ConfigItemType *pCurConfigItem;
+int ConfigManagerType::GetValue(const char *pTitle, char *pValue,
+				int maxlen) const {
+    const std::string *pFound;
+    size_t len;
 
-    pCurConfigItem = GetFirstItem();
+    pFound = FindValue(pTitle);
+    if (pFound == NULL)
+	return -1;
 
-    while (pCurConfigItem) {
-	if (strcmp(pTitle, pCurConfigItem->title) == 0) {
-	    D_CONFMANAGER("ConfigManagerType: GetValue():: Found a matching" \
-			  " item.\n");
+    if (maxlen <= 0)
+	return 0;
 
-	    strncpy(pValue, pCurConfigItem->value, maxlen);
+    len = pFound->copy(pValue, maxlen - 1);
+    pValue[len] = '\0';
 
-	    // Return in success.
-	    return 0;
-	}
+    // Return in success.
+    return 0;
+}
 
-	// Go on to the next config item.
-	pCurConfigItem = pCurConfigItem->pNextConfigItem;
-    }
+/**
+ * Get the value of a config item.
+ *
+ * Obtain the value of a config item given the title of the item, whatever
+ * its length.
+ * @param pTitle A pointer to a character array containing the item title.
+ * @param value Reference to store the value in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Success.
+ * @retval -1 Failed to find matching titled item.
+ */
+int ConfigManagerType::GetValue(const char *pTitle,
+				std::string &value) const {
+    const std::string *pFound;
 
-    // Return -1 to signify that no matching item was found.
-    return -1;
+    pFound = FindValue(pTitle);
+    if (pFound == NULL)
+	return -1;
+
+    value = *pFound;
+
+    // Return in success.
+    return 0;
 }
 
 /**
@@ -289,140 +263,604 @@ int ConfigManagerType::GetValue(char *pTitle, char *pValue, int maxlen) {
  * @retval 0 Success.
  * @retval -1 Failed to find matching titled item.
  */
-int ConfigManagerType::DeleteItem(char *pTitle) {
-    struct ConfigItemType *pCurConfigItem;
-
-    pCurConfigItem = GetFirstItem();
-
-    while (pCurConfigItem) {
-	if (strcmp(pTitle, pCurConfigItem->title) == 0) {
-	    D_CONFMANAGER("ConfigManagerType: GetValue():: Found a matching" \
-			  " item.\n");
-
-	    if ((pCurConfigItem->pNextConfigItem == NULL) &&
-		(pCurConfigItem->pPrevConfigItem == NULL)) {
-		pFirstConfigItem = NULL;
-		pLastConfigItem = NULL;
-	    } else if (pCurConfigItem->pNextConfigItem == NULL) {
-		pCurConfigItem->pPrevConfigItem->pNextConfigItem = NULL;
-		pLastConfigItem = pCurConfigItem->pPrevConfigItem;
-	    } else if (pCurConfigItem->pPrevConfigItem == NULL) {
-		pCurConfigItem->pNextConfigItem->pPrevConfigItem = NULL;
-		pFirstConfigItem = pCurConfigItem->pNextConfigItem;
-	    } else {
-		pCurConfigItem->pPrevConfigItem->pNextConfigItem = pCurConfigItem->pNextConfigItem;
-		pCurConfigItem->pNextConfigItem->pPrevConfigItem = pCurConfigItem->pPrevConfigItem;
-	    }
+int ConfigManagerType::DeleteItem(const char *pTitle) {
+    long int slot;
+    size_t len;
+
+    len = strlen(pTitle);
+    slot = FindSlot(pTitle, len, Hash(pTitle, len));
+    if (slot < 0)
+	return -1;
+
+    D_CONFMANAGER("ConfigManagerType: DeleteItem():: Found a matching" \
+		  " item.\n");
+
+    // The item stays in the list, so that the indexes of the items after
+    // it do not change, and its slot is marked so that the items placed
+    // after it are still found.
+    items[slots[slot]].isDeleted = true;
+    items[slots[slot]].title.clear();
+    items[slots[slot]].value.clear();
+    slots[slot] = CONFIG_SLOT_DELETED;
+    numItems--;
+
+    // Return in success.
+    return 0;
+}
+
+/**
+ * Get an integer config item.
+ *
+ * Obtain the value of a config item parsed as a decimal integer, which may
+ * be surrounded by white space.
+ * @param pTitle A pointer to a character array containing the item title.
+ * @param value Reference to store the integer in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Success.
+ * @retval -1 Failed to find matching titled item.
+ * @retval -2 The value of the item is not an integer.
+ */
+int ConfigManagerType::GetInt(const char *pTitle, long int &value) const {
+    const std::string *pFound;
+    const char *pStart;
+    char *pEnd;
+    long int number;
+
+    pFound = FindValue(pTitle);
+    if (pFound == NULL)
+	return -1;
+
+    pStart = pFound->c_str();
+    errno = 0;
+    number = strtol(pStart, &pEnd, 10);
+    if ((pEnd == pStart) || (errno != 0))
+	return -2;
+
+    while (isspace((unsigned char)*pEnd))
+	pEnd++;
+    if (*pEnd != '\0')
+	return -2;
+
+    value = number;
+    return 0;
+}
+
+/**
+ * Get a boolean config item.
+ *
+ * Obtain the value of a config item parsed as a boolean, one of yes, true,
+ * on and 1 or no, false, off and 0, in any case and which may be surrounded
+ * by white space.
+ * @param pTitle A pointer to a character array containing the item title.
+ * @param value Reference to store the boolean in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Success.
+ * @retval -1 Failed to find matching titled item.
+ * @retval -2 The value of the item is not a boolean.
+ */
+int ConfigManagerType::GetBool(const char *pTitle, bool &value) const {
+    static const char *trueNames[] = { "yes", "true", "on", "1" };
+    static const char *falseNames[] = { "no", "false", "off", "0" };
+    const std::string *pFound;
+    std::string::size_type start, stop;
+    std::string word;
+    unsigned int i;
+
+    pFound = FindValue(pTitle);
+    if (pFound == NULL)
+	return -1;
 
-	    delete pCurConfigItem;
+    start = pFound->find_first_not_of(" \t");
+    stop = pFound->find_last_not_of(" \t");
+    if (start != std::string::npos)
+	word = pFound->substr(start, stop - start + 1);
 
-	    // Return in success.
+    for (i = 0; i < 4; i++) {
+	if (strcasecmp(word.c_str(), trueNames[i]) == 0) {
+	    value = true;
+	    return 0;
+	}
+	if (strcasecmp(word.c_str(), falseNames[i]) == 0) {
+	    value = false;
 	    return 0;
 	}
+    }
 
-	// Go on to the next config item.
-	pCurConfigItem = pCurConfigItem->pNextConfigItem;
+    return -2;
+}
+
+/**
+ * Get a path config item.
+ *
+ * Obtain the value of a config item as a path, with a leading ~ replaced by
+ * the home directory of the user.
+ * @param pTitle A pointer to a character array containing the item title.
+ * @param path Reference to store the path in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Success.
+ * @retval -1 Failed to find matching titled item.
+ * @retval -2 The path starts with ~ but the HOME environment variable is
+ * not set.
+ */
+int ConfigManagerType::GetPath(const char *pTitle, std::string &path) const {
+    const std::string *pFound;
+    const char *pHome;
+
+    pFound = FindValue(pTitle);
+    if (pFound == NULL)
+	return -1;
+
+    if (pFound->empty() || ((*pFound)[0] != '~') ||
+	((pFound->size() > 1) && ((*pFound)[1] != '/'))) {
+	path = *pFound;
+	return 0;
     }
 
-    // Return -1 to signify that no matching item was found.
-    return -1;
+    pHome = getenv("HOME");
+    if (pHome == NULL)
+	return -2;
+
+    path.assign(pHome);
+    path.append(*pFound, 1, std::string::npos);
+    return 0;
 }
 
 /**
- * Add an item to the config manager.
+ * Get a list config item.
  *
- * Add a new item to the config manager given the title of the item and the
- * value to be associated with the item. Note: There is no protection from
- * creating multiple items with the same title. The results of such an action
- * are undefined.
- * @param pTitle Pointer to character array containing the title of the item.
- * @param pValue Pointer to character array containing the value of the item.
+ * Obtain the value of a config item as a comma separated list, with the
+ * white space around each entry removed and empty entries left out.
+ * @param pTitle A pointer to a character array containing the item title.
+ * @param list Reference to the vector to store the entries in.
  * @return An integer representing success (zero) or failure (non-zero).
  * @retval 0 Success.
- * @retval -1 Failed to allocate memory for the new config item.
+ * @retval -1 Failed to find matching titled item.
  */
-int ConfigManagerType::AddItem(char *pTitle, char *pValue) {
-    struct ConfigItemType *pNewConfigItem;
-
-    // Allocate momory for the new config item.
-    pNewConfigItem = new struct ConfigItemType;
-    if (pNewConfigItem == NULL) {
-	D_CONFMANAGER("ConifgManagerType: AddItem():: Failed to allocate" \
-		      " memory for the now config item.\n");
+int ConfigManagerType::GetList(const char *pTitle,
+			       std::vector<std::string> &list) const {
+    const std::string *pFound;
+    std::string::size_type start, stop, end;
+
+    pFound = FindValue(pTitle);
+    if (pFound == NULL)
 	return -1;
+
+    list.clear();
+    start = 0;
+    while (start <= pFound->size()) {
+	end = pFound->find(',', start);
+	if (end == std::string::npos)
+	    end = pFound->size();
+
+	stop = end;
+	while ((start < stop) && isspace((unsigned char)(*pFound)[start]))
+	    start++;
+	while ((stop > start) && isspace((unsigned char)(*pFound)[stop - 1]))
+	    stop--;
+	if (stop > start)
+	    list.push_back(pFound->substr(start, stop - start));
+
+	start = end + 1;
     }
 
-    // Copy the title and value into the new config item.
-    strncpy(pNewConfigItem->title, pTitle, 256);
-    strncpy(pNewConfigItem->value, pValue, 256);
-
-    // Check if this is the first item in the linked list.
-    if (pFirstConfigItem == NULL) {
-	// If it is the first node in the doubly linked list then I know that
-	// its previous pointer MUST BE NULL and its next MUST BE NULL.
-	pNewConfigItem->pPrevConfigItem = NULL;
-	pNewConfigItem->pNextConfigItem = NULL;
-
-	// So now that I have the enxt and previous pointers of the new node
-	// handled I need to have the root or start of the list point to this
-	// node since it is the first item in the list. Also since its the
-	// only node in the list lets set it to be the last node as well.
-	pFirstConfigItem = pNewConfigItem;
-	pLastConfigItem = pNewConfigItem;
-    } else {
-	// If it is NOT the first node in the doubly linked list then it is
-	// going to be the last because this function appends a new node to
-	// the doubly linked list. The last node in a doubly linked list has
-	// its previous pointer point to the old last node and its next
-	// pointer pointing to NULL.
-	pNewConfigItem->pPrevConfigItem = pLastConfigItem;
-	pNewConfigItem->pNextConfigItem = NULL;
-
-	pNewConfigItem->pPrevConfigItem->pNextConfigItem = pNewConfigItem;
-
-	// Now since I have appended a node to the list I want to set the old
-	// tail pointer to point to the new node.
-	pLastConfigItem = pNewConfigItem;
+    return 0;
+}
+
+/**
+ * Watch the config file.
+ *
+ * Start watching the config file last opened for changes with inotify. The
+ * directory holding it is watched, so that a file replaced by renaming a
+ * new one over it, as many editors do, is noticed as well. See
+ * CheckReload() for picking up the changes.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully started watching the config file.
+ * @retval -1 Failed, no config file was opened or inotify is unavailable.
+ * @retval -2 Failed to watch the directory of the config file.
+ */
+int ConfigManagerType::Watch(void) {
+#ifdef __linux__
+    std::string dirPath;
+    std::string::size_type slash;
+
+    if (configPath.empty())
+	return -1;
+    if (watchFD >= 0)
+	return 0;
+
+    watchFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watchFD < 0)
+	return -1;
+
+    slash = configPath.rfind('/');
+    if (slash == std::string::npos)
+	dirPath = ".";
+    else if (slash == 0)
+	dirPath = "/";
+    else
+	dirPath = configPath.substr(0, slash);
+
+    watchWD = inotify_add_watch(watchFD, dirPath.c_str(),
+				IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (watchWD < 0) {
+	close(watchFD);
+	watchFD = -1;
+	return -2;
     }
 
-    // Return in success.
     return 0;
+#else
+    return -1;
+#endif
 }
 
 /**
- * Get the first config item.
+ * Get the watch descriptor.
  *
- * Obtain the first config item from the list.
- * @return A pointer to the playlist item at head. If fails then NULL.
- * @retval NULL Failed to retrieve the item.
+ * Get the descriptor which becomes readable when the watched directory of
+ * the config file changes, so that a daemon may wait on it with select() or
+ * poll() along with its other descriptors.
+ * @return The watch descriptor, or -1 if the config file is not watched.
  */
-struct ConfigItemType *ConfigManagerType::GetFirstItem(void) {
-    if (pFirstConfigItem == NULL) {
-	D_CONFMANAGER("ConfigManagerType: GetFirstItem():: Failed to" \
-		      " retrieve config item -- pFirstConfigItem is equal" \
-		      " to NULL. Hence, there are no items in the config" \
-		      " object at this point.\n");
-	return NULL;
-    } else {
-	return pFirstConfigItem;
+int ConfigManagerType::GetWatchFD(void) const {
+    return watchFD;
+}
+
+/**
+ * Check for a reload.
+ *
+ * Read the pending changes of the watched directory without blocking and,
+ * if the config file is among them, reload it.
+ * @return An integer representing if the config was reloaded.
+ * @retval 1 The config file changed and was reloaded.
+ * @retval 0 The config file did not change.
+ * @retval -1 The config file changed but failed to reload, the items are
+ * left as they were.
+ * @retval -2 The config file is not watched.
+ */
+int ConfigManagerType::CheckReload(void) {
+#ifdef __linux__
+    char buff[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    const struct inotify_event *pEvent;
+    std::string::size_type slash;
+    const char *pBaseName;
+    bool isChanged = false;
+    ssize_t len, pos;
+
+    if (watchFD < 0)
+	return -2;
+
+    slash = configPath.rfind('/');
+    pBaseName = configPath.c_str() +
+	((slash == std::string::npos) ? 0 : slash + 1);
+
+    while ((len = read(watchFD, buff, sizeof(buff))) > 0) {
+	for (pos = 0; pos < len;
+	     pos += sizeof(struct inotify_event) + pEvent->len) {
+	    pEvent = (const struct inotify_event *)(buff + pos);
+	    if ((pEvent->len > 0) && (strcmp(pEvent->name, pBaseName) == 0))
+		isChanged = true;
+	}
+    }
+
+    if (!isChanged)
+	return 0;
+
+    D_CONFMANAGER("ConfigManagerType: CheckReload():: Config(%s)" \
+		  " changed.\n", configPath.c_str());
+
+    return (Reload() == -1) ? -1 : 1;
+#else
+    return -2;
+#endif
+}
+
+/**
+ * Reload the config file.
+ *
+ * Replace the items with those of the config file last opened, read again.
+ * Items set but not saved are lost. If the file fails to open the items are
+ * left as they were.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully reloaded the config.
+ * @retval -1 Failed to open the config file.
+ * @retval -2 Failed to find an equals on a non comment line, but reloaded
+ * what it could.
+ */
+int ConfigManagerType::Reload(void) {
+    ConfigManagerType fresh;
+    int retval;
+
+    if (configPath.empty())
+	return -1;
+
+    retval = fresh.Open(configPath.c_str());
+    if (retval == -1)
+	return -1;
+
+    Swap(fresh);
+    generation++;
+
+    return retval;
+}
+
+/**
+ * Get the generation.
+ *
+ * Get the number of times the config was reloaded, so that settings worked
+ * out from it may be worked out again when it changes.
+ * @return The generation of the config.
+ */
+unsigned long int ConfigManagerType::GetGeneration(void) const {
+    return generation;
+}
+
+/**
+ * Hash a title.
+ *
+ * Obtain the 32 bit FNV-1a hash of the given title.
+ * @param pTitle Pointer to the characters of the title.
+ * @param len The number of characters in the title.
+ * @return The hash of the title.
+ */
+uint32_t ConfigManagerType::Hash(const char *pTitle, size_t len) {
+    uint32_t hash = 2166136261U;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+	hash ^= (unsigned char)pTitle[i];
+	hash *= 16777619U;
     }
+
+    return hash;
 }
 
 /**
- * Get the last config item.
+ * Find the value of an item.
  *
- * Obtain the last config item from the list.
- * @return A pointer to the config item at tail. If fails then NULL.
- * @retval NULL Failed to retrieve the item.
+ * Find the value of the item with the given title.
+ * @param pTitle A pointer to a character array containing the item title.
+ * @return Pointer to the value of the item, or NULL if there is none.
  */
-struct ConfigItemType *ConfigManagerType::GetLastItem(void) {
-    if (pLastConfigItem == NULL) {
-	D_CONFMANAGER("ConfigManagerType: GetLastItem():: Failed to retrieve" \
-		      " config item -- pLastConfigItem is equal to NULL." \
-		      " Hence, there are no items in the config object at" \
-		      " this point.\n");
+const std::string *ConfigManagerType::FindValue(const char *pTitle) const {
+    long int slot;
+    size_t len;
+
+    len = strlen(pTitle);
+    slot = FindSlot(pTitle, len, Hash(pTitle, len));
+    if (slot < 0)
 	return NULL;
-    } else {
-	return pLastConfigItem;
+
+    return &items[slots[slot]].value;
+}
+
+/**
+ * Find the slot of an item.
+ *
+ * Find the slot of the hash table holding the item with the given title,
+ * probing the slots after the one the hash of the title picks until an
+ * empty one is reached.
+ * @param pTitle Pointer to the characters of the title.
+ * @param len The number of characters in the title.
+ * @param hash The hash of the title.
+ * @return The slot of the item, or -1 if there is no such item.
+ */
+long int ConfigManagerType::FindSlot(const char *pTitle, size_t len,
+				     uint32_t hash) const {
+    unsigned long int mask, slot;
+    long int index;
+
+    mask = slots.size() - 1;
+    slot = hash & mask;
+    while ((index = slots[slot]) != CONFIG_SLOT_EMPTY) {
+	if ((index >= 0) && (items[index].hash == hash) &&
+	    (items[index].title.size() == len) &&
+	    (items[index].title.compare(0, len, pTitle, len) == 0))
+	    return (long int)slot;
+	slot = (slot + 1) & mask;
     }
+
+    return -1;
+}
+
+/**
+ * Add an item to the config manager.
+ *
+ * Add a new item to the config manager given the title of the item and the
+ * value to be associated with the item. The caller makes sure there is no
+ * item with the same title yet.
+ * @param pTitle Pointer to the characters of the title of the item.
+ * @param titleLen The number of characters in the title.
+ * @param pValue Pointer to the characters of the value of the item.
+ * @param valueLen The number of characters in the value.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Success.
+ */
+int ConfigManagerType::AddItem(const char *pTitle, size_t titleLen,
+			       const char *pValue, size_t valueLen) {
+    unsigned long int mask, slot;
+
+    // I keep at least a quarter of the slots empty, counting the deleted
+    // ones as used, so that probing stays short and always ends.
+    if ((items.size() + 1) * 4 > slots.size() * 3)
+	Rehash();
+
+    items.push_back(ConfigItemType());
+    items.back().title.assign(pTitle, titleLen);
+    items.back().value.assign(pValue, valueLen);
+    items.back().hash = Hash(pTitle, titleLen);
+    items.back().isDeleted = false;
+
+    mask = slots.size() - 1;
+    slot = items.back().hash & mask;
+    while (slots[slot] >= 0)
+	slot = (slot + 1) & mask;
+    slots[slot] = (long int)(items.size() - 1);
+    numItems++;
+
+    // Return in success.
+    return 0;
+}
+
+/**
+ * Rebuild the hash table.
+ *
+ * Drop the deleted items and rebuild the hash table with room for twice as
+ * many items as are left.
+ */
+void ConfigManagerType::Rehash(void) {
+    std::vector<struct ConfigItemType> liveItems;
+    std::vector<struct ConfigItemType>::iterator iter;
+    unsigned long int numSlots, mask, slot, i;
+
+    liveItems.reserve(numItems + 1);
+    for (iter = items.begin(); iter != items.end(); ++iter) {
+	if (!(*iter).isDeleted) {
+	    liveItems.push_back(ConfigItemType());
+	    liveItems.back().title.swap((*iter).title);
+	    liveItems.back().value.swap((*iter).value);
+	    liveItems.back().hash = (*iter).hash;
+	    liveItems.back().isDeleted = false;
+	}
+    }
+    items.swap(liveItems);
+
+    numSlots = CONFIG_MIN_SLOTS;
+    while (numSlots < (items.size() + 1) * 4)
+	numSlots *= 2;
+
+    slots.assign(numSlots, CONFIG_SLOT_EMPTY);
+    mask = numSlots - 1;
+    for (i = 0; i < items.size(); i++) {
+	slot = items[i].hash & mask;
+	while (slots[slot] >= 0)
+	    slot = (slot + 1) & mask;
+	slots[slot] = (long int)i;
+    }
+}
+
+/**
+ * Parse config data.
+ *
+ * Add the items of the given config data, one title=value line each, in a
+ * single pass over it. Lines starting with # are comments and a [name] line
+ * starts the section of that name. A title given more than once keeps its
+ * first value.
+ * @param pData Pointer to the characters of the config data.
+ * @param size The number of characters.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully loaded the config.
+ * @retval -2 Failed to find an equals on a non comment line, but continued
+ * loading what it could.
+ */
+int ConfigManagerType::Parse(const char *pData, size_t size) {
+    const char *pLine, *pEnd, *pStop, *pEquals;
+    std::string title;
+    size_t sectionLen = 0;
+    int retval = 0;
+
+    pLine = pData;
+    pEnd = pData + size;
+    while (pLine < pEnd) {
+	pStop = (const char *)memchr(pLine, '\n', pEnd - pLine);
+	if (pStop == NULL)
+	    pStop = pEnd;
+
+	// The line continues after this one, so I move on before trimming
+	// the carriage return of a line ended by CR LF.
+	pData = pStop + 1;
+	if ((pStop > pLine) && (pStop[-1] == '\r'))
+	    pStop--;
+
+	if ((pStop > pLine) && (*pLine == '[') && (pStop[-1] == ']')) {
+	    // The titles of the items of a section carry the name of the
+	    // section, so I keep it at the start of the title buffer.
+	    title.assign(pLine + 1, pStop - pLine - 2);
+	    if (!title.empty())
+		title += ':';
+	    sectionLen = title.size();
+	} else if ((pStop > pLine) && (*pLine != '#')) {
+	    // Any valid line in the config has to have an equals sign, the
+	    // title being before it and the value after it.
+	    pEquals = (const char *)memchr(pLine, '=', pStop - pLine);
+	    if (pEquals) {
+		title.resize(sectionLen);
+		title.append(pLine, pEquals - pLine);
+		if (FindSlot(title.data(), title.size(),
+			     Hash(title.data(), title.size())) < 0)
+		    AddItem(title.data(), title.size(), pEquals + 1,
+			    pStop - pEquals - 1);
+	    } else {
+		D_CONFMANAGER("ConfigManagerType: Parse():: Failed to" \
+			      " find the equals sign in the line read in" \
+			      " entry.\n");
+		retval = -2;
+	    }
+	}
+
+	pLine = pData;
+    }
+
+    return retval;
+}
+
+/**
+ * Save items to a config file.
+ *
+ * Write either the items belonging to no section or those belonging to a
+ * section to the given file, one title=value line each, skipping deleted
+ * items. A line naming the section is written ahead of each run of items
+ * of the same section.
+ * @param outFile Reference to the file to write the items to.
+ * @param inSection True to write the items of sections, false to write the
+ * items belonging to no section.
+ * @return The number of items written.
+ */
+int ConfigManagerType::SaveItems(std::fstream &outFile, bool inSection) {
+    std::vector<struct ConfigItemType>::const_iterator iter;
+    std::string::size_type colon;
+    std::string section;
+    int count = 0;
+
+    // Loop through writing each items data to the file.
+    for (iter = items.begin(); iter != items.end(); ++iter) {
+	if ((*iter).isDeleted)
+	    continue;
+
+	colon = (*iter).title.find(':');
+	if ((colon != std::string::npos) != inSection)
+	    continue;
+
+	if (inSection) {
+	    if ((*iter).title.compare(0, colon, section) != 0) {
+		section.assign((*iter).title, 0, colon);
+		outFile << '[' << section << "]\n";
+	    }
+	    outFile << ((*iter).title.c_str() + colon + 1);
+	} else {
+	    outFile << (*iter).title;
+	}
+	outFile << '=' << (*iter).value << '\n';
+	count++;
+    }
+
+    return count;
+}
+
+/**
+ * Swap the items.
+ *
+ * Swap the items of this config manager with those of the given one. The
+ * path and watch of the config file are kept.
+ * @param other Reference to the config manager to swap items with.
+ */
+void ConfigManagerType::Swap(ConfigManagerType &other) {
+    unsigned long int tmpNumItems;
+
+    items.swap(other.items);
+    slots.swap(other.slots);
+
+    tmpNumItems = numItems;
+    numItems = other.numItems;
+    other.numItems = tmpNumItems;
 }
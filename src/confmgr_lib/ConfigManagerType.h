@@ -54,22 +54,15 @@
 #define CONFIGMANAGERTYPE_H
 
 #include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <fstream>
+#include <string>
+#include <vector>
 
 #include "DebugControl.h"
 
-// Here I define a type for the Items which are found in such configs. This
-// is specifically the type that allows for the construction of a double
-// linked list.
-struct ConfigItemType {
-    char value[256];
-    char title[256];
-    struct ConfigItemType *pNextConfigItem;
-    struct ConfigItemType *pPrevConfigItem;
-};
-
 /**
  * \class ConfigManagerType
  * \brief A type representing an generic configuration file.
@@ -78,28 +71,86 @@ struct ConfigItemType {
  * file. It provides all the common actions that would be able to be taken on
  * a configuration file. Such actions include reading, writing, and
  * editing. It supports accessing and setting existing or non existing data.
+ *
+ * The items are kept in the order they were read or added, and found by
+ * title through an open addressing hash table, so a lookup does not depend
+ * on the number of items. Titles and values may be of any length. Values
+ * may be obtained as they are or parsed as integers, booleans, paths or
+ * lists. A daemon may watch the config file with Watch() and call
+ * CheckReload() when the watch descriptor is readable, or every so often,
+ * to pick up changes to the file without restarting.
+ *
+ * Items following a [name] line belong to the section of that name, and are
+ * titled with the name of the section and a colon ahead of their own title,
+ * for instance "model SL-5500:passcode". The items before the first section
+ * line, or after an empty [] line, belong to no section.
  */
 class ConfigManagerType {
  public:
     ConfigManagerType(void);
     ~ConfigManagerType(void);
 
-    int Open(char *pConfigPath);
-    int Save(char *pSavePath);
-    int SetValue(char *pTitle, char *pValue);
-    int GetValue(char *pTitle, char *pValue, int maxlen);
-    int DeleteItem(char *pTitle);
+    int Open(const char *pConfigPath);
+    int Save(const char *pSavePath);
+    int SetValue(const char *pTitle, const char *pValue);
+    int GetValue(const char *pTitle, char *pValue, int maxlen) const;
+    int GetValue(const char *pTitle, std::string &value) const;
+    int DeleteItem(const char *pTitle);
+
+    int GetInt(const char *pTitle, long int &value) const;
+    int GetBool(const char *pTitle, bool &value) const;
+    int GetPath(const char *pTitle, std::string &path) const;
+    int GetList(const char *pTitle, std::vector<std::string> &list) const;
+
+    int Watch(void);
+    int GetWatchFD(void) const;
+    int CheckReload(void);
+    int Reload(void);
+    unsigned long int GetGeneration(void) const;
 
  private:
-    int AddItem(char *pTitle, char *pValue);
-    struct ConfigItemType *GetFirstItem(void);
-    struct ConfigItemType *GetLastItem(void);
+    // The manager may own a watch descriptor, so it may not be copied.
+    ConfigManagerType(const ConfigManagerType &);
+    ConfigManagerType &operator=(const ConfigManagerType &);
+
+    // Here I define a type for the Items which are found in such configs.
+    // A deleted item stays in place until the table is next rebuilt.
+    struct ConfigItemType {
+        std::string title;
+        std::string value;
+        uint32_t hash;
+        bool isDeleted;
+    };
+
+    static uint32_t Hash(const char *pTitle, size_t len);
+
+    const std::string *FindValue(const char *pTitle) const;
+    long int FindSlot(const char *pTitle, size_t len, uint32_t hash) const;
+    int AddItem(const char *pTitle, size_t titleLen, const char *pValue,
+                size_t valueLen);
+    void Rehash(void);
+    int Parse(const char *pData, size_t size);
+    int SaveItems(std::fstream &outFile, bool inSection);
+    void Swap(ConfigManagerType &other);
+
+    // The items in the order they were read or added.
+    std::vector<struct ConfigItemType> items;
+
+    // The hash table of indexes into the items, a power of two in size.
+    std::vector<long int> slots;
+
+    // The number of items which are not deleted.
+    unsigned long int numItems;
+
+    // The path of the config last opened, which is the one reloaded.
+    std::string configPath;
 
-    // Points to the first PlaylistItem of the playlist.
-    struct ConfigItemType *pFirstConfigItem;
+    // The inotify descriptor and watch of the directory of the config.
+    int watchFD;
+    int watchWD;
 
-    // Points to the last PlaylistItem of the playlist.
-    struct ConfigItemType *pLastConfigItem;
+    // Counts the times the config was reloaded.
+    unsigned long int generation;
 };
 
 #endif
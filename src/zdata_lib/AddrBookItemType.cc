@@ -29,6 +29,115 @@
 
 #include "AddrBookItemType.hh"
 
+#include <algorithm>
+
+// The descriptors of the fields of an Address Book item. This is the one
+// place the fields of an Address Book item are mapped to the parameters of
+// the Zaurus. Nearly all of them are text.
+const FieldDescType<AddrBookItemType> AddrBookItemType::fieldDescs[] = {
+    BASE_FIELD_DESCS(AddrBookItemType),
+    { "CTGR", DATA_ID_BARRAY, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_POOLED_ACCESS(AddrBookItemType, Category) },
+    { "NAME", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, FullName) },
+    { "KANA", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, FullNamePronun) },
+    { "HONR", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, TermOfRespect) },
+    { "LNME", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED | FIELD_MATCH,
+      FIELD_STRING_ACCESS(AddrBookItemType, LastName) },
+    { "FNME", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED | FIELD_MATCH,
+      FIELD_STRING_ACCESS(AddrBookItemType, FirstName) },
+    { "MNME", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, MiddleName) },
+    { "SUFX", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, Suffix) },
+    { "ANME", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, AlterName) },
+    { "LNPR", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, LastNamePronun) },
+    { "FNPR", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, FirstNamePronun) },
+    { "CPNY", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_POOLED_ACCESS(AddrBookItemType, Company) },
+    { "CPPR", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, CompanyPronun) },
+    { "SCTN", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_POOLED_ACCESS(AddrBookItemType, Department) },
+    { "POST", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, JobTitle) },
+    { "TEL2", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, WorkPhone) },
+    { "FAX2", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, WorkFax) },
+    { "CPS2", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, WorkMobile) },
+    { "STA2", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_POOLED_ACCESS(AddrBookItemType, WorkState) },
+    { "CTY2", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_POOLED_ACCESS(AddrBookItemType, WorkCity) },
+    { "STR2", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, WorkStreet) },
+    { "ZIP2", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, WorkZip) },
+    { "CTR2", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_POOLED_ACCESS(AddrBookItemType, WorkCountry) },
+    { "HPA2", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, WorkWebPage) },
+    { "OFCE", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_POOLED_ACCESS(AddrBookItemType, Office) },
+    { "PRFS", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_POOLED_ACCESS(AddrBookItemType, Profession) },
+    { "ASST", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, Assistant) },
+    { "MNGR", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, Manager) },
+    { "BEEP", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, Pager) },
+    { "CPS1", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, Cellular) },
+    { "TEL1", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, HomePhone) },
+    { "FAX1", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, HomeFax) },
+    { "STA1", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_POOLED_ACCESS(AddrBookItemType, HomeState) },
+    { "CTY1", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_POOLED_ACCESS(AddrBookItemType, HomeCity) },
+    { "STR1", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, HomeStreet) },
+    { "ZIP1", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, HomeZip) },
+    { "CTR1", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_POOLED_ACCESS(AddrBookItemType, HomeCountry) },
+    { "HPA1", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, HomeWebPage) },
+    { "DMAL", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, DefaultEmail) },
+    { "MAL1", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, Emails) },
+    { "SPUS", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, Spouse) },
+    { "GNDR", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_POOLED_ACCESS(AddrBookItemType, Gender) },
+    { "BRTH", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, Birthday) },
+    { "ANIV", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, Anniversary) },
+    { "NCNM", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, Nickname) },
+    { "CHLD", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, Children) },
+    { "MEM1", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(AddrBookItemType, Memo) },
+    { "GRPS", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_POOLED_ACCESS(AddrBookItemType, Group) }
+};
+
+const unsigned int AddrBookItemType::numFieldDescs =
+    sizeof(AddrBookItemType::fieldDescs) /
+    sizeof(AddrBookItemType::fieldDescs[0]);
+
 /**
  * Construct a default AddrBookItemType object.
  *
@@ -36,7 +145,20 @@
  * initialization. 
  */
 AddrBookItemType::AddrBookItemType(void) {
-
+    // The interned fields start out empty, the handle of which is zero.
+    categoryHandle = 0;
+    companyHandle = 0;
+    departmentHandle = 0;
+    workStateHandle = 0;
+    workCityHandle = 0;
+    workCountryHandle = 0;
+    officeHandle = 0;
+    professionHandle = 0;
+    homeStateHandle = 0;
+    homeCityHandle = 0;
+    homeCountryHandle = 0;
+    genderHandle = 0;
+    groupHandle = 0;
 }
 
 /**
@@ -55,18 +177,29 @@ AddrBookItemType::~AddrBookItemType(void) {
  * Set the category of the item.
  * @param value The value to set the category to.
  */
-void AddrBookItemType::SetCategory(std::string value) {
-    category = value;
+void AddrBookItemType::SetCategory(const std::string &value) {
+    categoryHandle = StringPoolType::GetSession().Intern(value);
 }
 
 /**
  * Get the category.
  *
  * Get the category of the item this object represents.
- * @return A string containing the category.
+ * @return A reference to the category.
  */
-std::string AddrBookItemType::GetCategory(void) const {
-    return category;
+StringRefType AddrBookItemType::GetCategory(void) const {
+    return StringPoolType::GetSession().Get(categoryHandle);
+}
+
+/**
+ * Get the handle of the category.
+ *
+ * Get the handle the category of the item this object represents is interned
+ * under in the pool of the session.
+ * @return The handle of the category.
+ */
+StringHandleType AddrBookItemType::GetCategoryHandle(void) const {
+    return categoryHandle;
 }
 
 /**
@@ -75,18 +208,19 @@ std::string AddrBookItemType::GetCategory(void) const {
  * Set the Full name of the item.
  * @param value The value to set the Full name to.
  */
-void AddrBookItemType::SetFullName(std::string value) {
-    fullName = value;
+void AddrBookItemType::SetFullName(const std::string &value) {
+    strings.Set(STR_FULL_NAME, value);
 }
 
 /**
  * Get the Full name.
  *
  * Get the Full name of the item this object represents.
- * @return A string containing the Full name.
+ * @return A reference to the Full name, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetFullName(void) const {
-    return fullName;
+StringRefType AddrBookItemType::GetFullName(void) const {
+    return strings.Get(STR_FULL_NAME);
 }
 
 /**
@@ -95,18 +229,19 @@ std::string AddrBookItemType::GetFullName(void) const {
  * Set the Full name pronunciation of the item.
  * @param value The value to set the Full name pronunciation to.
  */
-void AddrBookItemType::SetFullNamePronun(std::string value) {
-    fullNamePronun = value;
+void AddrBookItemType::SetFullNamePronun(const std::string &value) {
+    strings.Set(STR_FULL_NAME_PRONUN, value);
 }
 
 /**
  * Get the Full name pronunciation.
  *
  * Get the Full name pronunciation of the item this object represents.
- * @return A string containing the Full name pronunciation.
+ * @return A reference to the Full name pronunciation, valid until any string
+ * field of the item is set.
  */
-std::string AddrBookItemType::GetFullNamePronun(void) const {
-    return fullNamePronun;
+StringRefType AddrBookItemType::GetFullNamePronun(void) const {
+    return strings.Get(STR_FULL_NAME_PRONUN);
 }
 
 /**
@@ -115,18 +250,19 @@ std::string AddrBookItemType::GetFullNamePronun(void) const {
  * Set the Term of respect of the item.
  * @param value The value to set the Term of respect to.
  */
-void AddrBookItemType::SetTermOfRespect(std::string value) {
-    termOfRespect = value;
+void AddrBookItemType::SetTermOfRespect(const std::string &value) {
+    strings.Set(STR_TERM_OF_RESPECT, value);
 }
 
 /**
  * Get the Term of respect.
  *
  * Get the term of respect of the item this object represents.
- * @return A string containing the Term of respect.
+ * @return A reference to the Term of respect, valid until any string field of
+ * the item is set.
  */
-std::string AddrBookItemType::GetTermOfRespect(void) const {
-    return termOfRespect;
+StringRefType AddrBookItemType::GetTermOfRespect(void) const {
+    return strings.Get(STR_TERM_OF_RESPECT);
 }
 
 /**
@@ -135,18 +271,19 @@ std::string AddrBookItemType::GetTermOfRespect(void) const {
  * Set the Last Name of the item.
  * @param value The value to set the Last Name to.
  */
-void AddrBookItemType::SetLastName(std::string value) {
-    lastName = value;
+void AddrBookItemType::SetLastName(const std::string &value) {
+    strings.Set(STR_LAST_NAME, value);
 }
 
 /**
  * Get the Last Name.
  *
  * Get the Last Name of the item this object represents.
- * @return A string containing the Last Name.
+ * @return A reference to the Last Name, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetLastName(void) const {
-    return lastName;
+StringRefType AddrBookItemType::GetLastName(void) const {
+    return strings.Get(STR_LAST_NAME);
 }
 
 /**
@@ -155,18 +292,19 @@ std::string AddrBookItemType::GetLastName(void) const {
  * Set the First Name of the item.
  * @param value The value to set the First Name to.
  */
-void AddrBookItemType::SetFirstName(std::string value) {
-    firstName = value;
+void AddrBookItemType::SetFirstName(const std::string &value) {
+    strings.Set(STR_FIRST_NAME, value);
 }
 
 /**
  * Get the First Name.
  *
  * Get the First Name of the item this object represents.
- * @return A string containing the First Name.
+ * @return A reference to the First Name, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetFirstName(void) const {
-    return firstName;
+StringRefType AddrBookItemType::GetFirstName(void) const {
+    return strings.Get(STR_FIRST_NAME);
 }
 
 /**
@@ -175,18 +313,19 @@ std::string AddrBookItemType::GetFirstName(void) const {
  * Set the Middle Name of the item.
  * @param value The value to set the Middle Name to.
  */
-void AddrBookItemType::SetMiddleName(std::string value) {
-    middleName = value;
+void AddrBookItemType::SetMiddleName(const std::string &value) {
+    strings.Set(STR_MIDDLE_NAME, value);
 }
 
 /**
  * Get the Middle Name.
  *
  * Get the Middle Name of the item this object represents.
- * @return A string containing the Middle Name.
+ * @return A reference to the Middle Name, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetMiddleName(void) const {
-    return middleName;
+StringRefType AddrBookItemType::GetMiddleName(void) const {
+    return strings.Get(STR_MIDDLE_NAME);
 }
 
 /**
@@ -195,18 +334,19 @@ std::string AddrBookItemType::GetMiddleName(void) const {
  * Set the Suffix of the item.
  * @param value The value to set the Suffix to.
  */
-void AddrBookItemType::SetSuffix(std::string value) {
-    suffix = value;
+void AddrBookItemType::SetSuffix(const std::string &value) {
+    strings.Set(STR_SUFFIX, value);
 }
 
 /**
  * Get the Suffix.
  *
  * Get the Suffix of the item this object represents.
- * @return A string containing the Suffix.
+ * @return A reference to the Suffix, valid until any string field of the item
+ * is set.
  */
-std::string AddrBookItemType::GetSuffix(void) const {
-    return suffix;
+StringRefType AddrBookItemType::GetSuffix(void) const {
+    return strings.Get(STR_SUFFIX);
 }
 
 /**
@@ -215,18 +355,19 @@ std::string AddrBookItemType::GetSuffix(void) const {
  * Set the Alternate Name of the item.
  * @param value The value to set the Alternate Name to.
  */
-void AddrBookItemType::SetAlterName(std::string value) {
-    alterName = value;
+void AddrBookItemType::SetAlterName(const std::string &value) {
+    strings.Set(STR_ALTER_NAME, value);
 }
 
 /**
  * Get the Alternate Name.
  *
  * Get the Alternate Name of the item this object represents.
- * @return A string containing the Alternate Name.
+ * @return A reference to the Alternate Name, valid until any string field of
+ * the item is set.
  */
-std::string AddrBookItemType::GetAlterName(void) const {
-    return alterName;
+StringRefType AddrBookItemType::GetAlterName(void) const {
+    return strings.Get(STR_ALTER_NAME);
 }
 
 /**
@@ -235,18 +376,19 @@ std::string AddrBookItemType::GetAlterName(void) const {
  * Set the Last Name Pronunciation of the item.
  * @param value The value to set the Last Name Pronunciation to.
  */
-void AddrBookItemType::SetLastNamePronun(std::string value) {
-    lastNamePronun = value;
+void AddrBookItemType::SetLastNamePronun(const std::string &value) {
+    strings.Set(STR_LAST_NAME_PRONUN, value);
 }
 
 /**
  * Get the Last Name Pronunciation.
  *
  * Get the Last Name Pronunciation of the item this object represents.
- * @return A string containing the Last Name Pronunciation.
+ * @return A reference to the Last Name Pronunciation, valid until any string
+ * field of the item is set.
  */
-std::string AddrBookItemType::GetLastNamePronun(void) const {
-    return lastNamePronun;
+StringRefType AddrBookItemType::GetLastNamePronun(void) const {
+    return strings.Get(STR_LAST_NAME_PRONUN);
 }
 
 /**
@@ -255,18 +397,19 @@ std::string AddrBookItemType::GetLastNamePronun(void) const {
  * Set the First Name Pronunciation of the item.
  * @param value The value to set the First Name Pronunciation to.
  */
-void AddrBookItemType::SetFirstNamePronun(std::string value) {
-    firstNamePronun = value;
+void AddrBookItemType::SetFirstNamePronun(const std::string &value) {
+    strings.Set(STR_FIRST_NAME_PRONUN, value);
 }
 
 /**
  * Get the First Name Pronunciation.
  *
  * Get the First Name Pronunciation of the item this object represents.
- * @return A string containing the First Name Pronunciation.
+ * @return A reference to the First Name Pronunciation, valid until any string
+ * field of the item is set.
  */
-std::string AddrBookItemType::GetFirstNamePronun(void) const {
-    return firstNamePronun;
+StringRefType AddrBookItemType::GetFirstNamePronun(void) const {
+    return strings.Get(STR_FIRST_NAME_PRONUN);
 }
 
 /**
@@ -275,18 +418,29 @@ std::string AddrBookItemType::GetFirstNamePronun(void) const {
  * Set the Company of the item.
  * @param value The value to set the Company to.
  */
-void AddrBookItemType::SetCompany(std::string value) {
-    company = value;
+void AddrBookItemType::SetCompany(const std::string &value) {
+    companyHandle = StringPoolType::GetSession().Intern(value);
 }
 
 /**
  * Get the Company.
  *
  * Get the Company of the item this object represents.
- * @return A string containing the Company.
+ * @return A reference to the Company.
+ */
+StringRefType AddrBookItemType::GetCompany(void) const {
+    return StringPoolType::GetSession().Get(companyHandle);
+}
+
+/**
+ * Get the handle of the Company.
+ *
+ * Get the handle the Company of the item this object represents is interned
+ * under in the pool of the session.
+ * @return The handle of the Company.
  */
-std::string AddrBookItemType::GetCompany(void) const {
-    return company;
+StringHandleType AddrBookItemType::GetCompanyHandle(void) const {
+    return companyHandle;
 }
 
 /**
@@ -295,18 +449,19 @@ std::string AddrBookItemType::GetCompany(void) const {
  * Set the Company Pronunciation of the item.
  * @param value The value to set the Company Pronunciation to.
  */
-void AddrBookItemType::SetCompanyPronun(std::string value) {
-    companyPronun = value;
+void AddrBookItemType::SetCompanyPronun(const std::string &value) {
+    strings.Set(STR_COMPANY_PRONUN, value);
 }
 
 /**
  * Get the Company Pronunciation.
  *
  * Get the Company Pronunciation of the item this object represents.
- * @return A string containing the Company Pronunciation.
+ * @return A reference to the Company Pronunciation, valid until any string
+ * field of the item is set.
  */
-std::string AddrBookItemType::GetCompanyPronun(void) const {
-    return companyPronun;
+StringRefType AddrBookItemType::GetCompanyPronun(void) const {
+    return strings.Get(STR_COMPANY_PRONUN);
 }
 
 /**
@@ -315,18 +470,29 @@ std::string AddrBookItemType::GetCompanyPronun(void) const {
  * Set the Department of the item.
  * @param value The value to set the Department to.
  */
-void AddrBookItemType::SetDepartment(std::string value) {
-    department = value;
+void AddrBookItemType::SetDepartment(const std::string &value) {
+    departmentHandle = StringPoolType::GetSession().Intern(value);
 }
 
 /**
  * Get the Department.
  *
  * Get the Department of the item this object represents.
- * @return A string containing the Department.
+ * @return A reference to the Department.
+ */
+StringRefType AddrBookItemType::GetDepartment(void) const {
+    return StringPoolType::GetSession().Get(departmentHandle);
+}
+
+/**
+ * Get the handle of the Department.
+ *
+ * Get the handle the Department of the item this object represents is interned
+ * under in the pool of the session.
+ * @return The handle of the Department.
  */
-std::string AddrBookItemType::GetDepartment(void) const {
-    return department;
+StringHandleType AddrBookItemType::GetDepartmentHandle(void) const {
+    return departmentHandle;
 }
 
 /**
@@ -335,18 +501,19 @@ std::string AddrBookItemType::GetDepartment(void) const {
  * Set the Job Title of the item.
  * @param value The value to set the Job Title to.
  */
-void AddrBookItemType::SetJobTitle(std::string value) {
-    jobTitle = value;
+void AddrBookItemType::SetJobTitle(const std::string &value) {
+    strings.Set(STR_JOB_TITLE, value);
 }
 
 /**
  * Get the Job Title.
  *
  * Get the Job Title  of the item this object represents.
- * @return A string containing the Job Title.
+ * @return A reference to the Job Title, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetJobTitle(void) const {
-    return jobTitle;
+StringRefType AddrBookItemType::GetJobTitle(void) const {
+    return strings.Get(STR_JOB_TITLE);
 }
 
 /**
@@ -355,18 +522,19 @@ std::string AddrBookItemType::GetJobTitle(void) const {
  * Set the Work Phone of the item.
  * @param value The value to set the Work Phone to.
  */
-void AddrBookItemType::SetWorkPhone(std::string value) {
-    workPhone = value;
+void AddrBookItemType::SetWorkPhone(const std::string &value) {
+    strings.Set(STR_WORK_PHONE, value);
 }
 
 /**
  * Get the Work Phone.
  *
  * Get the Work Phone of the item this object represents.
- * @return A string containing the Work Phone.
+ * @return A reference to the Work Phone, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetWorkPhone(void) const {
-    return workPhone;
+StringRefType AddrBookItemType::GetWorkPhone(void) const {
+    return strings.Get(STR_WORK_PHONE);
 }
 
 /**
@@ -375,18 +543,19 @@ std::string AddrBookItemType::GetWorkPhone(void) const {
  * Set the Work Fax of the item.
  * @param value The value to set the Work Fax to.
  */
-void AddrBookItemType::SetWorkFax(std::string value) {
-    workFax = value;
+void AddrBookItemType::SetWorkFax(const std::string &value) {
+    strings.Set(STR_WORK_FAX, value);
 }
 
 /**
  * Get the Work Fax.
  *
  * Get the Work Fax of the item this object represents.
- * @return A string containing the Work Fax.
+ * @return A reference to the Work Fax, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetWorkFax(void) const {
-    return workFax;
+StringRefType AddrBookItemType::GetWorkFax(void) const {
+    return strings.Get(STR_WORK_FAX);
 }
 
 /**
@@ -395,18 +564,19 @@ std::string AddrBookItemType::GetWorkFax(void) const {
  * Set the Work Mobile of the item.
  * @param value The value to set the Work Mobile to.
  */
-void AddrBookItemType::SetWorkMobile(std::string value) {
-    workMobile = value;
+void AddrBookItemType::SetWorkMobile(const std::string &value) {
+    strings.Set(STR_WORK_MOBILE, value);
 }
 
 /**
  * Get the Work Mobile.
  *
  * Get the Work Mobile of the item this object represents.
- * @return A string containing the Work Mobile.
+ * @return A reference to the Work Mobile, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetWorkMobile(void) const {
-    return workMobile;
+StringRefType AddrBookItemType::GetWorkMobile(void) const {
+    return strings.Get(STR_WORK_MOBILE);
 }
 
 /**
@@ -415,18 +585,29 @@ std::string AddrBookItemType::GetWorkMobile(void) const {
  * Set the Work State of the item.
  * @param value The value to set the Work State to.
  */
-void AddrBookItemType::SetWorkState(std::string value) {
-    workState = value;
+void AddrBookItemType::SetWorkState(const std::string &value) {
+    workStateHandle = StringPoolType::GetSession().Intern(value);
 }
 
 /**
  * Get the Work State.
  *
  * Get the Work State of the item this object represents.
- * @return A string containing the Work Stat.
+ * @return A reference to the Work Stat.
+ */
+StringRefType AddrBookItemType::GetWorkState(void) const {
+    return StringPoolType::GetSession().Get(workStateHandle);
+}
+
+/**
+ * Get the handle of the Work State.
+ *
+ * Get the handle the Work State of the item this object represents is interned
+ * under in the pool of the session.
+ * @return The handle of the Work State.
  */
-std::string AddrBookItemType::GetWorkState(void) const {
-    return workState;
+StringHandleType AddrBookItemType::GetWorkStateHandle(void) const {
+    return workStateHandle;
 }
 
 /**
@@ -435,18 +616,29 @@ std::string AddrBookItemType::GetWorkState(void) const {
  * Set the Work City of the item.
  * @param value The value to set the Work City to.
  */
-void AddrBookItemType::SetWorkCity(std::string value) {
-    workCity = value;
+void AddrBookItemType::SetWorkCity(const std::string &value) {
+    workCityHandle = StringPoolType::GetSession().Intern(value);
 }
 
 /**
  * Get the Work City.
  *
  * Get the Work City of the item this object represents.
- * @return A string containing the Work City.
+ * @return A reference to the Work City.
  */
-std::string AddrBookItemType::GetWorkCity(void) const {
-    return workCity;
+StringRefType AddrBookItemType::GetWorkCity(void) const {
+    return StringPoolType::GetSession().Get(workCityHandle);
+}
+
+/**
+ * Get the handle of the Work City.
+ *
+ * Get the handle the Work City of the item this object represents is interned
+ * under in the pool of the session.
+ * @return The handle of the Work City.
+ */
+StringHandleType AddrBookItemType::GetWorkCityHandle(void) const {
+    return workCityHandle;
 }
 
 /**
@@ -455,18 +647,19 @@ std::string AddrBookItemType::GetWorkCity(void) const {
  * Set the Work Street of the item.
  * @param value The value to set the Work Street to.
  */
-void AddrBookItemType::SetWorkStreet(std::string value) {
-    workStreet = value;
+void AddrBookItemType::SetWorkStreet(const std::string &value) {
+    strings.Set(STR_WORK_STREET, value);
 }
 
 /**
  * Get the Work Street.
  *
  * Get the Work Street of the item this object represents.
- * @return A string containing the Work Street.
+ * @return A reference to the Work Street, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetWorkStreet(void) const {
-    return workStreet;
+StringRefType AddrBookItemType::GetWorkStreet(void) const {
+    return strings.Get(STR_WORK_STREET);
 }
 
 /**
@@ -475,18 +668,19 @@ std::string AddrBookItemType::GetWorkStreet(void) const {
  * Set the Work Zip of the item.
  * @param value The value to set the Work Zip to.
  */
-void AddrBookItemType::SetWorkZip(std::string value) {
-    workZip = value;
+void AddrBookItemType::SetWorkZip(const std::string &value) {
+    strings.Set(STR_WORK_ZIP, value);
 }
 
 /**
  * Get the Work Zip.
  *
  * Get the Work Zip of the item this object represents.
- * @return A string containing the Work Zip.
+ * @return A reference to the Work Zip, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetWorkZip(void) const {
-    return workZip;
+StringRefType AddrBookItemType::GetWorkZip(void) const {
+    return strings.Get(STR_WORK_ZIP);
 }
 
 /**
@@ -495,18 +689,29 @@ std::string AddrBookItemType::GetWorkZip(void) const {
  * Set the Work Country of the item.
  * @param value The value to set the Work Country to.
  */
-void AddrBookItemType::SetWorkCountry(std::string value) {
-    workCountry = value;
+void AddrBookItemType::SetWorkCountry(const std::string &value) {
+    workCountryHandle = StringPoolType::GetSession().Intern(value);
 }
 
 /**
  * Get the Work Country.
  *
  * Get the Work Country of the item this object represents.
- * @return A string containing the Work Country.
+ * @return A reference to the Work Country.
  */
-std::string AddrBookItemType::GetWorkCountry(void) const {
-    return workCountry;
+StringRefType AddrBookItemType::GetWorkCountry(void) const {
+    return StringPoolType::GetSession().Get(workCountryHandle);
+}
+
+/**
+ * Get the handle of the Work Country.
+ *
+ * Get the handle the Work Country of the item this object represents is interned
+ * under in the pool of the session.
+ * @return The handle of the Work Country.
+ */
+StringHandleType AddrBookItemType::GetWorkCountryHandle(void) const {
+    return workCountryHandle;
 }
 
 /**
@@ -515,18 +720,19 @@ std::string AddrBookItemType::GetWorkCountry(void) const {
  * Set the Work Web Page of the item.
  * @param value The value to set the Work Web Page to.
  */
-void AddrBookItemType::SetWorkWebPage(std::string value) {
-    workWebPage = value;
+void AddrBookItemType::SetWorkWebPage(const std::string &value) {
+    strings.Set(STR_WORK_WEB_PAGE, value);
 }
 
 /**
  * Get the Work Web Page.
  *
  * Get the Work Web Page of the item this object represents.
- * @return A string containing the Work Web Page.
+ * @return A reference to the Work Web Page, valid until any string field of
+ * the item is set.
  */
-std::string AddrBookItemType::GetWorkWebPage(void) const {
-    return workWebPage;
+StringRefType AddrBookItemType::GetWorkWebPage(void) const {
+    return strings.Get(STR_WORK_WEB_PAGE);
 }
 
 /**
@@ -535,18 +741,29 @@ std::string AddrBookItemType::GetWorkWebPage(void) const {
  * Set the Office of the item.
  * @param value The value to set the Office to.
  */
-void AddrBookItemType::SetOffice(std::string value) {
-    office = value;
+void AddrBookItemType::SetOffice(const std::string &value) {
+    officeHandle = StringPoolType::GetSession().Intern(value);
 }
 
 /**
  * Get the Office.
  *
  * Get the Office of the item this object represents.
- * @return A string containing the Office.
+ * @return A reference to the Office.
+ */
+StringRefType AddrBookItemType::GetOffice(void) const {
+    return StringPoolType::GetSession().Get(officeHandle);
+}
+
+/**
+ * Get the handle of the Office.
+ *
+ * Get the handle the Office of the item this object represents is interned
+ * under in the pool of the session.
+ * @return The handle of the Office.
  */
-std::string AddrBookItemType::GetOffice(void) const {
-    return office;
+StringHandleType AddrBookItemType::GetOfficeHandle(void) const {
+    return officeHandle;
 }
 
 /**
@@ -555,18 +772,29 @@ std::string AddrBookItemType::GetOffice(void) const {
  * Set the Profession of the item.
  * @param value The value to set the Profession to.
  */
-void AddrBookItemType::SetProfession(std::string value) {
-    profession = value;
+void AddrBookItemType::SetProfession(const std::string &value) {
+    professionHandle = StringPoolType::GetSession().Intern(value);
 }
 
 /**
  * Get the Profession.
  *
  * Get the Profession of the item this object represents.
- * @return A string containing the Profession.
+ * @return A reference to the Profession.
  */
-std::string AddrBookItemType::GetProfession(void) const {
-    return profession;
+StringRefType AddrBookItemType::GetProfession(void) const {
+    return StringPoolType::GetSession().Get(professionHandle);
+}
+
+/**
+ * Get the handle of the Profession.
+ *
+ * Get the handle the Profession of the item this object represents is interned
+ * under in the pool of the session.
+ * @return The handle of the Profession.
+ */
+StringHandleType AddrBookItemType::GetProfessionHandle(void) const {
+    return professionHandle;
 }
 
 /**
@@ -575,18 +803,19 @@ std::string AddrBookItemType::GetProfession(void) const {
  * Set the Assistant of the item.
  * @param value The value to set the Assistant to.
  */
-void AddrBookItemType::SetAssistant(std::string value) {
-    assistant = value;
+void AddrBookItemType::SetAssistant(const std::string &value) {
+    strings.Set(STR_ASSISTANT, value);
 }
 
 /**
  * Get the Assistant.
  *
  * Get the Assistant of the item this object represents.
- * @return A string containing the Assistant.
+ * @return A reference to the Assistant, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetAssistant(void) const {
-    return assistant;
+StringRefType AddrBookItemType::GetAssistant(void) const {
+    return strings.Get(STR_ASSISTANT);
 }
 
 /**
@@ -595,18 +824,19 @@ std::string AddrBookItemType::GetAssistant(void) const {
  * Set the Manager of the item.
  * @param value The value to set the Manager to.
  */
-void AddrBookItemType::SetManager(std::string value) {
-    manager = value;
+void AddrBookItemType::SetManager(const std::string &value) {
+    strings.Set(STR_MANAGER, value);
 }
 
 /**
  * Get the Manager.
  *
  * Get the Manager of the item this object represents.
- * @return A string containing the Manager.
+ * @return A reference to the Manager, valid until any string field of the item
+ * is set.
  */
-std::string AddrBookItemType::GetManager(void) const {
-    return manager;
+StringRefType AddrBookItemType::GetManager(void) const {
+    return strings.Get(STR_MANAGER);
 }
 
 /**
@@ -615,18 +845,19 @@ std::string AddrBookItemType::GetManager(void) const {
  * Set the Pager of the item.
  * @param value The value to set the Pager to.
  */
-void AddrBookItemType::SetPager(std::string value) {
-    pager = value;
+void AddrBookItemType::SetPager(const std::string &value) {
+    strings.Set(STR_PAGER, value);
 }
 
 /**
  * Get the Pager.
  *
  * Get the Pager of the item this object represents.
- * @return A string containing the Pager.
+ * @return A reference to the Pager, valid until any string field of the item
+ * is set.
  */
-std::string AddrBookItemType::GetPager(void) const {
-    return pager;
+StringRefType AddrBookItemType::GetPager(void) const {
+    return strings.Get(STR_PAGER);
 }
 
 /**
@@ -635,18 +866,19 @@ std::string AddrBookItemType::GetPager(void) const {
  * Set the Cellular of the item.
  * @param value The value to set the Cellular to.
  */
-void AddrBookItemType::SetCellular(std::string value) {
-    cellular = value;
+void AddrBookItemType::SetCellular(const std::string &value) {
+    strings.Set(STR_CELLULAR, value);
 }
 
 /**
  * Get the Cellular.
  *
  * Get the Cellular of the item this object represents.
- * @return A string containing the Cellular.
+ * @return A reference to the Cellular, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetCellular(void) const {
-    return cellular;
+StringRefType AddrBookItemType::GetCellular(void) const {
+    return strings.Get(STR_CELLULAR);
 }
 
 /**
@@ -655,18 +887,19 @@ std::string AddrBookItemType::GetCellular(void) const {
  * Set the Home Phone of the item.
  * @param value The value to set the Home Phone to.
  */
-void AddrBookItemType::SetHomePhone(std::string value) {
-    homePhone = value;
+void AddrBookItemType::SetHomePhone(const std::string &value) {
+    strings.Set(STR_HOME_PHONE, value);
 }
 
 /**
  * Get the Home Phone.
  *
  * Get the Home Phone of the item this object represents.
- * @return A string containing the Home Phone.
+ * @return A reference to the Home Phone, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetHomePhone(void) const {
-    return homePhone;
+StringRefType AddrBookItemType::GetHomePhone(void) const {
+    return strings.Get(STR_HOME_PHONE);
 }
 
 /**
@@ -675,18 +908,19 @@ std::string AddrBookItemType::GetHomePhone(void) const {
  * Set the Home Fax of the item.
  * @param value The value to set the Home Fax to.
  */
-void AddrBookItemType::SetHomeFax(std::string value) {
-    homeFax = value;
+void AddrBookItemType::SetHomeFax(const std::string &value) {
+    strings.Set(STR_HOME_FAX, value);
 }
 
 /**
  * Get the Home Fax.
  *
  * Get the Home Fax of the item this object represents.
- * @return A string containing the Home Fax.
+ * @return A reference to the Home Fax, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetHomeFax(void) const {
-    return homeFax;
+StringRefType AddrBookItemType::GetHomeFax(void) const {
+    return strings.Get(STR_HOME_FAX);
 }
 
 /**
@@ -695,18 +929,29 @@ std::string AddrBookItemType::GetHomeFax(void) const {
  * Set the Home State of the item.
  * @param value The value to set the Home State to.
  */
-void AddrBookItemType::SetHomeState(std::string value) {
-    homeState = value;
+void AddrBookItemType::SetHomeState(const std::string &value) {
+    homeStateHandle = StringPoolType::GetSession().Intern(value);
 }
 
 /**
  * Get the Home State.
  *
  * Get the Home State of the item this object represents.
- * @return A string containing the Home State.
+ * @return A reference to the Home State.
  */
-std::string AddrBookItemType::GetHomeState(void) const {
-    return homeState;
+StringRefType AddrBookItemType::GetHomeState(void) const {
+    return StringPoolType::GetSession().Get(homeStateHandle);
+}
+
+/**
+ * Get the handle of the Home State.
+ *
+ * Get the handle the Home State of the item this object represents is interned
+ * under in the pool of the session.
+ * @return The handle of the Home State.
+ */
+StringHandleType AddrBookItemType::GetHomeStateHandle(void) const {
+    return homeStateHandle;
 }
 
 /**
@@ -715,18 +960,29 @@ std::string AddrBookItemType::GetHomeState(void) const {
  * Set the Home City of the item.
  * @param value The value to set the Home City to.
  */
-void AddrBookItemType::SetHomeCity(std::string value) {
-    homeCity = value;
+void AddrBookItemType::SetHomeCity(const std::string &value) {
+    homeCityHandle = StringPoolType::GetSession().Intern(value);
 }
 
 /**
  * Get the Home City.
  *
  * Get the Home City of the item this object represents.
- * @return A string containing the Home City.
+ * @return A reference to the Home City.
  */
-std::string AddrBookItemType::GetHomeCity(void) const {
-    return homeCity;
+StringRefType AddrBookItemType::GetHomeCity(void) const {
+    return StringPoolType::GetSession().Get(homeCityHandle);
+}
+
+/**
+ * Get the handle of the Home City.
+ *
+ * Get the handle the Home City of the item this object represents is interned
+ * under in the pool of the session.
+ * @return The handle of the Home City.
+ */
+StringHandleType AddrBookItemType::GetHomeCityHandle(void) const {
+    return homeCityHandle;
 }
 
 /**
@@ -735,18 +991,19 @@ std::string AddrBookItemType::GetHomeCity(void) const {
  * Set the Home Street of the item.
  * @param value The value to set the Home Street to.
  */
-void AddrBookItemType::SetHomeStreet(std::string value) {
-    homeStreet = value;
+void AddrBookItemType::SetHomeStreet(const std::string &value) {
+    strings.Set(STR_HOME_STREET, value);
 }
 
 /**
  * Get the Home Street.
  *
  * Get the Home Street of the item this object represents.
- * @return A string containing the Home Street.
+ * @return A reference to the Home Street, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetHomeStreet(void) const {
-    return homeStreet;
+StringRefType AddrBookItemType::GetHomeStreet(void) const {
+    return strings.Get(STR_HOME_STREET);
 }
 
 /**
@@ -755,18 +1012,19 @@ std::string AddrBookItemType::GetHomeStreet(void) const {
  * Set the Home Zip of the item.
  * @param value The value to set the Home Zip to.
  */
-void AddrBookItemType::SetHomeZip(std::string value) {
-    homeZip = value;
+void AddrBookItemType::SetHomeZip(const std::string &value) {
+    strings.Set(STR_HOME_ZIP, value);
 }
 
 /**
  * Get the Home Zip.
  *
  * Get the Home Zip of the item this object represents.
- * @return A string containing the Home Zip.
+ * @return A reference to the Home Zip, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetHomeZip(void) const {
-    return homeZip;
+StringRefType AddrBookItemType::GetHomeZip(void) const {
+    return strings.Get(STR_HOME_ZIP);
 }
 
 /**
@@ -775,18 +1033,29 @@ std::string AddrBookItemType::GetHomeZip(void) const {
  * Set the Home Country of the item.
  * @param value The value to set the Home Country to.
  */
-void AddrBookItemType::SetHomeCountry(std::string value) {
-    homeCountry = value;
+void AddrBookItemType::SetHomeCountry(const std::string &value) {
+    homeCountryHandle = StringPoolType::GetSession().Intern(value);
 }
 
 /**
  * Get the Home Country.
  *
  * Get the Home Country of the item this object represents.
- * @return A string containing the Home Country.
+ * @return A reference to the Home Country.
+ */
+StringRefType AddrBookItemType::GetHomeCountry(void) const {
+    return StringPoolType::GetSession().Get(homeCountryHandle);
+}
+
+/**
+ * Get the handle of the Home Country.
+ *
+ * Get the handle the Home Country of the item this object represents is interned
+ * under in the pool of the session.
+ * @return The handle of the Home Country.
  */
-std::string AddrBookItemType::GetHomeCountry(void) const {
-    return homeCountry;
+StringHandleType AddrBookItemType::GetHomeCountryHandle(void) const {
+    return homeCountryHandle;
 }
 
 /**
@@ -795,18 +1064,19 @@ std::string AddrBookItemType::GetHomeCountry(void) const {
  * Set the Home Web Page of the item.
  * @param value The value to set the Home Web Page to.
  */
-void AddrBookItemType::SetHomeWebPage(std::string value) {
-    homeWebPage = value;
+void AddrBookItemType::SetHomeWebPage(const std::string &value) {
+    strings.Set(STR_HOME_WEB_PAGE, value);
 }
 
 /**
  * Get the Home Web Page.
  *
  * Get the Home Web Page of the item this object represents.
- * @return A string containing the Home Web Page.
+ * @return A reference to the Home Web Page, valid until any string field of
+ * the item is set.
  */
-std::string AddrBookItemType::GetHomeWebPage(void) const {
-    return homeWebPage;
+StringRefType AddrBookItemType::GetHomeWebPage(void) const {
+    return strings.Get(STR_HOME_WEB_PAGE);
 }
 
 /**
@@ -815,18 +1085,19 @@ std::string AddrBookItemType::GetHomeWebPage(void) const {
  * Set the Default Email of the item.
  * @param value The value to set the Default Email to.
  */
-void AddrBookItemType::SetDefaultEmail(std::string value) {
-    defaultEmail = value;
+void AddrBookItemType::SetDefaultEmail(const std::string &value) {
+    strings.Set(STR_DEFAULT_EMAIL, value);
 }
 
 /**
  * Get the Default Email.
  *
  * Get the Default Email of the item this object represents.
- * @return A string containing the Default Email.
+ * @return A reference to the Default Email, valid until any string field of
+ * the item is set.
  */
-std::string AddrBookItemType::GetDefaultEmail(void) const {
-    return defaultEmail;
+StringRefType AddrBookItemType::GetDefaultEmail(void) const {
+    return strings.Get(STR_DEFAULT_EMAIL);
 }
 
 /**
@@ -836,8 +1107,8 @@ std::string AddrBookItemType::GetDefaultEmail(void) const {
  * the first of which is the Default Email.
  * @param value The value to set the Emails to.
  */
-void AddrBookItemType::SetEmails(std::string value) {
-    emails = value;
+void AddrBookItemType::SetEmails(const std::string &value) {
+    strings.Set(STR_EMAILS, value);
 }
 
 /**
@@ -845,10 +1116,11 @@ void AddrBookItemType::SetEmails(std::string value) {
  *
  * Get the Emails of the item this object represents. This can be a space
  * seperated list of emails, the first of which is the Default Email.
- * @return A string containing the Emails.
+ * @return A reference to the Emails, valid until any string field of the item
+ * is set.
  */
-std::string AddrBookItemType::GetEmails(void) const {
-    return emails;
+StringRefType AddrBookItemType::GetEmails(void) const {
+    return strings.Get(STR_EMAILS);
 }
 
 /**
@@ -857,18 +1129,19 @@ std::string AddrBookItemType::GetEmails(void) const {
  * Set the Spouse of the item.
  * @param value The value to set the Spouse to.
  */
-void AddrBookItemType::SetSpouse(std::string value) {
-    spouse = value;
+void AddrBookItemType::SetSpouse(const std::string &value) {
+    strings.Set(STR_SPOUSE, value);
 }
 
 /**
  * Get the Spouse.
  *
  * Get the Spouse of the item this object represents.
- * @return A string containing the Spouse.
+ * @return A reference to the Spouse, valid until any string field of the item
+ * is set.
  */
-std::string AddrBookItemType::GetSpouse(void) const {
-    return spouse;
+StringRefType AddrBookItemType::GetSpouse(void) const {
+    return strings.Get(STR_SPOUSE);
 }
 
 /**
@@ -877,18 +1150,29 @@ std::string AddrBookItemType::GetSpouse(void) const {
  * Set the Gender of the item.
  * @param value The value to set the Gender to.
  */
-void AddrBookItemType::SetGender(std::string value) {
-    gender = value;
+void AddrBookItemType::SetGender(const std::string &value) {
+    genderHandle = StringPoolType::GetSession().Intern(value);
 }
 
 /**
  * Get the Gender.
  *
  * Get the Gender of the item this object represents.
- * @return A string containing the Gender.
+ * @return A reference to the Gender.
  */
-std::string AddrBookItemType::GetGender(void) const {
-    return gender;
+StringRefType AddrBookItemType::GetGender(void) const {
+    return StringPoolType::GetSession().Get(genderHandle);
+}
+
+/**
+ * Get the handle of the Gender.
+ *
+ * Get the handle the Gender of the item this object represents is interned
+ * under in the pool of the session.
+ * @return The handle of the Gender.
+ */
+StringHandleType AddrBookItemType::GetGenderHandle(void) const {
+    return genderHandle;
 }
 
 /**
@@ -897,18 +1181,19 @@ std::string AddrBookItemType::GetGender(void) const {
  * Set the Birthday of the item.
  * @param value The value to set the Birthday to.
  */
-void AddrBookItemType::SetBirthday(std::string value) {
-    birthday = value;
+void AddrBookItemType::SetBirthday(const std::string &value) {
+    strings.Set(STR_BIRTHDAY, value);
 }
 
 /**
  * Get the Birthday.
  *
  * Get the Birthday of the item this object represents.
- * @return A string containing the Birthday.
+ * @return A reference to the Birthday, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetBirthday(void) const {
-    return birthday;
+StringRefType AddrBookItemType::GetBirthday(void) const {
+    return strings.Get(STR_BIRTHDAY);
 }
 
 /**
@@ -917,18 +1202,19 @@ std::string AddrBookItemType::GetBirthday(void) const {
  * Set the Anniversary of the item.
  * @param value The value to set the Anniversary to.
  */
-void AddrBookItemType::SetAnniversary(std::string value) {
-    anniversary = value;
+void AddrBookItemType::SetAnniversary(const std::string &value) {
+    strings.Set(STR_ANNIVERSARY, value);
 }
 
 /**
  * Get the Anniversary.
  *
  * Get the Anniversary of the item this object represents.
- * @return A string containing the Anniversary.
+ * @return A reference to the Anniversary, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetAnniversary(void) const {
-    return anniversary;
+StringRefType AddrBookItemType::GetAnniversary(void) const {
+    return strings.Get(STR_ANNIVERSARY);
 }
 
 /**
@@ -937,18 +1223,19 @@ std::string AddrBookItemType::GetAnniversary(void) const {
  * Set the Nickname of the item.
  * @param value The value to set the Nickname to.
  */
-void AddrBookItemType::SetNickname(std::string value) {
-    nickname = value;
+void AddrBookItemType::SetNickname(const std::string &value) {
+    strings.Set(STR_NICKNAME, value);
 }
 
 /**
  * Get the Nickname.
  *
  * Get the Nickname of the item this object represents.
- * @return A string containing the Nickname.
+ * @return A reference to the Nickname, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetNickname(void) const {
-    return nickname;
+StringRefType AddrBookItemType::GetNickname(void) const {
+    return strings.Get(STR_NICKNAME);
 }
 
 /**
@@ -957,18 +1244,19 @@ std::string AddrBookItemType::GetNickname(void) const {
  * Set the Children of the item.
  * @param value The value to set the Children to.
  */
-void AddrBookItemType::SetChildren(std::string value) {
-    children = value;
+void AddrBookItemType::SetChildren(const std::string &value) {
+    strings.Set(STR_CHILDREN, value);
 }
 
 /**
  * Get the Children.
  *
  * Get the Children of the item this object represents.
- * @return A string containing the Children.
+ * @return A reference to the Children, valid until any string field of the
+ * item is set.
  */
-std::string AddrBookItemType::GetChildren(void) const {
-    return children;
+StringRefType AddrBookItemType::GetChildren(void) const {
+    return strings.Get(STR_CHILDREN);
 }
 
 /**
@@ -977,18 +1265,19 @@ std::string AddrBookItemType::GetChildren(void) const {
  * Set the Memo of the item.
  * @param value The value to set the Memo to.
  */
-void AddrBookItemType::SetMemo(std::string value) {
-    memo = value;
+void AddrBookItemType::SetMemo(const std::string &value) {
+    strings.Set(STR_MEMO, value);
 }
 
 /**
  * Get the Memo.
  *
  * Get the Memo of the item this object represents.
- * @return A string containing the Memo.
+ * @return A reference to the Memo, valid until any string field of the item is
+ * set.
  */
-std::string AddrBookItemType::GetMemo(void) const {
-    return memo;
+StringRefType AddrBookItemType::GetMemo(void) const {
+    return strings.Get(STR_MEMO);
 }
 
 /**
@@ -997,16 +1286,90 @@ std::string AddrBookItemType::GetMemo(void) const {
  * Set the Group of the item.
  * @param value The value to set the Group to.
  */
-void AddrBookItemType::SetGroup(std::string value) {
-    group = value;
+void AddrBookItemType::SetGroup(const std::string &value) {
+    groupHandle = StringPoolType::GetSession().Intern(value);
 }
 
 /**
  * Get the Group.
  *
  * Get the Group of the item this object represents.
- * @return A string containing the Group.
+ * @return A reference to the Group.
+ */
+StringRefType AddrBookItemType::GetGroup(void) const {
+    return StringPoolType::GetSession().Get(groupHandle);
+}
+
+/**
+ * Get the handle of the Group.
+ *
+ * Get the handle the Group of the item this object represents is interned
+ * under in the pool of the session.
+ * @return The handle of the Group.
+ */
+StringHandleType AddrBookItemType::GetGroupHandle(void) const {
+    return groupHandle;
+}
+
+/**
+ * Swap with another item.
+ *
+ * Exchange the content of the Address Book item this object represents with
+ * that of the given item, without copying any of their strings.
+ * @param other Reference to the item to swap with.
+ */
+void AddrBookItemType::Swap(AddrBookItemType &other) {
+    SwapBase(other);
+    strings.Swap(other.strings);
+    std::swap(categoryHandle, other.categoryHandle);
+    std::swap(companyHandle, other.companyHandle);
+    std::swap(departmentHandle, other.departmentHandle);
+    std::swap(workStateHandle, other.workStateHandle);
+    std::swap(workCityHandle, other.workCityHandle);
+    std::swap(workCountryHandle, other.workCountryHandle);
+    std::swap(officeHandle, other.officeHandle);
+    std::swap(professionHandle, other.professionHandle);
+    std::swap(homeStateHandle, other.homeStateHandle);
+    std::swap(homeCityHandle, other.homeCityHandle);
+    std::swap(homeCountryHandle, other.homeCountryHandle);
+    std::swap(genderHandle, other.genderHandle);
+    std::swap(groupHandle, other.groupHandle);
+}
+
+/**
+ * Get the content hash.
+ *
+ * Obtain a hash of the sync relevant content of the Address Book item this
+ * object represents. The sync ID, app ID, and times of the item are left
+ * out. Two items with equal content hashes hold the same data, so a
+ * modification from one to the other changes nothing.
+ * @return The content hash of the item.
+ */
+uint64_t AddrBookItemType::ContentHash(void) const {
+    return HashFields(*this);
+}
+
+/**
+ * Get the fingerprint.
+ *
+ * Obtain a hash of the normalized content of the Address Book item this
+ * object represents. Unlike the content hash, case and white space in the
+ * text of the item are ignored, so items which were entered separately on
+ * each side with the same content have the same fingerprint.
+ * @return The fingerprint of the item.
+ */
+uint64_t AddrBookItemType::Fingerprint(void) const {
+    return HashFields(*this, FIELD_CONTENT, true);
+}
+
+/**
+ * Get the match key.
+ *
+ * Obtain a hash of the normalized fields naming the Address Book item this
+ * object represents, that is its last and first names. Items which may be
+ * duplicates of each other have the same match key.
+ * @return The match key of the item.
  */
-std::string AddrBookItemType::GetGroup(void) const {
-    return group;
+uint64_t AddrBookItemType::MatchKey(void) const {
+    return HashFields(*this, FIELD_MATCH, true);
 }
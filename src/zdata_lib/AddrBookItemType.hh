@@ -33,11 +33,12 @@
 #define ADDRBOOKITEMTYPE_H
 
 #include "ItemType.hh"
+#include "StringBlockType.hh"
 
 #include <time.h>
 
 #include <string>
-#include <list>
+#include <vector>
 
 /**
  * @class AddrBookItemType
@@ -50,207 +51,250 @@
 class AddrBookItemType : public ItemType {
  public:
     // Define a type that is a list of AddrBookItemTypes.
-    typedef std::list<AddrBookItemType> List;
+    typedef std::vector<AddrBookItemType> List;
 
     AddrBookItemType(void);
     ~AddrBookItemType(void);
 
     // Access functions for the below data members.
-    void SetCategory(std::string value);
-    std::string GetCategory(void) const;
+    void SetCategory(const std::string &value);
+    StringRefType GetCategory(void) const;
+    StringHandleType GetCategoryHandle(void) const;
 
-    void SetFullName(std::string value);
-    std::string GetFullName(void) const;
+    void SetFullName(const std::string &value);
+    StringRefType GetFullName(void) const;
 
-    void SetFullNamePronun(std::string value);
-    std::string GetFullNamePronun(void) const;
+    void SetFullNamePronun(const std::string &value);
+    StringRefType GetFullNamePronun(void) const;
 
-    void SetTermOfRespect(std::string value);
-    std::string GetTermOfRespect(void) const;
+    void SetTermOfRespect(const std::string &value);
+    StringRefType GetTermOfRespect(void) const;
 
-    void SetLastName(std::string value);
-    std::string GetLastName(void) const;
+    void SetLastName(const std::string &value);
+    StringRefType GetLastName(void) const;
 
-    void SetFirstName(std::string value);
-    std::string GetFirstName(void) const;
+    void SetFirstName(const std::string &value);
+    StringRefType GetFirstName(void) const;
 
-    void SetMiddleName(std::string value);
-    std::string GetMiddleName(void) const;
+    void SetMiddleName(const std::string &value);
+    StringRefType GetMiddleName(void) const;
 
-    void SetSuffix(std::string value);
-    std::string GetSuffix(void) const;
+    void SetSuffix(const std::string &value);
+    StringRefType GetSuffix(void) const;
 
-    void SetAlterName(std::string value);
-    std::string GetAlterName(void) const;
+    void SetAlterName(const std::string &value);
+    StringRefType GetAlterName(void) const;
 
-    void SetLastNamePronun(std::string value);
-    std::string GetLastNamePronun(void) const;
+    void SetLastNamePronun(const std::string &value);
+    StringRefType GetLastNamePronun(void) const;
 
-    void SetFirstNamePronun(std::string value);
-    std::string GetFirstNamePronun(void) const;
+    void SetFirstNamePronun(const std::string &value);
+    StringRefType GetFirstNamePronun(void) const;
 
-    void SetCompany(std::string value);
-    std::string GetCompany(void) const;
+    void SetCompany(const std::string &value);
+    StringRefType GetCompany(void) const;
+    StringHandleType GetCompanyHandle(void) const;
 
-    void SetCompanyPronun(std::string value);
-    std::string GetCompanyPronun(void) const;
+    void SetCompanyPronun(const std::string &value);
+    StringRefType GetCompanyPronun(void) const;
 
-    void SetDepartment(std::string value);
-    std::string GetDepartment(void) const;
+    void SetDepartment(const std::string &value);
+    StringRefType GetDepartment(void) const;
+    StringHandleType GetDepartmentHandle(void) const;
 
-    void SetJobTitle(std::string value);
-    std::string GetJobTitle(void) const;
+    void SetJobTitle(const std::string &value);
+    StringRefType GetJobTitle(void) const;
 
-    void SetWorkPhone(std::string value);
-    std::string GetWorkPhone(void) const;
+    void SetWorkPhone(const std::string &value);
+    StringRefType GetWorkPhone(void) const;
 
-    void SetWorkFax(std::string value);
-    std::string GetWorkFax(void) const;
+    void SetWorkFax(const std::string &value);
+    StringRefType GetWorkFax(void) const;
 
-    void SetWorkMobile(std::string value);
-    std::string GetWorkMobile(void) const;
+    void SetWorkMobile(const std::string &value);
+    StringRefType GetWorkMobile(void) const;
 
-    void SetWorkState(std::string value);
-    std::string GetWorkState(void) const;
+    void SetWorkState(const std::string &value);
+    StringRefType GetWorkState(void) const;
+    StringHandleType GetWorkStateHandle(void) const;
 
-    void SetWorkCity(std::string value);
-    std::string GetWorkCity(void) const;
+    void SetWorkCity(const std::string &value);
+    StringRefType GetWorkCity(void) const;
+    StringHandleType GetWorkCityHandle(void) const;
 
-    void SetWorkStreet(std::string value);
-    std::string GetWorkStreet(void) const;
+    void SetWorkStreet(const std::string &value);
+    StringRefType GetWorkStreet(void) const;
 
-    void SetWorkZip(std::string value);
-    std::string GetWorkZip(void) const;
+    void SetWorkZip(const std::string &value);
+    StringRefType GetWorkZip(void) const;
 
-    void SetWorkCountry(std::string value);
-    std::string GetWorkCountry(void) const;
+    void SetWorkCountry(const std::string &value);
+    StringRefType GetWorkCountry(void) const;
+    StringHandleType GetWorkCountryHandle(void) const;
 
-    void SetWorkWebPage(std::string value);
-    std::string GetWorkWebPage(void) const;
+    void SetWorkWebPage(const std::string &value);
+    StringRefType GetWorkWebPage(void) const;
 
-    void SetOffice(std::string value);
-    std::string GetOffice(void) const;
+    void SetOffice(const std::string &value);
+    StringRefType GetOffice(void) const;
+    StringHandleType GetOfficeHandle(void) const;
 
-    void SetProfession(std::string value);
-    std::string GetProfession(void) const;
+    void SetProfession(const std::string &value);
+    StringRefType GetProfession(void) const;
+    StringHandleType GetProfessionHandle(void) const;
 
-    void SetAssistant(std::string value);
-    std::string GetAssistant(void) const;
+    void SetAssistant(const std::string &value);
+    StringRefType GetAssistant(void) const;
 
-    void SetManager(std::string value);
-    std::string GetManager(void) const;
+    void SetManager(const std::string &value);
+    StringRefType GetManager(void) const;
 
-    void SetPager(std::string value);
-    std::string GetPager(void) const;
+    void SetPager(const std::string &value);
+    StringRefType GetPager(void) const;
 
-    void SetCellular(std::string value);
-    std::string GetCellular(void) const;
+    void SetCellular(const std::string &value);
+    StringRefType GetCellular(void) const;
 
-    void SetHomePhone(std::string value);
-    std::string GetHomePhone(void) const;
+    void SetHomePhone(const std::string &value);
+    StringRefType GetHomePhone(void) const;
 
-    void SetHomeFax(std::string value);
-    std::string GetHomeFax(void) const;
+    void SetHomeFax(const std::string &value);
+    StringRefType GetHomeFax(void) const;
 
-    void SetHomeState(std::string value);
-    std::string GetHomeState(void) const;
+    void SetHomeState(const std::string &value);
+    StringRefType GetHomeState(void) const;
+    StringHandleType GetHomeStateHandle(void) const;
 
-    void SetHomeCity(std::string value);
-    std::string GetHomeCity(void) const;
+    void SetHomeCity(const std::string &value);
+    StringRefType GetHomeCity(void) const;
+    StringHandleType GetHomeCityHandle(void) const;
 
-    void SetHomeStreet(std::string value);
-    std::string GetHomeStreet(void) const;
+    void SetHomeStreet(const std::string &value);
+    StringRefType GetHomeStreet(void) const;
 
-    void SetHomeZip(std::string value);
-    std::string GetHomeZip(void) const;
+    void SetHomeZip(const std::string &value);
+    StringRefType GetHomeZip(void) const;
 
-    void SetHomeCountry(std::string value);
-    std::string GetHomeCountry(void) const;
+    void SetHomeCountry(const std::string &value);
+    StringRefType GetHomeCountry(void) const;
+    StringHandleType GetHomeCountryHandle(void) const;
 
-    void SetHomeWebPage(std::string value);
-    std::string GetHomeWebPage(void) const;
+    void SetHomeWebPage(const std::string &value);
+    StringRefType GetHomeWebPage(void) const;
 
-    void SetDefaultEmail(std::string value);
-    std::string GetDefaultEmail(void) const;
+    void SetDefaultEmail(const std::string &value);
+    StringRefType GetDefaultEmail(void) const;
 
-    void SetEmails(std::string value);
-    std::string GetEmails(void) const;
+    void SetEmails(const std::string &value);
+    StringRefType GetEmails(void) const;
 
-    void SetSpouse(std::string value);
-    std::string GetSpouse(void) const;
+    void SetSpouse(const std::string &value);
+    StringRefType GetSpouse(void) const;
 
-    void SetGender(std::string value);
-    std::string GetGender(void) const;
+    void SetGender(const std::string &value);
+    StringRefType GetGender(void) const;
+    StringHandleType GetGenderHandle(void) const;
 
-    void SetBirthday(std::string value);
-    std::string GetBirthday(void) const;
+    void SetBirthday(const std::string &value);
+    StringRefType GetBirthday(void) const;
 
-    void SetAnniversary(std::string value);
-    std::string GetAnniversary(void) const;
+    void SetAnniversary(const std::string &value);
+    StringRefType GetAnniversary(void) const;
 
-    void SetNickname(std::string value);
-    std::string GetNickname(void) const;
+    void SetNickname(const std::string &value);
+    StringRefType GetNickname(void) const;
 
-    void SetChildren(std::string value);
-    std::string GetChildren(void) const;
+    void SetChildren(const std::string &value);
+    StringRefType GetChildren(void) const;
 
-    void SetMemo(std::string value);
-    std::string GetMemo(void) const;
+    void SetMemo(const std::string &value);
+    StringRefType GetMemo(void) const;
 
-    void SetGroup(std::string value);
-    std::string GetGroup(void) const;
+    void SetGroup(const std::string &value);
+    StringRefType GetGroup(void) const;
+    StringHandleType GetGroupHandle(void) const;
 
     // Non Access Functions.
+    void Swap(AddrBookItemType &other);
+    uint64_t ContentHash(void) const;
+    uint64_t Fingerprint(void) const;
+    uint64_t MatchKey(void) const;
+
+    // The descriptors of the fields of a Address Book item, in the order their
+    // content is hashed and serialized.
+    static const FieldDescType<AddrBookItemType> fieldDescs[];
+    static const unsigned int numFieldDescs;
 
  private:
-    std::string category;
-    std::string fullName;
-    std::string fullNamePronun;
-    std::string termOfRespect;
-    std::string lastName;
-    std::string firstName;
-    std::string middleName;
-    std::string suffix;
-    std::string alterName;
-    std::string lastNamePronun;
-    std::string firstNamePronun;
-    std::string company;
-    std::string companyPronun;
-    std::string department;
-    std::string jobTitle;
-    std::string workPhone;
-    std::string workFax;
-    std::string workMobile;
-    std::string workState;
-    std::string workCity;
-    std::string workStreet;
-    std::string workZip;
-    std::string workCountry;
-    std::string workWebPage;
-    std::string office;
-    std::string profession;
-    std::string assistant;
-    std::string manager;
-    std::string pager;
-    std::string cellular;
-    std::string homePhone;
-    std::string homeFax;
-    std::string homeState;
-    std::string homeCity;
-    std::string homeStreet;
-    std::string homeZip;
-    std::string homeCountry;
-    std::string homeWebPage;
-    std::string defaultEmail;
-    std::string emails;
-    std::string spouse;
-    std::string gender;
-    std::string birthday;
-    std::string anniversary;
-    std::string nickname;
-    std::string children;
-    std::string memo;
-    std::string group;
+    // The indices of the string fields within the string block.
+    enum {
+        STR_FULL_NAME = 0,
+        STR_FULL_NAME_PRONUN,
+        STR_TERM_OF_RESPECT,
+        STR_LAST_NAME,
+        STR_FIRST_NAME,
+        STR_MIDDLE_NAME,
+        STR_SUFFIX,
+        STR_ALTER_NAME,
+        STR_LAST_NAME_PRONUN,
+        STR_FIRST_NAME_PRONUN,
+        STR_COMPANY_PRONUN,
+        STR_JOB_TITLE,
+        STR_WORK_PHONE,
+        STR_WORK_FAX,
+        STR_WORK_MOBILE,
+        STR_WORK_STREET,
+        STR_WORK_ZIP,
+        STR_WORK_WEB_PAGE,
+        STR_ASSISTANT,
+        STR_MANAGER,
+        STR_PAGER,
+        STR_CELLULAR,
+        STR_HOME_PHONE,
+        STR_HOME_FAX,
+        STR_HOME_STREET,
+        STR_HOME_ZIP,
+        STR_HOME_WEB_PAGE,
+        STR_DEFAULT_EMAIL,
+        STR_EMAILS,
+        STR_SPOUSE,
+        STR_BIRTHDAY,
+        STR_ANNIVERSARY,
+        STR_NICKNAME,
+        STR_CHILDREN,
+        STR_MEMO,
+        NUM_STRINGS
+    };
+
+    // Every field of an Address Book item is a string, those which are not
+    // interned are held together in a single block rather than in a
+    // std::string each.
+    StringBlockType<NUM_STRINGS> strings;
+
+    // The highly repetitive fields are interned in the pool of the session
+    // instead, so items sharing a value only hold its handle.
+    StringHandleType categoryHandle;
+    StringHandleType companyHandle;
+    StringHandleType departmentHandle;
+    StringHandleType workStateHandle;
+    StringHandleType workCityHandle;
+    StringHandleType workCountryHandle;
+    StringHandleType officeHandle;
+    StringHandleType professionHandle;
+    StringHandleType homeStateHandle;
+    StringHandleType homeCityHandle;
+    StringHandleType homeCountryHandle;
+    StringHandleType genderHandle;
+    StringHandleType groupHandle;
 };
 
+// Let the standard containers and algorithms swap Address Book items without
+// copying them.
+namespace std {
+    template <>
+    inline void swap(AddrBookItemType &a, AddrBookItemType &b) {
+        a.Swap(b);
+    }
+}
+
 #endif
@@ -29,6 +29,90 @@
 
 #include "CalendarItemType.hh"
 
+#include <algorithm>
+#include <limits>
+
+// The repeat type of an item which does not repeat.
+#define REPEAT_NONE 0xff
+
+// The number of seconds in a day.
+#define SECS_PER_DAY 86400
+
+/**
+ * Set the repeat end date if it is set.
+ *
+ * The accessor used to read the repeat end date from the Zaurus. The Zaurus
+ * always sends a repeat end date, but it only means something when the
+ * repeat end date setting says it is set, so it is dropped otherwise.
+ * @param item Reference to the item to set the repeat end date in.
+ * @param value The repeat end date, in seconds since Epoch.
+ */
+static void SetRepeatEndDateIfSet(CalendarItemType &item, uint64_t value) {
+    if (item.GetRepeatEndDateSetting() != 0)
+        item.SetRepeatEndDate((time_t)value);
+}
+
+// The descriptors of the fields of a Calendar item. This is the one place
+// the fields of a Calendar item are mapped to the parameters of the Zaurus.
+// The Zaurus sends the start and end times in the TIM1 and TIM2 parameters
+// but takes them back in TLM1 and TLM2, hence each has one descriptor for
+// each direction.
+const FieldDescType<CalendarItemType> CalendarItemType::fieldDescs[] = {
+    BASE_FIELD_DESCS(CalendarItemType),
+    { "CTGR", DATA_ID_BARRAY, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_POOLED_ACCESS(CalendarItemType, Category) },
+    { "DSRP", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED | FIELD_MATCH,
+      FIELD_STRING_ACCESS(CalendarItemType, Description) },
+    { "PLCE", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(CalendarItemType, Location) },
+    { "MEM1", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(CalendarItemType, Notes) },
+    { "TLM1", DATA_ID_TIME, FIELD_CONTENT | FIELD_TO_ZAURUS | FIELD_MATCH,
+      FIELD_NUMBER_ACCESS(CalendarItemType, time_t, StartTime) },
+    { "TLM2", DATA_ID_TIME, FIELD_CONTENT | FIELD_TO_ZAURUS,
+      FIELD_NUMBER_ACCESS(CalendarItemType, time_t, EndTime) },
+    { "ADAY", DATA_ID_UCHAR, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_NUMBER_ACCESS(CalendarItemType, unsigned char, ScheduleType) },
+    { "ARON", DATA_ID_UCHAR, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_NUMBER_ACCESS(CalendarItemType, unsigned char, Alarm) },
+    { "ARSD", DATA_ID_UCHAR, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_NUMBER_ACCESS(CalendarItemType, unsigned char, AlarmSetting) },
+    { "ARMN", DATA_ID_WORD, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_NUMBER_ACCESS(CalendarItemType, unsigned short int, AlarmTime) },
+    { "RTYP", DATA_ID_UCHAR, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_NUMBER_ACCESS(CalendarItemType, unsigned char, RepeatType) },
+    { "RFRQ", DATA_ID_WORD, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_NUMBER_ACCESS(CalendarItemType, unsigned short int, RepeatPeriod) },
+    { "RPOS", DATA_ID_WORD, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_NUMBER_ACCESS(CalendarItemType, unsigned short int,
+                          RepeatPosition) },
+    { "RDYS", DATA_ID_UCHAR, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_NUMBER_ACCESS(CalendarItemType, unsigned char, RepeatDate) },
+    { "REND", DATA_ID_UCHAR, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_NUMBER_ACCESS(CalendarItemType, unsigned char,
+                          RepeatEndDateSetting) },
+    { "REDT", DATA_ID_TIME, FIELD_CONTENT | FIELD_TO_ZAURUS,
+      FIELD_NUMBER_ACCESS(CalendarItemType, time_t, RepeatEndDate) },
+    { "ALSD", DATA_ID_TIME, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_NUMBER_ACCESS(CalendarItemType, time_t, AllDayStartDate) },
+    { "ALED", DATA_ID_TIME, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_NUMBER_ACCESS(CalendarItemType, time_t, AllDayEndDate) },
+    { "MDAY", DATA_ID_UCHAR, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_NUMBER_ACCESS(CalendarItemType, unsigned char, MultipleDaysFlag) },
+    { "TIM1", DATA_ID_TIME, FIELD_FROM_ZAURUS,
+      FIELD_NUMBER_ACCESS(CalendarItemType, time_t, StartTime) },
+    { "TIM2", DATA_ID_TIME, FIELD_FROM_ZAURUS,
+      FIELD_NUMBER_ACCESS(CalendarItemType, time_t, EndTime) },
+    { "REDT", DATA_ID_TIME, FIELD_FROM_ZAURUS,
+      &GetFieldNumber<CalendarItemType, CalendarItemType, time_t,
+                      &CalendarItemType::GetRepeatEndDate>,
+      &SetRepeatEndDateIfSet, NULL, NULL, NULL }
+};
+
+const unsigned int CalendarItemType::numFieldDescs =
+    sizeof(CalendarItemType::fieldDescs) /
+    sizeof(CalendarItemType::fieldDescs[0]);
+
 /**
  * Construct a default CalendarItemType object.
  *
@@ -36,7 +120,27 @@
  * initialization.
  */
 CalendarItemType::CalendarItemType(void) {
-
+    // The interned fields start out empty, the handle of which is zero.
+    categoryHandle = 0;
+
+    // The fixed size fields are hashed along with the rest of the content,
+    // so each of them starts out zero rather than as whatever was in memory,
+    // and an event does not repeat until it is told to.
+    startTime = 0;
+    endTime = 0;
+    repeatEndDate = 0;
+    allDayStartDate = 0;
+    allDayEndDate = 0;
+    alarmTime = 0;
+    repeatPeriod = 0;
+    repeatPosition = 0;
+    scheduleType = 0;
+    alarm = 0;
+    alarmSetting = 0;
+    repeatType = REPEAT_NONE;
+    repeatDate = 0;
+    repeatEndDateSetting = 0;
+    multipleDaysFlag = 0;
 }
 
 /**
@@ -55,18 +159,29 @@ CalendarItemType::~CalendarItemType(void) {
  * Set the category of the item.
  * @param value The value to set the category to.
  */
-void CalendarItemType::SetCategory(std::string value) {
-    category = value;
+void CalendarItemType::SetCategory(const std::string &value) {
+    categoryHandle = StringPoolType::GetSession().Intern(value);
 }
 
 /**
  * Get the category.
  *
  * Get the category of the item this object represents.
- * @return A string containing the category.
+ * @return A reference to the category.
  */
-std::string CalendarItemType::GetCategory(void) const {
-    return category;
+StringRefType CalendarItemType::GetCategory(void) const {
+    return StringPoolType::GetSession().Get(categoryHandle);
+}
+
+/**
+ * Get the handle of the category.
+ *
+ * Get the handle the category of the item this object represents is interned
+ * under in the pool of the session.
+ * @return The handle of the category.
+ */
+StringHandleType CalendarItemType::GetCategoryHandle(void) const {
+    return categoryHandle;
 }
 
 /**
@@ -75,18 +190,19 @@ std::string CalendarItemType::GetCategory(void) const {
  * Set the description of the item.
  * @param value The value to set the description to.
  */
-void CalendarItemType::SetDescription(std::string value) {
-    description = value;
+void CalendarItemType::SetDescription(const std::string &value) {
+    strings.Set(STR_DESCRIPTION, value);
 }
 
 /**
  * Get the description.
  *
  * Get the description of the item this object represents.
- * @return A string containing the description.
+ * @return A reference to the description, valid until any string field of the
+ * item is set.
  */
-std::string CalendarItemType::GetDescription(void) const {
-    return description;
+StringRefType CalendarItemType::GetDescription(void) const {
+    return strings.Get(STR_DESCRIPTION);
 }
 
 /**
@@ -95,18 +211,19 @@ std::string CalendarItemType::GetDescription(void) const {
  * Set the location of the item.
  * @param value The value to set the location to.
  */
-void CalendarItemType::SetLocation(std::string value) {
-    location = value;
+void CalendarItemType::SetLocation(const std::string &value) {
+    strings.Set(STR_LOCATION, value);
 }
 
 /**
  * Get the location.
  *
  * Get the location of the item this object represents.
- * @return A string containing the location.
+ * @return A reference to the location, valid until any string field of the
+ * item is set.
  */
-std::string CalendarItemType::GetLocation(void) const {
-    return location;
+StringRefType CalendarItemType::GetLocation(void) const {
+    return strings.Get(STR_LOCATION);
 }
 
 /**
@@ -115,18 +232,19 @@ std::string CalendarItemType::GetLocation(void) const {
  * Set the notes of the item.
  * @param value The value to set the notes to.
  */
-void CalendarItemType::SetNotes(std::string value) {
-    notes = value;
+void CalendarItemType::SetNotes(const std::string &value) {
+    strings.Set(STR_NOTES, value);
 }
 
 /**
  * Get the notes.
  *
  * Get the notes of the item this object represents.
- * @return A string containing the notes.
+ * @return A reference to the notes, valid until any string field of the item
+ * is set.
  */
-std::string CalendarItemType::GetNotes(void) const {
-    return notes;
+StringRefType CalendarItemType::GetNotes(void) const {
+    return strings.Get(STR_NOTES);
 }
 
 /**
@@ -470,3 +588,101 @@ void CalendarItemType::SetMultipleDaysFlag(unsigned char value) {
 unsigned char CalendarItemType::GetMultipleDaysFlag(void) const {
     return multipleDaysFlag;
 }
+
+/**
+ * Swap with another item.
+ *
+ * Exchange the content of the Calendar item this object represents with
+ * that of the given item, without copying any of their strings.
+ * @param other Reference to the item to swap with.
+ */
+void CalendarItemType::Swap(CalendarItemType &other) {
+    SwapBase(other);
+    strings.Swap(other.strings);
+    std::swap(startTime, other.startTime);
+    std::swap(endTime, other.endTime);
+    std::swap(repeatEndDate, other.repeatEndDate);
+    std::swap(allDayStartDate, other.allDayStartDate);
+    std::swap(allDayEndDate, other.allDayEndDate);
+    std::swap(categoryHandle, other.categoryHandle);
+    std::swap(alarmTime, other.alarmTime);
+    std::swap(repeatPeriod, other.repeatPeriod);
+    std::swap(repeatPosition, other.repeatPosition);
+    std::swap(scheduleType, other.scheduleType);
+    std::swap(alarm, other.alarm);
+    std::swap(alarmSetting, other.alarmSetting);
+    std::swap(repeatType, other.repeatType);
+    std::swap(repeatDate, other.repeatDate);
+    std::swap(repeatEndDateSetting, other.repeatEndDateSetting);
+    std::swap(multipleDaysFlag, other.multipleDaysFlag);
+}
+
+/**
+ * Get the content hash.
+ *
+ * Obtain a hash of the sync relevant content of the Calendar item this object
+ * represents. The sync ID, app ID, and times of the item are left out. Two
+ * items with equal content hashes hold the same data, so a modification
+ * from one to the other changes nothing.
+ * @return The content hash of the item.
+ */
+uint64_t CalendarItemType::ContentHash(void) const {
+    return HashFields(*this);
+}
+
+/**
+ * Get the fingerprint.
+ *
+ * Obtain a hash of the normalized content of the Calendar item this object
+ * represents. Unlike the content hash, case and white space in the text of
+ * the item are ignored, so items which were entered separately on each side
+ * with the same content have the same fingerprint.
+ * @return The fingerprint of the item.
+ */
+uint64_t CalendarItemType::Fingerprint(void) const {
+    return HashFields(*this, FIELD_CONTENT, true);
+}
+
+/**
+ * Get the match key.
+ *
+ * Obtain a hash of the normalized fields naming the Calendar item this
+ * object represents, that is its description and start time. Items which may
+ * be duplicates of each other have the same match key.
+ * @return The match key of the item.
+ */
+uint64_t CalendarItemType::MatchKey(void) const {
+    return HashFields(*this, FIELD_MATCH, true);
+}
+
+/**
+ * Get the span.
+ *
+ * Obtain the range of time the Calendar item this object represents may
+ * occupy. All day items span from the start of their first day to the end of
+ * their last. Repeating items span from their first occurrence through the
+ * end of the last one they may have, which is the latest time a time_t can
+ * hold when they repeat forever.
+ * @param spanStart Reference to store the start of the span in.
+ * @param spanEnd Reference to store the end of the span in.
+ */
+void CalendarItemType::GetSpan(time_t &spanStart, time_t &spanEnd) const {
+    if ((scheduleType == 1) && (allDayStartDate != 0)) {
+        spanStart = allDayStartDate;
+        spanEnd = std::max(allDayEndDate, allDayStartDate) + SECS_PER_DAY - 1;
+    } else {
+        spanStart = startTime;
+        spanEnd = std::max(endTime, startTime);
+    }
+
+    if (repeatType == REPEAT_NONE)
+        return;
+
+    // The repeat end date is the last day an occurrence may start on, so
+    // the span runs to the end of that day plus the length of an occurrence.
+    if (repeatEndDateSetting != 0)
+        spanEnd = std::max(spanEnd, repeatEndDate + SECS_PER_DAY - 1 +
+                           (spanEnd - spanStart));
+    else
+        spanEnd = std::numeric_limits<time_t>::max();
+}
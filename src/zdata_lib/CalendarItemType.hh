@@ -32,11 +32,12 @@
 #define CALENDARITEMTYPE_H
 
 #include "ItemType.hh"
+#include "StringBlockType.hh"
 
 #include <time.h>
 
 #include <string>
-#include <list>
+#include <vector>
 
 /**
  * @class CalendarItemType
@@ -49,23 +50,24 @@
 class CalendarItemType : public ItemType {
  public:
     // Define a type that is a list of CalendarItemTypes.
-    typedef std::list<CalendarItemType> List;
+    typedef std::vector<CalendarItemType> List;
 
     CalendarItemType(void);
     ~CalendarItemType(void);
 
     // Access functions for the below data members.
-    void SetCategory(std::string value);
-    std::string GetCategory(void) const;
+    void SetCategory(const std::string &value);
+    StringRefType GetCategory(void) const;
+    StringHandleType GetCategoryHandle(void) const;
 
-    void SetDescription(std::string value);
-    std::string GetDescription(void) const;
+    void SetDescription(const std::string &value);
+    StringRefType GetDescription(void) const;
 
-    void SetLocation(std::string value);
-    std::string GetLocation(void) const;
+    void SetLocation(const std::string &value);
+    StringRefType GetLocation(void) const;
 
-    void SetNotes(std::string value);
-    std::string GetNotes(void) const;
+    void SetNotes(const std::string &value);
+    StringRefType GetNotes(void) const;
 
     void SetStartTime(time_t epochSecs);
     time_t GetStartTime(void) const;
@@ -113,27 +115,55 @@ class CalendarItemType : public ItemType {
     unsigned char GetMultipleDaysFlag(void) const;
 
     // Non Access Functions.
+    void Swap(CalendarItemType &other);
+    uint64_t ContentHash(void) const;
+    uint64_t Fingerprint(void) const;
+    uint64_t MatchKey(void) const;
+    void GetSpan(time_t &spanStart, time_t &spanEnd) const;
+
+    // The descriptors of the fields of a Calendar item, in the order their
+    // content is hashed and serialized.
+    static const FieldDescType<CalendarItemType> fieldDescs[];
+    static const unsigned int numFieldDescs;
 
  private:
-    std::string category;
-    std::string description;
-    std::string location;
-    std::string notes;
+    // The indices of the string fields within the string block.
+    enum {
+        STR_DESCRIPTION = 0,
+        STR_LOCATION,
+        STR_NOTES,
+        NUM_STRINGS
+    };
+
+    // The string fields which are not interned are held together in a single
+    // block, and the fixed size fields follow from the widest to the
+    // narrowest so that no space is lost to padding between them.
+    StringBlockType<NUM_STRINGS> strings;
     time_t startTime;
     time_t endTime;
+    time_t repeatEndDate;
+    time_t allDayStartDate;
+    time_t allDayEndDate;
+    StringHandleType categoryHandle;
+    unsigned short int alarmTime;
+    unsigned short int repeatPeriod;
+    unsigned short int repeatPosition;
     unsigned char scheduleType;
     unsigned char alarm;
     unsigned char alarmSetting;
-    unsigned short int alarmTime;
     unsigned char repeatType;
-    unsigned short int repeatPeriod;
-    unsigned short int repeatPosition;
     unsigned char repeatDate;
     unsigned char repeatEndDateSetting;
-    time_t repeatEndDate;
-    time_t allDayStartDate;
-    time_t allDayEndDate;
     unsigned char multipleDaysFlag;
 };
 
+// Let the standard containers and algorithms swap Calendar items without
+// copying them.
+namespace std {
+    template <>
+    inline void swap(CalendarItemType &a, CalendarItemType &b) {
+        a.Swap(b);
+    }
+}
+
 #endif
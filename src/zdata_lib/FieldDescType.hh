@@ -0,0 +1,286 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file FieldDescType.hh
+ * @brief A specifications file for the descriptors of the fields of items.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for the descriptors of the fields of each type of
+ * item, along with the generic functions driven by them. Each type of item
+ * has a static table of these descriptors, so that comparing, hashing,
+ * serializing and transferring items does not have to be written out field
+ * by field for each type of item.
+ */
+
+#ifndef FIELDDESCTYPE_H
+#define FIELDDESCTYPE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "StringPoolType.hh"
+#include "StringRefType.hh"
+
+// Define all the different item parameter type identifiers, as used by the
+// Zaurus to describe each parameter of an item.
+#define DATA_ID_BIT 0x06
+#define DATA_ID_TIME 0x04
+#define DATA_ID_ULONG 0x12
+#define DATA_ID_BARRAY 0x0c
+#define DATA_ID_UTF8 0x11
+#define DATA_ID_UCHAR 0x0b
+#define DATA_ID_WORD 0x08
+
+// Define the flags describing how a field is used. A field which is part of
+// the content is compared, hashed and serialized. A field the Zaurus has is
+// read from the Zaurus, written to the Zaurus or both. A field common to all
+// items is part of the base of the item. A field which names the item, such
+// as its title and time, is part of the key duplicate items are matched on.
+#define FIELD_CONTENT 0x01
+#define FIELD_FROM_ZAURUS 0x02
+#define FIELD_TO_ZAURUS 0x04
+#define FIELD_SYNCED (FIELD_FROM_ZAURUS | FIELD_TO_ZAURUS)
+#define FIELD_BASE 0x08
+#define FIELD_MATCH 0x10
+
+/**
+ * @class FieldDescType
+ * @brief A type describing a field of an item.
+ *
+ * The FieldDescType is a structure which describes a single field of an
+ * item: the abbreviation of the parameter the Zaurus stores it in, the type
+ * identifier of that parameter, how the field is used and the functions used
+ * to access it. Number fields are accessed through the number functions and
+ * string fields through the string functions, the other pair is NULL. A
+ * string field interned in the pool of the session also has a function
+ * obtaining its handle, so it may be compared without touching the string.
+ */
+template <class ItemT>
+struct FieldDescType {
+    const char *pAbrev;
+    unsigned char typeID;
+    unsigned char flags;
+    uint64_t (*pGetNumber)(const ItemT &item);
+    void (*pSetNumber)(ItemT &item, uint64_t value);
+    StringRefType (*pGetString)(const ItemT &item);
+    void (*pSetString)(ItemT &item, const std::string &value);
+    StringHandleType (*pGetHandle)(const ItemT &item);
+};
+
+/**
+ * Get a number field.
+ *
+ * The accessor used by a field descriptor to obtain a number field of an
+ * item through the given getter.
+ * @param item Reference to the item to obtain the field from.
+ * @return The value of the field.
+ */
+template <class ItemT, class OwnerT, class ValT,
+          ValT (OwnerT::*pGet)(void) const>
+uint64_t GetFieldNumber(const ItemT &item) {
+    return (uint64_t)(item.*pGet)();
+}
+
+/**
+ * Set a number field.
+ *
+ * The accessor used by a field descriptor to set a number field of an item
+ * through the given setter.
+ * @param item Reference to the item to set the field in.
+ * @param value The value to set the field to.
+ */
+template <class ItemT, class OwnerT, class ValT, void (OwnerT::*pSet)(ValT)>
+void SetFieldNumber(ItemT &item, uint64_t value) {
+    (item.*pSet)((ValT)value);
+}
+
+/**
+ * Get a string field.
+ *
+ * The accessor used by a field descriptor to obtain a string field of an
+ * item through the given getter.
+ * @param item Reference to the item to obtain the field from.
+ * @return Reference to the value of the field.
+ */
+template <class ItemT, class OwnerT,
+          StringRefType (OwnerT::*pGet)(void) const>
+StringRefType GetFieldString(const ItemT &item) {
+    return (item.*pGet)();
+}
+
+/**
+ * Set a string field.
+ *
+ * The accessor used by a field descriptor to set a string field of an item
+ * through the given setter.
+ * @param item Reference to the item to set the field in.
+ * @param value The value to set the field to.
+ */
+template <class ItemT, class OwnerT,
+          void (OwnerT::*pSet)(const std::string &)>
+void SetFieldString(ItemT &item, const std::string &value) {
+    (item.*pSet)(value);
+}
+
+/**
+ * Get the handle of a string field.
+ *
+ * The accessor used by a field descriptor to obtain the handle of an
+ * interned string field of an item through the given getter.
+ * @param item Reference to the item to obtain the handle from.
+ * @return The handle of the field.
+ */
+template <class ItemT, class OwnerT,
+          StringHandleType (OwnerT::*pGet)(void) const>
+StringHandleType GetFieldHandle(const ItemT &item) {
+    return (item.*pGet)();
+}
+
+// The following macros fill in the accessors of a field descriptor given the
+// type of item, the class declaring the getter and setter, the type of the
+// value and the name of the field the getter and setter are named after.
+// The shorter forms are for fields declared by the type of item itself. The
+// pooled form is for string fields which also have a handle getter.
+#define FIELD_OWNER_NUMBER_ACCESS(ItemT, OwnerT, ValT, Name) \
+    &GetFieldNumber<ItemT, OwnerT, ValT, &OwnerT::Get##Name>, \
+    &SetFieldNumber<ItemT, OwnerT, ValT, &OwnerT::Set##Name>, \
+    NULL, NULL, NULL
+#define FIELD_NUMBER_ACCESS(ItemT, ValT, Name) \
+    FIELD_OWNER_NUMBER_ACCESS(ItemT, ItemT, ValT, Name)
+#define FIELD_STRING_ACCESS(ItemT, Name) \
+    NULL, NULL, &GetFieldString<ItemT, ItemT, &ItemT::Get##Name>, \
+    &SetFieldString<ItemT, ItemT, &ItemT::Set##Name>, NULL
+#define FIELD_POOLED_ACCESS(ItemT, Name) \
+    NULL, NULL, &GetFieldString<ItemT, ItemT, &ItemT::Get##Name>, \
+    &SetFieldString<ItemT, ItemT, &ItemT::Set##Name>, \
+    &GetFieldHandle<ItemT, ItemT, &ItemT::Get##Name##Handle>
+
+// The descriptors of the fields common to all items, which start the table
+// of every type of item.
+#define BASE_FIELD_DESCS(ItemT) \
+    { "ATTR", DATA_ID_BIT, FIELD_BASE | FIELD_CONTENT | FIELD_SYNCED, \
+      FIELD_OWNER_NUMBER_ACCESS(ItemT, ItemType, unsigned char, Attribute) }, \
+    { "CTTM", DATA_ID_TIME, FIELD_BASE | FIELD_SYNCED, \
+      FIELD_OWNER_NUMBER_ACCESS(ItemT, ItemType, time_t, CreatedTime) }, \
+    { "MDTM", DATA_ID_TIME, FIELD_BASE | FIELD_SYNCED, \
+      FIELD_OWNER_NUMBER_ACCESS(ItemT, ItemType, time_t, ModifiedTime) }, \
+    { "SYID", DATA_ID_ULONG, FIELD_BASE | FIELD_SYNCED, \
+      FIELD_OWNER_NUMBER_ACCESS(ItemT, ItemType, unsigned long int, SyncID) }
+
+/**
+ * Find a field descriptor.
+ *
+ * Find the descriptor of the field of the given type of item stored in the
+ * Zaurus parameter with the given abbreviation.
+ * @param paramAbrev The abbreviation of the parameter.
+ * @param flag The flag the field must have, FIELD_FROM_ZAURUS when reading
+ * the parameter or FIELD_TO_ZAURUS when writing it.
+ * @return A pointer to the descriptor found, or NULL if there is none.
+ */
+template <class ItemT>
+const FieldDescType<ItemT> *FindFieldDesc(const std::string &paramAbrev,
+                                          unsigned char flag) {
+    unsigned int i;
+
+    for (i = 0; i < ItemT::numFieldDescs; i++) {
+        if ((ItemT::fieldDescs[i].flags & flag) &&
+            (paramAbrev == ItemT::fieldDescs[i].pAbrev))
+            return &ItemT::fieldDescs[i];
+    }
+
+    return NULL;
+}
+
+/**
+ * Compare a field.
+ *
+ * Determine if the given field holds the same value in both items. Interned
+ * fields are compared by their handles.
+ * @param desc Reference to the descriptor of the field to compare.
+ * @param a Reference to the first item.
+ * @param b Reference to the second item.
+ * @return A boolean value representing true (equal) or false (differ).
+ */
+template <class ItemT>
+bool FieldEqual(const FieldDescType<ItemT> &desc, const ItemT &a,
+                const ItemT &b) {
+    if (desc.pGetNumber)
+        return (desc.pGetNumber(a) == desc.pGetNumber(b));
+
+    if (desc.pGetHandle)
+        return (desc.pGetHandle(a) == desc.pGetHandle(b));
+
+    return (desc.pGetString(a) == desc.pGetString(b));
+}
+
+/**
+ * Compare the content of items.
+ *
+ * Determine if two items hold the same content. The sync ID, app ID, and
+ * times are left out, just as they are from the content hash.
+ * @param a Reference to the first item.
+ * @param b Reference to the second item.
+ * @return A boolean value representing true (equal) or false (differ).
+ */
+template <class ItemT>
+bool FieldsEqual(const ItemT &a, const ItemT &b) {
+    unsigned int i;
+
+    for (i = 0; i < ItemT::numFieldDescs; i++) {
+        if ((ItemT::fieldDescs[i].flags & FIELD_CONTENT) &&
+            !FieldEqual(ItemT::fieldDescs[i], a, b))
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * Diff the content of items.
+ *
+ * Find the fields of the content which differ between two items.
+ * @param a Reference to the first item.
+ * @param b Reference to the second item.
+ * @param diffList Reference to a vector to add the descriptors of the
+ * fields which differ to.
+ * @return The number of fields which differ, hence zero if none do.
+ */
+template <class ItemT>
+unsigned int DiffFields(const ItemT &a, const ItemT &b,
+                        std::vector<const FieldDescType<ItemT> *> &diffList) {
+    unsigned int i;
+    unsigned int numDiffs = 0;
+
+    for (i = 0; i < ItemT::numFieldDescs; i++) {
+        if ((ItemT::fieldDescs[i].flags & FIELD_CONTENT) &&
+            !FieldEqual(ItemT::fieldDescs[i], a, b)) {
+            diffList.push_back(&ItemT::fieldDescs[i]);
+            numDiffs++;
+        }
+    }
+
+    return numDiffs;
+}
+
+#endif
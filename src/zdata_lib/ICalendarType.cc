@@ -0,0 +1,1299 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file ICalendarType.cc
+ * @brief An implementation file for reading and writing iCalendar data.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for the classes existing to convert Calendar and
+ * Todo items to and from iCalendar events and to dos, so that calendars
+ * may be imported and exported in bulk.
+ */
+
+#include "ICalendarType.hh"
+#include "RecurrenceType.hh"
+#include "TextScanType.hh"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+// The size of the chunks a file is read in, and the amount of output
+// buffered before it is written to a file.
+#define ICAL_CHUNK_SIZE 65536
+
+// The most occurrences a repeat rule with a count is walked through to
+// find its last occurrence.
+#define ICAL_MAX_COUNT 10000
+
+// The repeat position of a Monthly Day item in the last week of the month.
+#define ICAL_LAST_WEEK 5
+
+// The schedule type of an all day item.
+#define ICAL_SCHEDULE_ALL_DAY 1
+
+// The number of seconds in a day.
+#define SECS_PER_DAY 86400
+
+// The names of the weekdays in a repeat rule, from Monday to match the bits
+// of the repeat date.
+static const char *weekDayNames[] = {
+    "MO", "TU", "WE", "TH", "FR", "SA", "SU"
+};
+
+/**
+ * Parse a number.
+ *
+ * Parse the unsigned decimal number at the start of the given value.
+ * @param value The value to parse.
+ * @return The number, zero if the value does not start with one.
+ */
+static unsigned long int ParseNumber(const StringRefType &value) {
+    unsigned long int number = 0;
+    std::string::size_type i;
+
+    for (i = 0; (i < value.size()) && (value[i] >= '0') &&
+             (value[i] <= '9'); i++)
+        number = number * 10 + (value[i] - '0');
+
+    return number;
+}
+
+/**
+ * Parse digits.
+ *
+ * Parse the given number of decimal digits at the given position of a
+ * value.
+ * @param value The value to parse.
+ * @param pos The position of the first digit.
+ * @param count The number of digits.
+ * @param number Reference to store the number in.
+ * @return A boolean value representing if the digits were all there.
+ */
+static bool ParseDigits(const StringRefType &value,
+                        std::string::size_type pos, unsigned int count,
+                        int &number) {
+    unsigned int i;
+
+    if (pos + count > value.size())
+        return false;
+
+    number = 0;
+    for (i = 0; i < count; i++) {
+        if ((value[pos + i] < '0') || (value[pos + i] > '9'))
+            return false;
+        number = number * 10 + (value[pos + i] - '0');
+    }
+
+    return true;
+}
+
+/**
+ * Parse a time.
+ *
+ * Parse an iCalendar DATE or DATE-TIME value. A date is taken as the local
+ * midnight starting it, and a date and time as a local time unless it is
+ * in UTC.
+ * @param value The value to parse.
+ * @param when Reference to store the time in.
+ * @param isDate Reference to store whether the value is a date in.
+ * @return A boolean value representing if the value is a valid time.
+ */
+static bool ParseTime(const StringRefType &value, time_t &when,
+                      bool &isDate) {
+    struct tm timeTm;
+    int year, month, day;
+
+    if (!ParseDigits(value, 0, 4, year) || !ParseDigits(value, 4, 2, month) ||
+        !ParseDigits(value, 6, 2, day))
+        return false;
+
+    memset(&timeTm, 0, sizeof(timeTm));
+    timeTm.tm_year = year - 1900;
+    timeTm.tm_mon = month - 1;
+    timeTm.tm_mday = day;
+    timeTm.tm_isdst = -1;
+
+    isDate = ((value.size() < 9) || (value[8] != 'T'));
+    if (!isDate) {
+        if (!ParseDigits(value, 9, 2, timeTm.tm_hour) ||
+            !ParseDigits(value, 11, 2, timeTm.tm_min) ||
+            !ParseDigits(value, 13, 2, timeTm.tm_sec))
+            return false;
+        if ((value.size() > 15) && (value[15] == 'Z')) {
+            when = timegm(&timeTm);
+            return true;
+        }
+    }
+
+    when = mktime(&timeTm);
+    return (when != (time_t)-1);
+}
+
+/**
+ * Parse a duration.
+ *
+ * Parse an iCalendar DURATION value, such as -PT15M or P1DT2H.
+ * @param value The value to parse.
+ * @param secs Reference to store the signed length in seconds in.
+ * @return A boolean value representing if the value is a valid duration.
+ */
+static bool ParseDuration(const StringRefType &value, long int &secs) {
+    std::string::size_type i = 0;
+    long int total = 0;
+    long int number = 0;
+    long int sign = 1;
+    char ch;
+
+    if ((i < value.size()) && ((value[i] == '-') || (value[i] == '+'))) {
+        sign = (value[i] == '-') ? -1 : 1;
+        i++;
+    }
+    if ((i >= value.size()) || ((value[i] != 'P') && (value[i] != 'p')))
+        return false;
+
+    for (i++; i < value.size(); i++) {
+        ch = value[i];
+        if ((ch >= '0') && (ch <= '9')) {
+            number = number * 10 + (ch - '0');
+            continue;
+        }
+
+        switch (ch) {
+        case 'T':
+        case 't':
+            continue;
+        case 'W':
+        case 'w':
+            total += number * 7 * SECS_PER_DAY;
+            break;
+        case 'D':
+        case 'd':
+            total += number * SECS_PER_DAY;
+            break;
+        case 'H':
+        case 'h':
+            total += number * 3600;
+            break;
+        case 'M':
+        case 'm':
+            total += number * 60;
+            break;
+        case 'S':
+        case 's':
+            total += number;
+            break;
+        default:
+            return false;
+        }
+        number = 0;
+    }
+
+    secs = sign * total;
+    return true;
+}
+
+/**
+ * Move a local date.
+ *
+ * Get the local midnight starting the day the given number of days after
+ * the day of the given time.
+ * @param when The time to move from.
+ * @param numDays The number of days to move, negative to move back.
+ * @return The local midnight of the day moved to.
+ */
+static time_t AddLocalDays(time_t when, int numDays) {
+    struct tm localTm;
+
+    if (localtime_r(&when, &localTm) == NULL)
+        return when + (time_t)numDays * SECS_PER_DAY;
+
+    localTm.tm_mday += numDays;
+    localTm.tm_hour = 0;
+    localTm.tm_min = 0;
+    localTm.tm_sec = 0;
+    localTm.tm_isdst = -1;
+
+    return mktime(&localTm);
+}
+
+/**
+ * Check if two times are on the same day.
+ *
+ * Check if the given times fall on the same local day.
+ * @param first The first time.
+ * @param second The second time.
+ * @return A boolean value representing if they are on the same day.
+ */
+static bool IsSameLocalDay(time_t first, time_t second) {
+    struct tm firstTm, secondTm;
+
+    if ((localtime_r(&first, &firstTm) == NULL) ||
+        (localtime_r(&second, &secondTm) == NULL))
+        return true;
+
+    return ((firstTm.tm_year == secondTm.tm_year) &&
+            (firstTm.tm_yday == secondTm.tm_yday));
+}
+
+/**
+ * Construct a default ICalendarReaderType object.
+ *
+ * Construct an ICalendarReaderType object with nothing to read, see Open().
+ */
+ICalendarReaderType::ICalendarReaderType(void) {
+    pData = NULL;
+    dataPos = 0;
+    dataLen = 0;
+    fd = -1;
+    isDone = true;
+    readFailed = false;
+}
+
+/**
+ * Construct an ICalendarReaderType object for a buffer.
+ *
+ * Construct an ICalendarReaderType object reading the iCalendar data in
+ * the given buffer, which has to stay valid while the reader is used.
+ * @param pData Pointer to the characters of the data.
+ * @param size The number of characters.
+ */
+ICalendarReaderType::ICalendarReaderType(const char *pData, size_t size) {
+    this->pData = pData;
+    dataPos = 0;
+    dataLen = size;
+    fd = -1;
+    isDone = true;
+    readFailed = false;
+}
+
+/**
+ * Destruct the ICalendarReaderType object.
+ *
+ * Destruct the ICalendarReaderType object by closing the file it reads, if
+ * any.
+ */
+ICalendarReaderType::~ICalendarReaderType(void) {
+    Close();
+}
+
+/**
+ * Open a file.
+ *
+ * Open the file at the given path to be read a chunk at a time.
+ * @param filePath The path of the file.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully opened the file.
+ * @retval 1 Failed to open the file.
+ */
+int ICalendarReaderType::Open(const std::string &filePath) {
+    Close();
+
+    fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return 1;
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    chunk.resize(ICAL_CHUNK_SIZE);
+    pData = &chunk[0];
+    dataPos = 0;
+    dataLen = 0;
+    isDone = false;
+    readFailed = false;
+
+    return 0;
+}
+
+/**
+ * Close the file.
+ *
+ * Close the file being read, if any, leaving nothing to read.
+ */
+void ICalendarReaderType::Close(void) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+
+    dataPos = 0;
+    dataLen = 0;
+    isDone = true;
+}
+
+/**
+ * Read the next component.
+ *
+ * Read the next VEVENT or VTODO component into the given Calendar or Todo
+ * item, replacing all of its fields.
+ * @param event Reference to the item to read an event into.
+ * @param todo Reference to the item to read a to do into.
+ * @param component Reference to store which of them was read in, either
+ * ICAL_COMPONENT_EVENT or ICAL_COMPONENT_TODO.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully read a component.
+ * @retval 1 There are no more components.
+ * @retval 2 The last component ends before its END line.
+ * @retval 3 Failed to read the file.
+ */
+int ICalendarReaderType::Next(CalendarItemType &event, TodoItemType &todo,
+                              unsigned int &component) {
+    struct sProperty prop;
+    unsigned int skipDepth = 0;
+    bool inAlarm = false;
+    bool isBegin, isEnd;
+
+    component = 0;
+    while (NextLine()) {
+        if (!SplitLine(prop))
+            continue;
+
+        isBegin = TextScanType::EqualsNoCase(prop.name, "BEGIN");
+        isEnd = TextScanType::EqualsNoCase(prop.name, "END");
+
+        // I skip the components nested in an event or to do which are not
+        // understood, and any alarms after the first, along with their own
+        // nested components.
+        if (skipDepth > 0) {
+            if (isBegin)
+                skipDepth++;
+            else if (isEnd)
+                skipDepth--;
+            continue;
+        }
+
+        if (component == 0) {
+            if (isBegin && TextScanType::EqualsNoCase(prop.value, "VEVENT")) {
+                event = CalendarItemType();
+                startTime = 0;
+                endTime = 0;
+                duration = 0;
+                hasEnd = false;
+                hasDuration = false;
+                isAllDay = false;
+                hasAlarm = false;
+                alarmOffset = 0;
+                alarmTime = 0;
+                isAlarmTime = false;
+                isAudioAlarm = true;
+                repeatType = REPEAT_NONE;
+                repeatPeriod = 1;
+                repeatPosition = 0;
+                repeatDays = 0;
+                repeatUntil = 0;
+                repeatCount = 0;
+                component = ICAL_COMPONENT_EVENT;
+            } else if (isBegin &&
+                       TextScanType::EqualsNoCase(prop.value, "VTODO")) {
+                todo = TodoItemType();
+                todo.SetStartDate(0);
+                todo.SetDueDate(0);
+                todo.SetCompletedDate(0);
+                todo.SetProgressStatus(0);
+                todo.SetPriority(0);
+                component = ICAL_COMPONENT_TODO;
+            }
+            continue;
+        }
+
+        if (isBegin) {
+            if ((component == ICAL_COMPONENT_EVENT) && !inAlarm && !hasAlarm &&
+                TextScanType::EqualsNoCase(prop.value, "VALARM")) {
+                inAlarm = true;
+                hasAlarm = true;
+            } else {
+                skipDepth = 1;
+            }
+            continue;
+        }
+
+        if (isEnd) {
+            if (inAlarm) {
+                inAlarm = false;
+                continue;
+            }
+            if (component == ICAL_COMPONENT_EVENT)
+                FinishEvent(event);
+            return 0;
+        }
+
+        if (prop.binary)
+            continue;
+
+        if (inAlarm)
+            ApplyAlarm(prop);
+        else if (component == ICAL_COMPONENT_EVENT)
+            ApplyEvent(prop, event);
+        else
+            ApplyTodo(prop, todo);
+    }
+
+    if (readFailed)
+        return 3;
+
+    return (component != 0) ? 2 : 1;
+}
+
+/**
+ * Read a file.
+ *
+ * Read every event and to do of the iCalendar file at the given path,
+ * adding a Calendar item for each event and a Todo item for each to do to
+ * the end of the given lists.
+ * @param filePath The path of the file.
+ * @param eventList Reference to the list to add the Calendar items to.
+ * @param todoList Reference to the list to add the Todo items to.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully read the file.
+ * @retval 1 Failed to open the file.
+ * @retval 2 Failed to read the file, the components before the failure
+ * were read.
+ * @retval 3 The last component of the file ends before its END line, the
+ * components before it were read.
+ */
+int ICalendarReaderType::ReadFile(const std::string &filePath,
+                                  CalendarItemType::List &eventList,
+                                  TodoItemType::List &todoList) {
+    ICalendarReaderType reader;
+    CalendarItemType event;
+    TodoItemType todo;
+    unsigned int component;
+    int retval;
+
+    if (reader.Open(filePath) != 0)
+        return 1;
+
+    while ((retval = reader.Next(event, todo, component)) == 0) {
+        if (component == ICAL_COMPONENT_EVENT) {
+            eventList.push_back(CalendarItemType());
+            eventList.back().Swap(event);
+        } else {
+            todoList.push_back(TodoItemType());
+            todoList.back().Swap(todo);
+        }
+    }
+
+    if (retval == 3)
+        return 2;
+    if (retval == 2)
+        return 3;
+
+    return 0;
+}
+
+/**
+ * Fill the chunk buffer.
+ *
+ * Move the characters not yet read to the front of the chunk buffer and
+ * read the next chunk of the file after them. The buffer only grows when a
+ * single line does not fit in it.
+ * @return A boolean value representing if more characters were read.
+ */
+bool ICalendarReaderType::Fill(void) {
+    ssize_t numRead;
+
+    if ((fd < 0) || isDone)
+        return false;
+
+    if (dataPos > 0) {
+        memmove(&chunk[0], &chunk[dataPos], dataLen - dataPos);
+        dataLen -= dataPos;
+        dataPos = 0;
+    }
+    if (dataLen == chunk.size())
+        chunk.resize(chunk.size() * 2);
+    pData = &chunk[0];
+
+    do {
+        numRead = read(fd, &chunk[dataLen], chunk.size() - dataLen);
+    } while ((numRead < 0) && (errno == EINTR));
+
+    if (numRead <= 0) {
+        readFailed = (numRead < 0);
+        isDone = true;
+        return false;
+    }
+
+    dataLen += (size_t)numRead;
+    return true;
+}
+
+/**
+ * Get the next line.
+ *
+ * Get the next logical line of the data into the line buffer, without its
+ * line break, joining the lines it was folded over.
+ * @return A boolean value representing if there was a line.
+ */
+bool ICalendarReaderType::NextLine(void) {
+    const char *pStart, *pStop;
+    size_t nextPos;
+    bool hasLine = false;
+
+    line.clear();
+    while (true) {
+        do {
+            pStart = pData + dataPos;
+            pStop = (const char *)memchr(pStart, '\n', dataLen - dataPos);
+        } while ((pStop == NULL) && Fill());
+
+        if (pStop == NULL) {
+            if (dataPos == dataLen)
+                break;
+            pStop = pData + dataLen;
+            nextPos = dataLen;
+        } else {
+            nextPos = (size_t)(pStop - pData) + 1;
+        }
+        if ((pStop > pStart) && (pStop[-1] == '\r'))
+            pStop--;
+
+        line.append(pStart, pStop - pStart);
+        hasLine = true;
+        dataPos = nextPos;
+
+        // A folded line carries on after the white space starting the next
+        // line.
+        if (dataPos == dataLen)
+            Fill();
+        if ((dataPos == dataLen) ||
+            ((pData[dataPos] != ' ') && (pData[dataPos] != '\t')))
+            break;
+        dataPos++;
+    }
+
+    return hasLine;
+}
+
+/**
+ * Split the line.
+ *
+ * Split the current line into its name and value, noting whether the value
+ * is binary. The other parameters are not needed to map a property.
+ * @param prop Reference to the property to store the pieces in.
+ * @return A boolean value representing if the line is a content line.
+ */
+bool ICalendarReaderType::SplitLine(struct sProperty &prop) {
+    const char *p, *pStart, *pStop, *pParam;
+    StringRefType param;
+
+    pStart = line.data();
+    pStop = line.data() + line.size();
+    prop.binary = false;
+
+    // The name ends at the first colon or semicolon, and the value at the
+    // first colon which is not quoted.
+    pParam = TextScanType::FindAny(pStart, pStop, ':', ';', '"');
+    if ((pParam == pStop) || (*pParam == '"'))
+        return false;
+    prop.name = StringRefType(pStart, pParam - pStart);
+
+    while (*pParam == ';') {
+        p = pParam + 1;
+        pParam = TextScanType::FindAny(p, pStop, ':', ';', '"');
+        while ((pParam < pStop) && (*pParam == '"')) {
+            pParam = (const char *)memchr(pParam + 1, '"',
+                                          pStop - pParam - 1);
+            if (pParam == NULL)
+                return false;
+            pParam = TextScanType::FindAny(pParam + 1, pStop, ':', ';', '"');
+        }
+        if (pParam == pStop)
+            return false;
+
+        param = StringRefType(p, pParam - p);
+        if (TextScanType::EqualsNoCase(param, "ENCODING=BASE64") ||
+            TextScanType::EqualsNoCase(param, "VALUE=BINARY"))
+            prop.binary = true;
+    }
+
+    prop.value = StringRefType(pParam + 1, pStop - pParam - 1);
+    return true;
+}
+
+/**
+ * Decode a value.
+ *
+ * Decode a text value into the decode buffer, undoing the escaping of its
+ * characters.
+ * @param value The raw value to decode.
+ * @return Reference to the decoded value.
+ */
+const std::string &ICalendarReaderType::Decode(const StringRefType &value) {
+    decoded.clear();
+    TextScanType::AppendUnescaped(value, decoded);
+
+    return decoded;
+}
+
+/**
+ * Apply an event property.
+ *
+ * Set the fields of the given Calendar item the given property of a VEVENT
+ * maps to. The times, alarm and repeat rule are kept until the whole event
+ * has been read, see FinishEvent().
+ * @param prop The property to apply.
+ * @param event Reference to the item to set the fields of.
+ */
+void ICalendarReaderType::ApplyEvent(const struct sProperty &prop,
+                                     CalendarItemType &event) {
+    bool isDate;
+
+    if (TextScanType::EqualsNoCase(prop.name, "SUMMARY")) {
+        event.SetDescription(Decode(prop.value));
+    } else if (TextScanType::EqualsNoCase(prop.name, "DESCRIPTION")) {
+        event.SetNotes(Decode(prop.value));
+    } else if (TextScanType::EqualsNoCase(prop.name, "LOCATION")) {
+        event.SetLocation(Decode(prop.value));
+    } else if (TextScanType::EqualsNoCase(prop.name, "CATEGORIES")) {
+        event.SetCategory(Decode(prop.value));
+    } else if (TextScanType::EqualsNoCase(prop.name, "UID")) {
+        event.SetAppID(Decode(prop.value));
+    } else if (TextScanType::EqualsNoCase(prop.name, "DTSTART")) {
+        if (ParseTime(prop.value, startTime, isDate))
+            isAllDay = isDate;
+    } else if (TextScanType::EqualsNoCase(prop.name, "DTEND")) {
+        hasEnd = ParseTime(prop.value, endTime, isDate);
+    } else if (TextScanType::EqualsNoCase(prop.name, "DURATION")) {
+        long int secs;
+
+        hasDuration = ParseDuration(prop.value, secs);
+        duration = (time_t)secs;
+    } else if (TextScanType::EqualsNoCase(prop.name, "RRULE")) {
+        ApplyRule(prop.value);
+    }
+}
+
+/**
+ * Apply a to do property.
+ *
+ * Set the fields of the given Todo item the given property of a VTODO maps
+ * to.
+ * @param prop The property to apply.
+ * @param todo Reference to the item to set the fields of.
+ */
+void ICalendarReaderType::ApplyTodo(const struct sProperty &prop,
+                                    TodoItemType &todo) {
+    unsigned long int priority;
+    time_t when;
+    bool isDate;
+
+    if (TextScanType::EqualsNoCase(prop.name, "SUMMARY")) {
+        todo.SetDescription(Decode(prop.value));
+    } else if (TextScanType::EqualsNoCase(prop.name, "DESCRIPTION")) {
+        todo.SetNotes(Decode(prop.value));
+    } else if (TextScanType::EqualsNoCase(prop.name, "CATEGORIES")) {
+        todo.SetCategory(Decode(prop.value));
+    } else if (TextScanType::EqualsNoCase(prop.name, "UID")) {
+        todo.SetAppID(Decode(prop.value));
+    } else if (TextScanType::EqualsNoCase(prop.name, "DTSTART")) {
+        if (ParseTime(prop.value, when, isDate))
+            todo.SetStartDate(when);
+    } else if (TextScanType::EqualsNoCase(prop.name, "DUE")) {
+        if (ParseTime(prop.value, when, isDate))
+            todo.SetDueDate(when);
+    } else if (TextScanType::EqualsNoCase(prop.name, "COMPLETED")) {
+        if (ParseTime(prop.value, when, isDate))
+            todo.SetCompletedDate(when);
+    } else if (TextScanType::EqualsNoCase(prop.name, "STATUS")) {
+        todo.SetProgressStatus(
+            TextScanType::EqualsNoCase(prop.value, "COMPLETED") ? 1 : 0);
+    } else if (TextScanType::EqualsNoCase(prop.name, "PRIORITY")) {
+        // iCalendar priorities run from 1 to 9 and the Zaurus ones from 1
+        // to 5, zero meaning none in both.
+        priority = ParseNumber(prop.value);
+        if (priority > 9)
+            priority = 9;
+        todo.SetPriority((unsigned char)((priority + 1) / 2));
+    }
+}
+
+/**
+ * Apply an alarm property.
+ *
+ * Note the given property of the VALARM of an event, the trigger of which
+ * is either relative to the start of the event or an absolute time.
+ * @param prop The property to apply.
+ */
+void ICalendarReaderType::ApplyAlarm(const struct sProperty &prop) {
+    bool isDate;
+
+    if (TextScanType::EqualsNoCase(prop.name, "ACTION")) {
+        isAudioAlarm = TextScanType::EqualsNoCase(prop.value, "AUDIO");
+    } else if (TextScanType::EqualsNoCase(prop.name, "TRIGGER")) {
+        if (ParseDuration(prop.value, alarmOffset))
+            isAlarmTime = false;
+        else
+            isAlarmTime = ParseTime(prop.value, alarmTime, isDate);
+    }
+}
+
+/**
+ * Apply a repeat rule.
+ *
+ * Note the frequency, interval, days, position and end of the given RRULE
+ * value. Rules the Zaurus has no repeat type for, such as hourly ones,
+ * leave the event not repeating.
+ * @param rule The value of the RRULE property.
+ */
+void ICalendarReaderType::ApplyRule(const StringRefType &rule) {
+    const char *p, *pStop, *pPart, *pEquals;
+    StringRefType name, value, day;
+    std::string::size_type i;
+    unsigned int j;
+    int position;
+    bool isDate;
+
+    p = rule.data();
+    pStop = rule.data() + rule.size();
+    repeatType = REPEAT_NONE;
+
+    while (p < pStop) {
+        pPart = (const char *)memchr(p, ';', pStop - p);
+        if (pPart == NULL)
+            pPart = pStop;
+        pEquals = (const char *)memchr(p, '=', pPart - p);
+        if (pEquals == NULL) {
+            p = pPart + 1;
+            continue;
+        }
+        name = StringRefType(p, pEquals - p);
+        value = StringRefType(pEquals + 1, pPart - pEquals - 1);
+        p = pPart + 1;
+
+        if (TextScanType::EqualsNoCase(name, "FREQ")) {
+            if (TextScanType::EqualsNoCase(value, "DAILY"))
+                repeatType = REPEAT_DAILY;
+            else if (TextScanType::EqualsNoCase(value, "WEEKLY"))
+                repeatType = REPEAT_WEEKLY;
+            else if (TextScanType::EqualsNoCase(value, "MONTHLY"))
+                repeatType = REPEAT_MONTHLY_DATE;
+            else if (TextScanType::EqualsNoCase(value, "YEARLY"))
+                repeatType = REPEAT_YEARLY;
+        } else if (TextScanType::EqualsNoCase(name, "INTERVAL")) {
+            repeatPeriod = (unsigned short int)ParseNumber(value);
+            if (repeatPeriod == 0)
+                repeatPeriod = 1;
+        } else if (TextScanType::EqualsNoCase(name, "COUNT")) {
+            repeatCount = ParseNumber(value);
+        } else if (TextScanType::EqualsNoCase(name, "UNTIL")) {
+            if (!ParseTime(value, repeatUntil, isDate))
+                repeatUntil = 0;
+        } else if (TextScanType::EqualsNoCase(name, "BYDAY")) {
+            // Each day is a two letter name, which may be preceded by the
+            // signed week of the month it falls in.
+            i = 0;
+            while (i < value.size()) {
+                position = 0;
+                if ((value[i] == '+') || (value[i] == '-')) {
+                    position = (value[i] == '-') ? -1 : 1;
+                    i++;
+                }
+                if ((i < value.size()) && (value[i] >= '0') &&
+                    (value[i] <= '9')) {
+                    position = (position < 0) ? ICAL_LAST_WEEK :
+                        (int)ParseNumber(StringRefType(value.data() + i,
+                                                       value.size() - i));
+                    while ((i < value.size()) && (value[i] >= '0') &&
+                           (value[i] <= '9'))
+                        i++;
+                }
+                if (position > 0)
+                    repeatPosition = (unsigned short int)
+                        ((position > ICAL_LAST_WEEK) ? ICAL_LAST_WEEK :
+                         position);
+
+                day = StringRefType(value.data() + i,
+                                    (value.size() - i >= 2) ? 2 : 0);
+                for (j = 0; j < 7; j++) {
+                    if (TextScanType::EqualsNoCase(day, weekDayNames[j]))
+                        repeatDays |= (unsigned char)(1 << j);
+                }
+                while ((i < value.size()) && (value[i] != ','))
+                    i++;
+                i++;
+            }
+        }
+    }
+}
+
+/**
+ * Finish an event.
+ *
+ * Set the times, alarm and repeat rule of the given Calendar item once the
+ * whole of its VEVENT has been read. An all day event ends on the day
+ * before the date its DTEND gives, as that date is not part of it.
+ * @param event Reference to the item to set the fields of.
+ */
+void ICalendarReaderType::FinishEvent(CalendarItemType &event) {
+    RecurrenceType recurrence;
+    time_t lastStart, occStart;
+    unsigned long int i;
+    long int alarmMins;
+
+    if (!hasEnd)
+        endTime = hasDuration ? startTime + duration : startTime;
+
+    if (isAllDay) {
+        endTime = (endTime > startTime) ? AddLocalDays(endTime, -1) :
+            startTime;
+        event.SetScheduleType(ICAL_SCHEDULE_ALL_DAY);
+        event.SetAllDayStartDate(startTime);
+        event.SetAllDayEndDate(endTime);
+    } else {
+        if (endTime < startTime)
+            endTime = startTime;
+        event.SetScheduleType(0);
+        event.SetAllDayStartDate(0);
+        event.SetAllDayEndDate(0);
+    }
+    event.SetStartTime(startTime);
+    event.SetEndTime(endTime);
+    event.SetMultipleDaysFlag(IsSameLocalDay(startTime, endTime) ? 0 : 1);
+
+    // The Zaurus only has alarms going off a number of minutes before the
+    // start of an event.
+    alarmMins = 0;
+    if (isAlarmTime)
+        alarmOffset = (long int)(alarmTime - startTime);
+    if (alarmOffset < 0)
+        alarmMins = -alarmOffset / 60;
+    if (alarmMins > 0xffff)
+        alarmMins = 0xffff;
+    event.SetAlarm(hasAlarm ? 1 : 0);
+    event.SetAlarmSetting((hasAlarm && !isAudioAlarm) ? 1 : 0);
+    event.SetAlarmTime(hasAlarm ? (unsigned short int)alarmMins : 0);
+
+    // A monthly rule on a day of a given week is a Monthly Day one, and
+    // only a Weekly rule keeps the days it repeats on.
+    if ((repeatType == REPEAT_MONTHLY_DATE) && (repeatPosition != 0))
+        repeatType = REPEAT_MONTHLY_DAY;
+    if (repeatType != REPEAT_WEEKLY)
+        repeatDays = 0;
+    if (repeatType != REPEAT_MONTHLY_DAY)
+        repeatPosition = 0;
+    if (repeatType == REPEAT_NONE)
+        repeatPeriod = 0;
+
+    event.SetRepeatType(repeatType);
+    event.SetRepeatPeriod(repeatPeriod);
+    event.SetRepeatPosition(repeatPosition);
+    event.SetRepeatDate(repeatDays);
+    event.SetRepeatEndDateSetting(0);
+    event.SetRepeatEndDate(0);
+
+    // The Zaurus has no count of occurrences, so I end such a rule on the
+    // day of its last occurrence instead.
+    if ((repeatType != REPEAT_NONE) && (repeatUntil == 0) &&
+        (repeatCount > 0)) {
+        recurrence.SetItem(event);
+        lastStart = startTime;
+        for (i = 1; (i < repeatCount) && (i < ICAL_MAX_COUNT); i++) {
+            if (!recurrence.GetNextStart(lastStart + 1, occStart))
+                break;
+            lastStart = occStart;
+        }
+        repeatUntil = lastStart;
+    }
+
+    if ((repeatType != REPEAT_NONE) && (repeatUntil != 0)) {
+        event.SetRepeatEndDateSetting(1);
+        event.SetRepeatEndDate(AddLocalDays(repeatUntil, 0));
+    }
+}
+
+/**
+ * Construct an ICalendarWriterType object.
+ *
+ * Construct an ICalendarWriterType object with all the basic
+ * initialization.
+ */
+ICalendarWriterType::ICalendarWriterType(void) {
+
+}
+
+/**
+ * Begin the calendar.
+ *
+ * Append the start of the VCALENDAR object the components are written in
+ * to the given buffer.
+ * @param out Reference to the buffer to append to.
+ */
+void ICalendarWriterType::Begin(std::string &out) {
+    out.append("BEGIN:VCALENDAR\r\n");
+    out.append("VERSION:2.0\r\n");
+    out.append("PRODID:-//Zync//Zync//EN\r\n");
+}
+
+/**
+ * Put a Calendar item.
+ *
+ * Append the given Calendar item to the given buffer as a VEVENT.
+ * @param item Reference to the item to append.
+ * @param out Reference to the buffer to append the event to.
+ */
+void ICalendarWriterType::Put(const CalendarItemType &item,
+                              std::string &out) {
+    out.append("BEGIN:VEVENT\r\n");
+    PutText(out, "UID", item.GetAppID());
+    if (item.GetModifiedTime() != 0)
+        PutTime(out, "DTSTAMP", item.GetModifiedTime());
+    PutText(out, "SUMMARY", item.GetDescription());
+    PutText(out, "LOCATION", item.GetLocation());
+    PutText(out, "DESCRIPTION", item.GetNotes());
+    PutText(out, "CATEGORIES", item.GetCategory());
+
+    // The DTEND of an all day event is the day after its last day.
+    if ((item.GetScheduleType() == ICAL_SCHEDULE_ALL_DAY) &&
+        (item.GetAllDayStartDate() != 0)) {
+        PutDate(out, "DTSTART", item.GetAllDayStartDate());
+        PutDate(out, "DTEND",
+                AddLocalDays(std::max(item.GetAllDayEndDate(),
+                                      item.GetAllDayStartDate()), 1));
+    } else {
+        PutTime(out, "DTSTART", item.GetStartTime());
+        PutTime(out, "DTEND", std::max(item.GetEndTime(),
+                                       item.GetStartTime()));
+    }
+
+    PutRule(out, item);
+    PutAlarm(out, item);
+    out.append("END:VEVENT\r\n");
+}
+
+/**
+ * Put a Todo item.
+ *
+ * Append the given Todo item to the given buffer as a VTODO.
+ * @param item Reference to the item to append.
+ * @param out Reference to the buffer to append the to do to.
+ */
+void ICalendarWriterType::Put(const TodoItemType &item, std::string &out) {
+    char value[8];
+
+    out.append("BEGIN:VTODO\r\n");
+    PutText(out, "UID", item.GetAppID());
+    if (item.GetModifiedTime() != 0)
+        PutTime(out, "DTSTAMP", item.GetModifiedTime());
+    PutText(out, "SUMMARY", item.GetDescription());
+    PutText(out, "DESCRIPTION", item.GetNotes());
+    PutText(out, "CATEGORIES", item.GetCategory());
+    if (item.GetStartDate() != 0)
+        PutDate(out, "DTSTART", item.GetStartDate());
+    if (item.GetDueDate() != 0)
+        PutDate(out, "DUE", item.GetDueDate());
+    if (item.GetCompletedDate() != 0)
+        PutTime(out, "COMPLETED", item.GetCompletedDate());
+
+    if ((item.GetPriority() >= 1) && (item.GetPriority() <= 5)) {
+        snprintf(value, sizeof(value), "%u",
+                 (unsigned int)item.GetPriority() * 2 - 1);
+        out.append("PRIORITY:");
+        out.append(value);
+        out.append("\r\n");
+    }
+
+    if (item.GetProgressStatus() != 0)
+        out.append("STATUS:COMPLETED\r\n");
+    else
+        out.append("STATUS:NEEDS-ACTION\r\n");
+
+    out.append("END:VTODO\r\n");
+}
+
+/**
+ * End the calendar.
+ *
+ * Append the end of the VCALENDAR object to the given buffer.
+ * @param out Reference to the buffer to append to.
+ */
+void ICalendarWriterType::End(std::string &out) {
+    out.append("END:VCALENDAR\r\n");
+}
+
+/**
+ * Write a file.
+ *
+ * Write the given Calendar and Todo items to the file at the given path as
+ * an iCalendar object, replacing the file. The components are built a
+ * chunk at a time, so the whole file is never held in memory.
+ * @param filePath The path of the file.
+ * @param eventList Reference to the list of Calendar items to write.
+ * @param todoList Reference to the list of Todo items to write.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully wrote the file.
+ * @retval 1 Failed to create the file.
+ * @retval 2 Failed to write the file.
+ */
+int ICalendarWriterType::WriteFile(const std::string &filePath,
+                                   const CalendarItemType::List &eventList,
+                                   const TodoItemType::List &todoList) {
+    ICalendarWriterType writer;
+    CalendarItemType::List::const_iterator eventIter;
+    TodoItemType::List::const_iterator todoIter;
+    std::string buff;
+    bool failed = false;
+    int fd;
+
+    fd = open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        return 1;
+
+    buff.reserve(ICAL_CHUNK_SIZE + 4096);
+    writer.Begin(buff);
+
+    eventIter = eventList.begin();
+    todoIter = todoList.begin();
+    while (!failed && ((eventIter != eventList.end()) ||
+                       (todoIter != todoList.end()))) {
+        if (eventIter != eventList.end()) {
+            writer.Put(*eventIter, buff);
+            ++eventIter;
+        } else {
+            writer.Put(*todoIter, buff);
+            ++todoIter;
+        }
+
+        if (buff.size() >= ICAL_CHUNK_SIZE) {
+            failed = (write(fd, buff.data(), buff.size()) !=
+                      (ssize_t)buff.size());
+            buff.clear();
+        }
+    }
+
+    writer.End(buff);
+    if (!failed)
+        failed = (write(fd, buff.data(), buff.size()) !=
+                  (ssize_t)buff.size());
+
+    if ((close(fd) != 0) || failed)
+        return 2;
+
+    return 0;
+}
+
+/**
+ * Put a text property.
+ *
+ * Append a property with the given text value to the buffer, escaped and
+ * folded. A property with an empty value is left out.
+ * @param out Reference to the buffer to append the property to.
+ * @param pName The name of the property.
+ * @param value The value of the property.
+ */
+void ICalendarWriterType::PutText(std::string &out, const char *pName,
+                                  const StringRefType &value) {
+    if (value.empty())
+        return;
+
+    line.assign(pName);
+    line += ':';
+    TextScanType::AppendEscaped(value, line);
+    TextScanType::AppendFolded(line, out);
+}
+
+/**
+ * Put a time property.
+ *
+ * Append a property with the given time as a UTC DATE-TIME value to the
+ * buffer.
+ * @param out Reference to the buffer to append the property to.
+ * @param pName The name of the property.
+ * @param when The time.
+ */
+void ICalendarWriterType::PutTime(std::string &out, const char *pName,
+                                  time_t when) {
+    struct tm utcTm;
+    char value[80];
+
+    if (gmtime_r(&when, &utcTm) == NULL)
+        return;
+
+    snprintf(value, sizeof(value), "%04d%02d%02dT%02d%02d%02dZ",
+             utcTm.tm_year + 1900, utcTm.tm_mon + 1, utcTm.tm_mday,
+             utcTm.tm_hour, utcTm.tm_min, utcTm.tm_sec);
+    out.append(pName);
+    out += ':';
+    out.append(value);
+    out.append("\r\n");
+}
+
+/**
+ * Put a date property.
+ *
+ * Append a property with the local date of the given time as a DATE value
+ * to the buffer.
+ * @param out Reference to the buffer to append the property to.
+ * @param pName The name of the property.
+ * @param when The time.
+ */
+void ICalendarWriterType::PutDate(std::string &out, const char *pName,
+                                  time_t when) {
+    struct tm localTm;
+    char value[48];
+
+    if (localtime_r(&when, &localTm) == NULL)
+        return;
+
+    snprintf(value, sizeof(value), "%04d%02d%02d", localTm.tm_year + 1900,
+             localTm.tm_mon + 1, localTm.tm_mday);
+    out.append(pName);
+    out.append(";VALUE=DATE:");
+    out.append(value);
+    out.append("\r\n");
+}
+
+/**
+ * Put a repeat rule.
+ *
+ * Append the repeat rule of the given Calendar item to the buffer as an
+ * RRULE property, if the item repeats. The rule ends at the end of the
+ * local day of the repeat end date, as the Zaurus includes that whole day.
+ * @param out Reference to the buffer to append the property to.
+ * @param item Reference to the item whose rule to append.
+ */
+void ICalendarWriterType::PutRule(std::string &out,
+                                  const CalendarItemType &item) {
+    struct tm localTm, untilTm;
+    time_t start, until;
+    unsigned int position;
+    unsigned int i;
+    char value[80];
+    bool isFirst;
+    bool isAllDay;
+
+    if (item.GetRepeatType() > REPEAT_YEARLY)
+        return;
+
+    isAllDay = ((item.GetScheduleType() == ICAL_SCHEDULE_ALL_DAY) &&
+                (item.GetAllDayStartDate() != 0));
+    start = isAllDay ? item.GetAllDayStartDate() : item.GetStartTime();
+    if (localtime_r(&start, &localTm) == NULL)
+        return;
+
+    line.assign("RRULE:FREQ=");
+    switch (item.GetRepeatType()) {
+    case REPEAT_DAILY:
+        line.append("DAILY");
+        break;
+    case REPEAT_WEEKLY:
+        line.append("WEEKLY");
+        break;
+    case REPEAT_MONTHLY_DAY:
+    case REPEAT_MONTHLY_DATE:
+        line.append("MONTHLY");
+        break;
+    default:
+        line.append("YEARLY");
+        break;
+    }
+
+    if (item.GetRepeatPeriod() > 1) {
+        snprintf(value, sizeof(value), ";INTERVAL=%u",
+                 (unsigned int)item.GetRepeatPeriod());
+        line.append(value);
+    }
+
+    if ((item.GetRepeatType() == REPEAT_WEEKLY) &&
+        ((item.GetRepeatDate() & REPEAT_DAYS_MASK) != 0)) {
+        line.append(";BYDAY=");
+        isFirst = true;
+        for (i = 0; i < 7; i++) {
+            if ((item.GetRepeatDate() & (1 << i)) == 0)
+                continue;
+            if (!isFirst)
+                line += ',';
+            line.append(weekDayNames[i]);
+            isFirst = false;
+        }
+    } else if (item.GetRepeatType() == REPEAT_MONTHLY_DAY) {
+        // The weekday is that of the start, in the week of the month given
+        // by the repeat position or, without one, the week of the start.
+        position = item.GetRepeatPosition();
+        if (position == 0)
+            position = (localTm.tm_mday - 1) / 7 + 1;
+        if (position >= ICAL_LAST_WEEK)
+            snprintf(value, sizeof(value), ";BYDAY=-1%s",
+                     weekDayNames[(localTm.tm_wday + 6) % 7]);
+        else
+            snprintf(value, sizeof(value), ";BYDAY=%u%s", position,
+                     weekDayNames[(localTm.tm_wday + 6) % 7]);
+        line.append(value);
+    } else if (item.GetRepeatType() == REPEAT_MONTHLY_DATE) {
+        snprintf(value, sizeof(value), ";BYMONTHDAY=%d", localTm.tm_mday);
+        line.append(value);
+    }
+
+    // The UNTIL of an all day event has to be a date like its DTSTART.
+    if (item.GetRepeatEndDateSetting() != 0) {
+        until = AddLocalDays(item.GetRepeatEndDate(), 1) - 1;
+        if (isAllDay && (localtime_r(&until, &untilTm) != NULL)) {
+            snprintf(value, sizeof(value), ";UNTIL=%04d%02d%02d",
+                     untilTm.tm_year + 1900, untilTm.tm_mon + 1, untilTm.tm_mday);
+            line.append(value);
+        } else if (!isAllDay && (gmtime_r(&until, &untilTm) != NULL)) {
+            snprintf(value, sizeof(value),
+                     ";UNTIL=%04d%02d%02dT%02d%02d%02dZ",
+                     untilTm.tm_year + 1900, untilTm.tm_mon + 1, untilTm.tm_mday,
+                     untilTm.tm_hour, untilTm.tm_min, untilTm.tm_sec);
+            line.append(value);
+        }
+    }
+
+    TextScanType::AppendFolded(line, out);
+}
+
+/**
+ * Put an alarm.
+ *
+ * Append the alarm of the given Calendar item to the buffer as a VALARM,
+ * if it has one. A silent alarm is written as a DISPLAY alarm and any
+ * other as an AUDIO one.
+ * @param out Reference to the buffer to append the alarm to.
+ * @param item Reference to the item whose alarm to append.
+ */
+void ICalendarWriterType::PutAlarm(std::string &out,
+                                   const CalendarItemType &item) {
+    char value[32];
+
+    if (item.GetAlarm() == 0)
+        return;
+
+    out.append("BEGIN:VALARM\r\n");
+    if (item.GetAlarmSetting() != 0) {
+        out.append("ACTION:DISPLAY\r\n");
+        if (item.GetDescription().empty())
+            out.append("DESCRIPTION:Reminder\r\n");
+        else
+            PutText(out, "DESCRIPTION", item.GetDescription());
+    } else {
+        out.append("ACTION:AUDIO\r\n");
+    }
+
+    snprintf(value, sizeof(value), "TRIGGER:-PT%uM\r\n",
+             (unsigned int)item.GetAlarmTime());
+    out.append(value);
+    out.append("END:VALARM\r\n");
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file ICalendarType.hh
+ * @brief A specifications file for reading and writing iCalendar data.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for the classes existing to convert Calendar and
+ * Todo items to and from iCalendar events and to dos, so that calendars
+ * may be imported and exported in bulk.
+ */
+
+#ifndef ICALENDARTYPE_H
+#define ICALENDARTYPE_H
+
+#include <stddef.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "CalendarItemType.hh"
+#include "TodoItemType.hh"
+#include "StringRefType.hh"
+
+// Define the components an iCalendar reader may read.
+#define ICAL_COMPONENT_EVENT 1
+#define ICAL_COMPONENT_TODO 2
+
+/**
+ * @class ICalendarReaderType
+ * @brief A type reading Calendar and Todo items from iCalendar data.
+ *
+ * The ICalendarReaderType is a class which reads the VEVENT and VTODO
+ * components of iCalendar data, one after the other, into Calendar and
+ * Todo items. The summary, description, location, categories, times,
+ * all day dates, alarm and repeat rule of each component are mapped onto
+ * the matching fields, and every other component and property is skipped.
+ * Times with a time zone other than UTC are taken to be local times.
+ *
+ * The data is either a buffer or a file. A file is read a chunk at a time
+ * into a buffer which only grows to hold the longest line, so the memory
+ * used does not depend on the size of the file. Lines are unfolded and
+ * values unescaped into buffers kept by the reader.
+ */
+class ICalendarReaderType {
+public:
+    ICalendarReaderType(void);
+    ICalendarReaderType(const char *pData, size_t size);
+    ~ICalendarReaderType(void);
+
+    int Open(const std::string &filePath);
+    void Close(void);
+
+    int Next(CalendarItemType &event, TodoItemType &todo,
+             unsigned int &component);
+
+    static int ReadFile(const std::string &filePath,
+                        CalendarItemType::List &eventList,
+                        TodoItemType::List &todoList);
+
+private:
+    // The reader may own a file descriptor, so it may not be copied.
+    ICalendarReaderType(const ICalendarReaderType &);
+    ICalendarReaderType &operator=(const ICalendarReaderType &);
+
+    // The pieces of a content line, each referring into the line.
+    struct sProperty {
+        StringRefType name;
+        StringRefType value;
+        bool binary;
+    };
+
+    bool Fill(void);
+    bool NextLine(void);
+    bool SplitLine(struct sProperty &prop);
+    const std::string &Decode(const StringRefType &value);
+
+    void ApplyEvent(const struct sProperty &prop, CalendarItemType &event);
+    void ApplyTodo(const struct sProperty &prop, TodoItemType &todo);
+    void ApplyAlarm(const struct sProperty &prop);
+    void ApplyRule(const StringRefType &rule);
+    void FinishEvent(CalendarItemType &event);
+
+    // The data being read, either the buffer given or the chunk buffer the
+    // file is read into.
+    const char *pData;
+    size_t dataPos;
+    size_t dataLen;
+    std::vector<char> chunk;
+    int fd;
+    bool isDone;
+    bool readFailed;
+
+    // The current logical line and the buffer values are decoded into.
+    std::string line;
+    std::string decoded;
+
+    // The parts of the current event known only once all of it is read.
+    time_t startTime;
+    time_t endTime;
+    time_t duration;
+    bool hasEnd;
+    bool hasDuration;
+    bool isAllDay;
+    bool hasAlarm;
+    long int alarmOffset;
+    time_t alarmTime;
+    bool isAlarmTime;
+    bool isAudioAlarm;
+    unsigned char repeatType;
+    unsigned short int repeatPeriod;
+    unsigned short int repeatPosition;
+    unsigned char repeatDays;
+    time_t repeatUntil;
+    unsigned long int repeatCount;
+};
+
+/**
+ * @class ICalendarWriterType
+ * @brief A type writing Calendar and Todo items as iCalendar data.
+ *
+ * The ICalendarWriterType is a class which appends Calendar items as
+ * VEVENT components and Todo items as VTODO components to a buffer, with
+ * their alarms as VALARM components and their repeat rules as RRULE
+ * properties. All day items are written with dates and every other time in
+ * UTC. Values are escaped and lines folded as RFC 2445 requires.
+ */
+class ICalendarWriterType {
+public:
+    ICalendarWriterType(void);
+
+    void Begin(std::string &out);
+    void Put(const CalendarItemType &item, std::string &out);
+    void Put(const TodoItemType &item, std::string &out);
+    void End(std::string &out);
+
+    static int WriteFile(const std::string &filePath,
+                         const CalendarItemType::List &eventList,
+                         const TodoItemType::List &todoList);
+
+private:
+    void PutText(std::string &out, const char *pName,
+                 const StringRefType &value);
+    void PutTime(std::string &out, const char *pName, time_t when);
+    void PutDate(std::string &out, const char *pName, time_t when);
+    void PutRule(std::string &out, const CalendarItemType &item);
+    void PutAlarm(std::string &out, const CalendarItemType &item);
+
+    // The buffer the current line is built in before it is folded.
+    std::string line;
+};
+
+#endif
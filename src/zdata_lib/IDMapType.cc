@@ -0,0 +1,831 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file IDMapType.cc
+ * @brief An implementation file for an object mapping sync IDs to app IDs.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for a class existing to keep a persistent mapping
+ * between the sync IDs of the items on a Zaurus and the IDs the desktop
+ * application knows the same items by.
+ */
+
+#include "IDMapType.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// The magic bytes and version at the front of every mapping file.
+#define IDMAP_MAGIC "ZIDM"
+#define IDMAP_MAGIC_SIZE 4
+#define IDMAP_VERSION 0x02
+
+// The size reserved for the header at the front of the mapping file. The
+// sync ID table follows it, then the app ID table, then the heap.
+#define IDMAP_HEADER_SIZE 40
+
+// The number of entries in the tables of a new mapping, which must be a power
+// of two, and the initial size of its heap.
+#define IDMAP_INITIAL_CAPACITY 1024
+#define IDMAP_INITIAL_HEAP_SIZE 32768
+
+// The states an entry in the sync ID table may be in.
+#define IDMAP_ENTRY_EMPTY 0x00
+#define IDMAP_ENTRY_USED 0x01
+#define IDMAP_ENTRY_DELETED 0x02
+
+// The values of the app ID table which do not refer to an entry. Every other
+// value is the slot of an entry in the sync ID table plus one.
+#define IDMAP_APP_EMPTY 0x00000000
+#define IDMAP_APP_DELETED 0xffffffff
+
+// The layout of the header of the mapping file. The mapping is local to this
+// machine so it is simply stored in host byte order. The device key
+// identifies the Zaurus whose items the mapping is of.
+struct sIDMapHeader {
+    char magic[IDMAP_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t count;
+    uint32_t used;
+    uint32_t inUse;
+    uint32_t heapSize;
+    uint32_t heapUsed;
+    uint64_t device;
+};
+
+// The layout of each entry in the sync ID table. The offset of the app ID in
+// the heap and its length are packed into one word, so that changing the app
+// ID of an entry is a single store.
+struct sIDMapEntry {
+    uint64_t syncID;
+    uint64_t appIDRef;
+    uint32_t appIDHash;
+    uint32_t state;
+};
+
+#define IDMAP_REF(offset, len) (((uint64_t)(offset) << 32) | (uint32_t)(len))
+#define IDMAP_REF_OFFSET(ref) ((uint32_t)((ref) >> 32))
+#define IDMAP_REF_LEN(ref) ((uint32_t)(ref))
+
+#define IDMAP_HEADER(pMap) ((struct sIDMapHeader *)(pMap))
+#define IDMAP_ENTRIES(pMap) \
+    ((struct sIDMapEntry *)((char *)(pMap) + IDMAP_HEADER_SIZE))
+#define IDMAP_APP_SLOTS(pMap) \
+    ((uint32_t *)(IDMAP_ENTRIES(pMap) + IDMAP_HEADER(pMap)->capacity))
+#define IDMAP_HEAP(pMap) \
+    ((char *)(IDMAP_APP_SLOTS(pMap) + IDMAP_HEADER(pMap)->capacity))
+
+#define IDMAP_FILE_SIZE(capacity, heapSize) \
+    (IDMAP_HEADER_SIZE + (size_t)(capacity) * \
+        (sizeof(struct sIDMapEntry) + sizeof(uint32_t)) + (size_t)(heapSize))
+
+IDMapType *IDMapType::pSharedMap = NULL;
+
+/**
+ * Construct a default IDMapType object.
+ *
+ * Construct an IDMapType object which has no mapping file open.
+ */
+IDMapType::IDMapType(void) {
+    fd = -1;
+    pMap = NULL;
+    mapSize = 0;
+    deviceKey = 0;
+}
+
+/**
+ * Destruct the IDMapType object.
+ *
+ * Destruct the IDMapType object, closing the mapping file if it is open.
+ */
+IDMapType::~IDMapType(void) {
+    Close();
+}
+
+/**
+ * Open the mapping.
+ *
+ * Open the mapping file at the given path, creating it if it does not
+ * exist. If the mapping was left in use by a synchronization which never
+ * finished it is recovered. If the file does not hold a valid mapping it is
+ * started over empty. A valid mapping of a different device is refused and
+ * left as it is, since its app IDs mean nothing for this one.
+ * @param mapPath The path of the mapping file.
+ * @param device The key identifying the Zaurus the mapping is of.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully opened the mapping.
+ * @retval 1 Failed to open the mapping file.
+ * @retval 2 Failed to map the mapping file.
+ * @retval 3 The mapping file belongs to a different device.
+ */
+int IDMapType::Open(const std::string &mapPath, uint64_t device) {
+    struct stat fileStat;
+    struct sIDMapHeader *pHeader;
+    void *pFileMap;
+    bool valid = false;
+
+    Close();
+
+    path = mapPath;
+    deviceKey = device;
+    fd = open(path.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0)
+        return 1;
+
+    if ((fstat(fd, &fileStat) == 0) &&
+        (fileStat.st_size >= (off_t)IDMAP_HEADER_SIZE)) {
+        pFileMap = mmap(NULL, (size_t)fileStat.st_size,
+            PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (pFileMap != MAP_FAILED) {
+            pMap = pFileMap;
+            mapSize = (size_t)fileStat.st_size;
+            pHeader = IDMAP_HEADER(pMap);
+
+            // I only trust the mapping if the file holds the tables and heap
+            // its header claims. The file may be larger if zync died while
+            // growing the heap, the heap then simply takes up the rest.
+            if ((memcmp(pHeader->magic, IDMAP_MAGIC,
+                    IDMAP_MAGIC_SIZE) == 0) &&
+                (pHeader->version == IDMAP_VERSION) &&
+                (pHeader->capacity != 0) &&
+                ((pHeader->capacity & (pHeader->capacity - 1)) == 0) &&
+                (pHeader->heapUsed <= pHeader->heapSize) &&
+                (mapSize >= IDMAP_FILE_SIZE(pHeader->capacity,
+                    pHeader->heapSize)) &&
+                (mapSize - IDMAP_FILE_SIZE(pHeader->capacity, 0) <=
+                    0xffffffff)) {
+                pHeader->heapSize = (uint32_t)(mapSize -
+                    IDMAP_FILE_SIZE(pHeader->capacity, 0));
+                valid = true;
+            }
+        }
+    }
+
+    if (valid && (IDMAP_HEADER(pMap)->device != deviceKey)) {
+        Unmap();
+        close(fd);
+        fd = -1;
+        return 3;
+    }
+
+    if (valid) {
+        if (IDMAP_HEADER(pMap)->inUse != 0)
+            Recover();
+        IDMAP_HEADER(pMap)->inUse = 1;
+        msync(pMap, IDMAP_HEADER_SIZE, MS_SYNC);
+        return 0;
+    }
+
+    Unmap();
+    if (Map(IDMAP_INITIAL_CAPACITY, IDMAP_INITIAL_HEAP_SIZE, true) != 0) {
+        close(fd);
+        fd = -1;
+        return 2;
+    }
+
+    return 0;
+}
+
+/**
+ * Determine if the mapping is open.
+ *
+ * Determine if a mapping file is currently open.
+ * @return A boolean value representing true (yes) or false (no).
+ */
+bool IDMapType::IsOpen(void) const {
+    return (pMap != NULL);
+}
+
+/**
+ * Close the mapping.
+ *
+ * Flush the mapping to disk, mark it as no longer in use, and close the
+ * mapping file.
+ */
+void IDMapType::Close(void) {
+    if (pMap != NULL) {
+        // I make sure the tables are on disk before the header claims the
+        // mapping was closed properly.
+        msync(pMap, mapSize, MS_SYNC);
+        IDMAP_HEADER(pMap)->inUse = 0;
+        msync(pMap, IDMAP_HEADER_SIZE, MS_SYNC);
+        Unmap();
+    }
+
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+/**
+ * Sync the mapping.
+ *
+ * Flush every change made to the mapping so far to disk, so that it
+ * survives the machine going down and not just zync.
+ */
+void IDMapType::Sync(void) {
+    if (pMap != NULL)
+        msync(pMap, mapSize, MS_SYNC);
+}
+
+/**
+ * Get the number of mapped items.
+ *
+ * Get the number of items currently held in the mapping.
+ * @return The number of mapped items.
+ */
+unsigned long int IDMapType::GetCount(void) const {
+    if (pMap == NULL)
+        return 0;
+
+    return IDMAP_HEADER(pMap)->count;
+}
+
+/**
+ * Get the app ID of an item.
+ *
+ * Get the app ID the item with the given sync ID is mapped to.
+ * @param syncID The sync ID of the item.
+ * @param appID Reference to store the app ID of the item in.
+ * @return A boolean value representing true (found) or false (not found).
+ */
+bool IDMapType::GetAppID(unsigned long int syncID, std::string &appID) const {
+    uint32_t slot;
+
+    if (pMap == NULL)
+        return false;
+
+    slot = FindSlot(syncID, false);
+    if (slot == IDMAP_HEADER(pMap)->capacity)
+        return false;
+
+    appID = GetEntryAppID(slot);
+    return true;
+}
+
+/**
+ * Get the sync ID of an item.
+ *
+ * Get the sync ID the item with the given app ID is mapped to.
+ * @param appID The app ID of the item.
+ * @param syncID Reference to store the sync ID of the item in.
+ * @return A boolean value representing true (found) or false (not found).
+ */
+bool IDMapType::GetSyncID(const std::string &appID,
+                          unsigned long int &syncID) const {
+    uint32_t appSlot;
+
+    if ((pMap == NULL) || appID.empty())
+        return false;
+
+    appSlot = FindAppSlot(appID, HashAppID(appID), false);
+    if (appSlot == IDMAP_HEADER(pMap)->capacity)
+        return false;
+
+    syncID = (unsigned long int)IDMAP_ENTRIES(pMap)[
+        IDMAP_APP_SLOTS(pMap)[appSlot] - 1].syncID;
+    return true;
+}
+
+/**
+ * Put a mapping.
+ *
+ * Map the item with the given sync ID to the given app ID. Any mapping
+ * either of them was part of before is replaced, so each sync ID and each
+ * app ID is only ever mapped once.
+ * @param syncID The sync ID of the item.
+ * @param appID The app ID of the item.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully mapped the item.
+ * @retval 1 The mapping is not open.
+ * @retval 2 Failed to grow the mapping.
+ * @retval 3 The app ID is empty.
+ */
+int IDMapType::Put(unsigned long int syncID, const std::string &appID) {
+    struct sIDMapHeader *pHeader;
+    struct sIDMapEntry *pEntry;
+    unsigned long int oldSyncID;
+    uint32_t appIDHash;
+    uint32_t slot;
+    uint32_t appSlot;
+    uint32_t offset;
+
+    if (pMap == NULL)
+        return 1;
+
+    if (appID.empty())
+        return 3;
+
+    if (GetSyncID(appID, oldSyncID)) {
+        if (oldSyncID == syncID)
+            return 0;
+        Remove(oldSyncID);
+    }
+
+    // I keep the tables at most three quarters full, counting deleted
+    // entries, so that probing stays short and always finds an empty slot.
+    pHeader = IDMAP_HEADER(pMap);
+    if (((uint64_t)pHeader->used + 1) * 4 > (uint64_t)pHeader->capacity * 3) {
+        if (Rebuild(pHeader->capacity * 2) != 0)
+            return 2;
+    }
+
+    if (GrowHeap((uint32_t)appID.size()) != 0)
+        return 2;
+
+    pHeader = IDMAP_HEADER(pMap);
+    appIDHash = HashAppID(appID);
+
+    // The app ID is written to the heap before anything refers to it.
+    offset = pHeader->heapUsed;
+    memcpy(IDMAP_HEAP(pMap) + offset, appID.data(), appID.size());
+    pHeader->heapUsed += (uint32_t)appID.size();
+
+    slot = FindSlot(syncID, true);
+    pEntry = &IDMAP_ENTRIES(pMap)[slot];
+    if (pEntry->state == IDMAP_ENTRY_USED) {
+        appSlot = FindAppSlot(GetEntryAppID(slot), pEntry->appIDHash, false);
+        if (appSlot != pHeader->capacity)
+            IDMAP_APP_SLOTS(pMap)[appSlot] = IDMAP_APP_DELETED;
+    }
+
+    pEntry->syncID = syncID;
+    pEntry->appIDHash = appIDHash;
+    pEntry->appIDRef = IDMAP_REF(offset, appID.size());
+
+    // The entry has to be complete before it is flagged as used.
+    __sync_synchronize();
+    if (pEntry->state != IDMAP_ENTRY_USED) {
+        if (pEntry->state == IDMAP_ENTRY_EMPTY)
+            pHeader->used++;
+        pHeader->count++;
+        pEntry->state = IDMAP_ENTRY_USED;
+    }
+
+    appSlot = FindAppSlot(appID, appIDHash, true);
+    IDMAP_APP_SLOTS(pMap)[appSlot] = slot + 1;
+
+    return 0;
+}
+
+/**
+ * Remove a mapping.
+ *
+ * Remove the mapping of the item with the given sync ID, if it is mapped.
+ * @param syncID The sync ID of the item.
+ */
+void IDMapType::Remove(unsigned long int syncID) {
+    struct sIDMapEntry *pEntry;
+    uint32_t slot;
+    uint32_t appSlot;
+
+    if (pMap == NULL)
+        return;
+
+    slot = FindSlot(syncID, false);
+    if (slot == IDMAP_HEADER(pMap)->capacity)
+        return;
+
+    pEntry = &IDMAP_ENTRIES(pMap)[slot];
+    appSlot = FindAppSlot(GetEntryAppID(slot), pEntry->appIDHash, false);
+    if (appSlot != IDMAP_HEADER(pMap)->capacity)
+        IDMAP_APP_SLOTS(pMap)[appSlot] = IDMAP_APP_DELETED;
+
+    pEntry->state = IDMAP_ENTRY_DELETED;
+    IDMAP_HEADER(pMap)->count--;
+}
+
+/**
+ * Set the shared mapping.
+ *
+ * Set the mapping made available to plugins for the synchronization being
+ * performed, or NULL once there is none.
+ * @param pIDMap Pointer to the mapping to share.
+ */
+void IDMapType::SetShared(IDMapType *pIDMap) {
+    pSharedMap = pIDMap;
+}
+
+/**
+ * Get the shared mapping.
+ *
+ * Get the mapping between the sync IDs and app IDs of the type of items
+ * being synchronized. Plugins may use it to look up the app IDs of the items
+ * they are asked to modify or delete.
+ * @return A pointer to the shared mapping, or NULL if there is none.
+ */
+IDMapType *IDMapType::GetShared(void) {
+    return pSharedMap;
+}
+
+/**
+ * Create a mapping file.
+ *
+ * Create an empty mapping file at the given path with tables of the given
+ * capacity and a heap of the given size, replacing any file already there.
+ * @param filePath The path of the mapping file.
+ * @param capacity The number of entries in the tables.
+ * @param heapSize The size of the heap.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully created the mapping file.
+ * @retval 1 Failed to open the mapping file.
+ * @retval 2 Failed to map the mapping file.
+ */
+int IDMapType::Create(const std::string &filePath, uint32_t capacity,
+                      uint32_t heapSize) {
+    Close();
+
+    path = filePath;
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        return 1;
+
+    if (Map(capacity, heapSize, true) != 0) {
+        close(fd);
+        fd = -1;
+        return 2;
+    }
+
+    return 0;
+}
+
+/**
+ * Map the mapping file.
+ *
+ * Size the mapping file for tables with the given capacity and a heap of the
+ * given size, and map it into memory. If reset is true the mapping is
+ * started over empty and marked as in use. Otherwise the tables and the heap
+ * already in the file are kept, which is only valid if the capacity did not
+ * change since the heap is at the end of the file.
+ * @param capacity The number of entries in the tables.
+ * @param heapSize The size of the heap.
+ * @param reset Flag indicating if the mapping should be started over empty.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully mapped the mapping file.
+ * @retval 1 Failed to size the mapping file.
+ * @retval 2 Failed to map the mapping file.
+ */
+int IDMapType::Map(uint32_t capacity, uint32_t heapSize, bool reset) {
+    struct sIDMapHeader *pHeader;
+    size_t size;
+    void *pFileMap;
+
+    size = IDMAP_FILE_SIZE(capacity, heapSize);
+
+    if (reset && (ftruncate(fd, 0) != 0))
+        return 1;
+    if (ftruncate(fd, (off_t)size) != 0)
+        return 1;
+
+    pFileMap = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (pFileMap == MAP_FAILED)
+        return 2;
+
+    pMap = pFileMap;
+    mapSize = size;
+    pHeader = IDMAP_HEADER(pMap);
+
+    if (reset) {
+        memset(pMap, 0, mapSize);
+        memcpy(pHeader->magic, IDMAP_MAGIC, IDMAP_MAGIC_SIZE);
+        pHeader->version = IDMAP_VERSION;
+        pHeader->capacity = capacity;
+        pHeader->inUse = 1;
+        pHeader->device = deviceKey;
+    }
+    pHeader->heapSize = heapSize;
+
+    if (reset)
+        msync(pMap, mapSize, MS_SYNC);
+
+    return 0;
+}
+
+/**
+ * Unmap the mapping file.
+ *
+ * Unmap the mapping file from memory, if it is mapped.
+ */
+void IDMapType::Unmap(void) {
+    if (pMap != NULL) {
+        munmap(pMap, mapSize);
+        pMap = NULL;
+        mapSize = 0;
+    }
+}
+
+/**
+ * Recover the mapping.
+ *
+ * Recover a mapping which was left in use by a zync which died. Entries are
+ * only flagged as used once complete, so every used entry whose app ID lies
+ * within the heap is kept. The counts and the app ID table may have been
+ * left half updated, so they are rebuilt from the kept entries.
+ */
+void IDMapType::Recover(void) {
+    struct sIDMapHeader *pHeader;
+    struct sIDMapEntry *pEntries;
+    uint32_t *pAppSlots;
+    uint32_t appSlot;
+    uint64_t end;
+    uint32_t i;
+
+    pHeader = IDMAP_HEADER(pMap);
+    pEntries = IDMAP_ENTRIES(pMap);
+    pAppSlots = IDMAP_APP_SLOTS(pMap);
+
+    memset(pAppSlots, 0, (size_t)pHeader->capacity * sizeof(uint32_t));
+    pHeader->count = 0;
+    pHeader->used = 0;
+
+    for (i = 0; i < pHeader->capacity; i++) {
+        if (pEntries[i].state == IDMAP_ENTRY_EMPTY)
+            continue;
+
+        pHeader->used++;
+        if (pEntries[i].state != IDMAP_ENTRY_USED)
+            continue;
+
+        end = (uint64_t)IDMAP_REF_OFFSET(pEntries[i].appIDRef) +
+            IDMAP_REF_LEN(pEntries[i].appIDRef);
+        if ((end > pHeader->heapUsed) ||
+            (FindSlot((unsigned long int)pEntries[i].syncID, false) != i) ||
+            (FindAppSlot(GetEntryAppID(i), pEntries[i].appIDHash, false) !=
+                pHeader->capacity)) {
+            pEntries[i].state = IDMAP_ENTRY_DELETED;
+            continue;
+        }
+
+        pHeader->count++;
+        appSlot = FindAppSlot(GetEntryAppID(i), pEntries[i].appIDHash, true);
+        pAppSlots[appSlot] = i + 1;
+    }
+
+    msync(pMap, mapSize, MS_SYNC);
+}
+
+/**
+ * Rebuild the mapping.
+ *
+ * Rebuild the mapping with tables of the given capacity, dropping deleted
+ * entries and the app IDs no longer referred to from the heap. The rebuilt
+ * mapping is written to a new file which then replaces the old one, so the
+ * old mapping is left untouched if zync dies part way through.
+ * @param capacity The number of entries in the tables of the new mapping.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully rebuilt the mapping.
+ * @retval 1 Failed to create the new mapping file.
+ * @retval 2 Failed to put an entry in the new mapping.
+ * @retval 3 Failed to replace the old mapping file.
+ */
+int IDMapType::Rebuild(uint32_t capacity) {
+    IDMapType newMap;
+    struct sIDMapHeader *pHeader;
+    struct sIDMapEntry *pEntries;
+    std::string tmpPath;
+    uint32_t heapSize;
+    uint32_t i;
+
+    pHeader = IDMAP_HEADER(pMap);
+    pEntries = IDMAP_ENTRIES(pMap);
+
+    heapSize = IDMAP_INITIAL_HEAP_SIZE;
+    while (heapSize < pHeader->heapUsed)
+        heapSize = heapSize * 2;
+
+    tmpPath = path + ".tmp";
+    newMap.deviceKey = deviceKey;
+    if (newMap.Create(tmpPath, capacity, heapSize) != 0)
+        return 1;
+
+    for (i = 0; i < pHeader->capacity; i++) {
+        if (pEntries[i].state != IDMAP_ENTRY_USED)
+            continue;
+
+        if (newMap.Put((unsigned long int)pEntries[i].syncID,
+                       GetEntryAppID(i)) != 0) {
+            newMap.Close();
+            unlink(tmpPath.c_str());
+            return 2;
+        }
+    }
+
+    newMap.Sync();
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        newMap.Close();
+        unlink(tmpPath.c_str());
+        return 3;
+    }
+
+    // I take over the file of the new mapping, it is now the mapping file.
+    Unmap();
+    close(fd);
+    fd = newMap.fd;
+    pMap = newMap.pMap;
+    mapSize = newMap.mapSize;
+    newMap.fd = -1;
+    newMap.pMap = NULL;
+    newMap.mapSize = 0;
+
+    return 0;
+}
+
+/**
+ * Grow the heap.
+ *
+ * Make sure the heap has at least the given number of bytes free, doubling
+ * its size as often as needed. The heap is at the end of the file so it
+ * simply grows in place.
+ * @param minFree The number of bytes which need to be free.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully made room in the heap.
+ * @retval 1 Failed to map the grown mapping file.
+ */
+int IDMapType::GrowHeap(uint32_t minFree) {
+    struct sIDMapHeader *pHeader;
+    uint32_t capacity;
+    uint32_t heapSize;
+
+    pHeader = IDMAP_HEADER(pMap);
+    if ((uint64_t)pHeader->heapUsed + minFree <= pHeader->heapSize)
+        return 0;
+
+    capacity = pHeader->capacity;
+    heapSize = pHeader->heapSize;
+    while ((uint64_t)pHeader->heapUsed + minFree > heapSize)
+        heapSize = heapSize * 2;
+
+    msync(pMap, mapSize, MS_SYNC);
+    Unmap();
+    if (Map(capacity, heapSize, false) != 0)
+        return 1;
+
+    return 0;
+}
+
+/**
+ * Find the slot of an item.
+ *
+ * Find the slot in the sync ID table of the item with the given sync ID by
+ * linear probing. When looking an item up the capacity of the table is
+ * returned if it is not mapped. When finding a slot to insert an item into,
+ * the slot of the item is returned if it is mapped, otherwise the first
+ * deleted or empty slot along its probe sequence is returned.
+ * @param syncID The sync ID of the item.
+ * @param forInsert Flag indicating if a slot to insert into is wanted.
+ * @return The index of the slot found.
+ */
+uint32_t IDMapType::FindSlot(unsigned long int syncID, bool forInsert) const {
+    struct sIDMapEntry *pEntries;
+    uint32_t capacity;
+    uint32_t mask;
+    uint32_t slot;
+    uint32_t firstFree;
+    uint32_t i;
+
+    pEntries = IDMAP_ENTRIES(pMap);
+    capacity = IDMAP_HEADER(pMap)->capacity;
+    mask = capacity - 1;
+    firstFree = capacity;
+
+    slot = HashSyncID(syncID) & mask;
+    for (i = 0; i < capacity; i++) {
+        if (pEntries[slot].state == IDMAP_ENTRY_EMPTY) {
+            if (!forInsert)
+                return capacity;
+            return (firstFree != capacity) ? firstFree : slot;
+        } else if (pEntries[slot].state == IDMAP_ENTRY_DELETED) {
+            if (firstFree == capacity)
+                firstFree = slot;
+        } else if (pEntries[slot].syncID == (uint64_t)syncID) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    return forInsert ? firstFree : capacity;
+}
+
+/**
+ * Find the app ID slot of an item.
+ *
+ * Find the slot in the app ID table of the item with the given app ID by
+ * linear probing, the same way FindSlot() does for sync IDs.
+ * @param appID The app ID of the item.
+ * @param appIDHash The hash of the app ID of the item.
+ * @param forInsert Flag indicating if a slot to insert into is wanted.
+ * @return The index of the slot found.
+ */
+uint32_t IDMapType::FindAppSlot(const std::string &appID, uint32_t appIDHash,
+                                bool forInsert) const {
+    struct sIDMapEntry *pEntry;
+    uint32_t *pAppSlots;
+    uint32_t capacity;
+    uint32_t mask;
+    uint32_t slot;
+    uint32_t firstFree;
+    uint32_t i;
+
+    pAppSlots = IDMAP_APP_SLOTS(pMap);
+    capacity = IDMAP_HEADER(pMap)->capacity;
+    mask = capacity - 1;
+    firstFree = capacity;
+
+    slot = appIDHash & mask;
+    for (i = 0; i < capacity; i++) {
+        if (pAppSlots[slot] == IDMAP_APP_EMPTY) {
+            if (!forInsert)
+                return capacity;
+            return (firstFree != capacity) ? firstFree : slot;
+        } else if (pAppSlots[slot] == IDMAP_APP_DELETED) {
+            if (firstFree == capacity)
+                firstFree = slot;
+        } else {
+            pEntry = &IDMAP_ENTRIES(pMap)[pAppSlots[slot] - 1];
+            if ((pEntry->appIDHash == appIDHash) &&
+                (GetEntryAppID(pAppSlots[slot] - 1) == appID))
+                return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    return forInsert ? firstFree : capacity;
+}
+
+/**
+ * Get the app ID of an entry.
+ *
+ * Get the app ID stored in the heap for the entry in the given slot of the
+ * sync ID table.
+ * @param slot The slot of the entry.
+ * @return The app ID of the entry.
+ */
+std::string IDMapType::GetEntryAppID(uint32_t slot) const {
+    uint64_t appIDRef;
+
+    appIDRef = IDMAP_ENTRIES(pMap)[slot].appIDRef;
+    return std::string(IDMAP_HEAP(pMap) + IDMAP_REF_OFFSET(appIDRef),
+                       IDMAP_REF_LEN(appIDRef));
+}
+
+/**
+ * Hash a sync ID.
+ *
+ * Hash the given sync ID to pick its home slot in the sync ID table. Sync
+ * IDs are handed out sequentially by the Zaurus, so they are mixed first to
+ * spread them over the table.
+ * @param syncID The sync ID to hash.
+ * @return The hash of the sync ID.
+ */
+uint32_t IDMapType::HashSyncID(unsigned long int syncID) {
+    uint64_t x = (uint64_t)syncID;
+
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+
+    return (uint32_t)x;
+}
+
+/**
+ * Hash an app ID.
+ *
+ * Hash the given app ID to pick its home slot in the app ID table.
+ * @param appID The app ID to hash.
+ * @return The hash of the app ID.
+ */
+uint32_t IDMapType::HashAppID(const std::string &appID) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    std::string::size_type i;
+
+    for (i = 0; i < appID.size(); i++) {
+        hash ^= (unsigned char)appID[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return (uint32_t)(hash ^ (hash >> 32));
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file IDMapType.hh
+ * @brief A specifications file for an object mapping sync IDs to app IDs.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class existing to keep a persistent mapping
+ * between the sync IDs of the items on a Zaurus and the IDs the desktop
+ * application knows the same items by. It is part of the common data library
+ * so that plugins may look items up in it rather than keeping a mapping of
+ * their own.
+ */
+
+#ifndef IDMAPTYPE_H
+#define IDMAPTYPE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <string>
+
+/**
+ * @class IDMapType
+ * @brief A type representing a mapping between sync IDs and app IDs.
+ *
+ * The IDMapType is a class which represents a persistent, bidirectional
+ * mapping between the sync IDs of the items on a Zaurus and their app IDs.
+ * It is stored in a memory mapped file holding an open addressing hash table
+ * keyed by sync ID, a second table indexing the same entries by app ID, and
+ * a heap the app IDs are stored in. Hence, looking an item up either way
+ * costs the same no matter how many items are mapped. Every entry is written
+ * before it is flagged as used, so a mapping left open by a zync which died
+ * is recovered by dropping any half written entry and rebuilding the app ID
+ * index when it is next opened. A mapping is only ever used from one thread
+ * at a time.
+ *
+ * While a synchronization is running, zync makes the mapping of the type of
+ * items being synchronized available to the plugin through GetShared().
+ */
+class IDMapType {
+public:
+    IDMapType(void);
+    ~IDMapType(void);
+
+    int Open(const std::string &mapPath, uint64_t device);
+    bool IsOpen(void) const;
+    void Close(void);
+    void Sync(void);
+
+    unsigned long int GetCount(void) const;
+    bool GetAppID(unsigned long int syncID, std::string &appID) const;
+    bool GetSyncID(const std::string &appID, unsigned long int &syncID) const;
+    int Put(unsigned long int syncID, const std::string &appID);
+    void Remove(unsigned long int syncID);
+
+    static void SetShared(IDMapType *pIDMap);
+    static IDMapType *GetShared(void);
+
+private:
+    // The mapping owns its file, so it may not be copied.
+    IDMapType(const IDMapType &);
+    IDMapType &operator=(const IDMapType &);
+
+    int Create(const std::string &filePath, uint32_t capacity,
+               uint32_t heapSize);
+    int Map(uint32_t capacity, uint32_t heapSize, bool reset);
+    void Unmap(void);
+    void Recover(void);
+    int Rebuild(uint32_t capacity);
+    int GrowHeap(uint32_t minFree);
+    uint32_t FindSlot(unsigned long int syncID, bool forInsert) const;
+    uint32_t FindAppSlot(const std::string &appID, uint32_t appIDHash,
+                         bool forInsert) const;
+    std::string GetEntryAppID(uint32_t slot) const;
+
+    static uint32_t HashSyncID(unsigned long int syncID);
+    static uint32_t HashAppID(const std::string &appID);
+
+    std::string path;
+    int fd;
+    void *pMap;
+    size_t mapSize;
+
+    // The key identifying the Zaurus the mapping is of.
+    uint64_t deviceKey;
+
+    static IDMapType *pSharedMap;
+};
+
+#endif
@@ -0,0 +1,269 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file IntervalIndexType.hh
+ * @brief A specifications file for an index of time intervals.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class template existing to find the values
+ * whose time intervals overlap a given range, such as the calendar items
+ * falling within the sync window.
+ */
+
+#ifndef INTERVALINDEXTYPE_H
+#define INTERVALINDEXTYPE_H
+
+#include <time.h>
+
+#include <algorithm>
+#include <vector>
+
+/**
+ * @class IntervalIndexType
+ * @brief A type representing an index of time intervals.
+ *
+ * The IntervalIndexType is a class template which indexes values by the
+ * closed time interval each of them covers. Once every interval has been
+ * added and the index built, the values whose intervals overlap a range are
+ * found in time proportional to the log of the number of intervals plus the
+ * number found. The intervals are kept in a single array sorted by their
+ * start, which is treated as an implicit binary search tree where each node
+ * also records the latest end within its subtree, so whole subtrees which
+ * end before the range are passed over.
+ */
+template <class ValueT>
+class IntervalIndexType {
+public:
+    IntervalIndexType(void);
+
+    void Add(time_t start, time_t end, const ValueT &value);
+    void Build(void);
+    void Clear(void);
+
+    unsigned int Find(time_t rangeStart, time_t rangeEnd,
+                      std::vector<ValueT> &values) const;
+    unsigned long int GetCount(void) const;
+
+private:
+    struct sInterval {
+        time_t start;
+        time_t end;
+        time_t maxEnd;
+        ValueT value;
+        bool operator<(const struct sInterval &other) const {
+            return start < other.start;
+        }
+    };
+
+    // A subtree waiting to be searched, the node at its root, its level and
+    // whether its left half has been searched already.
+    struct sSubtree {
+        unsigned long int node;
+        int level;
+        bool leftDone;
+    };
+
+    std::vector<struct sInterval> intervals;
+    int maxLevel;
+};
+
+/**
+ * Construct a default IntervalIndexType object.
+ *
+ * Construct an IntervalIndexType object holding no intervals.
+ */
+template <class ValueT>
+IntervalIndexType<ValueT>::IntervalIndexType(void) {
+    maxLevel = -1;
+}
+
+/**
+ * Add an interval.
+ *
+ * Add the given value covering the given interval to the index. The index
+ * has to be built again before it is searched.
+ * @param start The start of the interval.
+ * @param end The end of the interval, not before its start.
+ * @param value The value the interval belongs to.
+ */
+template <class ValueT>
+void IntervalIndexType<ValueT>::Add(time_t start, time_t end,
+                                    const ValueT &value) {
+    struct sInterval interval;
+
+    interval.start = start;
+    interval.end = (end < start) ? start : end;
+    interval.maxEnd = interval.end;
+    interval.value = value;
+    intervals.push_back(interval);
+    maxLevel = -1;
+}
+
+/**
+ * Build the index.
+ *
+ * Sort the intervals added and record the latest end within each subtree
+ * of the implicit tree they form.
+ */
+template <class ValueT>
+void IntervalIndexType<ValueT>::Build(void) {
+    unsigned long int numIntervals, i, lastNode, half, step;
+    time_t lastMax, leftMax, rightMax;
+    int level;
+
+    maxLevel = -1;
+    numIntervals = intervals.size();
+    if (numIntervals == 0)
+        return;
+
+    std::sort(intervals.begin(), intervals.end());
+
+    // The leaves are the even positions.
+    lastNode = 0;
+    lastMax = intervals[0].end;
+    for (i = 0; i < numIntervals; i += 2) {
+        intervals[i].maxEnd = intervals[i].end;
+        lastNode = i;
+        lastMax = intervals[i].end;
+    }
+
+    // The tree is only complete when the number of intervals is one short
+    // of a power of two. Otherwise the right subtrees along its right edge
+    // are missing nodes, and the latest end found along that edge so far is
+    // carried up in their place.
+    for (level = 1; (1UL << level) <= numIntervals; level++) {
+        half = 1UL << (level - 1);
+        step = half << 2;
+        for (i = (half << 1) - 1; i < numIntervals; i += step) {
+            leftMax = intervals[i - half].maxEnd;
+            rightMax = (i + half < numIntervals) ?
+                intervals[i + half].maxEnd : lastMax;
+            intervals[i].maxEnd = std::max(intervals[i].end,
+                                           std::max(leftMax, rightMax));
+        }
+
+        lastNode = ((lastNode >> level) & 1) ?
+            lastNode - half : lastNode + half;
+        if ((lastNode < numIntervals) &&
+            (intervals[lastNode].maxEnd > lastMax))
+            lastMax = intervals[lastNode].maxEnd;
+    }
+
+    maxLevel = level - 1;
+}
+
+/**
+ * Clear the index.
+ *
+ * Remove every interval from the index.
+ */
+template <class ValueT>
+void IntervalIndexType<ValueT>::Clear(void) {
+    intervals.clear();
+    maxLevel = -1;
+}
+
+/**
+ * Find the overlapping intervals.
+ *
+ * Find the values whose intervals overlap the given closed range, which
+ * includes intervals merely touching it. The index has to have been built.
+ * @param rangeStart The start of the range.
+ * @param rangeEnd The end of the range.
+ * @param values Reference to the vector to append the values found to.
+ * @return The number of values found.
+ */
+template <class ValueT>
+unsigned int IntervalIndexType<ValueT>::Find(time_t rangeStart,
+    time_t rangeEnd, std::vector<ValueT> &values) const {
+    struct sSubtree stack[64];
+    struct sSubtree subtree, child;
+    unsigned long int numIntervals, first, last, i;
+    unsigned int numFound = 0;
+    int depth = 0;
+
+    if (maxLevel < 0)
+        return 0;
+
+    numIntervals = intervals.size();
+    subtree.node = (1UL << maxLevel) - 1;
+    subtree.level = maxLevel;
+    subtree.leftDone = false;
+    stack[depth++] = subtree;
+
+    while (depth > 0) {
+        subtree = stack[--depth];
+        if (subtree.level <= 3) {
+            // Small subtrees are simply scanned in order, up to the first
+            // interval starting after the range.
+            first = (subtree.node >> subtree.level) << subtree.level;
+            last = first + (1UL << (subtree.level + 1)) - 1;
+            if (last > numIntervals)
+                last = numIntervals;
+            for (i = first;
+                 (i < last) && (intervals[i].start <= rangeEnd); i++) {
+                if (intervals[i].end >= rangeStart) {
+                    values.push_back(intervals[i].value);
+                    numFound++;
+                }
+            }
+        } else if (!subtree.leftDone) {
+            // I come back to the node itself once its left subtree has been
+            // searched, which is skipped when it ends before the range.
+            child.node = subtree.node - (1UL << (subtree.level - 1));
+            child.level = subtree.level - 1;
+            child.leftDone = false;
+            subtree.leftDone = true;
+            stack[depth++] = subtree;
+            if ((child.node >= numIntervals) ||
+                (intervals[child.node].maxEnd >= rangeStart))
+                stack[depth++] = child;
+        } else if ((subtree.node < numIntervals) &&
+                   (intervals[subtree.node].start <= rangeEnd)) {
+            // Everything to the right starts no earlier than this node, so
+            // the right subtree is only searched if this node starts within
+            // the range.
+            if (intervals[subtree.node].end >= rangeStart) {
+                values.push_back(intervals[subtree.node].value);
+                numFound++;
+            }
+            child.node = subtree.node + (1UL << (subtree.level - 1));
+            child.level = subtree.level - 1;
+            child.leftDone = false;
+            stack[depth++] = child;
+        }
+    }
+
+    return numFound;
+}
+
+/**
+ * Get the number of intervals.
+ *
+ * Get the number of intervals which have been added to the index.
+ * @return The number of intervals in the index.
+ */
+template <class ValueT>
+unsigned long int IntervalIndexType<ValueT>::GetCount(void) const {
+    return (unsigned long int)intervals.size();
+}
+
+#endif
@@ -0,0 +1,619 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file ItemArchiveType.cc
+ * @brief An implementation file for a file holding a list of items.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for the classes existing to save a list of items
+ * to a binary file and to read the items back straight out of the memory
+ * mapped file.
+ */
+
+#include "ItemArchiveType.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+
+// The magic bytes and version at the front of every archive file.
+#define ARCHIVE_MAGIC "ZARC"
+#define ARCHIVE_MAGIC_SIZE 4
+#define ARCHIVE_VERSION 0x01
+
+// The layout of the header of the archive file, every value little endian.
+// The table of records, the index and the heap follow it, each starting on
+// an eight byte boundary.
+#define ARCHIVE_HEADER_SIZE 64
+#define ARCHIVE_OFF_VERSION 4
+#define ARCHIVE_OFF_SCHEMA 8
+#define ARCHIVE_OFF_NUM_FIELDS 12
+#define ARCHIVE_OFF_COUNT 16
+#define ARCHIVE_OFF_RECORD_SIZE 20
+#define ARCHIVE_OFF_TABLE 24
+#define ARCHIVE_OFF_INDEX 32
+#define ARCHIVE_OFF_HEAP 40
+#define ARCHIVE_OFF_HEAP_SIZE 48
+
+// The layout of the record of an item. The fields follow the fixed part,
+// eight bytes each, a number or the offset and size of a string in the
+// heap.
+#define RECORD_OFF_SYNC_ID 0
+#define RECORD_OFF_CREATED 8
+#define RECORD_OFF_MODIFIED 16
+#define RECORD_OFF_APP_ID 24
+#define RECORD_OFF_ATTRIBUTE 32
+#define RECORD_FIXED_SIZE 40
+#define RECORD_FIELD_SIZE 8
+
+/**
+ * Get a little endian 32 bit value.
+ *
+ * Assemble the 32 bit value stored little endian at the given address. On
+ * a little endian host this is a single load.
+ * @param pData Pointer to the bytes of the value.
+ * @return The value.
+ */
+static inline uint32_t GetLE32(const unsigned char *pData) {
+    return ((uint32_t)pData[0]) | ((uint32_t)pData[1] << 8) |
+        ((uint32_t)pData[2] << 16) | ((uint32_t)pData[3] << 24);
+}
+
+/**
+ * Get a little endian 64 bit value.
+ *
+ * Assemble the 64 bit value stored little endian at the given address.
+ * @param pData Pointer to the bytes of the value.
+ * @return The value.
+ */
+static inline uint64_t GetLE64(const unsigned char *pData) {
+    return ((uint64_t)GetLE32(pData)) | ((uint64_t)GetLE32(pData + 4) << 32);
+}
+
+/**
+ * Put a little endian 32 bit value.
+ *
+ * Store the given value little endian at the given position of a buffer.
+ * @param buff Reference to the buffer to store the value in.
+ * @param pos The position to store the value at.
+ * @param value The value to store.
+ */
+static void PutLE32(std::string &buff, std::string::size_type pos,
+                    uint32_t value) {
+    unsigned int i;
+
+    for (i = 0; i < 4; i++)
+        buff[pos + i] = (char)((value >> (i * 8)) & 0xff);
+}
+
+/**
+ * Put a little endian 64 bit value.
+ *
+ * Store the given value little endian at the given position of a buffer.
+ * @param buff Reference to the buffer to store the value in.
+ * @param pos The position to store the value at.
+ * @param value The value to store.
+ */
+static void PutLE64(std::string &buff, std::string::size_type pos,
+                    uint64_t value) {
+    PutLE32(buff, pos, (uint32_t)(value & 0xffffffff));
+    PutLE32(buff, pos + 4, (uint32_t)(value >> 32));
+}
+
+/**
+ * Round up to eight bytes.
+ *
+ * Round the given size up to the next multiple of eight.
+ * @param size The size to round.
+ * @return The rounded size.
+ */
+static inline uint64_t Align8(uint64_t size) {
+    return (size + 7) & ~(uint64_t)7;
+}
+
+/**
+ * Construct a default ItemArchiveFileType object.
+ *
+ * Construct an ItemArchiveFileType object without an archive open.
+ */
+ItemArchiveFileType::ItemArchiveFileType(void) {
+    pMap = NULL;
+    mapSize = 0;
+    count = 0;
+    recordSize = 0;
+    pTable = NULL;
+    pIndex = NULL;
+    pHeap = NULL;
+    heapSize = 0;
+}
+
+/**
+ * Destruct the ItemArchiveFileType object.
+ *
+ * Destruct the ItemArchiveFileType object, unmapping the archive if one is
+ * open.
+ */
+ItemArchiveFileType::~ItemArchiveFileType(void) {
+    Close();
+}
+
+/**
+ * Open an archive.
+ *
+ * Open and map the archive file at the given path. The header is checked
+ * against the given schema and number of fields, and every part of the
+ * file against its size, but no item is read.
+ * @param archivePath The path of the archive file.
+ * @param schema The schema the archive has to have been saved with.
+ * @param numFields The number of fields of each item.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully opened the archive.
+ * @retval 1 Failed to open the archive file, there may not be one yet.
+ * @retval 2 Failed to map the archive file.
+ * @retval 3 The file does not hold a valid archive of the schema.
+ */
+int ItemArchiveFileType::Open(const std::string &archivePath,
+                              uint32_t schema, uint32_t numFields) {
+    const unsigned char *pHeader;
+    struct stat fileStat;
+    uint64_t tableOffset, indexOffset, heapOffset;
+    void *pFileMap;
+    int fd;
+
+    Close();
+
+    fd = open(archivePath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return 1;
+
+    if (fstat(fd, &fileStat) != 0) {
+        close(fd);
+        return 1;
+    }
+    if (fileStat.st_size < (off_t)ARCHIVE_HEADER_SIZE) {
+        close(fd);
+        return 3;
+    }
+
+    // The mapping stays valid once the file is closed.
+    pFileMap = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_SHARED,
+                    fd, 0);
+    close(fd);
+    if (pFileMap == MAP_FAILED)
+        return 2;
+
+    pMap = pFileMap;
+    mapSize = (size_t)fileStat.st_size;
+    pHeader = (const unsigned char *)pMap;
+
+    count = GetLE32(pHeader + ARCHIVE_OFF_COUNT);
+    recordSize = GetLE32(pHeader + ARCHIVE_OFF_RECORD_SIZE);
+    tableOffset = GetLE64(pHeader + ARCHIVE_OFF_TABLE);
+    indexOffset = GetLE64(pHeader + ARCHIVE_OFF_INDEX);
+    heapOffset = GetLE64(pHeader + ARCHIVE_OFF_HEAP);
+    heapSize = GetLE64(pHeader + ARCHIVE_OFF_HEAP_SIZE);
+
+    // I check that the parts of the file follow each other within it, so
+    // that nothing read through them later can fall outside the mapping.
+    // Each offset is checked against the size of the file before anything
+    // is added to it, so that a corrupt offset can not wrap around.
+    if ((memcmp(pHeader, ARCHIVE_MAGIC, ARCHIVE_MAGIC_SIZE) != 0) ||
+        (GetLE32(pHeader + ARCHIVE_OFF_VERSION) != ARCHIVE_VERSION) ||
+        (GetLE32(pHeader + ARCHIVE_OFF_SCHEMA) != schema) ||
+        (GetLE32(pHeader + ARCHIVE_OFF_NUM_FIELDS) != numFields) ||
+        (recordSize != RECORD_FIXED_SIZE + numFields * RECORD_FIELD_SIZE) ||
+        (tableOffset < ARCHIVE_HEADER_SIZE) ||
+        (tableOffset > (uint64_t)mapSize) ||
+        ((uint64_t)count * recordSize > (uint64_t)mapSize - tableOffset) ||
+        (indexOffset < tableOffset + (uint64_t)count * recordSize) ||
+        (indexOffset > (uint64_t)mapSize) ||
+        ((uint64_t)count * 4 > (uint64_t)mapSize - indexOffset) ||
+        (heapOffset < indexOffset + (uint64_t)count * 4) ||
+        (heapOffset > (uint64_t)mapSize) ||
+        (heapSize > (uint64_t)mapSize - heapOffset)) {
+        Close();
+        return 3;
+    }
+
+    pTable = (const unsigned char *)pMap + tableOffset;
+    pIndex = (const unsigned char *)pMap + indexOffset;
+    pHeap = (const char *)pMap + heapOffset;
+
+    return 0;
+}
+
+/**
+ * Determine if an archive is open.
+ *
+ * Determine if an archive file is currently open.
+ * @return A boolean value representing true (yes) or false (no).
+ */
+bool ItemArchiveFileType::IsOpen(void) const {
+    return (pMap != NULL);
+}
+
+/**
+ * Close the archive.
+ *
+ * Unmap the archive file. Any string obtained from it is no longer valid.
+ */
+void ItemArchiveFileType::Close(void) {
+    if (pMap != NULL)
+        munmap(pMap, mapSize);
+
+    pMap = NULL;
+    mapSize = 0;
+    count = 0;
+    recordSize = 0;
+    pTable = NULL;
+    pIndex = NULL;
+    pHeap = NULL;
+    heapSize = 0;
+}
+
+/**
+ * Get the number of items.
+ *
+ * Get the number of items held in the archive.
+ * @return The number of items in the archive.
+ */
+unsigned long int ItemArchiveFileType::GetCount(void) const {
+    return count;
+}
+
+/**
+ * Find an item.
+ *
+ * Find the index of the item with the given sync ID by a binary search of
+ * the index of the archive.
+ * @param syncID The sync ID of the item to find.
+ * @param index Reference to store the index of the item in.
+ * @return A boolean value representing if the item was found.
+ */
+bool ItemArchiveFileType::Find(unsigned long int syncID,
+                               unsigned long int &index) const {
+    unsigned long int low = 0;
+    unsigned long int high = count;
+    unsigned long int mid;
+    uint32_t record;
+
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        record = GetLE32(pIndex + mid * 4);
+        if ((record < count) && (GetSyncID(record) < syncID))
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if (low == count)
+        return false;
+
+    record = GetLE32(pIndex + low * 4);
+    if ((record >= count) || (GetSyncID(record) != syncID))
+        return false;
+
+    index = record;
+    return true;
+}
+
+/**
+ * Get the sync ID of an item.
+ *
+ * Get the sync ID of the item at the given index of the archive.
+ * @param index The index of the item.
+ * @return The sync ID of the item.
+ */
+unsigned long int ItemArchiveFileType::GetSyncID(
+    unsigned long int index) const {
+    return (unsigned long int)GetLE64(GetRecord(index) + RECORD_OFF_SYNC_ID);
+}
+
+/**
+ * Get the attribute of an item.
+ *
+ * Get the attribute of the item at the given index of the archive.
+ * @param index The index of the item.
+ * @return The attribute of the item.
+ */
+unsigned char ItemArchiveFileType::GetAttribute(
+    unsigned long int index) const {
+    return GetRecord(index)[RECORD_OFF_ATTRIBUTE];
+}
+
+/**
+ * Get the created time of an item.
+ *
+ * Get the created time of the item at the given index of the archive.
+ * @param index The index of the item.
+ * @return The created time of the item.
+ */
+time_t ItemArchiveFileType::GetCreatedTime(unsigned long int index) const {
+    return (time_t)(int64_t)GetLE64(GetRecord(index) + RECORD_OFF_CREATED);
+}
+
+/**
+ * Get the modified time of an item.
+ *
+ * Get the modified time of the item at the given index of the archive.
+ * @param index The index of the item.
+ * @return The modified time of the item.
+ */
+time_t ItemArchiveFileType::GetModifiedTime(unsigned long int index) const {
+    return (time_t)(int64_t)GetLE64(GetRecord(index) + RECORD_OFF_MODIFIED);
+}
+
+/**
+ * Get the app ID of an item.
+ *
+ * Get the app ID of the item at the given index of the archive.
+ * @param index The index of the item.
+ * @return A reference to the app ID, valid while the archive is open.
+ */
+StringRefType ItemArchiveFileType::GetAppID(unsigned long int index) const {
+    return GetHeapString(GetRecord(index) + RECORD_OFF_APP_ID);
+}
+
+/**
+ * Get a number field of an item.
+ *
+ * Get the number field with the given number of the item at the given index
+ * of the archive.
+ * @param index The index of the item.
+ * @param field The number of the field.
+ * @return The value of the field.
+ */
+uint64_t ItemArchiveFileType::GetNumber(unsigned long int index,
+                                        unsigned int field) const {
+    return GetLE64(GetRecord(index) + RECORD_FIXED_SIZE +
+                   field * RECORD_FIELD_SIZE);
+}
+
+/**
+ * Get a string field of an item.
+ *
+ * Get the string field with the given number of the item at the given
+ * index of the archive.
+ * @param index The index of the item.
+ * @param field The number of the field.
+ * @return A reference to the value of the field, valid while the archive
+ * is open.
+ */
+StringRefType ItemArchiveFileType::GetString(unsigned long int index,
+                                             unsigned int field) const {
+    return GetHeapString(GetRecord(index) + RECORD_FIXED_SIZE +
+                         field * RECORD_FIELD_SIZE);
+}
+
+/**
+ * Get the record of an item.
+ *
+ * Get a pointer to the record of the item at the given index.
+ * @param index The index of the item.
+ * @return Pointer to the record of the item.
+ */
+const unsigned char *ItemArchiveFileType::GetRecord(
+    unsigned long int index) const {
+    return pTable + (size_t)index * recordSize;
+}
+
+/**
+ * Get a string from the heap.
+ *
+ * Get the string whose offset and size in the heap are stored at the given
+ * address. A string which does not lie within the heap is taken to be empty.
+ * @param pRef Pointer to the offset and size of the string.
+ * @return A reference to the string.
+ */
+StringRefType ItemArchiveFileType::GetHeapString(
+    const unsigned char *pRef) const {
+    uint32_t offset, size;
+
+    offset = GetLE32(pRef);
+    size = GetLE32(pRef + 4);
+    if ((uint64_t)offset + size > heapSize)
+        return StringRefType();
+
+    return StringRefType(pHeap + offset, size);
+}
+
+/**
+ * Construct an ItemArchiveBuilderType object.
+ *
+ * Construct an ItemArchiveBuilderType object laying out items with the given
+ * number of fields, to be saved with the given schema.
+ * @param schema The schema of the archive.
+ * @param numFields The number of fields of each item.
+ */
+ItemArchiveBuilderType::ItemArchiveBuilderType(uint32_t schema,
+                                               uint32_t numFields) {
+    schemaHash = schema;
+    fieldCount = numFields;
+    recordSize = RECORD_FIXED_SIZE + numFields * RECORD_FIELD_SIZE;
+}
+
+/**
+ * Reserve room for items.
+ *
+ * Reserve room for the records of the given number of items, so that they
+ * are laid out without being moved.
+ * @param numItems The number of items which will be added.
+ */
+void ItemArchiveBuilderType::Reserve(unsigned long int numItems) {
+    table.reserve((size_t)numItems * recordSize);
+    syncIDs.reserve(numItems);
+}
+
+/**
+ * Start an item.
+ *
+ * Add the record of a new item holding the given base fields. Its content
+ * fields are then put in order.
+ * @param syncID The sync ID of the item.
+ * @param attribute The attribute of the item.
+ * @param createdTime The created time of the item.
+ * @param modifiedTime The modified time of the item.
+ * @param appID The app ID of the item.
+ */
+void ItemArchiveBuilderType::StartItem(unsigned long int syncID,
+                                       unsigned char attribute,
+                                       time_t createdTime,
+                                       time_t modifiedTime,
+                                       const StringRefType &appID) {
+    std::string::size_type pos;
+
+    pos = table.size();
+    syncIDs.push_back(std::make_pair((uint64_t)syncID,
+                                     (uint32_t)(pos / recordSize)));
+
+    // I lay out the fixed part of the record now, and reserve the fields so
+    // each is filled in where it belongs as it is put.
+    table.append(RECORD_FIXED_SIZE, '\0');
+    PutLE64(table, pos + RECORD_OFF_SYNC_ID, (uint64_t)syncID);
+    PutLE64(table, pos + RECORD_OFF_CREATED, (uint64_t)(int64_t)createdTime);
+    PutLE64(table, pos + RECORD_OFF_MODIFIED,
+            (uint64_t)(int64_t)modifiedTime);
+    PutStringRef(pos + RECORD_OFF_APP_ID, appID);
+    table[pos + RECORD_OFF_ATTRIBUTE] = (char)attribute;
+}
+
+/**
+ * Put a number field.
+ *
+ * Put the next field of the current item, a number.
+ * @param value The value of the field.
+ */
+void ItemArchiveBuilderType::PutNumber(uint64_t value) {
+    std::string::size_type pos;
+
+    pos = table.size();
+    table.append(RECORD_FIELD_SIZE, '\0');
+    PutLE64(table, pos, value);
+}
+
+/**
+ * Put a string field.
+ *
+ * Put the next field of the current item, a string, whose characters are
+ * added to the heap.
+ * @param value The value of the field.
+ */
+void ItemArchiveBuilderType::PutString(const StringRefType &value) {
+    std::string::size_type pos;
+
+    pos = table.size();
+    table.append(RECORD_FIELD_SIZE, '\0');
+    PutStringRef(pos, value);
+}
+
+/**
+ * Save the archive.
+ *
+ * Save every item laid out so far to an archive file at the given path. The
+ * archive is written to a new file which then replaces the old one, so the
+ * old archive is left untouched if the process dies part way through.
+ * @param archivePath The path of the archive file.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully saved the archive.
+ * @retval 1 Failed to create the new archive file.
+ * @retval 2 Failed to write the new archive file, or the strings do not
+ * fit the four gigabytes an archive may hold.
+ * @retval 3 Failed to replace the old archive file.
+ */
+int ItemArchiveBuilderType::Save(const std::string &archivePath) const {
+    std::vector<std::pair<uint64_t, uint32_t> > sortedIDs(syncIDs);
+    std::string header(ARCHIVE_HEADER_SIZE, '\0');
+    std::string index;
+    std::string tmpPath;
+    uint64_t tableOffset, indexOffset, heapOffset;
+    unsigned long int i;
+    int fd;
+
+    if ((uint64_t)heap.size() > 0xffffffffULL)
+        return 2;
+
+    std::sort(sortedIDs.begin(), sortedIDs.end());
+    index.resize(sortedIDs.size() * 4);
+    for (i = 0; i < sortedIDs.size(); i++)
+        PutLE32(index, i * 4, sortedIDs[i].second);
+
+    tableOffset = ARCHIVE_HEADER_SIZE;
+    indexOffset = Align8(tableOffset + table.size());
+    heapOffset = Align8(indexOffset + index.size());
+    index.append((size_t)(heapOffset - indexOffset - index.size()), '\0');
+
+    memcpy(&header[0], ARCHIVE_MAGIC, ARCHIVE_MAGIC_SIZE);
+    PutLE32(header, ARCHIVE_OFF_VERSION, ARCHIVE_VERSION);
+    PutLE32(header, ARCHIVE_OFF_SCHEMA, schemaHash);
+    PutLE32(header, ARCHIVE_OFF_NUM_FIELDS, fieldCount);
+    PutLE32(header, ARCHIVE_OFF_COUNT, (uint32_t)syncIDs.size());
+    PutLE32(header, ARCHIVE_OFF_RECORD_SIZE, recordSize);
+    PutLE64(header, ARCHIVE_OFF_TABLE, tableOffset);
+    PutLE64(header, ARCHIVE_OFF_INDEX, indexOffset);
+    PutLE64(header, ARCHIVE_OFF_HEAP, heapOffset);
+    PutLE64(header, ARCHIVE_OFF_HEAP_SIZE, (uint64_t)heap.size());
+
+    tmpPath = archivePath + ".tmp";
+    fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        return 1;
+
+    // The records are a multiple of eight bytes, so the table needs no
+    // padding before the index.
+    if ((write(fd, header.data(), header.size()) !=
+            (ssize_t)header.size()) ||
+        (write(fd, table.data(), table.size()) != (ssize_t)table.size()) ||
+        (write(fd, index.data(), index.size()) != (ssize_t)index.size()) ||
+        (write(fd, heap.data(), heap.size()) != (ssize_t)heap.size()) ||
+        (fsync(fd) != 0)) {
+        close(fd);
+        unlink(tmpPath.c_str());
+        return 2;
+    }
+    close(fd);
+
+    if (rename(tmpPath.c_str(), archivePath.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return 3;
+    }
+
+    return 0;
+}
+
+/**
+ * Put a reference to a string.
+ *
+ * Add the characters of the given string to the heap and store their
+ * offset and size at the given position of the table.
+ * @param pos The position in the table to store the reference at.
+ * @param value The string to add.
+ */
+void ItemArchiveBuilderType::PutStringRef(std::string::size_type pos,
+                                          const StringRefType &value) {
+    PutLE32(table, pos, (uint32_t)heap.size());
+    PutLE32(table, pos + 4, (uint32_t)value.size());
+    heap.append(value.data(), value.size());
+}
@@ -0,0 +1,364 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file ItemArchiveType.hh
+ * @brief A specifications file for a file holding a list of items.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for the classes existing to save a list of items to
+ * a binary file and to read the items back straight out of the memory
+ * mapped file.
+ */
+
+#ifndef ITEMARCHIVETYPE_H
+#define ITEMARCHIVETYPE_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ItemType.hh"
+#include "StringRefType.hh"
+
+/**
+ * @class ItemArchiveFileType
+ * @brief A type reading an item archive file.
+ *
+ * The ItemArchiveFileType is a class which memory maps an item archive file
+ * and reads the fields of its items straight out of the mapping. An archive
+ * is laid out as a header, a table holding a fixed size record per item, an
+ * index of the records sorted by sync ID and a heap holding the characters
+ * of every string. A record holds the number fields of an item and the
+ * offset and size of each of its strings in the heap, all little endian, so
+ * reading a field is a load from the mapping and a string is returned as a
+ * reference into it. Hence, opening an archive costs the same no matter how
+ * many items it holds. The fields are numbered in the order of the content
+ * fields of the type of item, see ItemArchiveType for the typed view.
+ */
+class ItemArchiveFileType {
+public:
+    ItemArchiveFileType(void);
+    ~ItemArchiveFileType(void);
+
+    int Open(const std::string &archivePath, uint32_t schema,
+             uint32_t numFields);
+    bool IsOpen(void) const;
+    void Close(void);
+
+    unsigned long int GetCount(void) const;
+    bool Find(unsigned long int syncID, unsigned long int &index) const;
+
+    unsigned long int GetSyncID(unsigned long int index) const;
+    unsigned char GetAttribute(unsigned long int index) const;
+    time_t GetCreatedTime(unsigned long int index) const;
+    time_t GetModifiedTime(unsigned long int index) const;
+    StringRefType GetAppID(unsigned long int index) const;
+    uint64_t GetNumber(unsigned long int index, unsigned int field) const;
+    StringRefType GetString(unsigned long int index,
+                            unsigned int field) const;
+
+private:
+    // The archive owns its mapping, so it may not be copied.
+    ItemArchiveFileType(const ItemArchiveFileType &);
+    ItemArchiveFileType &operator=(const ItemArchiveFileType &);
+
+    const unsigned char *GetRecord(unsigned long int index) const;
+    StringRefType GetHeapString(const unsigned char *pRef) const;
+
+    void *pMap;
+    size_t mapSize;
+    unsigned long int count;
+    uint32_t recordSize;
+    const unsigned char *pTable;
+    const unsigned char *pIndex;
+    const char *pHeap;
+    uint64_t heapSize;
+};
+
+/**
+ * @class ItemArchiveBuilderType
+ * @brief A type writing an item archive file.
+ *
+ * The ItemArchiveBuilderType is a class which lays out the items it is
+ * given, one field at a time, in the format read by ItemArchiveFileType and
+ * saves them to a file. See ItemArchiveType for the typed way to save a
+ * list of items.
+ */
+class ItemArchiveBuilderType {
+public:
+    ItemArchiveBuilderType(uint32_t schema, uint32_t numFields);
+
+    void Reserve(unsigned long int numItems);
+    void StartItem(unsigned long int syncID, unsigned char attribute,
+                   time_t createdTime, time_t modifiedTime,
+                   const StringRefType &appID);
+    void PutNumber(uint64_t value);
+    void PutString(const StringRefType &value);
+
+    int Save(const std::string &archivePath) const;
+
+private:
+    void PutStringRef(std::string::size_type pos,
+                      const StringRefType &value);
+
+    uint32_t schemaHash;
+    uint32_t fieldCount;
+    uint32_t recordSize;
+    std::string table;
+    std::string heap;
+    std::vector<std::pair<uint64_t, uint32_t> > syncIDs;
+};
+
+/**
+ * @class ItemArchiveType
+ * @brief A type representing an item archive of a type of item.
+ *
+ * The ItemArchiveType is a class template which saves lists of the given
+ * type of item to an archive file and reads them back. Only the content
+ * fields of the items, along with their sync IDs, app IDs, attributes and
+ * times, are saved. An archive records which fields it was saved with, so
+ * an archive of another type of item, or of an older layout of the same
+ * type, is refused rather than misread. Items may be read field by field
+ * without building them, or built one at a time when needed.
+ */
+template <class ItemT>
+class ItemArchiveType : public ItemArchiveFileType {
+public:
+    int Open(const std::string &archivePath);
+
+    int GetItem(unsigned long int index, ItemT &item) const;
+    void GetItems(typename ItemT::List &itemList) const;
+
+    static int Save(const std::string &archivePath,
+                    const typename ItemT::List &itemList);
+    static int FindField(const char *pAbrev);
+
+private:
+    static bool IsArchived(const FieldDescType<ItemT> &desc) {
+        return ((desc.flags & FIELD_CONTENT) && !(desc.flags & FIELD_BASE));
+    }
+
+    static uint32_t GetNumFields(void);
+    static uint32_t GetSchema(void);
+};
+
+/**
+ * Open an archive.
+ *
+ * Open and map the archive file at the given path, checking that it was
+ * saved with the fields of this type of item.
+ * @param archivePath The path of the archive file.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully opened the archive.
+ * @retval 1 Failed to open the archive file, there may not be one yet.
+ * @retval 2 Failed to map the archive file.
+ * @retval 3 The file does not hold a valid archive of this type of item.
+ */
+template <class ItemT>
+int ItemArchiveType<ItemT>::Open(const std::string &archivePath) {
+    return ItemArchiveFileType::Open(archivePath, GetSchema(),
+                                     GetNumFields());
+}
+
+/**
+ * Get an item.
+ *
+ * Build the item at the given index of the archive.
+ * @param index The index of the item.
+ * @param item Reference to the item to store the fields in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully obtained the item.
+ * @retval 1 Failed, there is no item at the index.
+ */
+template <class ItemT>
+int ItemArchiveType<ItemT>::GetItem(unsigned long int index,
+                                    ItemT &item) const {
+    unsigned int field = 0;
+    unsigned int i;
+
+    if (index >= GetCount())
+        return 1;
+
+    item.SetSyncID(GetSyncID(index));
+    item.SetAttribute(GetAttribute(index));
+    item.SetCreatedTime(GetCreatedTime(index));
+    item.SetModifiedTime(GetModifiedTime(index));
+    item.SetAppID(GetAppID(index).str());
+
+    for (i = 0; i < ItemT::numFieldDescs; i++) {
+        const FieldDescType<ItemT> &desc = ItemT::fieldDescs[i];
+
+        if (!IsArchived(desc))
+            continue;
+
+        if (desc.pSetNumber)
+            desc.pSetNumber(item, GetNumber(index, field));
+        else
+            desc.pSetString(item, GetString(index, field).str());
+        field++;
+    }
+
+    return 0;
+}
+
+/**
+ * Get every item.
+ *
+ * Build every item of the archive, in the order they were saved in, and add
+ * them to the end of the given list.
+ * @param itemList Reference to the list to add the items to.
+ */
+template <class ItemT>
+void ItemArchiveType<ItemT>::GetItems(typename ItemT::List &itemList) const {
+    unsigned long int i;
+
+    itemList.reserve(itemList.size() + GetCount());
+    for (i = 0; i < GetCount(); i++) {
+        itemList.push_back(ItemT());
+        GetItem(i, itemList.back());
+    }
+}
+
+/**
+ * Save an archive.
+ *
+ * Save the given items to an archive file at the given path, replacing any
+ * archive already there.
+ * @param archivePath The path of the archive file.
+ * @param itemList Reference to the list of items to save.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully saved the archive.
+ * @retval 1 Failed to create the new archive file.
+ * @retval 2 Failed to write the new archive file.
+ * @retval 3 Failed to replace the old archive file.
+ */
+template <class ItemT>
+int ItemArchiveType<ItemT>::Save(const std::string &archivePath,
+                                 const typename ItemT::List &itemList) {
+    ItemArchiveBuilderType builder(GetSchema(), GetNumFields());
+    typename ItemT::List::const_iterator iter;
+    unsigned int i;
+
+    builder.Reserve(itemList.size());
+    for (iter = itemList.begin(); iter != itemList.end(); ++iter) {
+        builder.StartItem((*iter).GetSyncID(), (*iter).GetAttribute(),
+                          (*iter).GetCreatedTime(), (*iter).GetModifiedTime(),
+                          (*iter).GetAppID());
+
+        for (i = 0; i < ItemT::numFieldDescs; i++) {
+            const FieldDescType<ItemT> &desc = ItemT::fieldDescs[i];
+
+            if (!IsArchived(desc))
+                continue;
+
+            if (desc.pGetNumber)
+                builder.PutNumber(desc.pGetNumber(*iter));
+            else
+                builder.PutString(desc.pGetString(*iter));
+        }
+    }
+
+    return builder.Save(archivePath);
+}
+
+/**
+ * Find a field.
+ *
+ * Find the number of the field stored in the Zaurus parameter with the
+ * given abbreviation, as passed to GetNumber() and GetString().
+ * @param pAbrev The abbreviation of the parameter.
+ * @return The number of the field, or -1 if it is not archived.
+ */
+template <class ItemT>
+int ItemArchiveType<ItemT>::FindField(const char *pAbrev) {
+    unsigned int i;
+    int field = 0;
+
+    for (i = 0; i < ItemT::numFieldDescs; i++) {
+        const FieldDescType<ItemT> &desc = ItemT::fieldDescs[i];
+
+        if (!IsArchived(desc))
+            continue;
+
+        if (std::string(desc.pAbrev) == pAbrev)
+            return field;
+        field++;
+    }
+
+    return -1;
+}
+
+/**
+ * Get the number of fields.
+ *
+ * Get the number of fields of this type of item saved in an archive.
+ * @return The number of fields.
+ */
+template <class ItemT>
+uint32_t ItemArchiveType<ItemT>::GetNumFields(void) {
+    uint32_t numFields = 0;
+    unsigned int i;
+
+    for (i = 0; i < ItemT::numFieldDescs; i++) {
+        if (IsArchived(ItemT::fieldDescs[i]))
+            numFields++;
+    }
+
+    return numFields;
+}
+
+/**
+ * Get the schema.
+ *
+ * Get a hash of the abbreviation, type and kind of each field of this type
+ * of item saved in an archive, in order, which identifies the layout of
+ * its records.
+ * @return The schema of the archive.
+ */
+template <class ItemT>
+uint32_t ItemArchiveType<ItemT>::GetSchema(void) {
+    uint64_t hash = ITEM_HASH_SEED;
+    const char *pChar;
+    unsigned int i;
+
+    for (i = 0; i < ItemT::numFieldDescs; i++) {
+        const FieldDescType<ItemT> &desc = ItemT::fieldDescs[i];
+
+        if (!IsArchived(desc))
+            continue;
+
+        for (pChar = desc.pAbrev; *pChar != '\0'; pChar++) {
+            hash ^= (unsigned char)*pChar;
+            hash *= ITEM_HASH_PRIME;
+        }
+        hash ^= desc.typeID;
+        hash *= ITEM_HASH_PRIME;
+        hash ^= (desc.pGetNumber != NULL) ? 1 : 2;
+        hash *= ITEM_HASH_PRIME;
+    }
+
+    return (uint32_t)(hash ^ (hash >> 32));
+}
+
+#endif
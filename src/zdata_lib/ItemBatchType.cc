@@ -0,0 +1,316 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file ItemBatchType.cc
+ * @brief An implementation file for a columnar view of a list of items.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for a class existing to hold the sync IDs,
+ * attributes, times and content hashes of a list of items in dense arrays,
+ * so that items may be selected by them without walking the items.
+ */
+
+#include "ItemBatchType.hh"
+
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// The largest number of sync IDs which are compared against each item one
+// after the other, a larger index is binary searched instead.
+#define BATCH_MAX_SCAN_IDS 8
+
+/**
+ * Construct a default ItemBatchType object.
+ *
+ * Construct an ItemBatchType object holding no items.
+ */
+ItemBatchType::ItemBatchType(void) {
+
+}
+
+/**
+ * Clear the batch.
+ *
+ * Remove every item from the batch, keeping the memory of its columns for
+ * the next load.
+ */
+void ItemBatchType::Clear(void) {
+    syncIDs.clear();
+    attributes.clear();
+    createdTimes.clear();
+    modifiedTimes.clear();
+    contentHashes.clear();
+}
+
+/**
+ * Get the number of items.
+ *
+ * Get the number of items the batch was loaded with.
+ * @return The number of items in the batch.
+ */
+unsigned int ItemBatchType::GetCount(void) const {
+    return (unsigned int)syncIDs.size();
+}
+
+/**
+ * Check if the content hashes were loaded.
+ *
+ * Check if the batch holds the content hash of each of its items.
+ * @return A boolean value representing if the content hashes were loaded.
+ */
+bool ItemBatchType::HasHashes(void) const {
+    return (!syncIDs.empty() && (contentHashes.size() == syncIDs.size()));
+}
+
+/**
+ * Get the sync ID of an item.
+ *
+ * Get the sync ID of the item at the given index of the batch.
+ * @param index The index of the item.
+ * @return The sync ID of the item.
+ */
+unsigned long int ItemBatchType::GetSyncID(unsigned int index) const {
+    return (unsigned long int)syncIDs[index];
+}
+
+/**
+ * Get the attribute of an item.
+ *
+ * Get the attribute of the item at the given index of the batch.
+ * @param index The index of the item.
+ * @return The attribute of the item.
+ */
+unsigned char ItemBatchType::GetAttribute(unsigned int index) const {
+    return attributes[index];
+}
+
+/**
+ * Get the created time of an item.
+ *
+ * Get the created time of the item at the given index of the batch.
+ * @param index The index of the item.
+ * @return The created time of the item.
+ */
+time_t ItemBatchType::GetCreatedTime(unsigned int index) const {
+    return (time_t)createdTimes[index];
+}
+
+/**
+ * Get the modified time of an item.
+ *
+ * Get the modified time of the item at the given index of the batch.
+ * @param index The index of the item.
+ * @return The modified time of the item.
+ */
+time_t ItemBatchType::GetModifiedTime(unsigned int index) const {
+    return (time_t)modifiedTimes[index];
+}
+
+/**
+ * Get the content hash of an item.
+ *
+ * Get the content hash of the item at the given index of the batch.
+ * @param index The index of the item.
+ * @return The content hash of the item, zero if the hashes were not loaded.
+ */
+uint64_t ItemBatchType::GetContentHash(unsigned int index) const {
+    if (index >= contentHashes.size())
+        return 0;
+
+    return contentHashes[index];
+}
+
+/**
+ * Select the items modified after a time.
+ *
+ * Flag each item of the batch which was modified after the given time.
+ * @param when The time to compare with.
+ * @param flags Reference to the vector of flags to set, one per item.
+ * @return The number of items selected.
+ */
+unsigned int ItemBatchType::SelectModifiedAfter(time_t when,
+    std::vector<bool> &flags) const {
+    return SelectAfter(modifiedTimes, when, flags);
+}
+
+/**
+ * Select the items created after a time.
+ *
+ * Flag each item of the batch which was created after the given time.
+ * @param when The time to compare with.
+ * @param flags Reference to the vector of flags to set, one per item.
+ * @return The number of items selected.
+ */
+unsigned int ItemBatchType::SelectCreatedAfter(time_t when,
+    std::vector<bool> &flags) const {
+    return SelectAfter(createdTimes, when, flags);
+}
+
+/**
+ * Select the items with given sync IDs.
+ *
+ * Flag each item of the batch whose sync ID is in the given index. A small
+ * index is compared against every item directly, a large one is searched.
+ * @param idIndex The sorted index of the sync IDs to select.
+ * @param flags Reference to the vector of flags to set, one per item.
+ * @return The number of items selected.
+ */
+unsigned int ItemBatchType::SelectSyncIDs(
+    const std::vector<unsigned long int> &idIndex,
+    std::vector<bool> &flags) const {
+    unsigned int count = 0;
+    unsigned int numItems;
+    unsigned int i = 0;
+    unsigned int j;
+    bool found;
+
+    numItems = GetCount();
+    flags.assign(numItems, false);
+    if (idIndex.empty())
+        return 0;
+
+    if (idIndex.size() > BATCH_MAX_SCAN_IDS) {
+        for (i = 0; i < numItems; i++) {
+            if (std::binary_search(idIndex.begin(), idIndex.end(),
+                                   (unsigned long int)syncIDs[i])) {
+                flags[i] = true;
+                count++;
+            }
+        }
+        return count;
+    }
+
+#ifdef __SSE2__
+    __m128i wanted[BATCH_MAX_SCAN_IDS];
+    __m128i ids, eq, hit;
+    int mask;
+
+    for (j = 0; j < idIndex.size(); j++)
+        wanted[j] = _mm_set_epi32((int)((uint64_t)idIndex[j] >> 32),
+                                  (int)(uint32_t)idIndex[j],
+                                  (int)((uint64_t)idIndex[j] >> 32),
+                                  (int)(uint32_t)idIndex[j]);
+
+    // I compare two sync IDs at a time, each half of a sync ID separately,
+    // and only count a sync ID when both of its halves are equal.
+    for (; i + 2 <= numItems; i += 2) {
+        ids = _mm_loadu_si128((const __m128i *)&syncIDs[i]);
+        hit = _mm_setzero_si128();
+        for (j = 0; j < idIndex.size(); j++) {
+            eq = _mm_cmpeq_epi32(ids, wanted[j]);
+            eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq,
+                                                     _MM_SHUFFLE(2, 3, 0, 1)));
+            hit = _mm_or_si128(hit, eq);
+        }
+        mask = _mm_movemask_pd(_mm_castsi128_pd(hit));
+        if (mask & 1) {
+            flags[i] = true;
+            count++;
+        }
+        if (mask & 2) {
+            flags[i + 1] = true;
+            count++;
+        }
+    }
+#endif
+
+    for (; i < numItems; i++) {
+        found = false;
+        for (j = 0; (j < idIndex.size()) && !found; j++)
+            found = (syncIDs[i] == (uint64_t)idIndex[j]);
+        if (found) {
+            flags[i] = true;
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Select the times after a time.
+ *
+ * Flag each of the given times which is after the given time.
+ * @param times The column of times to compare.
+ * @param when The time to compare with.
+ * @param flags Reference to the vector of flags to set, one per time.
+ * @return The number of times selected.
+ */
+unsigned int ItemBatchType::SelectAfter(const std::vector<int64_t> &times,
+                                        time_t when,
+                                        std::vector<bool> &flags) {
+    unsigned int count = 0;
+    unsigned int numTimes;
+    unsigned int i = 0;
+
+    numTimes = (unsigned int)times.size();
+    flags.assign(numTimes, false);
+
+#ifdef __SSE2__
+    __m128i bias, limit, vals, gt, eq, after;
+    int mask;
+
+    // SSE2 has no 64 bit compare, so I compare the high halves signed and
+    // the low halves unsigned, by flipping their sign bits first, and then
+    // combine the two for each time.
+    bias = _mm_set_epi32(0, (int)0x80000000, 0, (int)0x80000000);
+    limit = _mm_xor_si128(_mm_set_epi32((int)((uint64_t)(int64_t)when >> 32),
+                                        (int)(uint32_t)(int64_t)when,
+                                        (int)((uint64_t)(int64_t)when >> 32),
+                                        (int)(uint32_t)(int64_t)when),
+                          bias);
+
+    for (; i + 2 <= numTimes; i += 2) {
+        vals = _mm_xor_si128(_mm_loadu_si128((const __m128i *)&times[i]),
+                             bias);
+        gt = _mm_cmpgt_epi32(vals, limit);
+        eq = _mm_cmpeq_epi32(vals, limit);
+        after = _mm_or_si128(_mm_shuffle_epi32(gt, _MM_SHUFFLE(3, 3, 1, 1)),
+                    _mm_and_si128(_mm_shuffle_epi32(eq,
+                                                    _MM_SHUFFLE(3, 3, 1, 1)),
+                                  _mm_shuffle_epi32(gt,
+                                                    _MM_SHUFFLE(2, 2, 0, 0))));
+        mask = _mm_movemask_pd(_mm_castsi128_pd(after));
+        if (mask == 0)
+            continue;
+        if (mask & 1) {
+            flags[i] = true;
+            count++;
+        }
+        if (mask & 2) {
+            flags[i + 1] = true;
+            count++;
+        }
+    }
+#endif
+
+    for (; i < numTimes; i++) {
+        if (times[i] > (int64_t)when) {
+            flags[i] = true;
+            count++;
+        }
+    }
+
+    return count;
+}
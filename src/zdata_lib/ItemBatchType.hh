@@ -0,0 +1,121 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file ItemBatchType.hh
+ * @brief A specifications file for a columnar view of a list of items.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class existing to hold the sync IDs,
+ * attributes, times and content hashes of a list of items in dense arrays,
+ * so that items may be selected by them without walking the items.
+ */
+
+#ifndef ITEMBATCHTYPE_H
+#define ITEMBATCHTYPE_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include <vector>
+
+/**
+ * @class ItemBatchType
+ * @brief A type representing the columns of a list of items.
+ *
+ * The ItemBatchType is a class which holds the fixed size fields of a list
+ * of items, one array per field, in the order of the list. It is loaded
+ * from a list once, after which items are selected by their modified time,
+ * created time or sync ID by scanning the arrays alone, several items at a
+ * time with SSE2 where the host has it. Hence, finding the changed items or
+ * the candidates among a large list neither touches the string data of the
+ * items nor leaves the cache for each of them.
+ *
+ * The selections fill a vector of flags, one per item of the list, which
+ * may be handed straight to EraseItems(). A batch is a snapshot, it has to
+ * be loaded again once the list it was loaded from changes.
+ */
+class ItemBatchType {
+public:
+    ItemBatchType(void);
+
+    template <class ListT>
+    void Load(const ListT &itemList, bool withHashes = false);
+    void Clear(void);
+
+    unsigned int GetCount(void) const;
+    bool HasHashes(void) const;
+
+    unsigned long int GetSyncID(unsigned int index) const;
+    unsigned char GetAttribute(unsigned int index) const;
+    time_t GetCreatedTime(unsigned int index) const;
+    time_t GetModifiedTime(unsigned int index) const;
+    uint64_t GetContentHash(unsigned int index) const;
+
+    unsigned int SelectModifiedAfter(time_t when,
+                                     std::vector<bool> &flags) const;
+    unsigned int SelectCreatedAfter(time_t when,
+                                    std::vector<bool> &flags) const;
+    unsigned int SelectSyncIDs(const std::vector<unsigned long int> &idIndex,
+                               std::vector<bool> &flags) const;
+
+private:
+    static unsigned int SelectAfter(const std::vector<int64_t> &times,
+                                    time_t when, std::vector<bool> &flags);
+
+    std::vector<uint64_t> syncIDs;
+    std::vector<unsigned char> attributes;
+    std::vector<int64_t> createdTimes;
+    std::vector<int64_t> modifiedTimes;
+    std::vector<uint64_t> contentHashes;
+};
+
+/**
+ * Load a list of items.
+ *
+ * Replace the columns of the batch with the fields of the items in the
+ * given list. The content hashes are only worked out if asked for, since
+ * they are the one column which reads the strings of each item.
+ * @param itemList Reference to the list of items to load.
+ * @param withHashes Whether the content hashes of the items are loaded.
+ */
+template <class ListT>
+void ItemBatchType::Load(const ListT &itemList, bool withHashes) {
+    typename ListT::const_iterator iter;
+
+    Clear();
+    syncIDs.reserve(itemList.size());
+    attributes.reserve(itemList.size());
+    createdTimes.reserve(itemList.size());
+    modifiedTimes.reserve(itemList.size());
+    if (withHashes)
+        contentHashes.reserve(itemList.size());
+
+    for (iter = itemList.begin(); iter != itemList.end(); ++iter) {
+        syncIDs.push_back((uint64_t)(*iter).GetSyncID());
+        attributes.push_back((*iter).GetAttribute());
+        createdTimes.push_back((int64_t)(*iter).GetCreatedTime());
+        modifiedTimes.push_back((int64_t)(*iter).GetModifiedTime());
+        if (withHashes)
+            contentHashes.push_back((*iter).ContentHash());
+    }
+}
+
+#endif
@@ -30,6 +30,8 @@
 
 #include "ItemType.hh"
 
+#include <algorithm>
+
 /**
  * Construct a default ItemType object.
  *
@@ -145,7 +147,7 @@ unsigned long int ItemType::GetSyncID(void) const {
  * application.
  * @param value The value to set the app ID to.
  */
-void ItemType::SetAppID(std::string value) {
+void ItemType::SetAppID(const std::string &value) {
     appId = value;
 }
 
@@ -153,8 +155,117 @@ void ItemType::SetAppID(std::string value) {
  * Get the App ID.
  *
  * Obtain the items ID that was given to it by the Desktop PIM application.
- * @return The value of the items app ID.
+ * @return Reference to the value of the items app ID.
  */
-std::string ItemType::GetAppID(void) const {
+const std::string &ItemType::GetAppID(void) const {
     return appId;
 }
+
+/**
+ * Swap the common fields.
+ *
+ * Exchange the fields common to all items with those of the given item,
+ * without copying the app ID of either.
+ * @param other Reference to the item to swap with.
+ */
+void ItemType::SwapBase(ItemType &other) {
+    std::swap(createdTime, other.createdTime);
+    std::swap(modifiedTime, other.modifiedTime);
+    std::swap(syncId, other.syncId);
+    appId.swap(other.appId);
+    std::swap(attribute, other.attribute);
+}
+
+/**
+ * Hash bytes.
+ *
+ * Continue the given FNV-1a hash over the given bytes.
+ * @param hash The hash to continue.
+ * @param pData Pointer to the bytes to hash.
+ * @param len The number of bytes to hash.
+ * @return The continued hash.
+ */
+uint64_t ItemType::HashBytes(uint64_t hash, const void *pData, size_t len) {
+    const unsigned char *pBytes = (const unsigned char *)pData;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        hash ^= pBytes[i];
+        hash *= ITEM_HASH_PRIME;
+    }
+
+    return hash;
+}
+
+/**
+ * Hash a number.
+ *
+ * Continue the given hash over a number. The number is always hashed as
+ * eight bytes, least significant first, so the hash is the same on any
+ * host.
+ * @param hash The hash to continue.
+ * @param value The number to hash.
+ * @return The continued hash.
+ */
+uint64_t ItemType::HashNumber(uint64_t hash, uint64_t value) {
+    unsigned char bytes[8];
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        bytes[i] = (unsigned char)(value & 0xff);
+        value >>= 8;
+    }
+
+    return HashBytes(hash, bytes, 8);
+}
+
+/**
+ * Hash a string.
+ *
+ * Continue the given hash over a string. The length of the string is
+ * hashed before its bytes, so that moving text from one field into the next
+ * changes the hash.
+ * @param hash The hash to continue.
+ * @param value The string to hash.
+ * @return The continued hash.
+ */
+uint64_t ItemType::HashString(uint64_t hash, const StringRefType &value) {
+    hash = HashNumber(hash, value.size());
+    return HashBytes(hash, value.data(), value.size());
+}
+
+/**
+ * Normalize a string.
+ *
+ * Obtain a copy of the given string with leading and trailing white space
+ * removed, each run of white space within it collapsed to a single space,
+ * and ASCII letters lowered. Two strings which only differ in the way they
+ * were typed normalize to the same string.
+ * @param value The string to normalize.
+ * @return The normalized string.
+ */
+std::string ItemType::NormalizeString(const StringRefType &value) {
+    std::string normValue;
+    std::string::size_type i;
+    bool inSpace = false;
+    char c;
+
+    normValue.reserve(value.size());
+    for (i = 0; i < value.size(); i++) {
+        c = value[i];
+        if ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n')) {
+            inSpace = true;
+            continue;
+        }
+
+        if (inSpace && !normValue.empty())
+            normValue += ' ';
+        inSpace = false;
+
+        if ((c >= 'A') && (c <= 'Z'))
+            c = c - 'A' + 'a';
+        normValue += c;
+    }
+
+    return normValue;
+}
@@ -33,13 +33,24 @@
 #define ITEMTYPE_H
 
 #include <time.h>
+#include <stdint.h>
+#include <stddef.h>
 
+#include "FieldDescType.hh"
+
+#include <algorithm>
 #include <list>
+#include <vector>
 #include <string>
 #include <iostream>
 
 typedef std::list<unsigned long int> SyncIDListType;
 
+// The offset basis and prime of the 64 bit FNV-1a hash used to hash the
+// content of items.
+#define ITEM_HASH_SEED 0xcbf29ce484222325ULL
+#define ITEM_HASH_PRIME 0x100000001b3ULL
+
 /**
  * @class ItemType
  * @brief A type representing a generic item.
@@ -66,15 +77,124 @@ class ItemType {
     void SetSyncID(unsigned long int value);
     unsigned long int GetSyncID(void) const;
 
-    void SetAppID(std::string value);
-    std::string GetAppID(void) const;
+    void SetAppID(const std::string &value);
+    const std::string &GetAppID(void) const;
+
+ protected:
+    template <class ItemT>
+    static uint64_t HashFields(const ItemT &item,
+                               unsigned char flag = FIELD_CONTENT,
+                               bool normalize = false);
+
+    static uint64_t HashBytes(uint64_t hash, const void *pData, size_t len);
+    static uint64_t HashNumber(uint64_t hash, uint64_t value);
+    static uint64_t HashString(uint64_t hash, const StringRefType &value);
+    static std::string NormalizeString(const StringRefType &value);
+
+    void SwapBase(ItemType &other);
 
  private:
-    unsigned char attribute;
+    // The attribute comes last, so the fields of the derived items may be
+    // laid out in the space after it rather than after padding.
     time_t createdTime;
     time_t modifiedTime;
     unsigned long int syncId;
     std::string appId;
+    unsigned char attribute;
 };
 
+/**
+ * Hash the content fields.
+ *
+ * Obtain a hash of the content of the given item, driven by the field
+ * descriptors of its type. The sync ID, app ID, and times are left out
+ * since they say which item this is and when it was touched, not what it
+ * holds. Hence, two items with the same content have the same content hash
+ * no matter which side they came from.
+ * @param item Reference to the item to hash.
+ * @param flag The flag of the fields to hash, FIELD_CONTENT by default.
+ * @param normalize Whether the string fields are normalized before being
+ * hashed, so that they match no matter their case and white space.
+ * @return The content hash of the item.
+ */
+template <class ItemT>
+uint64_t ItemType::HashFields(const ItemT &item, unsigned char flag,
+                              bool normalize) {
+    uint64_t hash = ITEM_HASH_SEED;
+    unsigned int i;
+
+    for (i = 0; i < ItemT::numFieldDescs; i++) {
+        const FieldDescType<ItemT> &desc = ItemT::fieldDescs[i];
+
+        if (!(desc.flags & flag))
+            continue;
+
+        if (desc.pGetNumber)
+            hash = HashNumber(hash, desc.pGetNumber(item));
+        else if (normalize)
+            hash = HashString(hash, NormalizeString(desc.pGetString(item)));
+        else
+            hash = HashString(hash, desc.pGetString(item));
+    }
+
+    return hash;
+}
+
+/**
+ * Splice items.
+ *
+ * Move every item of one list onto the end of another, leaving the first
+ * list empty. The items are swapped into place rather than copied, and an
+ * empty list simply takes over the storage of the other.
+ * @param toList Reference to the list to move the items onto.
+ * @param fromList Reference to the list to move the items from.
+ */
+template <class ListT>
+void SpliceItems(ListT &toList, ListT &fromList) {
+    typename ListT::size_type first;
+    typename ListT::size_type i;
+
+    if (toList.empty()) {
+        toList.swap(fromList);
+        return;
+    }
+
+    first = toList.size();
+    toList.resize(first + fromList.size());
+    for (i = 0; i < fromList.size(); i++)
+        std::swap(toList[first + i], fromList[i]);
+    fromList.clear();
+}
+
+/**
+ * Erase items.
+ *
+ * Remove the items flagged in the given vector from a list, keeping the
+ * rest in order. The items kept are swapped down into place rather than
+ * copied, so the list is compacted in a single pass.
+ * @param itemList Reference to the list to erase the items from.
+ * @param eraseFlags Reference to the flags saying which items to erase, one
+ * for each item in the list.
+ * @return The number of items erased.
+ */
+template <class ListT>
+unsigned int EraseItems(ListT &itemList, const std::vector<bool> &eraseFlags) {
+    typename ListT::size_type numKept = 0;
+    typename ListT::size_type numItems;
+    typename ListT::size_type i;
+
+    numItems = itemList.size();
+    for (i = 0; i < numItems; i++) {
+        if (eraseFlags[i])
+            continue;
+        if (numKept != i)
+            std::swap(itemList[numKept], itemList[i]);
+        numKept++;
+    }
+
+    itemList.erase(itemList.begin() + numKept, itemList.end());
+
+    return (unsigned int)(numItems - numKept);
+}
+
 #endif
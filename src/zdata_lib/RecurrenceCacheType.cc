@@ -0,0 +1,217 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file RecurrenceCacheType.cc
+ * @brief An implementation file for a cache of expanded occurrences.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for a class existing to keep the occurrences of
+ * many Calendar items expanded, so that repeated questions about the same
+ * range of time do not evaluate their repeat rules again.
+ */
+
+#include "RecurrenceCacheType.hh"
+
+#include <algorithm>
+#include <limits>
+
+/**
+ * Construct a default RecurrenceCacheType object.
+ *
+ * Construct a RecurrenceCacheType object holding no items.
+ */
+RecurrenceCacheType::RecurrenceCacheType(void) {
+
+}
+
+/**
+ * Update an item.
+ *
+ * Add the given item to the cache, or update it if it is already there. Its
+ * cached occurrences are kept unless its repeat rule, start or length
+ * changed.
+ * @param item Reference to the item to add or update.
+ * @return True if the cached occurrences of the item were dropped, false
+ * if they were kept.
+ */
+bool RecurrenceCacheType::Update(const CalendarItemType &item) {
+    std::map<unsigned long int, struct sEntry>::iterator fndIter;
+    RecurrenceType rule(item);
+    uint64_t ruleHash;
+
+    ruleHash = rule.GetRuleHash();
+    fndIter = entries.find(item.GetSyncID());
+    if ((fndIter != entries.end()) && (fndIter->second.ruleHash == ruleHash))
+        return false;
+
+    struct sEntry &entry = entries[item.GetSyncID()];
+    entry.rule = rule;
+    entry.ruleHash = ruleHash;
+    entry.isCached = false;
+    entry.occStarts.clear();
+
+    return true;
+}
+
+/**
+ * Remove an item.
+ *
+ * Remove the item with the given sync ID from the cache.
+ * @param syncID The sync ID of the item to remove.
+ */
+void RecurrenceCacheType::Remove(unsigned long int syncID) {
+    entries.erase(syncID);
+}
+
+/**
+ * Clear the cache.
+ *
+ * Remove every item from the cache.
+ */
+void RecurrenceCacheType::Clear(void) {
+    entries.clear();
+}
+
+/**
+ * Get the number of items.
+ *
+ * Get the number of items in the cache.
+ * @return The number of items in the cache.
+ */
+unsigned long int RecurrenceCacheType::GetCount(void) const {
+    return (unsigned long int)entries.size();
+}
+
+/**
+ * Expand the occurrences of an item within a range.
+ *
+ * Get the starts of the occurrences of the item with the given sync ID
+ * which overlap the given range, in order. The occurrences are taken from
+ * the cache, only those not cached yet being expanded. The range has to be
+ * bounded when the item repeats forever.
+ * @param syncID The sync ID of the item.
+ * @param rangeStart The start of the range.
+ * @param rangeEnd The end of the range.
+ * @param occStarts Reference to the vector to append the starts to.
+ * @return The number of occurrences found, zero if the item is not in the
+ * cache.
+ */
+unsigned int RecurrenceCacheType::Expand(unsigned long int syncID,
+    time_t rangeStart, time_t rangeEnd, std::vector<time_t> &occStarts) {
+    std::map<unsigned long int, struct sEntry>::iterator fndIter;
+    std::vector<time_t>::const_iterator first, last;
+    time_t from;
+
+    fndIter = entries.find(syncID);
+    if ((fndIter == entries.end()) || (rangeEnd < rangeStart))
+        return 0;
+
+    struct sEntry &entry = fndIter->second;
+    if (rangeStart < std::numeric_limits<time_t>::min() +
+        entry.rule.GetDuration())
+        from = std::numeric_limits<time_t>::min();
+    else
+        from = rangeStart - entry.rule.GetDuration();
+
+    Fill(entry, from, rangeEnd);
+
+    const std::vector<time_t> &cached = entry.occStarts;
+    first = std::lower_bound(cached.begin(), cached.end(), from);
+    last = std::upper_bound(first, cached.end(), rangeEnd);
+    occStarts.insert(occStarts.end(), first, last);
+
+    return (unsigned int)(last - first);
+}
+
+/**
+ * Check if an occurrence of an item overlaps a range.
+ *
+ * Check if any occurrence of the item with the given sync ID overlaps the
+ * given range. The cached occurrences are used when they cover the range,
+ * otherwise only the first overlapping occurrence is worked out, so the
+ * range may be unbounded.
+ * @param syncID The sync ID of the item.
+ * @param rangeStart The start of the range.
+ * @param rangeEnd The end of the range.
+ * @return True if an occurrence overlaps the range, false otherwise or if
+ * the item is not in the cache.
+ */
+bool RecurrenceCacheType::Overlaps(unsigned long int syncID,
+    time_t rangeStart, time_t rangeEnd) const {
+    std::map<unsigned long int, struct sEntry>::const_iterator fndIter;
+    std::vector<time_t>::const_iterator first;
+    time_t from;
+
+    fndIter = entries.find(syncID);
+    if (fndIter == entries.end())
+        return false;
+
+    const struct sEntry &entry = fndIter->second;
+    if (rangeStart < std::numeric_limits<time_t>::min() +
+        entry.rule.GetDuration())
+        from = std::numeric_limits<time_t>::min();
+    else
+        from = rangeStart - entry.rule.GetDuration();
+
+    if (!entry.isCached || (from < entry.cachedFrom) ||
+        (rangeEnd > entry.cachedTo))
+        return entry.rule.Overlaps(rangeStart, rangeEnd);
+
+    first = std::lower_bound(entry.occStarts.begin(), entry.occStarts.end(),
+                             from);
+    return ((first != entry.occStarts.end()) && (*first <= rangeEnd));
+}
+
+/**
+ * Fill the cache of an item.
+ *
+ * Make sure the cached occurrences of the given item cover every start
+ * within the given range, expanding only the parts before and after those
+ * already cached.
+ * @param entry Reference to the cache entry of the item.
+ * @param from The start of the range.
+ * @param to The end of the range.
+ */
+void RecurrenceCacheType::Fill(struct sEntry &entry, time_t from,
+                               time_t to) {
+    std::vector<time_t> before;
+
+    if (!entry.isCached) {
+        entry.occStarts.clear();
+        entry.rule.GetStarts(from, to, entry.occStarts);
+        entry.cachedFrom = from;
+        entry.cachedTo = to;
+        entry.isCached = true;
+        return;
+    }
+
+    if (from < entry.cachedFrom) {
+        entry.rule.GetStarts(from, entry.cachedFrom - 1, before);
+        entry.occStarts.insert(entry.occStarts.begin(), before.begin(),
+                               before.end());
+        entry.cachedFrom = from;
+    }
+
+    if (to > entry.cachedTo) {
+        entry.rule.GetStarts(entry.cachedTo + 1, to, entry.occStarts);
+        entry.cachedTo = to;
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file RecurrenceCacheType.hh
+ * @brief A specifications file for a cache of expanded occurrences.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class existing to keep the occurrences of
+ * many Calendar items expanded, so that repeated questions about the same
+ * range of time do not evaluate their repeat rules again.
+ */
+
+#ifndef RECURRENCECACHETYPE_H
+#define RECURRENCECACHETYPE_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include <map>
+#include <vector>
+
+#include "CalendarItemType.hh"
+#include "RecurrenceType.hh"
+
+/**
+ * @class RecurrenceCacheType
+ * @brief A type representing a cache of expanded occurrences.
+ *
+ * The RecurrenceCacheType is a class which holds the repeat rules of many
+ * Calendar items, keyed by sync ID, along with the occurrences of each
+ * which have been expanded so far. Each item caches the occurrences starting
+ * within a single range of time, which grows as wider ranges are asked for,
+ * only the part not already cached being expanded. When an item is updated
+ * its occurrences are only dropped if something they depend on changed, as
+ * told by the rule hash of the item.
+ */
+class RecurrenceCacheType {
+public:
+    RecurrenceCacheType(void);
+
+    bool Update(const CalendarItemType &item);
+    void Remove(unsigned long int syncID);
+    void Clear(void);
+    unsigned long int GetCount(void) const;
+
+    unsigned int Expand(unsigned long int syncID, time_t rangeStart,
+                        time_t rangeEnd, std::vector<time_t> &occStarts);
+    bool Overlaps(unsigned long int syncID, time_t rangeStart,
+                  time_t rangeEnd) const;
+
+private:
+    struct sEntry {
+        RecurrenceType rule;
+        uint64_t ruleHash;
+        bool isCached;
+        time_t cachedFrom;
+        time_t cachedTo;
+        std::vector<time_t> occStarts;
+    };
+
+    static void Fill(struct sEntry &entry, time_t from, time_t to);
+
+    std::map<unsigned long int, struct sEntry> entries;
+};
+
+#endif
@@ -0,0 +1,537 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file RecurrenceType.cc
+ * @brief An implementation file for the repeat rule of a Calendar item.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for a class existing to evaluate the repeat rule of
+ * a Calendar item, finding its occurrences within a range of time.
+ */
+
+#include "RecurrenceType.hh"
+
+#include <limits.h>
+
+#include <algorithm>
+#include <limits>
+
+// The number of seconds in a day.
+#define SECS_PER_DAY 86400
+
+// The number of months looked through for an occurrence before giving up.
+// Only Yearly items on the 29th of February skip more than a few.
+#define MAX_SKIPPED_MONTHS 120
+
+/**
+ * Get the day number of a date.
+ *
+ * Get the number of days between the 1st of January 1970 and the given date
+ * of the proleptic Gregorian calendar.
+ * @param year The year.
+ * @param month The month, from 1 to 12.
+ * @param day The day of the month, from 1 to 31.
+ * @return The day number of the date.
+ */
+static long int DaysFromCivil(long int year, int month, int day) {
+    long int era, yearOfEra, dayOfYear, dayOfEra;
+
+    year -= (month <= 2) ? 1 : 0;
+    era = ((year >= 0) ? year : year - 399) / 400;
+    yearOfEra = year - era * 400;
+    dayOfYear = (153 * (month + ((month > 2) ? -3 : 9)) + 2) / 5 + day - 1;
+    dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+    return era * 146097 + dayOfEra - 719468;
+}
+
+/**
+ * Get the date of a day number.
+ *
+ * Get the date of the proleptic Gregorian calendar the given number of days
+ * after the 1st of January 1970.
+ * @param dayNum The day number.
+ * @param year Reference to store the year in.
+ * @param month Reference to store the month, from 1 to 12, in.
+ * @param day Reference to store the day of the month in.
+ */
+static void CivilFromDays(long int dayNum, long int &year, int &month,
+                          int &day) {
+    long int era, dayOfEra, yearOfEra, dayOfYear, monthPos;
+
+    dayNum += 719468;
+    era = ((dayNum >= 0) ? dayNum : dayNum - 146096) / 146097;
+    dayOfEra = dayNum - era * 146097;
+    yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 -
+                 dayOfEra / 146096) / 365;
+    dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 -
+                            yearOfEra / 100);
+    monthPos = (5 * dayOfYear + 2) / 153;
+
+    day = (int)(dayOfYear - (153 * monthPos + 2) / 5 + 1);
+    month = (int)((monthPos < 10) ? monthPos + 3 : monthPos - 9);
+    year = yearOfEra + era * 400 + ((month <= 2) ? 1 : 0);
+}
+
+/**
+ * Get the weekday of a day number.
+ *
+ * Get the weekday of the given day number, counting from Monday as 0 to
+ * match the bits of the repeat date.
+ * @param dayNum The day number.
+ * @return The weekday, from 0 (Monday) to 6 (Sunday).
+ */
+static int WeekDay(long int dayNum) {
+    // The 1st of January 1970 was a Thursday.
+    return (int)(((dayNum % 7) + 7 + 3) % 7);
+}
+
+/**
+ * Get the number of days in a month.
+ *
+ * Get the number of days in the given month of the given year.
+ * @param year The year.
+ * @param month The month, from 1 to 12.
+ * @return The number of days in the month.
+ */
+static int DaysInMonth(long int year, int month) {
+    static const int monthDays[] = {
+        31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+    };
+
+    if ((month == 2) &&
+        (((year % 4) == 0) && (((year % 100) != 0) || ((year % 400) == 0))))
+        return 29;
+
+    return monthDays[month - 1];
+}
+
+/**
+ * Get the local day number of a time.
+ *
+ * Get the day number of the local date the given time falls on.
+ * @param when The time.
+ * @param dayNum Reference to store the day number in.
+ * @return True if the time could be converted, false otherwise.
+ */
+static bool LocalDayNum(time_t when, long int &dayNum) {
+    struct tm localTm;
+
+    if (localtime_r(&when, &localTm) == NULL)
+        return false;
+
+    dayNum = DaysFromCivil((long int)localTm.tm_year + 1900,
+                           localTm.tm_mon + 1, localTm.tm_mday);
+    return true;
+}
+
+/**
+ * Construct a default RecurrenceType object.
+ *
+ * Construct a RecurrenceType object with a single occurrence at the Epoch
+ * lasting no time at all.
+ */
+RecurrenceType::RecurrenceType(void) {
+    seriesStart = 0;
+    duration = 0;
+    repeatType = REPEAT_NONE;
+    period = 1;
+    position = 1;
+    weekDays = 0;
+    hasEnd = false;
+    monthDay = 1;
+    firstDay = 0;
+    lastDay = LONG_MAX;
+    hour = 0;
+    minute = 0;
+    second = 0;
+}
+
+/**
+ * Construct a RecurrenceType object for an item.
+ *
+ * Construct a RecurrenceType object representing the repeat rule of the
+ * given Calendar item.
+ * @param item Reference to the item whose repeat rule to represent.
+ */
+RecurrenceType::RecurrenceType(const CalendarItemType &item) {
+    SetItem(item);
+}
+
+/**
+ * Set the item.
+ *
+ * Set the Calendar item whose repeat rule this object represents. All day
+ * items occur from the start of their first day to the end of their last.
+ * @param item Reference to the item whose repeat rule to represent.
+ */
+void RecurrenceType::SetItem(const CalendarItemType &item) {
+    struct tm localTm;
+
+    if ((item.GetScheduleType() == 1) && (item.GetAllDayStartDate() != 0)) {
+        seriesStart = item.GetAllDayStartDate();
+        duration = std::max(item.GetAllDayEndDate(), seriesStart) -
+            seriesStart + SECS_PER_DAY - 1;
+    } else {
+        seriesStart = item.GetStartTime();
+        duration = std::max(item.GetEndTime(), seriesStart) - seriesStart;
+    }
+
+    repeatType = item.GetRepeatType();
+    if (repeatType > REPEAT_YEARLY)
+        repeatType = REPEAT_NONE;
+
+    period = item.GetRepeatPeriod();
+    if (period == 0)
+        period = 1;
+
+    firstDay = 0;
+    monthDay = 1;
+    hour = 0;
+    minute = 0;
+    second = 0;
+    if (localtime_r(&seriesStart, &localTm) != NULL) {
+        firstDay = DaysFromCivil((long int)localTm.tm_year + 1900,
+                                 localTm.tm_mon + 1, localTm.tm_mday);
+        monthDay = localTm.tm_mday;
+        hour = localTm.tm_hour;
+        minute = localTm.tm_min;
+        second = localTm.tm_sec;
+    } else {
+        repeatType = REPEAT_NONE;
+    }
+
+    // Weekly items without any days set repeat on the day they start, and
+    // Monthly Day items without a position in the week they start.
+    weekDays = item.GetRepeatDate() & REPEAT_DAYS_MASK;
+    if (weekDays == 0)
+        weekDays = (unsigned char)(1 << WeekDay(firstDay));
+
+    position = item.GetRepeatPosition();
+    if (position == 0)
+        position = (unsigned short int)((monthDay - 1) / 7 + 1);
+
+    hasEnd = (item.GetRepeatEndDateSetting() != 0);
+    lastDay = LONG_MAX;
+    if (hasEnd && !LocalDayNum(item.GetRepeatEndDate(), lastDay))
+        hasEnd = false;
+}
+
+/**
+ * Check if the item repeats.
+ *
+ * Check if the item has any occurrence other than its start.
+ * @return True if the item repeats, false otherwise.
+ */
+bool RecurrenceType::IsRepeating(void) const {
+    return (repeatType != REPEAT_NONE);
+}
+
+/**
+ * Get the duration.
+ *
+ * Get the length of time each occurrence of the item lasts.
+ * @return The duration of each occurrence in seconds.
+ */
+time_t RecurrenceType::GetDuration(void) const {
+    return duration;
+}
+
+/**
+ * Get the rule hash.
+ *
+ * Obtain a hash of everything the occurrences of the item depend on. Two
+ * items with the same rule hash occur at the same times, so an item whose
+ * rule hash did not change keeps its expanded occurrences.
+ * @return The rule hash of the item.
+ */
+uint64_t RecurrenceType::GetRuleHash(void) const {
+    uint64_t values[8];
+    uint64_t hash = ITEM_HASH_SEED;
+    unsigned int i, j;
+
+    values[0] = (uint64_t)seriesStart;
+    values[1] = (uint64_t)duration;
+    values[2] = repeatType;
+    values[3] = period;
+    values[4] = position;
+    values[5] = weekDays;
+    values[6] = hasEnd ? 1 : 0;
+    values[7] = (uint64_t)lastDay;
+
+    for (i = 0; i < 8; i++) {
+        for (j = 0; j < 8; j++) {
+            hash ^= (values[i] >> (j * 8)) & 0xff;
+            hash *= ITEM_HASH_PRIME;
+        }
+    }
+
+    return hash;
+}
+
+/**
+ * Get the next start.
+ *
+ * Get the start of the first occurrence of the item starting at or after
+ * the given time. It is worked out directly from the repeat rule rather than
+ * by walking the series.
+ * @param from The time the occurrence may start at the earliest.
+ * @param occStart Reference to store the start of the occurrence in.
+ * @return True if there is such an occurrence, false otherwise.
+ */
+bool RecurrenceType::GetNextStart(time_t from, time_t &occStart) const {
+    long int fromDay, dayNum, weekStart, firstWeek, numWeeks;
+    long int monthNum, firstMonth, stride;
+    struct tm localTm;
+    long int year;
+    int month, day, i;
+    time_t when;
+
+    if (from <= seriesStart) {
+        occStart = seriesStart;
+        return true;
+    }
+
+    if ((repeatType == REPEAT_NONE) || !LocalDayNum(from, fromDay))
+        return false;
+
+    switch (repeatType) {
+    case REPEAT_DAILY:
+        dayNum = firstDay + ((fromDay - firstDay + period - 1) / period) *
+            period;
+        when = MakeTime(dayNum);
+        if (when < from) {
+            dayNum += period;
+            when = MakeTime(dayNum);
+        }
+        if (dayNum > lastDay)
+            return false;
+        occStart = when;
+        return true;
+
+    case REPEAT_WEEKLY:
+        // The weeks run from Monday, every period weeks counting from the
+        // week the item starts in.
+        firstWeek = firstDay - WeekDay(firstDay);
+        weekStart = fromDay - WeekDay(fromDay);
+        numWeeks = (weekStart - firstWeek) / 7;
+        if ((numWeeks % period) != 0) {
+            weekStart = firstWeek + (numWeeks / period + 1) * period * 7;
+            fromDay = weekStart;
+        }
+        while (weekStart <= lastDay) {
+            if (FindInWeek(weekStart, fromDay, from, occStart))
+                return true;
+            weekStart += (long int)period * 7;
+            fromDay = weekStart;
+        }
+        return false;
+
+    default:
+        // The month based rules are evaluated one month at a time, starting
+        // from the last month of the series before the given time.
+        stride = (repeatType == REPEAT_YEARLY) ? 12L * period : period;
+        CivilFromDays(firstDay, year, month, day);
+        firstMonth = year * 12 + (month - 1);
+        if (localtime_r(&from, &localTm) == NULL)
+            return false;
+        monthNum = ((long int)localTm.tm_year + 1900) * 12 + localTm.tm_mon;
+        monthNum = firstMonth + ((monthNum - firstMonth) / stride) * stride;
+
+        for (i = 0; i < MAX_SKIPPED_MONTHS; i++, monthNum += stride) {
+            if (!GetMonthDay(monthNum, dayNum))
+                continue;
+            if (dayNum > lastDay)
+                return false;
+            when = MakeTime(dayNum);
+            if (when >= from) {
+                occStart = when;
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+/**
+ * Get the starts of occurrences.
+ *
+ * Get the starts of the occurrences of the item starting within the given
+ * range, in order. The range has to be bounded when the item repeats
+ * forever.
+ * @param from The start of the range.
+ * @param to The end of the range.
+ * @param occStarts Reference to the vector to append the starts to.
+ * @return The number of occurrences found.
+ */
+unsigned int RecurrenceType::GetStarts(time_t from, time_t to,
+                                       std::vector<time_t> &occStarts) const {
+    unsigned int numFound = 0;
+    time_t occStart;
+
+    while ((from <= to) && GetNextStart(from, occStart) && (occStart <= to)) {
+        occStarts.push_back(occStart);
+        numFound++;
+        if (occStart == std::numeric_limits<time_t>::max())
+            break;
+        from = occStart + 1;
+    }
+
+    return numFound;
+}
+
+/**
+ * Expand the occurrences within a range.
+ *
+ * Get the starts of the occurrences of the item which overlap the given
+ * range, in order, including those which started before it but have not
+ * ended yet. The range has to be bounded when the item repeats forever.
+ * @param rangeStart The start of the range.
+ * @param rangeEnd The end of the range.
+ * @param occStarts Reference to the vector to append the starts to.
+ * @return The number of occurrences found.
+ */
+unsigned int RecurrenceType::Expand(time_t rangeStart, time_t rangeEnd,
+                                    std::vector<time_t> &occStarts) const {
+    time_t from;
+
+    if (rangeStart < std::numeric_limits<time_t>::min() + duration)
+        from = std::numeric_limits<time_t>::min();
+    else
+        from = rangeStart - duration;
+
+    return GetStarts(from, rangeEnd, occStarts);
+}
+
+/**
+ * Check if an occurrence overlaps a range.
+ *
+ * Check if any occurrence of the item overlaps the given range. Only the
+ * first such occurrence is worked out, so the range may be unbounded.
+ * @param rangeStart The start of the range.
+ * @param rangeEnd The end of the range.
+ * @return True if an occurrence overlaps the range, false otherwise.
+ */
+bool RecurrenceType::Overlaps(time_t rangeStart, time_t rangeEnd) const {
+    time_t from, occStart;
+
+    if (rangeStart < std::numeric_limits<time_t>::min() + duration)
+        from = std::numeric_limits<time_t>::min();
+    else
+        from = rangeStart - duration;
+
+    return (GetNextStart(from, occStart) && (occStart <= rangeEnd));
+}
+
+/**
+ * Make the time of an occurrence.
+ *
+ * Make the time of the occurrence falling on the given local day, at the
+ * time of day the item starts.
+ * @param dayNum The local day number of the occurrence.
+ * @return The time of the occurrence.
+ */
+time_t RecurrenceType::MakeTime(long int dayNum) const {
+    struct tm localTm;
+    long int year;
+    int month, day;
+
+    CivilFromDays(dayNum, year, month, day);
+
+    localTm.tm_year = (int)(year - 1900);
+    localTm.tm_mon = month - 1;
+    localTm.tm_mday = day;
+    localTm.tm_hour = hour;
+    localTm.tm_min = minute;
+    localTm.tm_sec = second;
+    localTm.tm_isdst = -1;
+
+    return mktime(&localTm);
+}
+
+/**
+ * Find an occurrence within a week.
+ *
+ * Find the first occurrence of a Weekly item within the week starting on the
+ * given day which falls on or after the given day and time.
+ * @param weekStart The day number of the Monday of the week.
+ * @param fromDay The day number to start looking from.
+ * @param from The time the occurrence may start at the earliest.
+ * @param occStart Reference to store the start of the occurrence in.
+ * @return True if an occurrence was found, false otherwise.
+ */
+bool RecurrenceType::FindInWeek(long int weekStart, long int fromDay,
+                                time_t from, time_t &occStart) const {
+    long int dayNum;
+    time_t when;
+
+    for (dayNum = std::max(weekStart, fromDay); dayNum < weekStart + 7;
+         dayNum++) {
+        if (dayNum > lastDay)
+            return false;
+        if ((weekDays & (1 << WeekDay(dayNum))) == 0)
+            continue;
+        when = MakeTime(dayNum);
+        if (when >= from) {
+            occStart = when;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Get the day of a month based occurrence.
+ *
+ * Get the day number of the occurrence of a Monthly Day, Monthly Date or
+ * Yearly item within the given month.
+ * @param monthNum The month, as the number of months since year 0.
+ * @param dayNum Reference to store the day number of the occurrence in.
+ * @return True if the item has an occurrence in the month, false otherwise.
+ */
+bool RecurrenceType::GetMonthDay(long int monthNum, long int &dayNum) const {
+    long int year, firstOfMonth, lastOfMonth;
+    int month, startWeekDay, numDays;
+
+    year = monthNum / 12;
+    month = (int)(monthNum - year * 12) + 1;
+    numDays = DaysInMonth(year, month);
+    firstOfMonth = DaysFromCivil(year, month, 1);
+
+    if (repeatType != REPEAT_MONTHLY_DAY) {
+        if (monthDay > numDays)
+            return false;
+        dayNum = firstOfMonth + monthDay - 1;
+        return true;
+    }
+
+    startWeekDay = WeekDay(firstDay);
+    if (position >= 5) {
+        lastOfMonth = firstOfMonth + numDays - 1;
+        dayNum = lastOfMonth - ((WeekDay(lastOfMonth) - startWeekDay + 7) % 7);
+        return true;
+    }
+
+    dayNum = firstOfMonth + ((startWeekDay - WeekDay(firstOfMonth) + 7) % 7) +
+        (long int)(position - 1) * 7;
+    return true;
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file RecurrenceType.hh
+ * @brief A specifications file for the repeat rule of a Calendar item.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class existing to evaluate the repeat rule of
+ * a Calendar item, finding its occurrences within a range of time.
+ */
+
+#ifndef RECURRENCETYPE_H
+#define RECURRENCETYPE_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include <vector>
+
+#include "CalendarItemType.hh"
+
+// The repeat types of a Calendar item.
+#define REPEAT_DAILY 0
+#define REPEAT_WEEKLY 1
+#define REPEAT_MONTHLY_DAY 2
+#define REPEAT_MONTHLY_DATE 3
+#define REPEAT_YEARLY 4
+#define REPEAT_NONE 0xff
+
+// The bits of the repeat date, Monday is the lowest.
+#define REPEAT_DAYS_MASK 0x7f
+
+/**
+ * @class RecurrenceType
+ * @brief A type representing the repeat rule of a Calendar item.
+ *
+ * The RecurrenceType is a class which represents the repeat rule of a
+ * Calendar item, that is its repeat type, period, position, days and end
+ * date. It finds the occurrences of the item within any range of time by
+ * working out the first one in the range directly from the rule, so a
+ * series is never walked from its start. Occurrences are computed on the
+ * local calendar, so they keep their time of day across daylight saving
+ * changes. The first occurrence is always the start of the item itself.
+ * Monthly Day items repeat on the weekday of their start, in the week of
+ * the month given by their repeat position, with 5 meaning the last week.
+ * Dates a Monthly Date or Yearly item can not fall on, such as the 31st of
+ * a shorter month, are skipped.
+ */
+class RecurrenceType {
+public:
+    RecurrenceType(void);
+    RecurrenceType(const CalendarItemType &item);
+
+    void SetItem(const CalendarItemType &item);
+
+    bool IsRepeating(void) const;
+    time_t GetDuration(void) const;
+    uint64_t GetRuleHash(void) const;
+
+    bool GetNextStart(time_t from, time_t &occStart) const;
+    unsigned int GetStarts(time_t from, time_t to,
+                           std::vector<time_t> &occStarts) const;
+    unsigned int Expand(time_t rangeStart, time_t rangeEnd,
+                        std::vector<time_t> &occStarts) const;
+    bool Overlaps(time_t rangeStart, time_t rangeEnd) const;
+
+private:
+    time_t MakeTime(long int dayNum) const;
+    bool FindInWeek(long int weekStart, long int fromDay, time_t from,
+                    time_t &occStart) const;
+    bool GetMonthDay(long int monthNum, long int &dayNum) const;
+
+    time_t seriesStart;
+    time_t duration;
+    unsigned char repeatType;
+    unsigned short int period;
+    unsigned short int position;
+    unsigned char weekDays;
+    bool hasEnd;
+    int monthDay;
+
+    // The local day number of the first and last days occurrences may fall
+    // on, and the local time of day of every occurrence.
+    long int firstDay;
+    long int lastDay;
+    int hour;
+    int minute;
+    int second;
+};
+
+#endif
@@ -0,0 +1,309 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file StringBlockType.hh
+ * @brief A specifications file for a block holding the strings of an item.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class template existing to hold all of the
+ * string fields of an item in a single contiguous block of memory.
+ */
+
+#ifndef STRINGBLOCKTYPE_H
+#define STRINGBLOCKTYPE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+#include <string>
+
+#include "StringRefType.hh"
+
+/**
+ * @class StringBlockType
+ * @brief A type representing the strings of an item.
+ *
+ * The StringBlockType is a class template which holds a fixed number of
+ * strings, the string fields of an item, in one block of memory allocated
+ * for the item. The block starts with the offset each string ends at,
+ * followed by the characters of every string one after the other. Hence, an
+ * item costs a single pointer until one of its strings is set, a single
+ * allocation once they are, and its strings are read from memory that is
+ * close together. Setting a string moves the strings after it, which is
+ * cheap since the strings of an item are small and normally set in order.
+ * A copy is allocated exactly as large as the strings it holds.
+ */
+template <unsigned int NumStrings>
+class StringBlockType {
+public:
+    StringBlockType(void);
+    StringBlockType(const StringBlockType &other);
+    ~StringBlockType(void);
+
+    StringBlockType &operator=(const StringBlockType &other);
+
+    StringRefType Get(unsigned int index) const;
+    const char *GetData(unsigned int index) const;
+    uint32_t GetSize(unsigned int index) const;
+    void Set(unsigned int index, const std::string &value);
+    void Set(unsigned int index, const char *pData, uint32_t size);
+
+    size_t GetAllocSize(void) const;
+    void Swap(StringBlockType &other);
+
+private:
+    // The layout of the front of the block, the characters follow it.
+    struct sHeader {
+        uint32_t capacity;
+        uint32_t ends[NumStrings];
+    };
+
+    struct sHeader *GetHeader(void) const {
+        return (struct sHeader *)pBlock;
+    }
+    char *GetChars(void) const { return pBlock + sizeof(struct sHeader); }
+    uint32_t GetStart(unsigned int index) const {
+        return (index == 0) ? 0 : GetHeader()->ends[index - 1];
+    }
+    uint32_t GetTotalSize(void) const {
+        return (pBlock == NULL) ? 0 : GetHeader()->ends[NumStrings - 1];
+    }
+
+    char *pBlock;
+};
+
+/**
+ * Construct a default StringBlockType object.
+ *
+ * Construct a StringBlockType object whose strings are all empty, without
+ * allocating a block.
+ */
+template <unsigned int NumStrings>
+StringBlockType<NumStrings>::StringBlockType(void) {
+    pBlock = NULL;
+}
+
+/**
+ * Construct a copy of a StringBlockType object.
+ *
+ * Construct a StringBlockType object holding the same strings as the given
+ * one, in a block just large enough for them.
+ * @param other Reference to the object to copy.
+ */
+template <unsigned int NumStrings>
+StringBlockType<NumStrings>::StringBlockType(const StringBlockType &other) {
+    uint32_t totalSize;
+
+    pBlock = NULL;
+    totalSize = other.GetTotalSize();
+    if (totalSize == 0)
+        return;
+
+    pBlock = (char *)malloc(sizeof(struct sHeader) + totalSize);
+    if (pBlock == NULL)
+        throw std::bad_alloc();
+
+    memcpy(pBlock, other.pBlock, sizeof(struct sHeader) + totalSize);
+    GetHeader()->capacity = totalSize;
+}
+
+/**
+ * Destruct the StringBlockType object.
+ *
+ * Destruct the StringBlockType object by freeing its block.
+ */
+template <unsigned int NumStrings>
+StringBlockType<NumStrings>::~StringBlockType(void) {
+    free(pBlock);
+}
+
+/**
+ * Assign a StringBlockType object.
+ *
+ * Replace the strings of this object with a copy of those of the given one.
+ * @param other Reference to the object to copy.
+ * @return Reference to this object.
+ */
+template <unsigned int NumStrings>
+StringBlockType<NumStrings> &StringBlockType<NumStrings>::operator=(
+    const StringBlockType &other) {
+    if (this != &other) {
+        StringBlockType copy(other);
+        Swap(copy);
+    }
+
+    return *this;
+}
+
+/**
+ * Get a string.
+ *
+ * Get a reference to the string at the given index, which stays valid until
+ * a string is set.
+ * @param index The index of the string.
+ * @return Reference to the string at the index.
+ */
+template <unsigned int NumStrings>
+StringRefType StringBlockType<NumStrings>::Get(unsigned int index) const {
+    if (pBlock == NULL)
+        return StringRefType();
+
+    return StringRefType(GetData(index), GetSize(index));
+}
+
+/**
+ * Get the characters of a string.
+ *
+ * Get a pointer to the characters of the string at the given index, which
+ * are not terminated. It stays valid until a string is set.
+ * @param index The index of the string.
+ * @return Pointer to the characters of the string.
+ */
+template <unsigned int NumStrings>
+const char *StringBlockType<NumStrings>::GetData(unsigned int index) const {
+    if (pBlock == NULL)
+        return "";
+
+    return GetChars() + GetStart(index);
+}
+
+/**
+ * Get the size of a string.
+ *
+ * Get the number of characters of the string at the given index.
+ * @param index The index of the string.
+ * @return The size of the string.
+ */
+template <unsigned int NumStrings>
+uint32_t StringBlockType<NumStrings>::GetSize(unsigned int index) const {
+    if (pBlock == NULL)
+        return 0;
+
+    return GetHeader()->ends[index] - GetStart(index);
+}
+
+/**
+ * Set a string.
+ *
+ * Set the string at the given index to the given value.
+ * @param index The index of the string.
+ * @param value The value to set the string to.
+ */
+template <unsigned int NumStrings>
+void StringBlockType<NumStrings>::Set(unsigned int index,
+                                      const std::string &value) {
+    Set(index, value.data(), (uint32_t)value.size());
+}
+
+/**
+ * Set a string from characters.
+ *
+ * Set the string at the given index to the given characters, growing the
+ * block if they do not fit.
+ * @param index The index of the string.
+ * @param pData Pointer to the characters to set the string to.
+ * @param size The number of characters.
+ */
+template <unsigned int NumStrings>
+void StringBlockType<NumStrings>::Set(unsigned int index, const char *pData,
+                                      uint32_t size) {
+    uint32_t start, oldSize, totalSize, newTotalSize, capacity;
+    std::string ownData;
+    char *pNewBlock;
+    unsigned int i;
+
+    if (pBlock == NULL) {
+        if (size == 0)
+            return;
+        pBlock = (char *)malloc(sizeof(struct sHeader) + size);
+        if (pBlock == NULL)
+            throw std::bad_alloc();
+        memset(pBlock, 0, sizeof(struct sHeader));
+        GetHeader()->capacity = size;
+    }
+
+    // The characters may come from this very block, which may be moved.
+    if ((pData >= GetChars()) &&
+        (pData < GetChars() + GetHeader()->capacity)) {
+        ownData.assign(pData, size);
+        pData = ownData.data();
+    }
+
+    start = GetStart(index);
+    oldSize = GetHeader()->ends[index] - start;
+    totalSize = GetTotalSize();
+    newTotalSize = totalSize - oldSize + size;
+
+    if (newTotalSize > GetHeader()->capacity) {
+        capacity = GetHeader()->capacity + GetHeader()->capacity / 2;
+        if (capacity < newTotalSize)
+            capacity = newTotalSize;
+        pNewBlock = (char *)realloc(pBlock,
+                                    sizeof(struct sHeader) + capacity);
+        if (pNewBlock == NULL)
+            throw std::bad_alloc();
+        pBlock = pNewBlock;
+        GetHeader()->capacity = capacity;
+    }
+
+    memmove(GetChars() + start + size, GetChars() + start + oldSize,
+            totalSize - start - oldSize);
+    if (size > 0)
+        memcpy(GetChars() + start, pData, size);
+
+    for (i = index; i < NumStrings; i++)
+        GetHeader()->ends[i] = GetHeader()->ends[i] - oldSize + size;
+}
+
+/**
+ * Get the size of the block.
+ *
+ * Get the number of bytes allocated for the block, zero if every string has
+ * always been empty.
+ * @return The size of the block in bytes.
+ */
+template <unsigned int NumStrings>
+size_t StringBlockType<NumStrings>::GetAllocSize(void) const {
+    if (pBlock == NULL)
+        return 0;
+
+    return sizeof(struct sHeader) + GetHeader()->capacity;
+}
+
+/**
+ * Swap with another StringBlockType object.
+ *
+ * Exchange the strings of this object with those of the given one, by
+ * exchanging their blocks rather than copying any string.
+ * @param other Reference to the object to swap with.
+ */
+template <unsigned int NumStrings>
+void StringBlockType<NumStrings>::Swap(StringBlockType &other) {
+    char *pOldBlock;
+
+    pOldBlock = pBlock;
+    pBlock = other.pBlock;
+    other.pBlock = pOldBlock;
+}
+
+#endif
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file StringPoolType.cc
+ * @brief An implementation file for a table of interned strings.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for a class existing to store each distinct value
+ * of the highly repetitive string fields of items once, handing out a small
+ * integer handle for it.
+ */
+
+#include "StringPoolType.hh"
+
+// The number of slots the hash table starts out with, which has to be a
+// power of two.
+#define POOL_INITIAL_SLOTS 64
+
+/**
+ * Construct a default StringPoolType object.
+ *
+ * Construct a StringPoolType object holding only the empty string, under
+ * the handle zero.
+ */
+StringPoolType::StringPoolType(void) {
+    pthread_mutex_init(&mutex, NULL);
+
+    values.push_back(std::string());
+    hashes.push_back(HashString(values.back()));
+    slots.resize(POOL_INITIAL_SLOTS, 0);
+    slots[FindSlot(values.back(), hashes.back())] = 1;
+}
+
+/**
+ * Destruct the StringPoolType object.
+ *
+ * Destruct the StringPoolType object, freeing every string in it.
+ */
+StringPoolType::~StringPoolType(void) {
+    pthread_mutex_destroy(&mutex);
+}
+
+/**
+ * Intern a string.
+ *
+ * Get the handle of the given string, adding it to the pool if it is not
+ * there yet.
+ * @param value The string to intern.
+ * @return The handle of the string.
+ */
+StringHandleType StringPoolType::Intern(const std::string &value) {
+    StringHandleType handle;
+    uint32_t hash;
+    uint32_t slot;
+
+    if (value.empty())
+        return 0;
+
+    hash = HashString(value);
+
+    pthread_mutex_lock(&mutex);
+    slot = FindSlot(value, hash);
+    if (slots[slot] != 0) {
+        handle = slots[slot] - 1;
+    } else {
+        handle = (StringHandleType)values.size();
+        values.push_back(value);
+        hashes.push_back(hash);
+        slots[slot] = handle + 1;
+
+        // I keep the table at most half full so probes stay short.
+        if (values.size() * 2 > slots.size())
+            Grow();
+    }
+    pthread_mutex_unlock(&mutex);
+
+    return handle;
+}
+
+/**
+ * Find a string.
+ *
+ * Get the handle of the given string without adding it to the pool. A
+ * string which is not in the pool can not be equal to any interned one.
+ * @param value The string to find.
+ * @param handle Reference to store the handle of the string in.
+ * @return A boolean value representing if the string is in the pool.
+ */
+bool StringPoolType::Find(const std::string &value,
+                          StringHandleType &handle) const {
+    uint32_t slot;
+    bool found;
+
+    pthread_mutex_lock(&mutex);
+    slot = FindSlot(value, HashString(value));
+    found = (slots[slot] != 0);
+    if (found)
+        handle = slots[slot] - 1;
+    pthread_mutex_unlock(&mutex);
+
+    return found;
+}
+
+/**
+ * Get a string.
+ *
+ * Get the string with the given handle. The reference stays valid as long
+ * as the pool does.
+ * @param handle The handle of the string.
+ * @return Reference to the string, the empty string if the handle is not
+ * one of this pool.
+ */
+const std::string &StringPoolType::Get(StringHandleType handle) const {
+    const std::string *pValue;
+
+    pthread_mutex_lock(&mutex);
+    if (handle < values.size())
+        pValue = &values[handle];
+    else
+        pValue = &values[0];
+    pthread_mutex_unlock(&mutex);
+
+    return *pValue;
+}
+
+/**
+ * Get the number of strings.
+ *
+ * Get the number of distinct strings in the pool, counting the empty one.
+ * @return The number of strings in the pool.
+ */
+unsigned long int StringPoolType::GetCount(void) const {
+    unsigned long int count;
+
+    pthread_mutex_lock(&mutex);
+    count = (unsigned long int)values.size();
+    pthread_mutex_unlock(&mutex);
+
+    return count;
+}
+
+/**
+ * Get the pool of the session.
+ *
+ * Get the pool the string fields of items are interned in for the session.
+ * @return Reference to the pool of the session.
+ */
+StringPoolType &StringPoolType::GetSession(void) {
+    static StringPoolType sessionPool;
+
+    return sessionPool;
+}
+
+/**
+ * Find the slot of a string.
+ *
+ * Find the slot of the hash table holding the given string by linear
+ * probing, or the empty slot it would be put in if it is not there.
+ * @param value The string to find.
+ * @param hash The hash of the string.
+ * @return The index of the slot found.
+ */
+uint32_t StringPoolType::FindSlot(const std::string &value,
+                                  uint32_t hash) const {
+    uint32_t mask;
+    uint32_t slot;
+
+    mask = (uint32_t)slots.size() - 1;
+    slot = hash & mask;
+    while (slots[slot] != 0) {
+        if ((hashes[slots[slot] - 1] == hash) &&
+            (values[slots[slot] - 1] == value))
+            break;
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+/**
+ * Grow the hash table.
+ *
+ * Double the number of slots of the hash table and put every string back
+ * into it. The strings and their handles are left where they are.
+ */
+void StringPoolType::Grow(void) {
+    uint32_t mask;
+    uint32_t slot;
+    uint32_t i;
+
+    slots.assign(slots.size() * 2, 0);
+    mask = (uint32_t)slots.size() - 1;
+
+    for (i = 0; i < (uint32_t)values.size(); i++) {
+        slot = hashes[i] & mask;
+        while (slots[slot] != 0)
+            slot = (slot + 1) & mask;
+        slots[slot] = i + 1;
+    }
+}
+
+/**
+ * Hash a string.
+ *
+ * Hash the given string to pick its home slot in the hash table.
+ * @param value The string to hash.
+ * @return The hash of the string.
+ */
+uint32_t StringPoolType::HashString(const std::string &value) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    std::string::size_type i;
+
+    for (i = 0; i < value.size(); i++) {
+        hash ^= (unsigned char)value[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return (uint32_t)(hash ^ (hash >> 32));
+}
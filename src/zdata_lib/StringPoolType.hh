@@ -0,0 +1,96 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file StringPoolType.hh
+ * @brief A specifications file for a table of interned strings.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class existing to store each distinct value
+ * of the highly repetitive string fields of items once, handing out a small
+ * integer handle for it.
+ */
+
+#ifndef STRINGPOOLTYPE_H
+#define STRINGPOOLTYPE_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+// Define the type of the handle of an interned string. The empty string
+// always has the handle zero.
+typedef uint32_t StringHandleType;
+
+/**
+ * @class StringPoolType
+ * @brief A type representing a table of interned strings.
+ *
+ * The StringPoolType is a class which stores each distinct string it is
+ * given once and hands out a handle for it, the same handle for the same
+ * string every time. Hence, two interned strings are equal exactly when
+ * their handles are, and items which share a value, such as a category or
+ * company, only hold the handle of it. Strings are found through an open
+ * addressing hash table, and are never removed, so a handle and a reference
+ * to the string behind it stay valid as long as the pool does.
+ *
+ * The pool of the session, returned by GetSession(), is the one the items
+ * intern their fields in. It lives as long as the process does, which is a
+ * single synchronization for zync, so handles are only comparable within a
+ * session and are never stored. A pool may be used from many threads.
+ */
+class StringPoolType {
+public:
+    StringPoolType(void);
+    ~StringPoolType(void);
+
+    StringHandleType Intern(const std::string &value);
+    bool Find(const std::string &value, StringHandleType &handle) const;
+    const std::string &Get(StringHandleType handle) const;
+    unsigned long int GetCount(void) const;
+
+    static StringPoolType &GetSession(void);
+
+private:
+    // The pool refers to its strings by address, so it may not be copied.
+    StringPoolType(const StringPoolType &);
+    StringPoolType &operator=(const StringPoolType &);
+
+    uint32_t FindSlot(const std::string &value, uint32_t hash) const;
+    void Grow(void);
+
+    static uint32_t HashString(const std::string &value);
+
+    // The strings in order of their handles, which never move once added,
+    // and the hash of each of them.
+    std::deque<std::string> values;
+    std::vector<uint32_t> hashes;
+
+    // The hash table, each slot holding one more than the handle of the
+    // string in it, or zero if it is empty.
+    std::vector<uint32_t> slots;
+
+    mutable pthread_mutex_t mutex;
+};
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file StringRefType.hh
+ * @brief A specifications file for a reference to the characters of a string.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class existing to refer to the characters of
+ * a string field of an item without copying them.
+ */
+
+#ifndef STRINGREFTYPE_H
+#define STRINGREFTYPE_H
+
+#include <string.h>
+
+#include <ostream>
+#include <string>
+
+/**
+ * @class StringRefType
+ * @brief A type referring to the characters of a string.
+ *
+ * The StringRefType is a class which refers to a run of characters owned by
+ * something else, such as an item, along with their number. It is what the
+ * string fields of items are obtained as, so reading a field does not copy
+ * it. The characters are not terminated, and a reference is only valid
+ * until any string field of the item it was obtained from is set or the
+ * item is destroyed, since the strings of an item share one block which
+ * setting any of them may move. It converts to a std::string, copying the
+ * characters, wherever one is needed.
+ */
+class StringRefType {
+public:
+    StringRefType(void) : pData(""), length(0) { }
+    StringRefType(const char *pChars, std::string::size_type size) :
+        pData(pChars), length(size) { }
+    StringRefType(const char *pChars) :
+        pData(pChars), length(strlen(pChars)) { }
+    StringRefType(const std::string &value) :
+        pData(value.data()), length(value.size()) { }
+
+    const char *data(void) const { return pData; }
+    std::string::size_type size(void) const { return length; }
+    bool empty(void) const { return (length == 0); }
+    char operator[](std::string::size_type index) const {
+        return pData[index];
+    }
+
+    std::string str(void) const { return std::string(pData, length); }
+    operator std::string(void) const { return str(); }
+
+    int compare(const StringRefType &other) const;
+
+private:
+    const char *pData;
+    std::string::size_type length;
+};
+
+/**
+ * Compare to another string.
+ *
+ * Compare the characters referred to with those of the given string, the
+ * same way std::string::compare() does.
+ * @param other The string to compare to.
+ * @return Less than, equal to or greater than zero if this string sorts
+ * before, the same as or after the other.
+ */
+inline int StringRefType::compare(const StringRefType &other) const {
+    std::string::size_type minLength;
+    int result;
+
+    minLength = (length < other.length) ? length : other.length;
+    result = (minLength == 0) ? 0 : memcmp(pData, other.pData, minLength);
+    if (result != 0)
+        return result;
+
+    if (length == other.length)
+        return 0;
+    return (length < other.length) ? -1 : 1;
+}
+
+inline bool operator==(const StringRefType &a, const StringRefType &b) {
+    return ((a.size() == b.size()) &&
+            ((a.size() == 0) || (memcmp(a.data(), b.data(), a.size()) == 0)));
+}
+
+inline bool operator!=(const StringRefType &a, const StringRefType &b) {
+    return !(a == b);
+}
+
+inline bool operator<(const StringRefType &a, const StringRefType &b) {
+    return (a.compare(b) < 0);
+}
+
+inline std::ostream &operator<<(std::ostream &out,
+                                const StringRefType &value) {
+    return out.write(value.data(), value.size());
+}
+
+#endif
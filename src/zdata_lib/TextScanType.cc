@@ -0,0 +1,248 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file TextScanType.cc
+ * @brief An implementation file for scanning and escaping text formats.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for a class existing to scan, escape and fold the
+ * lines of the text formats items are imported from and exported to, such
+ * as vCard and iCalendar.
+ */
+
+#include "TextScanType.hh"
+
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// The longest line written before it is folded, in octets.
+#define TEXT_LINE_SIZE 75
+
+/**
+ * Find any of three characters.
+ *
+ * Find the first of the given characters in a run of characters, sixteen
+ * characters at a time with SSE2 where the host has it.
+ * @param p Pointer to the first character of the run.
+ * @param pEnd Pointer just past the last character of the run.
+ * @param a The first character to find.
+ * @param b The second character to find.
+ * @param c The third character to find.
+ * @return Pointer to the first character found, or pEnd if there is none.
+ */
+const char *TextScanType::FindAny(const char *p, const char *pEnd, char a,
+                                  char b, char c) {
+#ifdef __SSE2__
+    __m128i va, vb, vc, chunk, hits;
+    int mask;
+
+    va = _mm_set1_epi8(a);
+    vb = _mm_set1_epi8(b);
+    vc = _mm_set1_epi8(c);
+    while (pEnd - p >= 16) {
+        chunk = _mm_loadu_si128((const __m128i *)p);
+        hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, va),
+                                          _mm_cmpeq_epi8(chunk, vb)),
+                            _mm_cmpeq_epi8(chunk, vc));
+        mask = _mm_movemask_epi8(hits);
+        if (mask != 0)
+            return p + __builtin_ctz((unsigned int)mask);
+        p += 16;
+    }
+#endif
+
+    for (; p < pEnd; p++) {
+        if ((*p == a) || (*p == b) || (*p == c))
+            return p;
+    }
+
+    return pEnd;
+}
+
+/**
+ * Compare without regard to case.
+ *
+ * Determine if a string equals the given upper case ASCII name, ignoring
+ * the case of the string.
+ * @param value The string to compare.
+ * @param pName The upper case name to compare with.
+ * @return A boolean value representing if they are equal.
+ */
+bool TextScanType::EqualsNoCase(const StringRefType &value,
+                                const char *pName) {
+    std::string::size_type i;
+    char ch;
+
+    for (i = 0; i < value.size(); i++) {
+        if (pName[i] == '\0')
+            return false;
+        ch = value[i];
+        if ((ch >= 'a') && (ch <= 'z'))
+            ch = ch - 'a' + 'A';
+        if (ch != pName[i])
+            return false;
+    }
+
+    return (pName[i] == '\0');
+}
+
+/**
+ * Append an escaped value.
+ *
+ * Append a text value to the given string, escaping backslashes, commas,
+ * semicolons and line breaks so they are not read as part of the syntax. A
+ * CR LF line break is escaped as a single new line, and so is a lone CR,
+ * since a raw CR may not appear within a content line.
+ * @param value The value to append.
+ * @param out Reference to the string to append the value to.
+ */
+void TextScanType::AppendEscaped(const StringRefType &value,
+                                 std::string &out) {
+    const char *p, *pStart, *pStop, *pBreak;
+
+    p = value.data();
+    pStop = value.data() + value.size();
+
+    while (p < pStop) {
+        // The scan has no room for a fourth character, so I look for the
+        // line break characters in the run before the escape separately.
+        pStart = p;
+        p = FindAny(p, pStop, '\\', ';', ',');
+        pBreak = (const char *)memchr(pStart, '\n', p - pStart);
+        if (pBreak != NULL)
+            p = pBreak;
+        pBreak = (const char *)memchr(pStart, '\r', p - pStart);
+        if (pBreak != NULL)
+            p = pBreak;
+
+        out.append(pStart, p - pStart);
+        if (p == pStop)
+            break;
+
+        if (*p == '\r') {
+            // The CR of a CR LF line break is dropped, its new line being
+            // escaped on its own.
+            if ((p + 1 == pStop) || (p[1] != '\n'))
+                out.append("\\n");
+        } else if (*p == '\n') {
+            out.append("\\n");
+        } else {
+            out += '\\';
+            out += *p;
+        }
+        p++;
+    }
+}
+
+/**
+ * Append an unescaped value.
+ *
+ * Append a text value to the given string, undoing the escaping of its
+ * characters and turning CR LF line breaks into plain new lines. An escape
+ * which is not known is kept as it is.
+ * @param value The value to append.
+ * @param out Reference to the string to append the value to.
+ */
+void TextScanType::AppendUnescaped(const StringRefType &value,
+                                   std::string &out) {
+    const char *p, *pStart, *pStop;
+
+    p = value.data();
+    pStop = value.data() + value.size();
+
+    while (p < pStop) {
+        pStart = p;
+        p = FindAny(p, pStop, '\\', '\r', '\\');
+        out.append(pStart, p - pStart);
+        if (p == pStop)
+            break;
+
+        if (*p == '\r') {
+            if ((p + 1 == pStop) || (p[1] != '\n'))
+                out += '\r';
+            p++;
+            continue;
+        }
+
+        if (p + 1 == pStop) {
+            out += '\\';
+            break;
+        }
+        switch (p[1]) {
+        case 'n':
+        case 'N':
+            out += '\n';
+            break;
+        case '\\':
+        case ',':
+        case ';':
+        case ':':
+            out += p[1];
+            break;
+        default:
+            out += '\\';
+            out += p[1];
+            break;
+        }
+        p += 2;
+    }
+}
+
+/**
+ * Append a folded line.
+ *
+ * Append a content line to the given string followed by a CR LF line
+ * break, folding it so that no line is longer than 75 octets. A fold never
+ * splits a UTF-8 character.
+ * @param line The content line to append.
+ * @param out Reference to the string to append the line to.
+ */
+void TextScanType::AppendFolded(const std::string &line, std::string &out) {
+    std::string::size_type start, stop;
+
+    if (line.size() <= TEXT_LINE_SIZE) {
+        out.append(line);
+        out.append("\r\n");
+        return;
+    }
+
+    start = 0;
+    while (start < line.size()) {
+        // A continuation line starts with a space taking up one octet.
+        stop = start + ((start == 0) ? TEXT_LINE_SIZE : TEXT_LINE_SIZE - 1);
+        if (stop >= line.size()) {
+            stop = line.size();
+        } else {
+            while ((stop > start + 1) &&
+                   (((unsigned char)line[stop] & 0xc0) == 0x80))
+                stop--;
+        }
+
+        if (start > 0)
+            out += ' ';
+        out.append(line, start, stop - start);
+        out.append("\r\n");
+        start = stop;
+    }
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file TextScanType.hh
+ * @brief A specifications file for scanning and escaping text formats.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class existing to scan, escape and fold the
+ * lines of the text formats items are imported from and exported to, such
+ * as vCard and iCalendar.
+ */
+
+#ifndef TEXTSCANTYPE_H
+#define TEXTSCANTYPE_H
+
+#include <string>
+
+#include "StringRefType.hh"
+
+/**
+ * @class TextScanType
+ * @brief A type holding the scanning routines of the text formats.
+ *
+ * The TextScanType is a class of static routines shared by the readers and
+ * writers of the text formats whose content lines follow RFC 2425, such as
+ * vCard 3.0 and iCalendar. Runs of characters are scanned sixteen at a time
+ * with SSE2 where the host has it, and copied whole between the characters
+ * found, so the per character work is kept out of the common case.
+ */
+class TextScanType {
+public:
+    static const char *FindAny(const char *p, const char *pEnd, char a,
+                               char b, char c);
+    static bool EqualsNoCase(const StringRefType &value, const char *pName);
+
+    static void AppendEscaped(const StringRefType &value, std::string &out);
+    static void AppendUnescaped(const StringRefType &value,
+                                std::string &out);
+    static void AppendFolded(const std::string &line, std::string &out);
+};
+
+#endif
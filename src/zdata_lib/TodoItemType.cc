@@ -29,13 +29,49 @@
 
 #include "TodoItemType.hh"
 
+#include <algorithm>
+
+// The descriptors of the fields of a Todo item. This is the one place the
+// fields of a Todo item are mapped to the parameters of the Zaurus.
+const FieldDescType<TodoItemType> TodoItemType::fieldDescs[] = {
+    BASE_FIELD_DESCS(TodoItemType),
+    { "CTGR", DATA_ID_BARRAY, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_POOLED_ACCESS(TodoItemType, Category) },
+    { "ETDY", DATA_ID_TIME, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_NUMBER_ACCESS(TodoItemType, time_t, StartDate) },
+    { "LTDY", DATA_ID_TIME, FIELD_CONTENT | FIELD_SYNCED | FIELD_MATCH,
+      FIELD_NUMBER_ACCESS(TodoItemType, time_t, DueDate) },
+    { "FNDY", DATA_ID_TIME, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_NUMBER_ACCESS(TodoItemType, time_t, CompletedDate) },
+    { "MARK", DATA_ID_UCHAR, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_NUMBER_ACCESS(TodoItemType, unsigned char, ProgressStatus) },
+    { "PRTY", DATA_ID_UCHAR, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_NUMBER_ACCESS(TodoItemType, unsigned char, Priority) },
+    { "TITL", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED | FIELD_MATCH,
+      FIELD_STRING_ACCESS(TodoItemType, Description) },
+    { "MEM1", DATA_ID_UTF8, FIELD_CONTENT | FIELD_SYNCED,
+      FIELD_STRING_ACCESS(TodoItemType, Notes) }
+};
+
+const unsigned int TodoItemType::numFieldDescs =
+    sizeof(TodoItemType::fieldDescs) / sizeof(TodoItemType::fieldDescs[0]);
+
 /**
  * Construct a default TodoItemType object.
  *
  * Construct a default TodoItemType object with all the basic initialization.
  */
 TodoItemType::TodoItemType(void) {
+    // The interned fields start out empty, the handle of which is zero.
+    categoryHandle = 0;
 
+    // The fixed size fields are hashed along with the rest of the content,
+    // so each of them starts out zero rather than as whatever was in memory.
+    startDate = 0;
+    dueDate = 0;
+    completedDate = 0;
+    progressStatus = 0;
+    priority = 0;
 }
 
 /**
@@ -54,18 +90,29 @@ TodoItemType::~TodoItemType(void) {
  * Set the category of the item.
  * @param value The value to set the category to.
  */
-void TodoItemType::SetCategory(std::string value) {
-    category = value;
+void TodoItemType::SetCategory(const std::string &value) {
+    categoryHandle = StringPoolType::GetSession().Intern(value);
 }
 
 /**
  * Get the category.
  *
  * Get the category of the item this object represents.
- * @return A string containing the category.
+ * @return A reference to the category.
+ */
+StringRefType TodoItemType::GetCategory(void) const {
+    return StringPoolType::GetSession().Get(categoryHandle);
+}
+
+/**
+ * Get the handle of the category.
+ *
+ * Get the handle the category of the item this object represents is interned
+ * under in the pool of the session.
+ * @return The handle of the category.
  */
-std::string TodoItemType::GetCategory(void) const {
-    return category;
+StringHandleType TodoItemType::GetCategoryHandle(void) const {
+    return categoryHandle;
 }
 
 /**
@@ -190,18 +237,19 @@ unsigned char TodoItemType::GetPriority(void) const {
  * Set the description of the item.
  * @param value The value to set the description to.
  */
-void TodoItemType::SetDescription(std::string value) {
-    description = value;
+void TodoItemType::SetDescription(const std::string &value) {
+    strings.Set(STR_DESCRIPTION, value);
 }
 
 /**
  * Get the description.
  *
  * Get the description of the item this object represents.
- * @return A string containing the description.
+ * @return A reference to the description, valid until any string field of the
+ * item is set.
  */
-std::string TodoItemType::GetDescription(void) const {
-    return description;
+StringRefType TodoItemType::GetDescription(void) const {
+    return strings.Get(STR_DESCRIPTION);
 }
 
 /**
@@ -210,16 +258,73 @@ std::string TodoItemType::GetDescription(void) const {
  * Set the notes of the item.
  * @param value The value to set the notes to.
  */
-void TodoItemType::SetNotes(std::string value) {
-    notes = value;
+void TodoItemType::SetNotes(const std::string &value) {
+    strings.Set(STR_NOTES, value);
 }
 
 /**
  * Get the notes.
  *
  * Get the notes of the item this object represents.
- * @return A string containing the notes.
+ * @return A reference to the notes, valid until any string field of the item
+ * is set.
+ */
+StringRefType TodoItemType::GetNotes(void) const {
+    return strings.Get(STR_NOTES);
+}
+
+/**
+ * Swap with another item.
+ *
+ * Exchange the content of the To-do item this object represents with
+ * that of the given item, without copying any of their strings.
+ * @param other Reference to the item to swap with.
+ */
+void TodoItemType::Swap(TodoItemType &other) {
+    SwapBase(other);
+    strings.Swap(other.strings);
+    std::swap(startDate, other.startDate);
+    std::swap(dueDate, other.dueDate);
+    std::swap(completedDate, other.completedDate);
+    std::swap(categoryHandle, other.categoryHandle);
+    std::swap(progressStatus, other.progressStatus);
+    std::swap(priority, other.priority);
+}
+
+/**
+ * Get the content hash.
+ *
+ * Obtain a hash of the sync relevant content of the To-do item this object
+ * represents. The sync ID, app ID, and times of the item are left out. Two
+ * items with equal content hashes hold the same data, so a modification
+ * from one to the other changes nothing.
+ * @return The content hash of the item.
+ */
+uint64_t TodoItemType::ContentHash(void) const {
+    return HashFields(*this);
+}
+
+/**
+ * Get the fingerprint.
+ *
+ * Obtain a hash of the normalized content of the To-do item this object
+ * represents. Unlike the content hash, case and white space in the text of
+ * the item are ignored, so items which were entered separately on each side
+ * with the same content have the same fingerprint.
+ * @return The fingerprint of the item.
+ */
+uint64_t TodoItemType::Fingerprint(void) const {
+    return HashFields(*this, FIELD_CONTENT, true);
+}
+
+/**
+ * Get the match key.
+ *
+ * Obtain a hash of the normalized fields naming the To-do item this object
+ * represents, that is its description and due date. Items which may be
+ * duplicates of each other have the same match key.
+ * @return The match key of the item.
  */
-std::string TodoItemType::GetNotes(void) const {
-    return notes;
+uint64_t TodoItemType::MatchKey(void) const {
+    return HashFields(*this, FIELD_MATCH, true);
 }
@@ -32,11 +32,12 @@
 #define TODOITEMTYPE_H
 
 #include "ItemType.hh"
+#include "StringBlockType.hh"
 
 #include <time.h>
 
 #include <string>
-#include <list>
+#include <vector>
 
 /**
  * @class TodoItemType
@@ -49,14 +50,15 @@
 class TodoItemType : public ItemType {
  public:
     // Define a type that is a list of TodoItemTypes.
-    typedef std::list<TodoItemType> List;
+    typedef std::vector<TodoItemType> List;
 
     TodoItemType(void);
     ~TodoItemType(void);
 
     // Access functions for the below data members.
-    void SetCategory(std::string value);
-    std::string GetCategory(void) const;
+    void SetCategory(const std::string &value);
+    StringRefType GetCategory(void) const;
+    StringHandleType GetCategoryHandle(void) const;
 
     void SetStartDate(time_t epochSecs);
     time_t GetStartDate(void) const;
@@ -73,23 +75,50 @@ class TodoItemType : public ItemType {
     void SetPriority(unsigned char value);
     unsigned char GetPriority(void) const;
 
-    void SetDescription(std::string value);
-    std::string GetDescription(void) const;
+    void SetDescription(const std::string &value);
+    StringRefType GetDescription(void) const;
 
-    void SetNotes(std::string value);
-    std::string GetNotes(void) const;
+    void SetNotes(const std::string &value);
+    StringRefType GetNotes(void) const;
 
     // Non Access Functions.
+    void Swap(TodoItemType &other);
+    uint64_t ContentHash(void) const;
+    uint64_t Fingerprint(void) const;
+    uint64_t MatchKey(void) const;
+
+    // The descriptors of the fields of a Todo item, in the order their
+    // content is hashed and serialized.
+    static const FieldDescType<TodoItemType> fieldDescs[];
+    static const unsigned int numFieldDescs;
 
  private:
-    std::string category;
+    // The indices of the string fields within the string block.
+    enum {
+        STR_DESCRIPTION = 0,
+        STR_NOTES,
+        NUM_STRINGS
+    };
+
+    // The string fields which are not interned are held together in a single
+    // block, and the fixed size fields follow from the widest to the
+    // narrowest so that no space is lost to padding between them.
+    StringBlockType<NUM_STRINGS> strings;
     time_t startDate;
     time_t dueDate;
     time_t completedDate;
+    StringHandleType categoryHandle;
     unsigned char progressStatus;
     unsigned char priority;
-    std::string description;
-    std::string notes;
 };
 
+// Let the standard containers and algorithms swap To-do items without
+// copying them.
+namespace std {
+    template <>
+    inline void swap(TodoItemType &a, TodoItemType &b) {
+        a.Swap(b);
+    }
+}
+
 #endif
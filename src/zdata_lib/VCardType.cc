@@ -0,0 +1,1064 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file VCardType.cc
+ * @brief An implementation file for reading and writing vCards.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for the classes existing to convert Address Book
+ * items to and from vCard 2.1 and 3.0, so that address books may be
+ * imported and exported in bulk.
+ */
+
+#include "VCardType.hh"
+#include "TextScanType.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Define the flags of the TYPE parameter a property may have.
+#define VCARD_TYPE_WORK 0x01
+#define VCARD_TYPE_HOME 0x02
+#define VCARD_TYPE_CELL 0x04
+#define VCARD_TYPE_FAX 0x08
+#define VCARD_TYPE_PAGER 0x10
+#define VCARD_TYPE_PREF 0x20
+
+// The prefix of the properties holding the fields without a standard one.
+#define VCARD_EXTRA_PREFIX "X-ZAURUS-"
+#define VCARD_EXTRA_PREFIX_SIZE 9
+
+// The longest quoted printable line written before it is broken, in
+// octets.
+#define VCARD_LINE_SIZE 75
+
+// The amount of output buffered before it is written to a file.
+#define VCARD_WRITE_CHUNK 65536
+
+// The properties which map straight onto a single field, given by the
+// Zaurus parameter it is stored in. Those not written are only recognized
+// when reading cards written by other programs.
+struct sSimpleProp {
+    const char *pName;
+    const char *pAbrev;
+    bool isWritten;
+};
+
+static const struct sSimpleProp simpleProps[] = {
+    { "FN", "NAME", false },
+    { "NICKNAME", "NCNM", true },
+    { "TITLE", "POST", true },
+    { "ROLE", "PRFS", true },
+    { "BDAY", "BRTH", true },
+    { "X-ANNIVERSARY", "ANIV", true },
+    { "NOTE", "MEM1", true },
+    { "CATEGORIES", "CTGR", true },
+    { "SORT-STRING", "KANA", true },
+    { "X-PHONETIC-FIRST-NAME", "FNPR", true },
+    { "X-PHONETIC-LAST-NAME", "LNPR", true },
+    { "X-PHONETIC-ORG", "CPPR", true },
+    { "ANNIVERSARY", "ANIV", false },
+    { "X-EVOLUTION-ANNIVERSARY", "ANIV", false },
+    { "X-SPOUSE", "SPUS", false },
+    { "X-EVOLUTION-SPOUSE", "SPUS", false },
+    { "X-ASSISTANT", "ASST", false },
+    { "X-EVOLUTION-ASSISTANT", "ASST", false },
+    { "X-MANAGER", "MNGR", false },
+    { "X-EVOLUTION-MANAGER", "MNGR", false },
+    { "X-GENDER", "GNDR", false }
+};
+
+static const unsigned int numSimpleProps =
+    sizeof(simpleProps) / sizeof(simpleProps[0]);
+
+// The fields written as part of the structured properties, FN, N, ORG, TEL,
+// ADR, URL and EMAIL.
+static const char *structuredAbrevs[] = {
+    "NAME", "LNME", "FNME", "MNME", "HONR", "SUFX", "CPNY", "SCTN", "TEL1",
+    "TEL2", "FAX1", "FAX2", "CPS1", "CPS2", "BEEP", "STR1", "CTY1", "STA1",
+    "ZIP1", "CTR1", "STR2", "CTY2", "STA2", "ZIP2", "CTR2", "HPA1", "HPA2",
+    "DMAL", "MAL1"
+};
+
+static const unsigned int numStructuredAbrevs =
+    sizeof(structuredAbrevs) / sizeof(structuredAbrevs[0]);
+
+/**
+ * Find the descriptor of a field.
+ *
+ * Find the descriptor of the string field of an Address Book item stored
+ * in the Zaurus parameter with the given abbreviation.
+ * @param abrev The abbreviation of the parameter.
+ * @return Pointer to the descriptor, or NULL if there is none.
+ */
+static const FieldDescType<AddrBookItemType> *FindStringDesc(
+    const StringRefType &abrev) {
+    unsigned int i;
+
+    for (i = 0; i < AddrBookItemType::numFieldDescs; i++) {
+        const FieldDescType<AddrBookItemType> &desc =
+            AddrBookItemType::fieldDescs[i];
+
+        if ((desc.pSetString != NULL) &&
+            TextScanType::EqualsNoCase(abrev, desc.pAbrev))
+            return &desc;
+    }
+
+    return NULL;
+}
+
+/**
+ * Get the value of a hexadecimal digit.
+ *
+ * Get the value of the given hexadecimal digit.
+ * @param ch The digit.
+ * @return The value of the digit, or -1 if it is not one.
+ */
+static int HexValue(char ch) {
+    if ((ch >= '0') && (ch <= '9'))
+        return ch - '0';
+    if ((ch >= 'A') && (ch <= 'F'))
+        return ch - 'A' + 10;
+    if ((ch >= 'a') && (ch <= 'f'))
+        return ch - 'a' + 10;
+    return -1;
+}
+
+/**
+ * Construct a VCardReaderType object.
+ *
+ * Construct a VCardReaderType object reading the vCards in the given
+ * buffer.
+ * @param pData Pointer to the characters of the vCards.
+ * @param size The number of characters.
+ */
+VCardReaderType::VCardReaderType(const char *pData, size_t size) {
+    unsigned int i;
+
+    pCur = pData;
+    pEnd = pData + size;
+
+    simpleDescs.resize(numSimpleProps);
+    for (i = 0; i < numSimpleProps; i++)
+        simpleDescs[i] = FindStringDesc(simpleProps[i].pAbrev);
+}
+
+/**
+ * Read the next card.
+ *
+ * Read the next vCard of the buffer into the given item, replacing all of
+ * its fields.
+ * @param item Reference to the item to read the card into.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully read a card.
+ * @retval 1 There are no more cards.
+ * @retval 2 The last card ends before its END line.
+ */
+int VCardReaderType::Next(AddrBookItemType &item) {
+    struct sProperty prop;
+    StringRefType line;
+    bool inCard = false;
+
+    while (NextLine(line)) {
+        if (!SplitLine(line, prop))
+            continue;
+
+        if (!inCard) {
+            if (TextScanType::EqualsNoCase(prop.name, "BEGIN") &&
+                TextScanType::EqualsNoCase(prop.value, "VCARD")) {
+                item = AddrBookItemType();
+                emails.clear();
+                defaultEmail.clear();
+                inCard = true;
+            }
+            continue;
+        }
+
+        if (TextScanType::EqualsNoCase(prop.name, "END") &&
+            TextScanType::EqualsNoCase(prop.value, "VCARD")) {
+            // The Zaurus keeps every email in one field, the default one
+            // first, as well as the default one on its own.
+            if (defaultEmail.empty() && !emails.empty())
+                defaultEmail.assign(emails, 0, emails.find(' '));
+            item.SetDefaultEmail(defaultEmail);
+            item.SetEmails(emails);
+            return 0;
+        }
+
+        if (!prop.binary)
+            ApplyProperty(prop, item);
+    }
+
+    return inCard ? 2 : 1;
+}
+
+/**
+ * Read a file of cards.
+ *
+ * Read every vCard of the file at the given path, adding an item for each
+ * to the end of the given list. The file is memory mapped rather than read
+ * into a buffer.
+ * @param filePath The path of the file.
+ * @param itemList Reference to the list to add the items to.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully read the file.
+ * @retval 1 Failed to open the file.
+ * @retval 2 Failed to map the file.
+ * @retval 3 The last card of the file ends before its END line, the cards
+ * before it were read.
+ */
+int VCardReaderType::ReadFile(const std::string &filePath,
+                              AddrBookItemType::List &itemList) {
+    struct stat fileStat;
+    void *pFileMap;
+    int retval;
+    int fd;
+
+    fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return 1;
+
+    if (fstat(fd, &fileStat) != 0) {
+        close(fd);
+        return 1;
+    }
+    if (fileStat.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    pFileMap = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE,
+                    fd, 0);
+    close(fd);
+    if (pFileMap == MAP_FAILED)
+        return 2;
+
+    madvise(pFileMap, (size_t)fileStat.st_size, MADV_SEQUENTIAL);
+
+    VCardReaderType reader((const char *)pFileMap,
+                           (size_t)fileStat.st_size);
+    itemList.push_back(AddrBookItemType());
+    while ((retval = reader.Next(itemList.back())) == 0)
+        itemList.push_back(AddrBookItemType());
+    itemList.pop_back();
+
+    munmap(pFileMap, (size_t)fileStat.st_size);
+
+    return (retval == 2) ? 3 : 0;
+}
+
+/**
+ * Get the next line.
+ *
+ * Get the next logical line of the buffer, without its line break. A line
+ * folded over several lines, or a quoted printable value broken over
+ * several lines, is joined into the unfolded buffer, otherwise the line is
+ * referred to where it is.
+ * @param line Reference to store the line in.
+ * @return A boolean value representing if there was a line.
+ */
+bool VCardReaderType::NextLine(StringRefType &line) {
+    const char *pStart, *pStop, *pColon;
+    std::string::size_type i;
+    bool isJoined = false;
+    bool isQP = false;
+    bool isSoftBreak, isFolded;
+
+    if (pCur >= pEnd)
+        return false;
+
+    while (true) {
+        pStart = pCur;
+        pStop = (const char *)memchr(pCur, '\n', pEnd - pCur);
+        if (pStop == NULL) {
+            pStop = pEnd;
+            pCur = pEnd;
+        } else {
+            pCur = pStop + 1;
+        }
+        if ((pStop > pStart) && (pStop[-1] == '\r'))
+            pStop--;
+
+        // A quoted printable value ending in an equals sign carries on on
+        // the next line, the break being no part of it. Whether the value
+        // is quoted printable is given by the parameters on the first line.
+        if (!isJoined) {
+            pColon = (const char *)memchr(pStart, ':', pStop - pStart);
+            for (i = 0; (pColon != NULL) && (pStart + i + 16 <= pColon) &&
+                     !isQP; i++)
+                isQP = TextScanType::EqualsNoCase(
+                    StringRefType(pStart + i, 16), "QUOTED-PRINTABLE");
+        }
+        isSoftBreak = (isQP && (pStop > pStart) && (pStop[-1] == '=') &&
+                       (pCur < pEnd));
+        if (isSoftBreak)
+            pStop--;
+
+        // A folded line carries on after the white space starting the next
+        // line.
+        isFolded = (!isSoftBreak && (pCur < pEnd) &&
+                    ((*pCur == ' ') || (*pCur == '\t')));
+
+        if (!isJoined && !isSoftBreak && !isFolded) {
+            line = StringRefType(pStart, pStop - pStart);
+            return true;
+        }
+
+        if (!isJoined) {
+            unfolded.assign(pStart, pStop - pStart);
+            isJoined = true;
+        } else {
+            unfolded.append(pStart, pStop - pStart);
+        }
+
+        if (isFolded)
+            pCur++;
+        else if (!isSoftBreak)
+            break;
+    }
+
+    line = StringRefType(unfolded);
+    return true;
+}
+
+/**
+ * Split a line.
+ *
+ * Split a content line into its name, parameters and value. The group in
+ * front of the name, if any, is dropped.
+ * @param line The line to split.
+ * @param prop Reference to the property to store the pieces in.
+ * @return A boolean value representing if the line is a content line.
+ */
+bool VCardReaderType::SplitLine(const StringRefType &line,
+                                struct sProperty &prop) {
+    const char *p, *pStop, *pParam, *pDot;
+
+    p = line.data();
+    pStop = line.data() + line.size();
+
+    prop.types = 0;
+    prop.quotedPrintable = false;
+    prop.binary = false;
+
+    // The name ends at the first colon or semicolon, quoted parameter
+    // values aside.
+    pParam = TextScanType::FindAny(p, pStop, ':', ';', '"');
+    if ((pParam == pStop) || (*pParam == '"'))
+        return false;
+
+    pDot = p;
+    while ((pDot < pParam) && (*pDot != '.'))
+        pDot++;
+    if (pDot < pParam)
+        p = pDot + 1;
+    prop.name = StringRefType(p, pParam - p);
+
+    while (*pParam == ';') {
+        p = pParam + 1;
+        pParam = TextScanType::FindAny(p, pStop, ':', ';', '"');
+        while ((pParam < pStop) && (*pParam == '"')) {
+            pParam = (const char *)memchr(pParam + 1, '"',
+                                          pStop - pParam - 1);
+            if (pParam == NULL)
+                return false;
+            pParam = TextScanType::FindAny(pParam + 1, pStop, ':', ';', '"');
+        }
+        if (pParam == pStop)
+            return false;
+        ParseParam(StringRefType(p, pParam - p), prop);
+    }
+
+    prop.value = StringRefType(pParam + 1, pStop - pParam - 1);
+    return true;
+}
+
+/**
+ * Parse a parameter.
+ *
+ * Parse a parameter of a property, either a vCard 3.0 NAME=VALUE pair, the
+ * value of which may be a comma separated list, or a bare vCard 2.1 type.
+ * @param param The parameter to parse.
+ * @param prop Reference to the property to record the parameter in.
+ */
+void VCardReaderType::ParseParam(const StringRefType &param,
+                                 struct sProperty &prop) {
+    const char *p, *pStop, *pEquals, *pComma;
+    StringRefType name, token;
+
+    p = param.data();
+    pStop = param.data() + param.size();
+    pEquals = (const char *)memchr(p, '=', pStop - p);
+
+    if (pEquals != NULL) {
+        name = StringRefType(p, pEquals - p);
+        p = pEquals + 1;
+        if (TextScanType::EqualsNoCase(name, "ENCODING")) {
+            token = StringRefType(p, pStop - p);
+            if (TextScanType::EqualsNoCase(token, "QUOTED-PRINTABLE"))
+                prop.quotedPrintable = true;
+            else if (TextScanType::EqualsNoCase(token, "B") ||
+                     TextScanType::EqualsNoCase(token, "BASE64"))
+                prop.binary = true;
+            return;
+        }
+        if (!TextScanType::EqualsNoCase(name, "TYPE"))
+            return;
+    }
+
+    while (p < pStop) {
+        pComma = (const char *)memchr(p, ',', pStop - p);
+        if (pComma == NULL)
+            pComma = pStop;
+        token = StringRefType(p, pComma - p);
+        p = pComma + 1;
+
+        if (token.size() && (token[0] == '"'))
+            token = StringRefType(token.data() + 1, token.size() - 1);
+        if (token.size() && (token[token.size() - 1] == '"'))
+            token = StringRefType(token.data(), token.size() - 1);
+
+        if (TextScanType::EqualsNoCase(token, "WORK"))
+            prop.types |= VCARD_TYPE_WORK;
+        else if (TextScanType::EqualsNoCase(token, "HOME"))
+            prop.types |= VCARD_TYPE_HOME;
+        else if (TextScanType::EqualsNoCase(token, "CELL"))
+            prop.types |= VCARD_TYPE_CELL;
+        else if (TextScanType::EqualsNoCase(token, "FAX"))
+            prop.types |= VCARD_TYPE_FAX;
+        else if (TextScanType::EqualsNoCase(token, "PAGER"))
+            prop.types |= VCARD_TYPE_PAGER;
+        else if (TextScanType::EqualsNoCase(token, "PREF"))
+            prop.types |= VCARD_TYPE_PREF;
+        else if (TextScanType::EqualsNoCase(token, "QUOTED-PRINTABLE"))
+            prop.quotedPrintable = true;
+        else if (TextScanType::EqualsNoCase(token, "BASE64"))
+            prop.binary = true;
+    }
+}
+
+/**
+ * Split a structured value.
+ *
+ * Split the raw value of a structured property, such as N or ADR, into its
+ * components at each semicolon which is not escaped.
+ * @param value The raw value to split.
+ */
+void VCardReaderType::SplitValue(const StringRefType &value) {
+    const char *p, *pStart, *pStop;
+
+    parts.clear();
+    pStart = value.data();
+    pStop = value.data() + value.size();
+    p = pStart;
+
+    while (true) {
+        p = TextScanType::FindAny(p, pStop, ';', '\\', ';');
+        if ((p < pStop) && (*p == '\\')) {
+            p += 2;
+            if (p > pStop)
+                p = pStop;
+            continue;
+        }
+        parts.push_back(StringRefType(pStart, p - pStart));
+        if (p == pStop)
+            break;
+        p++;
+        pStart = p;
+    }
+}
+
+/**
+ * Decode a value.
+ *
+ * Decode a raw value, or a component of one, undoing the quoted printable
+ * encoding if it has it and the escaping of its characters.
+ * @param value The raw value to decode.
+ * @param quotedPrintable Whether the value is quoted printable.
+ * @param decoded Reference to the string to store the decoded value in.
+ */
+void VCardReaderType::DecodeValue(const StringRefType &value,
+                                  bool quotedPrintable,
+                                  std::string &decoded) {
+    const char *p, *pStart, *pStop;
+    int high, low;
+
+    p = value.data();
+    pStop = value.data() + value.size();
+
+    if (quotedPrintable) {
+        qpDecoded.clear();
+        while (p < pStop) {
+            pStart = p;
+            p = (const char *)memchr(p, '=', pStop - p);
+            if (p == NULL)
+                p = pStop;
+            qpDecoded.append(pStart, p - pStart);
+            if (p == pStop)
+                break;
+
+            if ((pStop - p >= 3) && ((high = HexValue(p[1])) >= 0) &&
+                ((low = HexValue(p[2])) >= 0)) {
+                qpDecoded += (char)((high << 4) | low);
+                p += 3;
+            } else {
+                qpDecoded += '=';
+                p++;
+            }
+        }
+
+        p = qpDecoded.data();
+        pStop = qpDecoded.data() + qpDecoded.size();
+    }
+
+    decoded.clear();
+    TextScanType::AppendUnescaped(StringRefType(p, pStop - p), decoded);
+}
+
+/**
+ * Get a component of a structured value.
+ *
+ * Get the decoded component at the given index of the structured value
+ * split last.
+ * @param index The index of the component.
+ * @param prop The property the value belongs to.
+ * @return Reference to the decoded component, empty if there is none.
+ */
+const std::string &VCardReaderType::GetPart(unsigned int index,
+                                            const struct sProperty &prop) {
+    if (index >= parts.size())
+        part.clear();
+    else
+        DecodeValue(parts[index], prop.quotedPrintable, part);
+
+    return part;
+}
+
+/**
+ * Apply a property.
+ *
+ * Set the fields of the given item the given property maps to.
+ * @param prop The property to apply.
+ * @param item Reference to the item to set the fields of.
+ */
+void VCardReaderType::ApplyProperty(const struct sProperty &prop,
+                                    AddrBookItemType &item) {
+    const FieldDescType<AddrBookItemType> *pDesc;
+    unsigned int i;
+
+    if (TextScanType::EqualsNoCase(prop.name, "N")) {
+        SplitValue(prop.value);
+        item.SetLastName(GetPart(0, prop));
+        item.SetFirstName(GetPart(1, prop));
+        item.SetMiddleName(GetPart(2, prop));
+        item.SetTermOfRespect(GetPart(3, prop));
+        item.SetSuffix(GetPart(4, prop));
+    } else if (TextScanType::EqualsNoCase(prop.name, "ORG")) {
+        SplitValue(prop.value);
+        item.SetCompany(GetPart(0, prop));
+        item.SetDepartment(GetPart(1, prop));
+    } else if (TextScanType::EqualsNoCase(prop.name, "TEL")) {
+        SetPhone(prop, item);
+    } else if (TextScanType::EqualsNoCase(prop.name, "ADR")) {
+        SetAddress(prop, item);
+    } else if (TextScanType::EqualsNoCase(prop.name, "EMAIL")) {
+        DecodeValue(prop.value, prop.quotedPrintable, decoded);
+        if (decoded.empty())
+            return;
+        if ((prop.types & VCARD_TYPE_PREF) && defaultEmail.empty()) {
+            defaultEmail = decoded;
+            emails.insert(0, decoded + (emails.empty() ? "" : " "));
+        } else {
+            if (!emails.empty())
+                emails += ' ';
+            emails += decoded;
+        }
+    } else if (TextScanType::EqualsNoCase(prop.name, "URL")) {
+        DecodeValue(prop.value, prop.quotedPrintable, decoded);
+        if (prop.types & VCARD_TYPE_WORK)
+            item.SetWorkWebPage(decoded);
+        else
+            item.SetHomeWebPage(decoded);
+    } else if (TextScanType::EqualsNoCase(prop.name, "UID")) {
+        DecodeValue(prop.value, prop.quotedPrintable, decoded);
+        item.SetAppID(decoded);
+    } else if ((prop.name.size() > VCARD_EXTRA_PREFIX_SIZE) &&
+               TextScanType::EqualsNoCase(
+                   StringRefType(prop.name.data(), VCARD_EXTRA_PREFIX_SIZE),
+                   VCARD_EXTRA_PREFIX)) {
+        pDesc = FindStringDesc(StringRefType(
+            prop.name.data() + VCARD_EXTRA_PREFIX_SIZE,
+            prop.name.size() - VCARD_EXTRA_PREFIX_SIZE));
+        if (pDesc) {
+            DecodeValue(prop.value, prop.quotedPrintable, decoded);
+            pDesc->pSetString(item, decoded);
+        }
+    } else {
+        for (i = 0; i < numSimpleProps; i++) {
+            if (TextScanType::EqualsNoCase(prop.name, simpleProps[i].pName)) {
+                if (simpleDescs[i]) {
+                    DecodeValue(prop.value, prop.quotedPrintable, decoded);
+                    simpleDescs[i]->pSetString(item, decoded);
+                }
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * Set a phone number.
+ *
+ * Set the phone number field of the given item matching the types of the
+ * given TEL property. A number without a type goes to the first of the home
+ * and work phone which is still empty.
+ * @param prop The TEL property.
+ * @param item Reference to the item to set the field of.
+ */
+void VCardReaderType::SetPhone(const struct sProperty &prop,
+                               AddrBookItemType &item) {
+    bool isWork;
+
+    DecodeValue(prop.value, prop.quotedPrintable, decoded);
+    if (decoded.empty())
+        return;
+
+    isWork = ((prop.types & VCARD_TYPE_WORK) != 0);
+    if (prop.types & VCARD_TYPE_CELL) {
+        if (isWork && item.GetWorkMobile().empty())
+            item.SetWorkMobile(decoded);
+        else if (!isWork && item.GetCellular().empty())
+            item.SetCellular(decoded);
+    } else if (prop.types & VCARD_TYPE_FAX) {
+        if (isWork && item.GetWorkFax().empty())
+            item.SetWorkFax(decoded);
+        else if (!isWork && item.GetHomeFax().empty())
+            item.SetHomeFax(decoded);
+    } else if (prop.types & VCARD_TYPE_PAGER) {
+        if (item.GetPager().empty())
+            item.SetPager(decoded);
+    } else if (isWork) {
+        if (item.GetWorkPhone().empty())
+            item.SetWorkPhone(decoded);
+    } else if (item.GetHomePhone().empty()) {
+        item.SetHomePhone(decoded);
+    } else if (!(prop.types & VCARD_TYPE_HOME) &&
+               item.GetWorkPhone().empty()) {
+        item.SetWorkPhone(decoded);
+    }
+}
+
+/**
+ * Set an address.
+ *
+ * Set the work or home address fields of the given item from the given ADR
+ * property, the home address unless it is typed as work.
+ * @param prop The ADR property.
+ * @param item Reference to the item to set the fields of.
+ */
+void VCardReaderType::SetAddress(const struct sProperty &prop,
+                                 AddrBookItemType &item) {
+    SplitValue(prop.value);
+
+    // The components are the post office box, extended address, street,
+    // city, region, postal code and country, the Zaurus has no room for
+    // the first two.
+    if (prop.types & VCARD_TYPE_WORK) {
+        item.SetWorkStreet(GetPart(2, prop));
+        item.SetWorkCity(GetPart(3, prop));
+        item.SetWorkState(GetPart(4, prop));
+        item.SetWorkZip(GetPart(5, prop));
+        item.SetWorkCountry(GetPart(6, prop));
+    } else {
+        item.SetHomeStreet(GetPart(2, prop));
+        item.SetHomeCity(GetPart(3, prop));
+        item.SetHomeState(GetPart(4, prop));
+        item.SetHomeZip(GetPart(5, prop));
+        item.SetHomeCountry(GetPart(6, prop));
+    }
+}
+
+/**
+ * Construct a VCardWriterType object.
+ *
+ * Construct a VCardWriterType object writing cards of the given version.
+ * @param vCardVersion The version of vCard to write, VCARD_VERSION_21 or
+ * VCARD_VERSION_30.
+ */
+VCardWriterType::VCardWriterType(unsigned int vCardVersion) {
+    unsigned int i, j;
+    bool isCovered;
+
+    version = vCardVersion;
+
+    simpleDescs.resize(numSimpleProps);
+    for (i = 0; i < numSimpleProps; i++) {
+        if (simpleProps[i].isWritten)
+            simpleDescs[i] = FindStringDesc(simpleProps[i].pAbrev);
+    }
+
+    for (i = 0; i < AddrBookItemType::numFieldDescs; i++) {
+        const FieldDescType<AddrBookItemType> &desc =
+            AddrBookItemType::fieldDescs[i];
+
+        if ((desc.pGetString == NULL) || !(desc.flags & FIELD_CONTENT))
+            continue;
+
+        isCovered = false;
+        for (j = 0; (j < numSimpleProps) && !isCovered; j++)
+            isCovered = (simpleProps[j].isWritten &&
+                         (strcmp(simpleProps[j].pAbrev, desc.pAbrev) == 0));
+        for (j = 0; (j < numStructuredAbrevs) && !isCovered; j++)
+            isCovered = (strcmp(structuredAbrevs[j], desc.pAbrev) == 0);
+
+        if (!isCovered)
+            extraDescs.push_back(&desc);
+    }
+}
+
+/**
+ * Put an item.
+ *
+ * Append the given item to the given buffer as a vCard.
+ * @param item Reference to the item to append.
+ * @param out Reference to the buffer to append the card to.
+ */
+void VCardWriterType::Put(const AddrBookItemType &item, std::string &out) {
+    StringRefType values[7];
+    StringRefType emails;
+    std::string::size_type start, stop;
+    std::string fullName;
+    char name[VCARD_EXTRA_PREFIX_SIZE + 8];
+    unsigned int i;
+
+    out.append("BEGIN:VCARD\r\n");
+    if (version == VCARD_VERSION_21)
+        out.append("VERSION:2.1\r\n");
+    else
+        out.append("VERSION:3.0\r\n");
+
+    if (!item.GetAppID().empty())
+        PutProperty(out, "UID", NULL, item.GetAppID());
+
+    values[0] = item.GetLastName();
+    values[1] = item.GetFirstName();
+    values[2] = item.GetMiddleName();
+    values[3] = item.GetTermOfRespect();
+    values[4] = item.GetSuffix();
+    PutProperty(out, "N", NULL, values, 5);
+
+    // vCard 3.0 requires a formatted name, so I make one up from the name
+    // or company when the item has none.
+    if (!item.GetFullName().empty()) {
+        PutProperty(out, "FN", NULL, item.GetFullName());
+    } else {
+        fullName = item.GetFirstName().str();
+        if (!item.GetLastName().empty()) {
+            if (!fullName.empty())
+                fullName += ' ';
+            fullName.append(item.GetLastName().data(),
+                            item.GetLastName().size());
+        }
+        if (fullName.empty())
+            fullName = item.GetCompany().str();
+        PutProperty(out, "FN", NULL, fullName);
+    }
+
+    if (!item.GetCompany().empty() || !item.GetDepartment().empty()) {
+        values[0] = item.GetCompany();
+        values[1] = item.GetDepartment();
+        PutProperty(out, "ORG", NULL, values, 2);
+    }
+
+    PutProperty(out, "TEL", "WORK,VOICE", item.GetWorkPhone());
+    PutProperty(out, "TEL", "WORK,FAX", item.GetWorkFax());
+    PutProperty(out, "TEL", "WORK,CELL", item.GetWorkMobile());
+    PutProperty(out, "TEL", "HOME,VOICE", item.GetHomePhone());
+    PutProperty(out, "TEL", "HOME,FAX", item.GetHomeFax());
+    PutProperty(out, "TEL", "CELL", item.GetCellular());
+    PutProperty(out, "TEL", "PAGER", item.GetPager());
+
+    values[0] = StringRefType();
+    values[1] = StringRefType();
+    values[2] = item.GetWorkStreet();
+    values[3] = item.GetWorkCity();
+    values[4] = item.GetWorkState();
+    values[5] = item.GetWorkZip();
+    values[6] = item.GetWorkCountry();
+    PutProperty(out, "ADR", "WORK", values, 7);
+    values[2] = item.GetHomeStreet();
+    values[3] = item.GetHomeCity();
+    values[4] = item.GetHomeState();
+    values[5] = item.GetHomeZip();
+    values[6] = item.GetHomeCountry();
+    PutProperty(out, "ADR", "HOME", values, 7);
+
+    PutProperty(out, "URL", "WORK", item.GetWorkWebPage());
+    PutProperty(out, "URL", "HOME", item.GetHomeWebPage());
+
+    // The default email is written first and preferred, followed by the
+    // rest of the space separated list of emails.
+    PutProperty(out, "EMAIL", "INTERNET,PREF", item.GetDefaultEmail());
+    emails = item.GetEmails();
+    start = 0;
+    while (start < emails.size()) {
+        stop = start;
+        while ((stop < emails.size()) && (emails[stop] != ' '))
+            stop++;
+        values[0] = StringRefType(emails.data() + start, stop - start);
+        if (!values[0].empty() && (values[0] != item.GetDefaultEmail()))
+            PutProperty(out, "EMAIL", "INTERNET", values[0]);
+        start = stop + 1;
+    }
+
+    for (i = 0; i < numSimpleProps; i++) {
+        if (simpleDescs[i])
+            PutProperty(out, simpleProps[i].pName, NULL,
+                        simpleDescs[i]->pGetString(item));
+    }
+
+    for (i = 0; i < extraDescs.size(); i++) {
+        strcpy(name, VCARD_EXTRA_PREFIX);
+        strncat(name, extraDescs[i]->pAbrev, 7);
+        PutProperty(out, name, NULL, extraDescs[i]->pGetString(item));
+    }
+
+    out.append("END:VCARD\r\n");
+}
+
+/**
+ * Write a file of cards.
+ *
+ * Write every item of the given list to the file at the given path as a
+ * vCard, replacing the file. The cards are built a chunk at a time, so the
+ * whole file is never held in memory.
+ * @param filePath The path of the file.
+ * @param itemList Reference to the list of items to write.
+ * @param vCardVersion The version of vCard to write.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully wrote the file.
+ * @retval 1 Failed to create the file.
+ * @retval 2 Failed to write the file.
+ */
+int VCardWriterType::WriteFile(const std::string &filePath,
+                               const AddrBookItemType::List &itemList,
+                               unsigned int vCardVersion) {
+    VCardWriterType writer(vCardVersion);
+    AddrBookItemType::List::const_iterator iter;
+    std::string buff;
+    bool failed = false;
+    int fd;
+
+    fd = open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        return 1;
+
+    buff.reserve(VCARD_WRITE_CHUNK + 4096);
+    for (iter = itemList.begin(); (iter != itemList.end()) && !failed;
+         ++iter) {
+        writer.Put(*iter, buff);
+        if (buff.size() >= VCARD_WRITE_CHUNK) {
+            failed = (write(fd, buff.data(), buff.size()) !=
+                      (ssize_t)buff.size());
+            buff.clear();
+        }
+    }
+
+    if (!failed && !buff.empty())
+        failed = (write(fd, buff.data(), buff.size()) !=
+                  (ssize_t)buff.size());
+
+    if ((close(fd) != 0) || failed)
+        return 2;
+
+    return 0;
+}
+
+/**
+ * Put a property.
+ *
+ * Append a property with the given name, types and value to the buffer as
+ * a line of the version being written. A structured value is given as its
+ * components. A property whose components are all empty is left out.
+ * @param out Reference to the buffer to append the property to.
+ * @param pName The name of the property.
+ * @param pTypes The comma separated types of the property, or NULL.
+ * @param pValues Pointer to the components of the value.
+ * @param numValues The number of components.
+ */
+void VCardWriterType::PutProperty(std::string &out, const char *pName,
+                                  const char *pTypes,
+                                  const StringRefType *pValues,
+                                  unsigned int numValues) {
+    std::string::size_type i;
+    unsigned int j;
+    bool isEmpty = true;
+    bool isQP = false;
+
+    for (j = 0; j < numValues; j++) {
+        if (!pValues[j].empty())
+            isEmpty = false;
+    }
+    if (isEmpty)
+        return;
+
+    line.assign(pName);
+    if (pTypes != NULL) {
+        if (version == VCARD_VERSION_21) {
+            line += ';';
+            for (i = 0; pTypes[i] != '\0'; i++)
+                line += (pTypes[i] == ',') ? ';' : pTypes[i];
+        } else {
+            line.append(";TYPE=");
+            line.append(pTypes);
+        }
+    }
+
+    // vCard 2.1 has no way to escape a line break or a character outside
+    // of ASCII, so such values are quoted printable instead.
+    if (version == VCARD_VERSION_21) {
+        for (j = 0; (j < numValues) && !isQP; j++) {
+            for (i = 0; (i < pValues[j].size()) && !isQP; i++)
+                isQP = (((unsigned char)pValues[j][i] >= 0x80) ||
+                        ((unsigned char)pValues[j][i] < 0x20));
+        }
+        if (isQP)
+            line.append(";ENCODING=QUOTED-PRINTABLE;CHARSET=UTF-8");
+    }
+
+    line += ':';
+    for (j = 0; j < numValues; j++) {
+        if (j > 0)
+            line += ';';
+        if (isQP)
+            PutQuotedPrintable(pValues[j]);
+        else
+            PutEscaped(pValues[j]);
+    }
+
+    PutLine(out);
+}
+
+/**
+ * Put an escaped value.
+ *
+ * Append a value to the current line, escaping the characters which would
+ * otherwise be read as part of the syntax.
+ * @param value The value to append.
+ */
+void VCardWriterType::PutEscaped(const StringRefType &value) {
+    const char *p, *pStart, *pStop;
+
+    if (version != VCARD_VERSION_21) {
+        TextScanType::AppendEscaped(value, line);
+        return;
+    }
+
+    // vCard 2.1 only escapes the semicolons which would split a value.
+    p = value.data();
+    pStop = value.data() + value.size();
+    while (p < pStop) {
+        pStart = p;
+        p = (const char *)memchr(p, ';', pStop - p);
+        if (p == NULL)
+            p = pStop;
+        line.append(pStart, p - pStart);
+        if (p == pStop)
+            break;
+        line.append("\\;");
+        p++;
+    }
+}
+
+/**
+ * Put a quoted printable value.
+ *
+ * Append a value to the current line in the quoted printable encoding,
+ * line breaks as CR LF. Semicolons are encoded too, so that they do not
+ * split a structured value.
+ * @param value The value to append.
+ */
+void VCardWriterType::PutQuotedPrintable(const StringRefType &value) {
+    static const char hexDigits[] = "0123456789ABCDEF";
+    std::string::size_type i;
+    unsigned char ch;
+
+    for (i = 0; i < value.size(); i++) {
+        ch = (unsigned char)value[i];
+        if (ch == '\n') {
+            line.append("=0D=0A");
+        } else if ((ch >= 0x80) || (ch < 0x20) || (ch == '=') ||
+                   (ch == ';')) {
+            line += '=';
+            line += hexDigits[ch >> 4];
+            line += hexDigits[ch & 0x0f];
+        } else {
+            line += (char)ch;
+        }
+    }
+}
+
+/**
+ * Put the current line.
+ *
+ * Append the current line to the buffer followed by a line break. A vCard
+ * 3.0 line is folded so no line is longer than 75 octets, without breaking
+ * a UTF-8 character, and a quoted printable vCard 2.1 line is broken with
+ * soft line breaks, without breaking an encoded character.
+ * @param out Reference to the buffer to append the line to.
+ */
+void VCardWriterType::PutLine(std::string &out) {
+    std::string::size_type start, stop;
+
+    if (version != VCARD_VERSION_21) {
+        TextScanType::AppendFolded(line, out);
+        return;
+    }
+
+    if ((line.size() <= VCARD_LINE_SIZE) ||
+        (line.find("QUOTED-PRINTABLE") == std::string::npos)) {
+        out.append(line);
+        out.append("\r\n");
+        return;
+    }
+
+    start = 0;
+    while (start < line.size()) {
+        // A soft line break ends with an equals sign taking up one octet.
+        stop = start + VCARD_LINE_SIZE;
+        if (stop >= line.size()) {
+            stop = line.size();
+        } else if ((stop - 1 > start) && (line[stop - 1] == '=')) {
+            stop -= 1;
+        } else if ((stop - 2 > start) && (line[stop - 2] == '=')) {
+            stop -= 2;
+        }
+
+        out.append(line, start, stop - start);
+        if (stop < line.size())
+            out += '=';
+        out.append("\r\n");
+        start = stop;
+    }
+}
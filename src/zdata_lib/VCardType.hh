@@ -0,0 +1,161 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file VCardType.hh
+ * @brief A specifications file for reading and writing vCards.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for the classes existing to convert Address Book
+ * items to and from vCard 2.1 and 3.0, so that address books may be
+ * imported and exported in bulk.
+ */
+
+#ifndef VCARDTYPE_H
+#define VCARDTYPE_H
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "AddrBookItemType.hh"
+#include "StringRefType.hh"
+
+// Define the versions of vCard which may be written.
+#define VCARD_VERSION_21 21
+#define VCARD_VERSION_30 30
+
+/**
+ * @class VCardReaderType
+ * @brief A type reading Address Book items from vCards.
+ *
+ * The VCardReaderType is a class which reads the vCards held in a buffer,
+ * one after the other, into Address Book items. Both vCard 2.1 and 3.0 are
+ * read, including folded lines, quoted printable values and escaped
+ * characters, and the text is taken to be UTF-8. The properties which have
+ * a standard meaning are mapped to the matching fields, and a field of the
+ * item with no such property is read from an X-ZAURUS- property named after
+ * the Zaurus parameter it is stored in, as written by VCardWriterType.
+ * Properties which have no field, such as photos, are skipped.
+ *
+ * The buffer is scanned in place, a run of characters at a time, and values
+ * are decoded into buffers kept by the reader, so reading a card allocates
+ * nothing but the strings of the item itself. The buffer has to stay valid
+ * while the reader is used.
+ */
+class VCardReaderType {
+public:
+    VCardReaderType(const char *pData, size_t size);
+
+    int Next(AddrBookItemType &item);
+
+    static int ReadFile(const std::string &filePath,
+                        AddrBookItemType::List &itemList);
+
+private:
+    // The pieces of a content line, each referring into the buffer or the
+    // line the reader unfolded.
+    struct sProperty {
+        StringRefType name;
+        StringRefType value;
+        unsigned int types;
+        bool quotedPrintable;
+        bool binary;
+    };
+
+    bool NextLine(StringRefType &line);
+    bool SplitLine(const StringRefType &line, struct sProperty &prop);
+    void ParseParam(const StringRefType &param, struct sProperty &prop);
+    void SplitValue(const StringRefType &value);
+    void DecodeValue(const StringRefType &value, bool quotedPrintable,
+                     std::string &decoded);
+    void ApplyProperty(const struct sProperty &prop, AddrBookItemType &item);
+    void SetPhone(const struct sProperty &prop, AddrBookItemType &item);
+    void SetAddress(const struct sProperty &prop, AddrBookItemType &item);
+    const std::string &GetPart(unsigned int index,
+                               const struct sProperty &prop);
+
+    const char *pCur;
+    const char *pEnd;
+
+    // The descriptor of the field each simple property is read into.
+    std::vector<const FieldDescType<AddrBookItemType> *> simpleDescs;
+
+    // The buffers reused for every card, so that reading a card does not
+    // allocate beyond the strings of the item.
+    std::string unfolded;
+    std::string decoded;
+    std::string qpDecoded;
+    std::string part;
+    std::string emails;
+    std::string defaultEmail;
+    std::vector<StringRefType> parts;
+};
+
+/**
+ * @class VCardWriterType
+ * @brief A type writing Address Book items as vCards.
+ *
+ * The VCardWriterType is a class which appends Address Book items to a
+ * buffer as vCards of the version it was constructed with. Fields with a
+ * standard property are written as that property, and every other field is
+ * written as an X-ZAURUS- property named after the Zaurus parameter it is
+ * stored in, so that no field is lost when the cards are read back. Values
+ * are escaped as the version requires, vCard 3.0 lines are folded and vCard
+ * 2.1 values which are not plain ASCII are quoted printable.
+ */
+class VCardWriterType {
+public:
+    VCardWriterType(unsigned int vCardVersion = VCARD_VERSION_30);
+
+    void Put(const AddrBookItemType &item, std::string &out);
+
+    static int WriteFile(const std::string &filePath,
+                         const AddrBookItemType::List &itemList,
+                         unsigned int vCardVersion = VCARD_VERSION_30);
+
+private:
+    void PutProperty(std::string &out, const char *pName,
+                     const char *pTypes, const StringRefType *pValues,
+                     unsigned int numValues);
+    void PutProperty(std::string &out, const char *pName,
+                     const char *pTypes, const StringRefType &value) {
+        PutProperty(out, pName, pTypes, &value, 1);
+    }
+    void PutEscaped(const StringRefType &value);
+    void PutQuotedPrintable(const StringRefType &value);
+    void PutLine(std::string &out);
+
+    unsigned int version;
+
+    // The descriptor of the field each simple property is written from,
+    // NULL for those which are only read.
+    std::vector<const FieldDescType<AddrBookItemType> *> simpleDescs;
+
+    // The descriptors of the fields without a standard property, which are
+    // written as X-ZAURUS- properties.
+    std::vector<const FieldDescType<AddrBookItemType> *> extraDescs;
+
+    // The buffer the current line is built in before it is folded.
+    std::string line;
+};
+
+#endif
@@ -33,5 +33,6 @@
 #include "TodoItemType.hh"
 #include "AddrBookItemType.hh"
 #include "CalendarItemType.hh"
+#include "IDMapType.hh"
 
 #endif
@@ -306,6 +306,60 @@ int RDWMessageType::CommitContent(void) {
     return retval;
 }
 
+/**
+ * Get the size of the built content.
+ *
+ * Get the number of bytes of content that have been built so far. Since
+ * each Append member function appends its data at the end of the content,
+ * calling this just before an Append gives the offset of the appended item,
+ * which can later be handed to PatchULong.
+ * @return The number of bytes of content built so far.
+ */
+unsigned short int RDWMessageType::GetBuiltSize(void) const {
+    return buffSize;
+}
+
+/**
+ * Patch a previously appended DATA_ID_ULONG.
+ *
+ * Overwrite the data of a DATA_ID_ULONG which was previously appended at
+ * the given offset, and commit the content again so the message is ready to
+ * be sent. This allows a message to be fully built before one of its values
+ * is known, such as the synchronization ID of a new item.
+ * @param offset The offset of the item, as obtained from GetBuiltSize just
+ * before the item was appended.
+ * @param data The data to store in the item.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully patched the data.
+ * @retval 1 Failed, the offset does not refer to an item within the content.
+ * @retval 2 Failed, failed to swap data byte order.
+ * @retval 3 Failed to commit the patched content.
+ */
+int RDWMessageType::PatchULong(unsigned short int offset,
+			       unsigned long int data) {
+    unsigned char *pItemData;
+
+    if ((pBuff == NULL) ||
+	((unsigned long int)offset + itemLenSize + sizeof(unsigned long int)) >
+	buffSize)
+	return 1;
+
+    pItemData = pBuff + offset + itemLenSize;
+
+    if (IsBigEndian()) {
+	if (SwapByteOrder((const void *)&data, (void *)pItemData,
+			  sizeof(unsigned long int)))
+	    return 2;
+    } else {
+	memcpy((void *)pItemData, (const void *)&data, sizeof(unsigned long int));
+    }
+
+    if (CommitContent())
+	return 3;
+
+    return 0;
+}
+
 /**
  * Append generic data.
  *
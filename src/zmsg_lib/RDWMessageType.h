@@ -70,6 +70,9 @@ class RDWMessageType : public DesktopMessageType {
 
     int CommitContent(void);
 
+    unsigned short int GetBuiltSize(void) const;
+    int PatchULong(unsigned short int offset, unsigned long int data);
+
  private:
     int AppendData(const unsigned char *data, unsigned long int len);
     int ConvCalTime(time_t calTime, unsigned char *dest,
@@ -38,6 +38,41 @@
 #include <string.h>     // memcpy()
 #include <netinet/in.h> // ntohs()
 #include <limits.h>     // USHRT_MAX
+#include <sys/time.h>   // gettimeofday()
+
+// The function messages are reported to, if any, and its context.
+static MsgTraceFunc pTraceFunc = NULL;
+static void *pTraceCtx = NULL;
+
+/**
+ * Get the time waited.
+ *
+ * Get the number of seconds which have passed since the given time.
+ * @param pStart Pointer to the time the wait started.
+ * @return The number of seconds waited.
+ */
+static double GetWaitTime(const struct timeval *pStart) {
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return (double)(now.tv_sec - pStart->tv_sec) +
+        (double)(now.tv_usec - pStart->tv_usec) / 1000000.0;
+}
+
+/**
+ * Set the message trace.
+ *
+ * Set the function every message sent and received is reported to, along
+ * with its size and the time spent waiting for it, so that the time a sync
+ * takes may be broken down. Only one trace is set at a time and it is
+ * called from whichever thread sends or receives the message.
+ * @param pFunc Pointer to the function to report to, or NULL for none.
+ * @param pCtx Pointer passed on to the function.
+ */
+void SetMsgTrace(MsgTraceFunc pFunc, void *pCtx) {
+    pTraceFunc = pFunc;
+    pTraceCtx = pCtx;
+}
 
 
 /**
@@ -116,8 +151,13 @@ int RecvAck(const int sd) {
     int retval;
     char msg_data[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x96, 0x06};
     char buff[7];
+    struct timeval start;
 
+    gettimeofday(&start, NULL);
     retval = read(sd, buff, 7);
+    if (pTraceFunc)
+        pTraceFunc(pTraceCtx, MSG_TRACE_ACK, NULL,
+                   (retval > 0) ? retval : 0, GetWaitTime(&start));
     if (retval == -1) {
         perror("RecvAck");
         exit(1);
@@ -154,8 +194,13 @@ int RecvRqst(const int sd) {
     int retval;
     char msg_data[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x96, 0x05};
     char buff[7];
+    struct timeval start;
 
+    gettimeofday(&start, NULL);
     retval = read(sd, buff, 7);
+    if (pTraceFunc)
+        pTraceFunc(pTraceCtx, MSG_TRACE_RQST, NULL,
+                   (retval > 0) ? retval : 0, GetWaitTime(&start));
     if (retval == -1) {
         perror("RecvAck");
         exit(1);
@@ -193,8 +238,13 @@ int RecvAbrt(const int sd) {
     int retval;
     char msg_data[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x96, 0x18};
     char buff[7];
+    struct timeval start;
 
+    gettimeofday(&start, NULL);
     retval = read(sd, buff, 7);
+    if (pTraceFunc)
+        pTraceFunc(pTraceCtx, MSG_TRACE_REPLY, NULL,
+                   (retval > 0) ? retval : 0, GetWaitTime(&start));
     if (retval == -1) {
         perror("RecvAbrt");
         exit(1);
@@ -232,6 +282,9 @@ void SendAck(const int sockfd) {
         perror("SendAck");
         exit(1);
     }
+
+    if (pTraceFunc)
+        pTraceFunc(pTraceCtx, MSG_TRACE_SENT, NULL, retval, 0.0);
 }
 
 /**
@@ -250,6 +303,9 @@ void SendRqst(const int sockfd) {
         perror("send_recqst_msg");
         exit(1);
     }
+
+    if (pTraceFunc)
+        pTraceFunc(pTraceCtx, MSG_TRACE_SENT, NULL, retval, 0.0);
 }
 
 /**
@@ -282,8 +338,20 @@ int RecvMessage(const int sd, MessageType *pMsg) {
 
     unsigned short int bodySize;
     unsigned short int checkSum;
+    struct timeval start;
 
+    gettimeofday(&start, NULL);
     numBytesRead = read(sd, (void *)buff, maxBuffSize);
+    if (pTraceFunc) {
+        if (numBytesRead >= MSG_HDR_SIZE + 2 + MSG_TYPE_SIZE)
+            pTraceFunc(pTraceCtx, MSG_TRACE_REPLY,
+                       (const char *)(buff + MSG_HDR_SIZE + 2),
+                       numBytesRead, GetWaitTime(&start));
+        else
+            pTraceFunc(pTraceCtx, MSG_TRACE_REPLY, NULL,
+                       (numBytesRead > 0) ? numBytesRead : 0,
+                       GetWaitTime(&start));
+    }
 
     printf("libzmsg: RecvMessage(): -----Message Beginning-----\n");
 
@@ -478,6 +546,10 @@ int SendMessage(const int sd, MessageType *pMsg) {
     // Free the dynamically allocated memory.
     free(wireMsg);
 
+    if (pTraceFunc)
+        pTraceFunc(pTraceCtx, MSG_TRACE_SENT, (const char *)pMsg->GetType(),
+                   (int)msgSize, 0.0);
+
     // Return in success.
     return 0;
 }
@@ -64,6 +64,20 @@
 #include <stdlib.h>
 #include <string.h>
 
+// The events reported to the message trace, see SetMsgTrace().
+#define MSG_TRACE_SENT 1
+#define MSG_TRACE_RQST 2
+#define MSG_TRACE_ACK 3
+#define MSG_TRACE_REPLY 4
+
+// The type of the function a message trace reports to. The type is the three
+// letters of the message type, not terminated, or NULL for the short Ack,
+// Rqst and Abrt messages. The wait time is in seconds.
+typedef void (*MsgTraceFunc)(void *pCtx, int event, const char *pType,
+                             int numBytes, double waitTime);
+
+void SetMsgTrace(MsgTraceFunc pFunc, void *pCtx);
+
 int IsAckMessage(const unsigned char *buff);
 int IsRqstMessage(const unsigned char *buff);
 int IsAbrtMessage(const unsigned char *buff);
@@ -150,6 +150,9 @@ public:
      * Map the Item IDs
      *
      * Map the Item IDs between the Zaurus and the Desktop PIM application.
+     * zync keeps the same mapping itself, and while synchronizing makes it
+     * available through IDMapType::GetShared(), so a plugin may look items
+     * up there rather than keeping a mapping of its own.
      * @param calendarItems A list of items which need their IDs mapped.
      * @return An integer representing success (zero) or failure (non-zero).
      */
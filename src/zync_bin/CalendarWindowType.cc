@@ -0,0 +1,349 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file CalendarWindowType.cc
+ * @brief An implementation file for the calendar sync window.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for a class existing to limit a Calendar sync to
+ * the events falling within a window of time around the present.
+ */
+
+#include "CalendarWindowType.hh"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <vector>
+
+#include <zdata_lib/IntervalIndexType.hh>
+#include <zdata_lib/RecurrenceType.hh>
+
+// The magic bytes and version at the front of every spans file.
+#define SPANS_MAGIC "ZSPN"
+#define SPANS_MAGIC_SIZE 4
+#define SPANS_VERSION 0x02
+
+// The layout of the header of the spans file, the entries follow it. Like
+// the snapshot, the spans are local to this machine so they are simply
+// stored in host byte order. The device key identifies the Zaurus the
+// events are on.
+struct sSpansHeader {
+    char magic[SPANS_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t device;
+};
+
+// The layout of each entry of the spans file.
+struct sSpansEntry {
+    uint64_t syncID;
+    int64_t start;
+    int64_t end;
+};
+
+/**
+ * Construct a default CalendarWindowType object.
+ *
+ * Construct a CalendarWindowType object whose window is not set, which
+ * contains every event.
+ */
+CalendarWindowType::CalendarWindowType(void) {
+    windowStart = 0;
+    windowEnd = 0;
+    enabled = false;
+}
+
+/**
+ * Set the window.
+ *
+ * Set the window of time the sync is limited to.
+ * @param start The start of the window.
+ * @param end The end of the window.
+ */
+void CalendarWindowType::SetWindow(time_t start, time_t end) {
+    windowStart = start;
+    windowEnd = end;
+    enabled = true;
+}
+
+/**
+ * Check if the window is set.
+ *
+ * Check if the sync is limited to a window at all.
+ * @return True if the window is set, false otherwise.
+ */
+bool CalendarWindowType::IsEnabled(void) const {
+    return enabled;
+}
+
+/**
+ * Check if an event falls within the window.
+ *
+ * Check if any occurrence of the given event overlaps the window. An
+ * event whose recorded span on the Zaurus overlaps the window falls within
+ * it as well, so that an event moved out of the window is still changed on
+ * the side which holds it within the window. Every event falls within a
+ * window which is not set.
+ * @param item The event to check.
+ * @return True if the event falls within the window, false otherwise.
+ */
+bool CalendarWindowType::Contains(const CalendarItemType &item) const {
+    std::map<unsigned long int, struct sSpan>::const_iterator fndIter;
+    time_t spanStart, spanEnd;
+
+    if (!enabled)
+        return true;
+
+    // The span is only a bound on the occurrences of a repeating event, so
+    // it is checked first and the occurrences only when it overlaps.
+    item.GetSpan(spanStart, spanEnd);
+    if ((spanStart <= windowEnd) && (spanEnd >= windowStart) &&
+        RecurrenceType(item).Overlaps(windowStart, windowEnd))
+        return true;
+
+    fndIter = spans.find(item.GetSyncID());
+    return ((fndIter != spans.end()) &&
+            (fndIter->second.start <= windowEnd) &&
+            (fndIter->second.end >= windowStart));
+}
+
+/**
+ * Load the spans.
+ *
+ * Load the spans of the events on the Zaurus from the file at the given
+ * path. The spans of the events on a different device are refused.
+ * @param spansPath The path of the spans file.
+ * @param device The key identifying the Zaurus being synchronized.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully loaded the spans.
+ * @retval 1 Failed to open the spans file, there may not be one yet.
+ * @retval 2 The spans file does not hold valid spans.
+ * @retval 3 The spans file belongs to a different device.
+ */
+int CalendarWindowType::Load(const std::string &spansPath,
+                             uint64_t device) {
+    struct sSpansHeader header;
+    std::vector<struct sSpansEntry> entries;
+    struct stat fileStat;
+    struct sSpan span;
+    size_t size;
+    ssize_t numRead;
+    unsigned int i;
+    int fd;
+
+    spans.clear();
+
+    fd = open(spansPath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return 1;
+
+    if ((fstat(fd, &fileStat) != 0) ||
+        (read(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) ||
+        (memcmp(header.magic, SPANS_MAGIC, SPANS_MAGIC_SIZE) != 0) ||
+        (header.version != SPANS_VERSION) ||
+        ((size_t)fileStat.st_size != sizeof(header) +
+            (size_t)header.count * sizeof(struct sSpansEntry))) {
+        close(fd);
+        return 2;
+    }
+
+    if (header.device != device) {
+        close(fd);
+        return 3;
+    }
+
+    entries.resize(header.count);
+    size = (size_t)header.count * sizeof(struct sSpansEntry);
+    numRead = 0;
+    if (size > 0)
+        numRead = read(fd, &entries[0], size);
+    close(fd);
+
+    if (numRead != (ssize_t)size)
+        return 2;
+
+    for (i = 0; i < entries.size(); i++) {
+        span.start = (time_t)entries[i].start;
+        span.end = (time_t)entries[i].end;
+        spans[(unsigned long int)entries[i].syncID] = span;
+    }
+
+    return 0;
+}
+
+/**
+ * Save the spans.
+ *
+ * Save the spans of the events on the Zaurus to the file at the given path.
+ * They are written to a new file which then replaces the old one, so the old
+ * spans are left untouched if zync dies part way through.
+ * @param spansPath The path of the spans file.
+ * @param device The key identifying the Zaurus being synchronized.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully saved the spans.
+ * @retval 1 Failed to create the new spans file.
+ * @retval 2 Failed to write the new spans file.
+ * @retval 3 Failed to replace the old spans file.
+ */
+int CalendarWindowType::Save(const std::string &spansPath,
+                             uint64_t device) const {
+    struct sSpansHeader header;
+    std::vector<struct sSpansEntry> entries;
+    std::map<unsigned long int, struct sSpan>::const_iterator iter;
+    struct sSpansEntry entry;
+    std::string tmpPath;
+    size_t size;
+    int fd;
+
+    entries.reserve(spans.size());
+    for (iter = spans.begin(); iter != spans.end(); ++iter) {
+        entry.syncID = (uint64_t)iter->first;
+        entry.start = (int64_t)iter->second.start;
+        entry.end = (int64_t)iter->second.end;
+        entries.push_back(entry);
+    }
+
+    tmpPath = spansPath + ".tmp";
+    fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        return 1;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SPANS_MAGIC, SPANS_MAGIC_SIZE);
+    header.version = SPANS_VERSION;
+    header.count = (uint32_t)entries.size();
+    header.device = device;
+
+    size = entries.size() * sizeof(struct sSpansEntry);
+    if ((write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) ||
+        ((size > 0) &&
+            (write(fd, &entries[0], size) != (ssize_t)size)) ||
+        (fsync(fd) != 0)) {
+        close(fd);
+        unlink(tmpPath.c_str());
+        return 2;
+    }
+    close(fd);
+
+    if (rename(tmpPath.c_str(), spansPath.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return 3;
+    }
+
+    return 0;
+}
+
+/**
+ * Record the span of an event.
+ *
+ * Record the span of the given event, which was just read from or written
+ * to the Zaurus. Events without a sync ID are not on the Zaurus yet, so
+ * they are not recorded.
+ * @param item The event to record the span of.
+ */
+void CalendarWindowType::Record(const CalendarItemType &item) {
+    struct sSpan span;
+
+    if (item.GetSyncID() == 0)
+        return;
+
+    item.GetSpan(span.start, span.end);
+    spans[item.GetSyncID()] = span;
+}
+
+/**
+ * Forget the spans of events.
+ *
+ * Forget the spans of the events with the given sync IDs, which are no
+ * longer on the Zaurus.
+ * @param syncIDList The list of sync IDs of the events to forget.
+ */
+void CalendarWindowType::Forget(const SyncIDListType &syncIDList) {
+    SyncIDListType::const_iterator iter;
+
+    for (iter = syncIDList.begin(); iter != syncIDList.end(); ++iter)
+        spans.erase(*iter);
+}
+
+/**
+ * Retain only the given events.
+ *
+ * Forget the span of every event whose sync ID is not in the given set.
+ * This is used once the full list of events on the Zaurus is known, to drop
+ * the ones which have since disappeared from it.
+ * @param syncIDs The set of sync IDs of the events to retain.
+ */
+void CalendarWindowType::RetainOnly(
+    const std::set<unsigned long int> &syncIDs) {
+    std::map<unsigned long int, struct sSpan>::iterator iter;
+
+    iter = spans.begin();
+    while (iter != spans.end()) {
+        if (syncIDs.find(iter->first) == syncIDs.end())
+            spans.erase(iter++);
+        else
+            ++iter;
+    }
+}
+
+/**
+ * Get the sync IDs of the events outside the window.
+ *
+ * Get the sync IDs of the events on the Zaurus whose recorded spans do not
+ * overlap the window. Events whose spans were never recorded are not
+ * included, since nothing is known about them.
+ * @param syncIDs Reference to the set to store the sync IDs in.
+ * @return The number of events found outside the window.
+ */
+unsigned long int CalendarWindowType::GetOutsideSyncIDs(
+    std::set<unsigned long int> &syncIDs) const {
+    IntervalIndexType<unsigned long int> spanIndex;
+    std::map<unsigned long int, struct sSpan>::const_iterator iter;
+    std::vector<unsigned long int> insideIDs;
+    std::set<unsigned long int> insideSet;
+
+    syncIDs.clear();
+    if (!enabled)
+        return 0;
+
+    for (iter = spans.begin(); iter != spans.end(); ++iter)
+        spanIndex.Add(iter->second.start, iter->second.end, iter->first);
+    spanIndex.Build();
+
+    // Far fewer events fall within the window than outside it for anyone
+    // with years of history, so I search for the ones inside and take the
+    // rest.
+    spanIndex.Find(windowStart, windowEnd, insideIDs);
+    insideSet.insert(insideIDs.begin(), insideIDs.end());
+
+    for (iter = spans.begin(); iter != spans.end(); ++iter) {
+        if (insideSet.find(iter->first) == insideSet.end())
+            syncIDs.insert(syncIDs.end(), iter->first);
+    }
+
+    return (unsigned long int)syncIDs.size();
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file CalendarWindowType.hh
+ * @brief A specifications file for the calendar sync window.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class existing to limit a Calendar sync to
+ * the events falling within a window of time around the present.
+ */
+
+#ifndef CALENDARWINDOWTYPE_H
+#define CALENDARWINDOWTYPE_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include <map>
+#include <set>
+#include <string>
+
+#include <zdata_lib/CalendarItemType.hh>
+
+/**
+ * @class CalendarWindowType
+ * @brief A type representing the window of a Calendar sync.
+ *
+ * The CalendarWindowType is a class which represents the window of time a
+ * Calendar sync is limited to. Events whose span, including every
+ * occurrence of a repeating event, does not overlap the window are left out
+ * of the sync. It also keeps the spans of the events last seen on a Zaurus,
+ * saved from one sync to the next, so that during a full sync the events
+ * known to lie outside the window are not even fetched from the Zaurus. Those
+ * spans are searched through an IntervalIndexType.
+ */
+class CalendarWindowType {
+public:
+    CalendarWindowType(void);
+
+    void SetWindow(time_t start, time_t end);
+    bool IsEnabled(void) const;
+    bool Contains(const CalendarItemType &item) const;
+
+    int Load(const std::string &spansPath, uint64_t device);
+    int Save(const std::string &spansPath, uint64_t device) const;
+
+    void Record(const CalendarItemType &item);
+    void Forget(const SyncIDListType &syncIDList);
+    void RetainOnly(const std::set<unsigned long int> &syncIDs);
+    unsigned long int GetOutsideSyncIDs(
+        std::set<unsigned long int> &syncIDs) const;
+
+private:
+    struct sSpan {
+        time_t start;
+        time_t end;
+    };
+
+    time_t windowStart;
+    time_t windowEnd;
+    bool enabled;
+
+    // The spans of the events on the Zaurus, keyed by sync ID.
+    std::map<unsigned long int, struct sSpan> spans;
+};
+
+#endif
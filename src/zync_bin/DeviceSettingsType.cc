@@ -0,0 +1,471 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file DeviceSettingsType.cc
+ * @brief An implementation file for the settings of a device.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for a class existing to hold the settings a sync
+ * with a particular Zaurus uses, resolved from its profiles in the config.
+ */
+
+#include "DeviceSettingsType.hh"
+
+#include <limits.h>
+
+// The options naming the plugin of each type of synchronization.
+static const char *pluginPathKeys[] = {
+    "todo_plugin_path",
+    "cal_plugin_path",
+    "addr_plugin_path"
+};
+
+/**
+ * Construct a default DeviceSettingsType object.
+ *
+ * Construct a default DeviceSettingsType object, holding the settings used
+ * when the config sets none of them.
+ */
+DeviceSettingsType::DeviceSettingsType(void) {
+    hostPlugin = false;
+    pluginTimeout = 0;
+    confWinner = 0;
+    hasPasscode = false;
+    useSnapshot = false;
+    windowPast = -1;
+    windowFuture = -1;
+    socketTimeout = 0;
+    socketBuffer = 0;
+    noDelay = false;
+    journalMaxAge = JOURNAL_MAX_AGE;
+    statsFormat = STATS_FORMAT_JSON;
+    usesAddress = false;
+    usesModel = false;
+}
+
+/**
+ * Resolve the settings.
+ *
+ * Resolve the settings of a sync with the Zaurus of the given address and
+ * model from the config, taking each from the most specific profile setting
+ * it.
+ * @param confManager Reference to the config manager to resolve from.
+ * @param address The address the Zaurus connected from.
+ * @param model The model the Zaurus reported.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully resolved the settings.
+ * @retval 1 Failed, conflict_winner is not set or is not one of zaurus,
+ * desktop or both.
+ * @retval 2 Failed, an option has an invalid value, see GetBadOption().
+ */
+int DeviceSettingsType::Resolve(const ConfigManagerType &confManager,
+                                const std::string &address,
+                                const std::string &model) {
+    std::string title;
+    std::string value;
+    long int count;
+    bool flag;
+    unsigned int i;
+
+    addressSection = "address " + address + ":";
+    usesAddress = false;
+    usesModel = false;
+    modelSection = "model " + model + ":";
+
+    // The statistics are resolved first, so that a sync failing on any of
+    // the other settings still has them written. They are written as JSON
+    // unless stats_format asks for the Prometheus text format.
+    if (Find(confManager, "stats_file", title) == 0) {
+        if (confManager.GetPath(title.c_str(), statsPath) != 0) {
+            badOption = "stats_file";
+            return 2;
+        }
+    }
+
+    if ((Find(confManager, "stats_format", title) == 0) &&
+        (confManager.GetValue(title.c_str(), value) == 0)) {
+        if (value == "json") {
+            statsFormat = STATS_FORMAT_JSON;
+        } else if (value == "prometheus") {
+            statsFormat = STATS_FORMAT_PROMETHEUS;
+        } else {
+            badOption = "stats_format";
+            return 2;
+        }
+    }
+
+    // The plugins need only be set for the types of synchronization which
+    // are performed, so a missing one is left for the sync to report.
+    for (i = 0; i < sizeof(pluginPathKeys) / sizeof(pluginPathKeys[0]);
+         i++) {
+        if (Find(confManager, pluginPathKeys[i], title) != 0)
+            continue;
+        if (confManager.GetPath(title.c_str(), value) != 0) {
+            badOption = pluginPathKeys[i];
+            return 2;
+        }
+        pluginPaths[pluginPathKeys[i]] = value;
+    }
+
+    if ((Find(confManager, "plugin_host", title) == 0) &&
+        (confManager.GetValue(title.c_str(), value) == 0))
+        hostPlugin = (value == "process");
+
+    if (FindCount(confManager, "plugin_timeout", count) == -2)
+        return 2;
+    if ((count >= 0) && (count <= (long int)UINT_MAX))
+        pluginTimeout = (unsigned int)count;
+
+    if ((Find(confManager, "conflict_winner", title) != 0) ||
+        (confManager.GetValue(title.c_str(), value) != 0)) {
+        badOption = "conflict_winner";
+        return 1;
+    }
+    if (value == "zaurus") {
+        confWinner = CONF_WIN_Z;
+    } else if (value == "desktop") {
+        confWinner = CONF_WIN_D;
+    } else if (value == "both") {
+        confWinner = CONF_WIN_B;
+    } else {
+        badOption = "conflict_winner";
+        return 1;
+    }
+
+    if ((Find(confManager, "passcode", title) == 0) &&
+        (confManager.GetValue(title.c_str(), passcode) == 0))
+        hasPasscode = true;
+
+    if ((Find(confManager, "change_detection", title) == 0) &&
+        (confManager.GetValue(title.c_str(), value) == 0))
+        useSnapshot = (value == "snapshot");
+
+    if ((FindCount(confManager, "cal_window_past", windowPast) == -2) ||
+        (FindCount(confManager, "cal_window_future", windowFuture) == -2))
+        return 2;
+
+    if (FindCount(confManager, "socket_timeout", count) == -2)
+        return 2;
+    if ((count >= 0) && (count <= (long int)UINT_MAX))
+        socketTimeout = (unsigned int)count;
+
+    if (FindCount(confManager, "socket_buffer", count) == -2)
+        return 2;
+    if ((count >= 0) && (count <= (long int)INT_MAX))
+        socketBuffer = (int)count;
+
+    if (Find(confManager, "tcp_nodelay", title) == 0) {
+        if (confManager.GetBool(title.c_str(), flag) != 0) {
+            badOption = "tcp_nodelay";
+            return 2;
+        }
+        noDelay = flag;
+    }
+
+    if (FindCount(confManager, "journal_max_age", count) == -2)
+        return 2;
+    if ((count >= 0) && (count <= (long int)UINT_MAX))
+        journalMaxAge = (unsigned int)count;
+
+    // I note the sections which set any of the settings as the profiles in
+    // use, without the colon separating them from the options.
+    profiles.clear();
+    if (usesAddress)
+        profiles.assign(addressSection, 0, addressSection.size() - 1);
+    if (usesModel) {
+        if (!profiles.empty())
+            profiles += ", ";
+        profiles.append(modelSection, 0, modelSection.size() - 1);
+    }
+
+    return 0;
+}
+
+/**
+ * Get the profiles.
+ *
+ * Get the sections of the config which set any of the settings, separated
+ * by commas, for showing which profiles a sync uses.
+ * @return The sections setting any of the settings, or an empty string if
+ * every setting belongs to no section.
+ */
+const std::string &DeviceSettingsType::GetProfiles(void) const {
+    return profiles;
+}
+
+/**
+ * Get the bad option.
+ *
+ * Get the option whose value was not valid when resolving failed.
+ * @return The name of the option.
+ */
+const std::string &DeviceSettingsType::GetBadOption(void) const {
+    return badOption;
+}
+
+/**
+ * Get the path of a plugin.
+ *
+ * Get the path of the plugin named by the given option, with a leading ~
+ * replaced by the home directory of the user.
+ * @param pKey The option naming the plugin, such as todo_plugin_path.
+ * @param path Reference to store the path in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully got the path.
+ * @retval 1 The option is not set.
+ */
+int DeviceSettingsType::GetPluginPath(const char *pKey,
+                                      std::string &path) const {
+    std::map<std::string, std::string>::const_iterator iter;
+
+    iter = pluginPaths.find(pKey);
+    if (iter == pluginPaths.end())
+        return 1;
+
+    path = iter->second;
+    return 0;
+}
+
+/**
+ * Determine if the plugin is hosted.
+ *
+ * Determine if the plugin runs in a host process of its own, which it does
+ * with plugin_host set to process.
+ * @return A boolean value representing true (yes) or false (no).
+ */
+bool DeviceSettingsType::IsPluginHosted(void) const {
+    return hostPlugin;
+}
+
+/**
+ * Get the plugin timeout.
+ *
+ * Get the number of seconds a hosted plugin may take to answer before it
+ * is killed.
+ * @return The plugin timeout in seconds, zero for none.
+ */
+unsigned int DeviceSettingsType::GetPluginTimeout(void) const {
+    return pluginTimeout;
+}
+
+/**
+ * Get the conflict winner.
+ *
+ * Get the side which wins conflicting modifications.
+ * @return One of CONF_WIN_Z, CONF_WIN_D or CONF_WIN_B.
+ */
+unsigned short int DeviceSettingsType::GetConflictWinner(void) const {
+    return confWinner;
+}
+
+/**
+ * Determine if there is a passcode.
+ *
+ * Determine if a passcode is set to authenticate with.
+ * @return A boolean value representing true (yes) or false (no).
+ */
+bool DeviceSettingsType::HasPasscode(void) const {
+    return hasPasscode;
+}
+
+/**
+ * Get the passcode.
+ *
+ * Get the passcode to authenticate with, only valid if HasPasscode().
+ * @return The passcode.
+ */
+const std::string &DeviceSettingsType::GetPasscode(void) const {
+    return passcode;
+}
+
+/**
+ * Determine if a snapshot is used.
+ *
+ * Determine if the changes to the plugin items are found by comparing them
+ * to a snapshot, which they are with change_detection set to snapshot.
+ * @return A boolean value representing true (yes) or false (no).
+ */
+bool DeviceSettingsType::UsesSnapshot(void) const {
+    return useSnapshot;
+}
+
+/**
+ * Determine if there is a sync window.
+ *
+ * Determine if a Calendar sync is limited to a window of time, which it is
+ * when either cal_window_past or cal_window_future is set.
+ * @return A boolean value representing true (yes) or false (no).
+ */
+bool DeviceSettingsType::HasSyncWindow(void) const {
+    return ((windowPast >= 0) || (windowFuture >= 0));
+}
+
+/**
+ * Get the days before the present.
+ *
+ * Get the number of days before the present the sync window starts.
+ * @return The number of days, negative if the window has no start.
+ */
+long int DeviceSettingsType::GetWindowPast(void) const {
+    return windowPast;
+}
+
+/**
+ * Get the days after the present.
+ *
+ * Get the number of days after the present the sync window ends.
+ * @return The number of days, negative if the window has no end.
+ */
+long int DeviceSettingsType::GetWindowFuture(void) const {
+    return windowFuture;
+}
+
+/**
+ * Get the socket timeout.
+ *
+ * Get the number of seconds a send or receive on the connection may wait.
+ * @return The socket timeout in seconds, zero for none.
+ */
+unsigned int DeviceSettingsType::GetSocketTimeout(void) const {
+    return socketTimeout;
+}
+
+/**
+ * Get the socket buffer size.
+ *
+ * Get the size of the send and receive buffers of the connection.
+ * @return The buffer size in bytes, zero to keep the default.
+ */
+int DeviceSettingsType::GetSocketBuffer(void) const {
+    return socketBuffer;
+}
+
+/**
+ * Determine if Nagle's algorithm is disabled.
+ *
+ * Determine if Nagle's algorithm is disabled on the connection, which it
+ * is with tcp_nodelay set.
+ * @return A boolean value representing true (yes) or false (no).
+ */
+bool DeviceSettingsType::GetNoDelay(void) const {
+    return noDelay;
+}
+
+/**
+ * Get the journal age.
+ *
+ * Get the number of seconds after it was interrupted that a sync may be
+ * resumed from its journal, as set by journal_max_age. An older journal is
+ * started over, since the items may have changed since it was written.
+ * @return The journal age in seconds, zero to never resume.
+ */
+unsigned int DeviceSettingsType::GetJournalMaxAge(void) const {
+    return journalMaxAge;
+}
+
+/**
+ * Get the statistics path.
+ *
+ * Get the path of the file the statistics of the sync are written to.
+ * @return The path of the statistics file, or an empty string if the
+ * statistics are not written.
+ */
+const std::string &DeviceSettingsType::GetStatsPath(void) const {
+    return statsPath;
+}
+
+/**
+ * Get the statistics format.
+ *
+ * Get the format the statistics of the sync are written in.
+ * @return Either STATS_FORMAT_JSON or STATS_FORMAT_PROMETHEUS.
+ */
+int DeviceSettingsType::GetStatsFormat(void) const {
+    return statsFormat;
+}
+
+/**
+ * Find an option.
+ *
+ * Find the most specific item of the config setting the given option, in
+ * the address section of the device, its model section or no section.
+ * @param confManager Reference to the config manager to search.
+ * @param pOption The name of the option.
+ * @param title Reference to store the title of the item found in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully found the option.
+ * @retval -1 The option is not set.
+ */
+int DeviceSettingsType::Find(const ConfigManagerType &confManager,
+                             const char *pOption, std::string &title) {
+    const std::string *pSection;
+    std::string value;
+    unsigned int i;
+
+    for (i = 0; i < 2; i++) {
+        pSection = (i == 0) ? &addressSection : &modelSection;
+        title = *pSection + pOption;
+        if (confManager.GetValue(title.c_str(), value) != 0)
+            continue;
+
+        if (i == 0)
+            usesAddress = true;
+        else
+            usesModel = true;
+        return 0;
+    }
+
+    title = pOption;
+    if (confManager.GetValue(title.c_str(), value) != 0)
+        return -1;
+
+    return 0;
+}
+
+/**
+ * Find a count option.
+ *
+ * Find the most specific item of the config setting the given option and
+ * parse its value as a count, a whole number which is not negative.
+ * @param confManager Reference to the config manager to search.
+ * @param pOption The name of the option.
+ * @param value Reference to store the count in, -1 if it is not set.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully found the option.
+ * @retval 1 The option is not set.
+ * @retval -2 The value of the option is not a count.
+ */
+int DeviceSettingsType::FindCount(const ConfigManagerType &confManager,
+                                  const char *pOption, long int &value) {
+    std::string title;
+
+    value = -1;
+    if (Find(confManager, pOption, title) != 0)
+        return 1;
+
+    if ((confManager.GetInt(title.c_str(), value) != 0) || (value < 0)) {
+        value = -1;
+        badOption = pOption;
+        return -2;
+    }
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file DeviceSettingsType.hh
+ * @brief A specifications file for the settings of a device.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class existing to hold the settings a sync
+ * with a particular Zaurus uses, resolved from its profiles in the config.
+ */
+
+#ifndef DEVICESETTINGSTYPE_H
+#define DEVICESETTINGSTYPE_H
+
+#include <map>
+#include <string>
+
+#include <ConfigManagerType.h>
+
+#include "SyncStatsType.hh"
+
+// Define the sides which may win a conflict.
+#define CONF_WIN_Z 1
+#define CONF_WIN_D 2
+#define CONF_WIN_B 3
+
+// The number of seconds an interrupted sync may be resumed for, unless
+// journal_max_age says otherwise.
+#define JOURNAL_MAX_AGE 3600
+
+/**
+ * @class DeviceSettingsType
+ * @brief A type holding the settings of a sync with a device.
+ *
+ * The DeviceSettingsType is a class which holds every setting a sync with a
+ * particular Zaurus uses: the plugins, the plugin host, the conflict
+ * winner, the passcode, the change detection, the Calendar sync window,
+ * the tuning of the socket, how long an interrupted sync may be resumed for
+ * and where the statistics of the sync go. They
+ * are resolved from the config once the Zaurus has connected and
+ * identified itself, and are not looked up in the config again for the
+ * rest of the sync.
+ *
+ * A setting is taken from the [address <address>] section of the config
+ * matching the address the Zaurus connected from, then the [model <model>]
+ * section matching the model it reported, and then from the items
+ * belonging to no section, the first one found being used. So a host
+ * serving many handhelds may give each its own plugins and policies while
+ * sharing the rest.
+ */
+class DeviceSettingsType {
+public:
+    DeviceSettingsType(void);
+
+    int Resolve(const ConfigManagerType &confManager,
+                const std::string &address, const std::string &model);
+
+    const std::string &GetProfiles(void) const;
+    const std::string &GetBadOption(void) const;
+
+    int GetPluginPath(const char *pKey, std::string &path) const;
+    bool IsPluginHosted(void) const;
+    unsigned int GetPluginTimeout(void) const;
+    unsigned short int GetConflictWinner(void) const;
+    bool HasPasscode(void) const;
+    const std::string &GetPasscode(void) const;
+    bool UsesSnapshot(void) const;
+    bool HasSyncWindow(void) const;
+    long int GetWindowPast(void) const;
+    long int GetWindowFuture(void) const;
+    unsigned int GetSocketTimeout(void) const;
+    int GetSocketBuffer(void) const;
+    bool GetNoDelay(void) const;
+    unsigned int GetJournalMaxAge(void) const;
+    const std::string &GetStatsPath(void) const;
+    int GetStatsFormat(void) const;
+
+private:
+    int Find(const ConfigManagerType &confManager, const char *pOption,
+             std::string &title);
+    int FindCount(const ConfigManagerType &confManager, const char *pOption,
+                  long int &value);
+
+    // The sections of the config for the device, and those of them which
+    // set any of the settings.
+    std::string addressSection;
+    std::string modelSection;
+    bool usesAddress;
+    bool usesModel;
+    std::string profiles;
+
+    // The option whose value was not valid, if resolving failed.
+    std::string badOption;
+
+    // The paths of the plugins, by the option naming them.
+    std::map<std::string, std::string> pluginPaths;
+    bool hostPlugin;
+    unsigned int pluginTimeout;
+
+    unsigned short int confWinner;
+    bool hasPasscode;
+    std::string passcode;
+    bool useSnapshot;
+
+    // The days of the Calendar sync window before and after the present,
+    // negative if not set.
+    long int windowPast;
+    long int windowFuture;
+
+    unsigned int socketTimeout;
+    int socketBuffer;
+    bool noDelay;
+    unsigned int journalMaxAge;
+
+    // The file the statistics are written to, empty for none, and their
+    // format.
+    std::string statsPath;
+    int statsFormat;
+};
+
+#endif
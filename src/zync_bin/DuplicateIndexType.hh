@@ -0,0 +1,165 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file DuplicateIndexType.hh
+ * @brief A specifications file for an index of possibly duplicate items.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class template existing to find the items in
+ * a list which duplicate an item from the other side of a sync, so that the
+ * two can be mapped to each other rather than each being added to the other
+ * side.
+ */
+
+#ifndef DUPLICATEINDEXTYPE_H
+#define DUPLICATEINDEXTYPE_H
+
+#include <stdint.h>
+
+#include <zdata_lib/ItemType.hh>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+/**
+ * @class DuplicateIndexType
+ * @brief An index of the items in a list which may be duplicates.
+ *
+ * The DuplicateIndexType is a class template which indexes the items of a
+ * list by their match key, which covers the fields naming an item such as
+ * its title and time. The candidates sharing the match key of an item are
+ * only taken as duplicates of it if their fingerprints, which cover the
+ * normalized content of the items, are the same as well. Hence, finding the
+ * duplicate of an item costs a single lookup rather than a pass over the
+ * whole list. The index refers to the items in place by their position, so
+ * the list may not be changed while the index is in use. Items taken out of
+ * the list are left behind empty until EraseTaken() removes them, which
+ * ends the use of the index.
+ */
+template <class ListType>
+class DuplicateIndexType {
+public:
+    typedef typename ListType::value_type ItemT;
+
+    DuplicateIndexType(ListType &itemList);
+
+    bool Take(const ItemT &item, ItemT &dupItem);
+    unsigned int GetCount(void) const;
+    void EraseTaken(void);
+
+private:
+    struct sCandidate {
+        uint64_t fingerprint;
+        typename ListType::size_type index;
+    };
+
+    typedef std::multimap<uint64_t, struct sCandidate> CandidateMapType;
+
+    ListType &items;
+    CandidateMapType candidates;
+    std::vector<bool> takenFlags;
+};
+
+/**
+ * Construct a DuplicateIndexType object.
+ *
+ * Construct a DuplicateIndexType object indexing every item currently in
+ * the given list.
+ * @param itemList Reference to the list of items to index.
+ */
+template <class ListType>
+DuplicateIndexType<ListType>::DuplicateIndexType(ListType &itemList)
+    : items(itemList), takenFlags(itemList.size(), false) {
+    struct sCandidate candidate;
+    typename ListType::size_type i;
+
+    for (i = 0; i < items.size(); i++) {
+        candidate.fingerprint = items[i].Fingerprint();
+        candidate.index = i;
+        candidates.insert(std::make_pair(items[i].MatchKey(), candidate));
+    }
+}
+
+/**
+ * Take the duplicate of an item.
+ *
+ * Find an indexed item which duplicates the given item. If one is found it
+ * is swapped out of the indexed list and removed from the index, so that
+ * each indexed item is only ever taken as the duplicate of one item.
+ * @param item Reference to the item to find the duplicate of.
+ * @param dupItem Reference to swap the duplicate item into.
+ * @return A boolean value representing if a duplicate was taken.
+ * @retval true A duplicate was found and copied into the passed item.
+ * @retval false No indexed item duplicates the passed item.
+ */
+template <class ListType>
+bool DuplicateIndexType<ListType>::Take(const ItemT &item, ItemT &dupItem) {
+    std::pair<typename CandidateMapType::iterator,
+        typename CandidateMapType::iterator> range;
+    typename CandidateMapType::iterator iter;
+    uint64_t fingerprint;
+
+    range = candidates.equal_range(item.MatchKey());
+    if (range.first == range.second)
+        return false;
+
+    // Items sharing the match key are only near duplicates, the content of
+    // the two has to match as well for them to be collapsed.
+    fingerprint = item.Fingerprint();
+    for (iter = range.first; iter != range.second; ++iter) {
+        if (iter->second.fingerprint == fingerprint) {
+            std::swap(dupItem, items[iter->second.index]);
+            takenFlags[iter->second.index] = true;
+            candidates.erase(iter);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Get the count.
+ *
+ * Get the number of indexed items which have not been taken.
+ * @return The number of items left in the index.
+ */
+template <class ListType>
+unsigned int DuplicateIndexType<ListType>::GetCount(void) const {
+    return (unsigned int)candidates.size();
+}
+
+/**
+ * Erase the taken items.
+ *
+ * Remove the items which have been taken from the indexed list. The
+ * positions of the items left change, so the index is emptied and may not
+ * be used again.
+ */
+template <class ListType>
+void DuplicateIndexType<ListType>::EraseTaken(void) {
+    EraseItems(items, takenFlags);
+    takenFlags.clear();
+    candidates.clear();
+}
+
+#endif
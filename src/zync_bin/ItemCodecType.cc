@@ -0,0 +1,569 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file ItemCodecType.cc
+ * @brief An implementation file for an object to serialize items.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for a class existing to serialize items into a
+ * compact binary form and back, so that they may be stored on disk.
+ */
+
+#include "ItemCodecType.hh"
+
+// The version of the serialized item format. This is stored at the front of
+// each serialized item so that old data is never misread.
+#define ITEM_CODEC_VERSION 0x01
+
+/**
+ * Construct a default ItemCodecType object.
+ *
+ * Construct an ItemCodecType object used to build serialized data.
+ */
+ItemCodecType::ItemCodecType(void) {
+    pos = 0;
+    pReadData = NULL;
+    readSize = 0;
+}
+
+/**
+ * Construct an ItemCodecType object.
+ *
+ * Construct an ItemCodecType object used to read the given serialized data.
+ * @param data The serialized data to read.
+ */
+ItemCodecType::ItemCodecType(const std::string &data) {
+    buff = data;
+    pos = 0;
+    pReadData = buff.data();
+    readSize = buff.size();
+}
+
+/**
+ * Construct an ItemCodecType object.
+ *
+ * Construct an ItemCodecType object used to read the serialized data in the
+ * given buffer in place. The buffer must outlive the object.
+ * @param pData Pointer to the serialized data to read.
+ * @param size The size of the serialized data in bytes.
+ */
+ItemCodecType::ItemCodecType(const char *pData, size_t size) {
+    pos = 0;
+    pReadData = pData;
+    readSize = (std::string::size_type)size;
+}
+
+/**
+ * Put an unsigned char.
+ *
+ * Append an unsigned char to the serialized data.
+ * @param value The value to append.
+ */
+void ItemCodecType::PutUChar(unsigned char value) {
+    PutBytes(value, 1);
+}
+
+/**
+ * Put an unsigned short int.
+ *
+ * Append an unsigned short int to the serialized data.
+ * @param value The value to append.
+ */
+void ItemCodecType::PutUShort(unsigned short int value) {
+    PutBytes(value, 2);
+}
+
+/**
+ * Put a 32 bit unsigned int.
+ *
+ * Append the low 32 bits of the given value to the serialized data.
+ * @param value The value to append.
+ */
+void ItemCodecType::PutUInt(unsigned long int value) {
+    PutBytes(value, 4);
+}
+
+/**
+ * Put an unsigned long int.
+ *
+ * Append an unsigned long int to the serialized data. It is always stored
+ * in 8 bytes so that the data is the same on 32 and 64 bit hosts.
+ * @param value The value to append.
+ */
+void ItemCodecType::PutULong(unsigned long int value) {
+    PutBytes(value, 8);
+}
+
+/**
+ * Put a time.
+ *
+ * Append a time, in seconds since Epoch, to the serialized data.
+ * @param value The value to append.
+ */
+void ItemCodecType::PutTime(time_t value) {
+    PutBytes((uint64_t)((int64_t)value), 8);
+}
+
+/**
+ * Put a string.
+ *
+ * Append a string to the serialized data as its length followed by its
+ * bytes.
+ * @param value The value to append.
+ */
+void ItemCodecType::PutString(const StringRefType &value) {
+    PutUInt(value.size());
+    buff.append(value.data(), value.size());
+}
+
+/**
+ * Get an unsigned char.
+ *
+ * Read the next unsigned char from the serialized data.
+ * @param value Reference to store the value read in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully read the value.
+ * @retval 1 Failed, the data ended before the value.
+ */
+int ItemCodecType::GetUChar(unsigned char &value) {
+    uint64_t tmp;
+
+    if (GetBytes(tmp, 1))
+        return 1;
+
+    value = (unsigned char)tmp;
+    return 0;
+}
+
+/**
+ * Get an unsigned short int.
+ *
+ * Read the next unsigned short int from the serialized data.
+ * @param value Reference to store the value read in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully read the value.
+ * @retval 1 Failed, the data ended before the value.
+ */
+int ItemCodecType::GetUShort(unsigned short int &value) {
+    uint64_t tmp;
+
+    if (GetBytes(tmp, 2))
+        return 1;
+
+    value = (unsigned short int)tmp;
+    return 0;
+}
+
+/**
+ * Get a 32 bit unsigned int.
+ *
+ * Read the next 32 bit unsigned int from the serialized data.
+ * @param value Reference to store the value read in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully read the value.
+ * @retval 1 Failed, the data ended before the value.
+ */
+int ItemCodecType::GetUInt(unsigned long int &value) {
+    uint64_t tmp;
+
+    if (GetBytes(tmp, 4))
+        return 1;
+
+    value = (unsigned long int)tmp;
+    return 0;
+}
+
+/**
+ * Get an unsigned long int.
+ *
+ * Read the next unsigned long int from the serialized data.
+ * @param value Reference to store the value read in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully read the value.
+ * @retval 1 Failed, the data ended before the value.
+ */
+int ItemCodecType::GetULong(unsigned long int &value) {
+    uint64_t tmp;
+
+    if (GetBytes(tmp, 8))
+        return 1;
+
+    value = (unsigned long int)tmp;
+    return 0;
+}
+
+/**
+ * Get a time.
+ *
+ * Read the next time, in seconds since Epoch, from the serialized data.
+ * @param value Reference to store the value read in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully read the value.
+ * @retval 1 Failed, the data ended before the value.
+ */
+int ItemCodecType::GetTime(time_t &value) {
+    uint64_t tmp;
+
+    if (GetBytes(tmp, 8))
+        return 1;
+
+    value = (time_t)((int64_t)tmp);
+    return 0;
+}
+
+/**
+ * Get a string.
+ *
+ * Read the next string from the serialized data.
+ * @param value Reference to store the value read in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully read the value.
+ * @retval 1 Failed, the data ended before the length of the string.
+ * @retval 2 Failed, the data ended before the end of the string.
+ */
+int ItemCodecType::GetString(std::string &value) {
+    uint64_t len;
+
+    if (GetBytes(len, 4))
+        return 1;
+
+    if (len > (readSize - pos))
+        return 2;
+
+    value.assign(pReadData + pos, (std::string::size_type)len);
+    pos += (std::string::size_type)len;
+
+    return 0;
+}
+
+/**
+ * Get the serialized data.
+ *
+ * Get the serialized data which has been built so far.
+ * @return A reference to the serialized data.
+ */
+const std::string &ItemCodecType::GetData(void) const {
+    return buff;
+}
+
+/**
+ * Check for the end of the data.
+ *
+ * Check if all of the serialized data has been read.
+ * @return True if all of the data has been read, false otherwise.
+ */
+bool ItemCodecType::AtEnd(void) const {
+    return (pos >= readSize);
+}
+
+/**
+ * Encode an item.
+ *
+ * Serialize all the data of the given item on its own.
+ * @param item The item to serialize.
+ * @param data Reference to store the serialized data in.
+ */
+template <class ItemT>
+void ItemCodecType::EncodeItem(const ItemT &item, std::string &data) {
+    ItemCodecType codec;
+
+    codec.PutItem(item);
+    data = codec.GetData();
+}
+
+/**
+ * Decode an item.
+ *
+ * Deserialize an item from data built by EncodeItem.
+ * @param data The serialized data to read.
+ * @param item Reference to the item to store the data in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully decoded the item.
+ * @retval 1 Failed, the data is not a complete serialized item.
+ */
+template <class ItemT>
+int ItemCodecType::DecodeItem(const std::string &data, ItemT &item) {
+    ItemCodecType codec(data.data(), data.size());
+
+    return codec.GetItem(item);
+}
+
+/**
+ * Put an item.
+ *
+ * Append all the data of the given item to the serialized data, so that
+ * several items may be serialized one after the other. After the data
+ * common to all items, each field of the content is stored in the order of
+ * the field descriptors of its type.
+ * @param item The item to append.
+ */
+template <class ItemT>
+void ItemCodecType::PutItem(const ItemT &item) {
+    unsigned int i;
+
+    EncodeItemBase(item);
+    for (i = 0; i < ItemT::numFieldDescs; i++) {
+        const FieldDescType<ItemT> &desc = ItemT::fieldDescs[i];
+
+        if (!(desc.flags & FIELD_CONTENT) || (desc.flags & FIELD_BASE))
+            continue;
+
+        if (desc.pGetNumber)
+            PutNumber(desc.typeID, desc.pGetNumber(item));
+        else
+            PutString(desc.pGetString(item));
+    }
+}
+
+/**
+ * Get an item.
+ *
+ * Read the next item from the serialized data, as appended by PutItem.
+ * @param item Reference to the item to store the data in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully read the item.
+ * @retval 1 Failed, the data is not a complete serialized item.
+ */
+template <class ItemT>
+int ItemCodecType::GetItem(ItemT &item) {
+    std::string strVal;
+    uint64_t numVal;
+    unsigned int i;
+
+    if (DecodeItemBase(item))
+        return 1;
+
+    for (i = 0; i < ItemT::numFieldDescs; i++) {
+        const FieldDescType<ItemT> &desc = ItemT::fieldDescs[i];
+
+        if (!(desc.flags & FIELD_CONTENT) || (desc.flags & FIELD_BASE))
+            continue;
+
+        if (desc.pSetNumber) {
+            if (GetNumber(desc.typeID, numVal))
+                return 1;
+            desc.pSetNumber(item, numVal);
+        } else {
+            if (GetString(strVal))
+                return 1;
+            desc.pSetString(item, strVal);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Put a number.
+ *
+ * Append a number field to the serialized data, in the width used for the
+ * given Zaurus parameter type.
+ * @param typeID The type identifier of the parameter the field is stored in.
+ * @param value The value to append.
+ */
+void ItemCodecType::PutNumber(unsigned char typeID, uint64_t value) {
+    switch (typeID) {
+        case DATA_ID_WORD:
+            PutUShort((unsigned short int)value);
+            break;
+
+        case DATA_ID_TIME:
+            PutTime((time_t)value);
+            break;
+
+        case DATA_ID_ULONG:
+            PutULong((unsigned long int)value);
+            break;
+
+        default:
+            PutUChar((unsigned char)value);
+            break;
+    }
+}
+
+/**
+ * Get a number.
+ *
+ * Read the next number field from the serialized data, in the width used
+ * for the given Zaurus parameter type.
+ * @param typeID The type identifier of the parameter the field is stored in.
+ * @param value Reference to store the value read in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully read the value.
+ * @retval 1 Failed, the data ended before the value.
+ */
+int ItemCodecType::GetNumber(unsigned char typeID, uint64_t &value) {
+    unsigned char ucharVal;
+    unsigned short int ushortVal;
+    unsigned long int ulongVal;
+    time_t timeVal;
+
+    switch (typeID) {
+        case DATA_ID_WORD:
+            if (GetUShort(ushortVal))
+                return 1;
+            value = ushortVal;
+            break;
+
+        case DATA_ID_TIME:
+            if (GetTime(timeVal))
+                return 1;
+            value = (uint64_t)timeVal;
+            break;
+
+        case DATA_ID_ULONG:
+            if (GetULong(ulongVal))
+                return 1;
+            value = ulongVal;
+            break;
+
+        default:
+            if (GetUChar(ucharVal))
+                return 1;
+            value = ucharVal;
+            break;
+    }
+
+    return 0;
+}
+
+/**
+ * Put bytes.
+ *
+ * Append the low order bytes of the given value to the serialized data,
+ * least significant byte first.
+ * @param value The value to append.
+ * @param numBytes The number of bytes of the value to append.
+ */
+void ItemCodecType::PutBytes(uint64_t value, unsigned int numBytes) {
+    unsigned int i;
+
+    for (i = 0; i < numBytes; i++) {
+        buff.push_back((char)(value & 0xff));
+        value = value >> 8;
+    }
+}
+
+/**
+ * Get bytes.
+ *
+ * Read a value stored in the given number of bytes, least significant byte
+ * first, from the serialized data.
+ * @param value Reference to store the value read in.
+ * @param numBytes The number of bytes the value is stored in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully read the value.
+ * @retval 1 Failed, the data ended before the value.
+ */
+int ItemCodecType::GetBytes(uint64_t &value, unsigned int numBytes) {
+    unsigned int i;
+
+    if (numBytes > (readSize - pos))
+        return 1;
+
+    value = 0;
+    for (i = 0; i < numBytes; i++) {
+        value = value |
+            (((uint64_t)((unsigned char)pReadData[pos + i])) << (8 * i));
+    }
+    pos += numBytes;
+
+    return 0;
+}
+
+/**
+ * Encode the base item data.
+ *
+ * Append the format version followed by the data every item has in common.
+ * @param item The item whose common data should be appended.
+ */
+void ItemCodecType::EncodeItemBase(const ItemType &item) {
+    PutUChar(ITEM_CODEC_VERSION);
+    PutUChar(item.GetAttribute());
+    PutTime(item.GetCreatedTime());
+    PutTime(item.GetModifiedTime());
+    PutULong(item.GetSyncID());
+    PutString(item.GetAppID());
+}
+
+/**
+ * Decode the base item data.
+ *
+ * Read the format version followed by the data every item has in common.
+ * @param item Reference to the item to store the common data in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully read the common data.
+ * @retval 1 Failed, the data is of an unknown format version.
+ * @retval 2 Failed, the data ended before the end of the common data.
+ */
+int ItemCodecType::DecodeItemBase(ItemType &item) {
+    unsigned char version;
+    unsigned char ucharVal;
+    time_t timeVal;
+    unsigned long int ulongVal;
+    std::string strVal;
+
+    if (GetUChar(version) || (version != ITEM_CODEC_VERSION))
+        return 1;
+
+    if (GetUChar(ucharVal))
+        return 2;
+    item.SetAttribute(ucharVal);
+
+    if (GetTime(timeVal))
+        return 2;
+    item.SetCreatedTime(timeVal);
+
+    if (GetTime(timeVal))
+        return 2;
+    item.SetModifiedTime(timeVal);
+
+    if (GetULong(ulongVal))
+        return 2;
+    item.SetSyncID(ulongVal);
+
+    if (GetString(strVal))
+        return 2;
+    item.SetAppID(strVal);
+
+    return 0;
+}
+
+// Items are serialized the same way no matter their type, hence the codec is
+// instantiated here for each of the types of items.
+template void ItemCodecType::EncodeItem(const TodoItemType &item,
+    std::string &data);
+template void ItemCodecType::EncodeItem(const CalendarItemType &item,
+    std::string &data);
+template void ItemCodecType::EncodeItem(const AddrBookItemType &item,
+    std::string &data);
+template int ItemCodecType::DecodeItem(const std::string &data,
+    TodoItemType &item);
+template int ItemCodecType::DecodeItem(const std::string &data,
+    CalendarItemType &item);
+template int ItemCodecType::DecodeItem(const std::string &data,
+    AddrBookItemType &item);
+template void ItemCodecType::PutItem(const TodoItemType &item);
+template void ItemCodecType::PutItem(const CalendarItemType &item);
+template void ItemCodecType::PutItem(const AddrBookItemType &item);
+template int ItemCodecType::GetItem(TodoItemType &item);
+template int ItemCodecType::GetItem(CalendarItemType &item);
+template int ItemCodecType::GetItem(AddrBookItemType &item);
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file ItemCodecType.hh
+ * @brief A specifications file for an object to serialize items.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class existing to serialize items into a
+ * compact binary form and back, so that they may be stored on disk.
+ */
+
+#ifndef ITEMCODECTYPE_H
+#define ITEMCODECTYPE_H
+
+#include <zdata_lib/TodoItemType.hh>
+#include <zdata_lib/CalendarItemType.hh>
+#include <zdata_lib/AddrBookItemType.hh>
+
+#include <stdint.h>
+#include <time.h>
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @class ItemCodecType
+ * @brief A type used to serialize items.
+ *
+ * The ItemCodecType is a class which serializes items into a compact binary
+ * form and back. All values are stored little endian with fixed widths, no
+ * matter the host, so the data may be read back on any machine. Strings are
+ * stored as a length followed by their bytes. An ItemCodecType is either
+ * used to build data with the Put member functions or to read data with the
+ * Get member functions, depending on how it was constructed. Data read from
+ * a buffer given by pointer is read in place rather than copied, the buffer
+ * just has to outlive the ItemCodecType.
+ */
+class ItemCodecType {
+public:
+    ItemCodecType(void);
+    ItemCodecType(const std::string &data);
+    ItemCodecType(const char *pData, size_t size);
+
+    void PutUChar(unsigned char value);
+    void PutUShort(unsigned short int value);
+    void PutUInt(unsigned long int value);
+    void PutULong(unsigned long int value);
+    void PutTime(time_t value);
+    void PutString(const StringRefType &value);
+
+    int GetUChar(unsigned char &value);
+    int GetUShort(unsigned short int &value);
+    int GetUInt(unsigned long int &value);
+    int GetULong(unsigned long int &value);
+    int GetTime(time_t &value);
+    int GetString(std::string &value);
+
+    const std::string &GetData(void) const;
+    bool AtEnd(void) const;
+
+    template <class ItemT>
+    void PutItem(const ItemT &item);
+    template <class ItemT>
+    int GetItem(ItemT &item);
+
+    template <class ItemT>
+    static void EncodeItem(const ItemT &item, std::string &data);
+    template <class ItemT>
+    static int DecodeItem(const std::string &data, ItemT &item);
+
+private:
+    void PutBytes(uint64_t value, unsigned int numBytes);
+    int GetBytes(uint64_t &value, unsigned int numBytes);
+    void PutNumber(unsigned char typeID, uint64_t value);
+    int GetNumber(unsigned char typeID, uint64_t &value);
+
+    void EncodeItemBase(const ItemType &item);
+    int DecodeItemBase(ItemType &item);
+
+    std::string buff;
+    std::string::size_type pos;
+
+    // The data read by the Get member functions, either the buffer above or
+    // one given by pointer.
+    const char *pReadData;
+    std::string::size_type readSize;
+};
+
+#endif
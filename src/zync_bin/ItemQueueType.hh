@@ -0,0 +1,234 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file ItemQueueType.hh
+ * @brief A specifications file for a bounded queue of items.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class template existing to hand items from one
+ * thread (the producer) to exactly one other thread (the consumer) through a
+ * fixed size ring buffer. It is used to stream items off of the Zaurus into
+ * a plugin while the items are still being fetched.
+ */
+
+#ifndef ITEMQUEUETYPE_H
+#define ITEMQUEUETYPE_H
+
+#include <sched.h>
+#include <time.h>
+
+#include <algorithm>
+
+/**
+ * @class ItemQueueType
+ * @brief A bounded single producer, single consumer queue of items.
+ *
+ * The ItemQueueType is a class template which represents a bounded queue
+ * shared between a single producer thread and a single consumer thread. The
+ * queue is a ring buffer whose read and write positions are each only ever
+ * written by one side, so no lock is needed to protect them. Memory barriers
+ * are used to publish a slot before the position that exposes it. When the
+ * queue is full the producer backs off, and when it is empty the consumer
+ * backs off, which bounds the memory used no matter how many items flow
+ * through it.
+ */
+template <class T>
+class ItemQueueType {
+public:
+    ItemQueueType(unsigned int minCapacity);
+    ~ItemQueueType(void);
+
+    void Push(T &item);
+    bool Pop(T &item);
+    void Close(void);
+
+    unsigned int GetCapacity(void) const;
+
+private:
+    // The queue owns its slots, so it may not be copied.
+    ItemQueueType(const ItemQueueType &);
+    ItemQueueType &operator=(const ItemQueueType &);
+
+    void Backoff(unsigned int &numWaits) const;
+
+    T *pSlots;
+    unsigned int capacity;
+    unsigned int mask;
+
+    // The position of the next slot to be read. Only the consumer writes it.
+    volatile unsigned int head;
+
+    // The position of the next slot to be written. Only the producer writes
+    // it.
+    volatile unsigned int tail;
+
+    // Set by the producer once it will not push any more items.
+    volatile int closed;
+};
+
+/**
+ * Construct an ItemQueueType object.
+ *
+ * Construct an ItemQueueType object able to hold at least the given number
+ * of items. The capacity is rounded up to a power of two so that positions
+ * can be mapped to slots with a mask.
+ * @param minCapacity The minimum number of items the queue should hold.
+ */
+template <class T>
+ItemQueueType<T>::ItemQueueType(unsigned int minCapacity) {
+    capacity = 1;
+    while (capacity < minCapacity)
+        capacity = capacity << 1;
+    mask = capacity - 1;
+
+    pSlots = new T[capacity];
+
+    head = 0;
+    tail = 0;
+    closed = 0;
+}
+
+/**
+ * Destruct the ItemQueueType object.
+ *
+ * Destruct the ItemQueueType object by deallocating the slots.
+ */
+template <class T>
+ItemQueueType<T>::~ItemQueueType(void) {
+    delete [] pSlots;
+}
+
+/**
+ * Push an item onto the queue.
+ *
+ * Push the given item onto the tail of the queue. The item is swapped into
+ * its slot rather than copied, so the given item is left holding whatever
+ * the slot held before. If the queue is full this blocks until the consumer
+ * has made room. This must only be called from the producer thread.
+ * @param item Reference to the item to push onto the queue.
+ */
+template <class T>
+void ItemQueueType<T>::Push(T &item) {
+    unsigned int numWaits = 0;
+
+    while ((tail - head) == capacity)
+        Backoff(numWaits);
+
+    std::swap(pSlots[tail & mask], item);
+
+    // Make sure the slot content is visible before the consumer is allowed
+    // to see the new tail.
+    __sync_synchronize();
+    tail = tail + 1;
+}
+
+/**
+ * Pop an item off of the queue.
+ *
+ * Pop the item at the head of the queue, swapping it into the given item
+ * rather than copying it. If the queue is empty this blocks until the
+ * producer pushes an item or closes the queue. This must only be called from
+ * the consumer thread.
+ * @param item Reference to the item to swap the popped item into.
+ * @return A boolean value representing if an item was popped.
+ * @retval true An item was popped into the passed item.
+ * @retval false The queue was closed and all items have been popped.
+ */
+template <class T>
+bool ItemQueueType<T>::Pop(T &item) {
+    unsigned int numWaits = 0;
+    unsigned int curTail;
+    int isClosed;
+
+    while (1) {
+        // The closed flag has to be read before the tail. The producer sets
+        // it after its last push, so if it is seen here the tail read below
+        // already includes every item.
+        isClosed = closed;
+        __sync_synchronize();
+        curTail = tail;
+
+        if (head != curTail) {
+            std::swap(item, pSlots[head & mask]);
+
+            // Make sure the slot has been read before the producer is
+            // allowed to overwrite it.
+            __sync_synchronize();
+            head = head + 1;
+            return true;
+        }
+
+        if (isClosed)
+            return false;
+
+        Backoff(numWaits);
+    }
+}
+
+/**
+ * Close the queue.
+ *
+ * Close the queue, stating that the producer will not push any more
+ * items. Once the consumer has popped the remaining items Pop() returns
+ * false. This must only be called from the producer thread.
+ */
+template <class T>
+void ItemQueueType<T>::Close(void) {
+    __sync_synchronize();
+    closed = 1;
+}
+
+/**
+ * Get the capacity.
+ *
+ * Get the maximum number of items the queue holds at one time.
+ * @return The capacity of the queue.
+ */
+template <class T>
+unsigned int ItemQueueType<T>::GetCapacity(void) const {
+    return capacity;
+}
+
+/**
+ * Back off while waiting on the other thread.
+ *
+ * Give up the processor while waiting on the other side of the queue. The
+ * first few waits only yield since the other side is usually about to make
+ * progress. After that it sleeps briefly so that a side waiting on the
+ * network does not spin.
+ * @param numWaits Reference to the number of times the caller has waited.
+ */
+template <class T>
+void ItemQueueType<T>::Backoff(unsigned int &numWaits) const {
+    struct timespec delay;
+
+    if (numWaits < 64) {
+        sched_yield();
+    } else {
+        delay.tv_sec = 0;
+        delay.tv_nsec = 200000;
+        nanosleep(&delay, NULL);
+    }
+
+    numWaits++;
+}
+
+#endif
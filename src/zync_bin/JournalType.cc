@@ -0,0 +1,771 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file JournalType.cc
+ * @brief An implementation file for an object representing a sync journal.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for a class existing to record the progress of a
+ * synchronization on disk, so that an interrupted synchronization may be
+ * resumed rather than started over.
+ */
+
+#include "JournalType.hh"
+#include "ItemCodecType.hh"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <string.h>
+
+#include <vector>
+
+// The magic bytes and version at the front of every journal file.
+#define JOURNAL_MAGIC "ZJNL"
+#define JOURNAL_MAGIC_SIZE 4
+#define JOURNAL_VERSION 0x02
+
+// Each record is a one byte type and a four byte payload length, followed by
+// the payload and a four byte check sum.
+#define JOURNAL_REC_HEAD_SIZE 5
+#define JOURNAL_REC_SUM_SIZE 4
+
+// The number of records which may be appended before the journal is
+// automatically flushed to disk.
+#define JOURNAL_CHECKPOINT_INTERVAL 64
+
+// The offset basis of the FNV-1a check sum used on each record.
+#define JOURNAL_SUM_SEED 2166136261UL
+
+/**
+ * Construct a default JournalType object.
+ *
+ * Construct a JournalType object which has no journal file open.
+ */
+JournalType::JournalType(void) {
+    fd = -1;
+    endOffset = 0;
+    resumed = false;
+    numUnsynced = 0;
+    pthread_mutex_init(&mutex, NULL);
+}
+
+/**
+ * Destruct the JournalType object.
+ *
+ * Destruct the JournalType object, closing the journal file if it is open.
+ * The journal file is kept so that the synchronization may be resumed.
+ */
+JournalType::~JournalType(void) {
+    Close();
+    pthread_mutex_destroy(&mutex);
+}
+
+/**
+ * Open the journal.
+ *
+ * Open the journal file at the given path, creating it if it does not
+ * exist. If the file holds the journal of an interrupted synchronization of
+ * the same type with the same device, its records are loaded so that the
+ * synchronization may be resumed. The journal of a different device is
+ * refused and left as it is. Otherwise, or if the last record was written
+ * longer ago than the given age, the file is started over.
+ * @param journalPath The path of the journal file.
+ * @param syncType The type of synchronization being performed.
+ * @param device The identity of the Zaurus being synchronized.
+ * @param maxAge The number of seconds an interrupted sync may be resumed
+ * for.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully opened the journal.
+ * @retval 1 Failed to open the journal file.
+ * @retval 2 Failed to write the header of a new journal.
+ * @retval 3 The journal file belongs to a different device.
+ */
+int JournalType::Open(const std::string &journalPath, unsigned char syncType,
+                      const std::string &device, unsigned int maxAge) {
+    struct stat fileStat;
+    bool expired;
+    int retval;
+
+    Close();
+
+    fd = open(journalPath.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0)
+        return 1;
+
+    path = journalPath;
+
+    // The items may have changed on either side since a journal left long
+    // ago was written, so its records are only trusted for a short while.
+    // Loading it may cut it short, so I note its age first.
+    expired = ((fstat(fd, &fileStat) != 0) ||
+               (time(NULL) - fileStat.st_mtime > (time_t)maxAge));
+
+    // If the journal does not belong to an interrupted synchronization of
+    // this kind I simply start it over, unless it is the journal of another
+    // device which could still be resumed with that device.
+    retval = Load(syncType, device);
+    if (retval == 4) {
+        Close();
+        return 3;
+    } else if ((retval != 0) || (resumed && expired)) {
+        Reset();
+        if ((ftruncate(fd, 0) != 0) ||
+            (WriteHeader(syncType, device) != 0)) {
+            Close();
+            return 2;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Determine if the journal is open.
+ *
+ * Determine if a journal file is currently open.
+ * @return A boolean value representing true (yes) or false (no).
+ */
+bool JournalType::IsOpen(void) const {
+    return (fd >= 0);
+}
+
+/**
+ * Determine if a synchronization is being resumed.
+ *
+ * Determine if the journal file held records from an interrupted
+ * synchronization when it was opened.
+ * @return A boolean value representing true (yes) or false (no).
+ */
+bool JournalType::IsResumed(void) const {
+    return resumed;
+}
+
+/**
+ * Checkpoint the journal.
+ *
+ * Flush all of the records appended so far to disk. Once this returns the
+ * recorded progress survives a crash.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully flushed the journal.
+ * @retval 1 Failed to flush the journal.
+ */
+int JournalType::Checkpoint(void) {
+    int retval = 0;
+
+    if (fd < 0)
+        return 0;
+
+    pthread_mutex_lock(&mutex);
+    if (numUnsynced > 0) {
+        if (fdatasync(fd) != 0)
+            retval = 1;
+        else
+            numUnsynced = 0;
+    }
+    pthread_mutex_unlock(&mutex);
+
+    return retval;
+}
+
+/**
+ * Finish the journal.
+ *
+ * Close and remove the journal file. This should be called once a
+ * synchronization has completed, since there is then nothing to resume.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully removed the journal.
+ * @retval 1 Failed to remove the journal file.
+ */
+int JournalType::Finish(void) {
+    std::string journalPath;
+
+    if (fd < 0)
+        return 0;
+
+    journalPath = path;
+    Close();
+
+    if (unlink(journalPath.c_str()) != 0)
+        return 1;
+
+    return 0;
+}
+
+/**
+ * Close the journal.
+ *
+ * Flush and close the journal file, keeping it on disk.
+ */
+void JournalType::Close(void) {
+    if (fd < 0)
+        return;
+
+    Checkpoint();
+    close(fd);
+    fd = -1;
+    Reset();
+}
+
+/**
+ * Record a fetched item.
+ *
+ * Record the serialized data of an item which has been fetched from the
+ * Zaurus.
+ * @param syncID The sync ID of the fetched item.
+ * @param itemData The serialized data of the fetched item.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully recorded the item.
+ * @retval 1 Failed to append the record.
+ */
+int JournalType::RecordFetched(unsigned long int syncID,
+                               const std::string &itemData) {
+    ItemCodecType codec;
+    off_t dataOffset;
+    int retval = 0;
+
+    if (fd < 0)
+        return 0;
+
+    codec.PutULong(syncID);
+
+    pthread_mutex_lock(&mutex);
+    dataOffset = endOffset + JOURNAL_REC_HEAD_SIZE + codec.GetData().size();
+    if (AppendRecord(JOURNAL_REC_FETCHED, codec.GetData() + itemData) != 0)
+        retval = 1;
+    else
+        fetched[syncID] = std::make_pair(dataOffset, itemData.size());
+    pthread_mutex_unlock(&mutex);
+
+    return retval;
+}
+
+/**
+ * Record an applied item.
+ *
+ * Record that the change to the item with the given sync ID has been
+ * applied to the plugin, along with the content hash of the item applied.
+ * @param syncID The sync ID of the applied item.
+ * @param hash The content hash of the applied item, zero for a deletion.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully recorded the item.
+ * @retval 1 Failed to append the record.
+ */
+int JournalType::RecordApplied(unsigned long int syncID, uint64_t hash) {
+    ItemCodecType codec;
+    int retval = 0;
+
+    if (fd < 0)
+        return 0;
+
+    codec.PutULong(syncID);
+    codec.PutUInt((unsigned long int)(hash >> 32));
+    codec.PutUInt((unsigned long int)(hash & 0xffffffff));
+
+    pthread_mutex_lock(&mutex);
+    if (AppendRecord(JOURNAL_REC_APPLIED, codec.GetData()) != 0)
+        retval = 1;
+    else
+        applied[syncID] = hash;
+    pthread_mutex_unlock(&mutex);
+
+    return retval;
+}
+
+/**
+ * Record a written item.
+ *
+ * Record that the item with the given sync ID has been modified or deleted
+ * on the Zaurus, along with the content hash of the item written.
+ * @param syncID The sync ID of the written item.
+ * @param hash The content hash of the written item, zero for a deletion.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully recorded the item.
+ * @retval 1 Failed to append the record.
+ */
+int JournalType::RecordWritten(unsigned long int syncID, uint64_t hash) {
+    ItemCodecType codec;
+    int retval = 0;
+
+    if (fd < 0)
+        return 0;
+
+    codec.PutULong(syncID);
+    codec.PutUInt((unsigned long int)(hash >> 32));
+    codec.PutUInt((unsigned long int)(hash & 0xffffffff));
+
+    pthread_mutex_lock(&mutex);
+    if (AppendRecord(JOURNAL_REC_WRITTEN, codec.GetData()) != 0)
+        retval = 1;
+    else
+        written[syncID] = hash;
+    pthread_mutex_unlock(&mutex);
+
+    return retval;
+}
+
+/**
+ * Record a mapped item.
+ *
+ * Record the sync ID the Zaurus assigned to an item added to it from the
+ * plugin. Since adding the item again would duplicate it, the record is
+ * flushed to disk right away.
+ * @param syncID The sync ID the Zaurus assigned to the item.
+ * @param appID The application ID of the item in the plugin.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully recorded the item.
+ * @retval 1 Failed to append the record.
+ * @retval 2 Failed to flush the record.
+ */
+int JournalType::RecordMapped(unsigned long int syncID,
+                              const std::string &appID) {
+    ItemCodecType codec;
+    int retval = 0;
+
+    if (fd < 0)
+        return 0;
+
+    codec.PutULong(syncID);
+
+    pthread_mutex_lock(&mutex);
+    if (AppendRecord(JOURNAL_REC_MAPPED, codec.GetData() + appID) != 0) {
+        retval = 1;
+    } else {
+        mapped[appID] = syncID;
+        mappedIDs.insert(syncID);
+    }
+    pthread_mutex_unlock(&mutex);
+
+    if ((retval == 0) && (Checkpoint() != 0))
+        retval = 2;
+
+    return retval;
+}
+
+/**
+ * Get a fetched item.
+ *
+ * Get the serialized data of an item which was recorded as fetched from the
+ * Zaurus.
+ * @param syncID The sync ID of the item to get.
+ * @param itemData Reference to store the serialized data of the item in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully got the item data.
+ * @retval 1 Failed, no item with the given sync ID was recorded.
+ * @retval 2 Failed to read the item data from the journal file.
+ */
+int JournalType::GetFetched(unsigned long int syncID, std::string &itemData) {
+    std::map<unsigned long int, std::pair<off_t, size_t> >::iterator iter;
+    std::vector<char> buff;
+    int retval = 0;
+
+    if (fd < 0)
+        return 1;
+
+    pthread_mutex_lock(&mutex);
+    iter = fetched.find(syncID);
+    if (iter == fetched.end()) {
+        retval = 1;
+    } else {
+        buff.resize((*iter).second.second + 1);
+        if (ReadAt((*iter).second.first, &buff[0], (*iter).second.second))
+            retval = 2;
+        else
+            itemData.assign(&buff[0], (*iter).second.second);
+    }
+    pthread_mutex_unlock(&mutex);
+
+    return retval;
+}
+
+/**
+ * Determine if an item was applied.
+ *
+ * Determine if the change to the item with the given sync ID was recorded
+ * as applied to the plugin. Only the very change recorded counts, so an
+ * item which changed again since is applied again.
+ * @param syncID The sync ID of the item.
+ * @param hash The content hash of the item, zero for a deletion.
+ * @return A boolean value representing true (yes) or false (no).
+ */
+bool JournalType::WasApplied(unsigned long int syncID, uint64_t hash) {
+    std::map<unsigned long int, uint64_t>::iterator iter;
+    bool found;
+
+    pthread_mutex_lock(&mutex);
+    iter = applied.find(syncID);
+    found = ((iter != applied.end()) && ((*iter).second == hash));
+    pthread_mutex_unlock(&mutex);
+
+    return found;
+}
+
+/**
+ * Determine if an item was written.
+ *
+ * Determine if the item with the given sync ID was recorded as modified or
+ * deleted on the Zaurus. Only the very item recorded counts, so an item
+ * which changed again since is written again.
+ * @param syncID The sync ID of the item.
+ * @param hash The content hash of the item, zero for a deletion.
+ * @return A boolean value representing true (yes) or false (no).
+ */
+bool JournalType::WasWritten(unsigned long int syncID, uint64_t hash) {
+    std::map<unsigned long int, uint64_t>::iterator iter;
+    bool found;
+
+    pthread_mutex_lock(&mutex);
+    iter = written.find(syncID);
+    found = ((iter != written.end()) && ((*iter).second == hash));
+    pthread_mutex_unlock(&mutex);
+
+    return found;
+}
+
+/**
+ * Get the sync ID mapped to an application ID.
+ *
+ * Get the sync ID the Zaurus assigned to the item with the given
+ * application ID, if the item was recorded as added to the Zaurus.
+ * @param appID The application ID of the item in the plugin.
+ * @param syncID Reference to store the sync ID in.
+ * @return A boolean value representing found (true) or not found (false).
+ */
+bool JournalType::GetMappedSyncID(const std::string &appID,
+                                  unsigned long int &syncID) {
+    std::map<std::string, unsigned long int>::iterator iter;
+    bool found = false;
+
+    pthread_mutex_lock(&mutex);
+    iter = mapped.find(appID);
+    if (iter != mapped.end()) {
+        syncID = (*iter).second;
+        found = true;
+    }
+    pthread_mutex_unlock(&mutex);
+
+    return found;
+}
+
+/**
+ * Determine if a sync ID was mapped.
+ *
+ * Determine if the item with the given sync ID was recorded as added to the
+ * Zaurus from the plugin. Such items already exist in the plugin.
+ * @param syncID The sync ID of the item.
+ * @return A boolean value representing true (yes) or false (no).
+ */
+bool JournalType::IsMappedSyncID(unsigned long int syncID) {
+    bool found;
+
+    pthread_mutex_lock(&mutex);
+    found = (mappedIDs.find(syncID) != mappedIDs.end());
+    pthread_mutex_unlock(&mutex);
+
+    return found;
+}
+
+/**
+ * Load the journal.
+ *
+ * Read the header and all the records of the journal file. Reading stops at
+ * the first incomplete or corrupt record, which is cut off of the file so
+ * that new records follow the last good one.
+ * @param syncType The type of synchronization being performed.
+ * @param device The identity of the Zaurus being synchronized.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully loaded the journal.
+ * @retval 1 Failed, the file has no valid header.
+ * @retval 2 Failed, the journal is of another type.
+ * @retval 3 Failed to cut off a corrupt record.
+ * @retval 4 Failed, the journal is of another device.
+ */
+int JournalType::Load(unsigned char syncType, const std::string &device) {
+    char headBuff[JOURNAL_MAGIC_SIZE + 4];
+    char recHead[JOURNAL_REC_HEAD_SIZE];
+    char sumBuff[JOURNAL_REC_SUM_SIZE];
+    std::vector<char> payloadBuff;
+    std::string headData;
+    std::string payload;
+    std::string fileDevice;
+    unsigned char fileVersion;
+    unsigned char fileSyncType;
+    unsigned char recType;
+    unsigned short int deviceLen;
+    unsigned long int payloadLen;
+    unsigned long int sum;
+    unsigned long int fileSum;
+    unsigned long int syncID;
+    unsigned long int hashHigh;
+    unsigned long int hashLow;
+    off_t offset;
+
+    Reset();
+
+    // Here I read and check the header. The device identity follows the
+    // fixed portion of the header.
+    if (ReadAt(0, headBuff, sizeof(headBuff)))
+        return 1;
+
+    if (memcmp(headBuff, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE) != 0)
+        return 1;
+
+    ItemCodecType headCodec(std::string(headBuff + JOURNAL_MAGIC_SIZE, 4));
+    headCodec.GetUChar(fileVersion);
+    headCodec.GetUChar(fileSyncType);
+    headCodec.GetUShort(deviceLen);
+
+    if ((fileVersion != JOURNAL_VERSION) || (fileSyncType != syncType))
+        return 2;
+
+    payloadBuff.resize(deviceLen + 1);
+    if (ReadAt(sizeof(headBuff), &payloadBuff[0], deviceLen))
+        return 1;
+    fileDevice.assign(&payloadBuff[0], deviceLen);
+    if (fileDevice != device)
+        return 4;
+
+    offset = sizeof(headBuff) + deviceLen;
+
+    // Here I read each of the records, checking each check sum, until I
+    // reach the end of the file or a record which is not whole.
+    while (1) {
+        if (ReadAt(offset, recHead, JOURNAL_REC_HEAD_SIZE))
+            break;
+
+        ItemCodecType lenCodec(std::string(recHead + 1, 4));
+        lenCodec.GetUInt(payloadLen);
+        recType = (unsigned char)recHead[0];
+
+        payloadBuff.resize(payloadLen + 1);
+        if (ReadAt(offset + JOURNAL_REC_HEAD_SIZE, &payloadBuff[0],
+                   payloadLen))
+            break;
+        if (ReadAt(offset + JOURNAL_REC_HEAD_SIZE + payloadLen, sumBuff,
+                   JOURNAL_REC_SUM_SIZE))
+            break;
+
+        sum = CheckSum(recHead, JOURNAL_REC_HEAD_SIZE, JOURNAL_SUM_SEED);
+        sum = CheckSum(&payloadBuff[0], payloadLen, sum);
+        ItemCodecType sumCodec(std::string(sumBuff, JOURNAL_REC_SUM_SIZE));
+        sumCodec.GetUInt(fileSum);
+        if (sum != fileSum)
+            break;
+
+        payload.assign(&payloadBuff[0], payloadLen);
+        ItemCodecType recCodec(payload);
+        if (recCodec.GetULong(syncID))
+            break;
+
+        // The applied and written records carry the content hash of the
+        // item after its sync ID.
+        if (((recType == JOURNAL_REC_APPLIED) ||
+             (recType == JOURNAL_REC_WRITTEN)) &&
+            (recCodec.GetUInt(hashHigh) || recCodec.GetUInt(hashLow)))
+            break;
+
+        if (recType == JOURNAL_REC_FETCHED) {
+            fetched[syncID] = std::make_pair(offset + JOURNAL_REC_HEAD_SIZE +
+                8, payloadLen - 8);
+        } else if (recType == JOURNAL_REC_APPLIED) {
+            applied[syncID] = ((uint64_t)hashHigh << 32) | hashLow;
+        } else if (recType == JOURNAL_REC_WRITTEN) {
+            written[syncID] = ((uint64_t)hashHigh << 32) | hashLow;
+        } else if (recType == JOURNAL_REC_MAPPED) {
+            mapped[payload.substr(8)] = syncID;
+            mappedIDs.insert(syncID);
+        }
+
+        resumed = true;
+        offset = offset + JOURNAL_REC_HEAD_SIZE + payloadLen +
+            JOURNAL_REC_SUM_SIZE;
+    }
+
+    // Anything after the last whole record was torn by a crash, so I cut it
+    // off of the file.
+    if (ftruncate(fd, offset) != 0)
+        return 3;
+
+    endOffset = offset;
+
+    return 0;
+}
+
+/**
+ * Write the header.
+ *
+ * Write the header of a new journal file.
+ * @param syncType The type of synchronization being performed.
+ * @param device The identity of the Zaurus being synchronized.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully wrote the header.
+ * @retval 1 Failed to write the header.
+ */
+int JournalType::WriteHeader(unsigned char syncType,
+                             const std::string &device) {
+    ItemCodecType codec;
+    std::string header;
+    ssize_t numWritten;
+
+    codec.PutUChar(JOURNAL_VERSION);
+    codec.PutUChar(syncType);
+    codec.PutUShort(device.size());
+
+    header = std::string(JOURNAL_MAGIC) + codec.GetData() + device;
+
+    numWritten = pwrite(fd, header.data(), header.size(), 0);
+    if ((numWritten < 0) || ((size_t)numWritten != header.size()))
+        return 1;
+
+    if (fdatasync(fd) != 0)
+        return 1;
+
+    endOffset = header.size();
+
+    return 0;
+}
+
+/**
+ * Append a record.
+ *
+ * Append a record to the end of the journal file. The caller must hold the
+ * mutex.
+ * @param recType The type of the record.
+ * @param payload The payload of the record.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully appended the record.
+ * @retval 1 Failed to write the record.
+ */
+int JournalType::AppendRecord(unsigned char recType,
+                              const std::string &payload) {
+    ItemCodecType lenCodec;
+    ItemCodecType sumCodec;
+    std::string record;
+    unsigned long int sum;
+    size_t numDone = 0;
+    ssize_t numWritten;
+
+    // Here I build the whole record in memory so that it is written with as
+    // few system calls as possible.
+    lenCodec.PutUChar(recType);
+    lenCodec.PutUInt(payload.size());
+    record = lenCodec.GetData();
+
+    sum = CheckSum(record.data(), record.size(), JOURNAL_SUM_SEED);
+    sum = CheckSum(payload.data(), payload.size(), sum);
+    sumCodec.PutUInt(sum);
+
+    record.append(payload);
+    record.append(sumCodec.GetData());
+
+    while (numDone < record.size()) {
+        numWritten = pwrite(fd, record.data() + numDone,
+                            record.size() - numDone, endOffset + numDone);
+        if (numWritten < 0) {
+            if (errno == EINTR)
+                continue;
+            return 1;
+        }
+        numDone += numWritten;
+    }
+
+    endOffset += record.size();
+    numUnsynced++;
+
+    if (numUnsynced >= JOURNAL_CHECKPOINT_INTERVAL) {
+        if (fdatasync(fd) == 0)
+            numUnsynced = 0;
+    }
+
+    return 0;
+}
+
+/**
+ * Read from the journal file.
+ *
+ * Read exactly the given number of bytes from the journal file at the given
+ * offset.
+ * @param offset The offset in the file to read from.
+ * @param pBuff Pointer to the buffer to read into.
+ * @param len The number of bytes to read.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully read the data.
+ * @retval 1 Failed, the file ended or could not be read.
+ */
+int JournalType::ReadAt(off_t offset, char *pBuff, size_t len) {
+    size_t numDone = 0;
+    ssize_t numRead;
+
+    while (numDone < len) {
+        numRead = pread(fd, pBuff + numDone, len - numDone, offset + numDone);
+        if (numRead < 0) {
+            if (errno == EINTR)
+                continue;
+            return 1;
+        }
+        if (numRead == 0)
+            return 1;
+        numDone += numRead;
+    }
+
+    return 0;
+}
+
+/**
+ * Reset the loaded records.
+ *
+ * Forget all of the records which have been loaded or appended.
+ */
+void JournalType::Reset(void) {
+    fetched.clear();
+    applied.clear();
+    written.clear();
+    mapped.clear();
+    mappedIDs.clear();
+    resumed = false;
+    numUnsynced = 0;
+    endOffset = 0;
+}
+
+/**
+ * Calculate a check sum.
+ *
+ * Calculate the 32 bit FNV-1a check sum of the given data, continuing from
+ * the given check sum. Pass JOURNAL_SUM_SEED as the sum to start a new check
+ * sum.
+ * @param pData Pointer to the data to sum.
+ * @param len The length of the data in bytes.
+ * @param sum The check sum to continue from.
+ * @return The check sum.
+ */
+unsigned long int JournalType::CheckSum(const char *pData, size_t len,
+                                        unsigned long int sum) {
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        sum = sum ^ (unsigned char)pData[i];
+        sum = (sum * 16777619UL) & 0xffffffffUL;
+    }
+
+    return sum;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file JournalType.hh
+ * @brief A specifications file for an object representing a sync journal.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class existing to record the progress of a
+ * synchronization on disk, so that an interrupted synchronization may be
+ * resumed rather than started over.
+ */
+
+#ifndef JOURNALTYPE_H
+#define JOURNALTYPE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <pthread.h>
+
+#include <map>
+#include <set>
+#include <string>
+
+// Define all the different journal record types.
+#define JOURNAL_REC_FETCHED 0x01
+#define JOURNAL_REC_APPLIED 0x02
+#define JOURNAL_REC_WRITTEN 0x03
+#define JOURNAL_REC_MAPPED 0x04
+
+/**
+ * @class JournalType
+ * @brief A type representing a synchronization journal.
+ *
+ * The JournalType is a class which represents an append only journal of the
+ * progress of a synchronization. It records the items fetched from the
+ * Zaurus, the items applied to the plugin, the items written to the Zaurus
+ * and the sync IDs the Zaurus assigned to items added to it. Each record is
+ * check summed so a record torn by a crash is detected and dropped, along
+ * with anything after it. If a synchronization is interrupted, the next
+ * synchronization of the same type with the same device opens the journal
+ * and uses it to skip the work which has already been done, as long as it
+ * was interrupted recently. Once a synchronization completes its journal is
+ * removed.
+ */
+class JournalType {
+public:
+    JournalType(void);
+    ~JournalType(void);
+
+    int Open(const std::string &journalPath, unsigned char syncType,
+        const std::string &device, unsigned int maxAge);
+    bool IsOpen(void) const;
+    bool IsResumed(void) const;
+    int Checkpoint(void);
+    int Finish(void);
+    void Close(void);
+
+    int RecordFetched(unsigned long int syncID, const std::string &itemData);
+    int RecordApplied(unsigned long int syncID, uint64_t hash);
+    int RecordWritten(unsigned long int syncID, uint64_t hash);
+    int RecordMapped(unsigned long int syncID, const std::string &appID);
+
+    int GetFetched(unsigned long int syncID, std::string &itemData);
+    bool WasApplied(unsigned long int syncID, uint64_t hash);
+    bool WasWritten(unsigned long int syncID, uint64_t hash);
+    bool GetMappedSyncID(const std::string &appID, unsigned long int &syncID);
+    bool IsMappedSyncID(unsigned long int syncID);
+
+private:
+    // The journal owns its file descriptor, so it may not be copied.
+    JournalType(const JournalType &);
+    JournalType &operator=(const JournalType &);
+
+    int Load(unsigned char syncType, const std::string &device);
+    int WriteHeader(unsigned char syncType, const std::string &device);
+    int AppendRecord(unsigned char recType, const std::string &payload);
+    int ReadAt(off_t offset, char *pBuff, size_t len);
+    void Reset(void);
+
+    static unsigned long int CheckSum(const char *pData, size_t len,
+        unsigned long int sum);
+
+    int fd;
+    std::string path;
+    off_t endOffset;
+    bool resumed;
+    unsigned int numUnsynced;
+
+    // This map holds the location and length, in the journal file, of the
+    // serialized data of each fetched item keyed by its sync ID. The item
+    // data is read back from the file when needed, so it is never all held
+    // in memory at once.
+    std::map<unsigned long int, std::pair<off_t, size_t> > fetched;
+
+    // These maps hold the content hash of each item applied to the plugin
+    // and written to the Zaurus, keyed by its sync ID.
+    std::map<unsigned long int, uint64_t> applied;
+    std::map<unsigned long int, uint64_t> written;
+    std::map<std::string, unsigned long int> mapped;
+    std::set<unsigned long int> mappedIDs;
+
+    // This mutex protects all of the above, since items are recorded from
+    // the thread fetching them while others are recorded from the main
+    // thread.
+    pthread_mutex_t mutex;
+};
+
+#endif
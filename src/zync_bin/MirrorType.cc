@@ -0,0 +1,500 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file MirrorType.cc
+ * @brief An implementation file for an object mirroring a devices items.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for a class existing to keep a persistent record of
+ * the items known to be on a Zaurus, so that a full synchronization does not
+ * have to transfer every item again.
+ */
+
+#include "MirrorType.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <utility>
+#include <vector>
+
+// The magic bytes and version at the front of every mirror file.
+#define MIRROR_MAGIC "ZMIR"
+#define MIRROR_MAGIC_SIZE 4
+#define MIRROR_VERSION 0x02
+
+// The size reserved for the header at the front of the mirror file, the
+// entries of the table follow it.
+#define MIRROR_HEADER_SIZE 32
+
+// The number of entries in the table of a new mirror. This must be a power of
+// two.
+#define MIRROR_INITIAL_CAPACITY 1024
+
+// The states an entry in the table may be in.
+#define MIRROR_ENTRY_EMPTY 0x00
+#define MIRROR_ENTRY_USED 0x01
+#define MIRROR_ENTRY_DELETED 0x02
+
+// The layout of the header of the mirror file. The mirror is a cache local to
+// this machine so it is simply stored in host byte order. The device key
+// identifies the Zaurus whose items are mirrored.
+struct sMirrorHeader {
+    char magic[MIRROR_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t count;
+    uint32_t used;
+    uint32_t inUse;
+    uint64_t device;
+};
+
+// The layout of each entry in the table of the mirror file.
+struct sMirrorEntry {
+    uint64_t syncID;
+    uint64_t hash;
+    uint32_t state;
+    uint32_t reserved;
+};
+
+#define MIRROR_HEADER(pMap) ((struct sMirrorHeader *)(pMap))
+#define MIRROR_ENTRIES(pMap) \
+    ((struct sMirrorEntry *)((char *)(pMap) + MIRROR_HEADER_SIZE))
+
+/**
+ * Construct a default MirrorType object.
+ *
+ * Construct a MirrorType object which has no mirror file open.
+ */
+MirrorType::MirrorType(void) {
+    fd = -1;
+    pMap = NULL;
+    mapSize = 0;
+    deviceKey = 0;
+}
+
+/**
+ * Destruct the MirrorType object.
+ *
+ * Destruct the MirrorType object, closing the mirror file if it is open.
+ */
+MirrorType::~MirrorType(void) {
+    Close();
+}
+
+/**
+ * Open the mirror.
+ *
+ * Open the mirror file at the given path, creating it if it does not exist.
+ * If the file does not hold a valid mirror, or it was left in use by a
+ * synchronization which never finished, it is started over empty. A valid
+ * mirror of a different device is refused and left as it is.
+ * @param mirrorPath The path of the mirror file.
+ * @param device The key identifying the Zaurus being mirrored.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully opened the mirror.
+ * @retval 1 Failed to open the mirror file.
+ * @retval 2 Failed to map the mirror file.
+ * @retval 3 The mirror file belongs to a different device.
+ */
+int MirrorType::Open(const std::string &mirrorPath, uint64_t device) {
+    struct stat fileStat;
+    struct sMirrorHeader *pHeader;
+    void *pFileMap;
+    bool valid = false;
+
+    Close();
+
+    deviceKey = device;
+    fd = open(mirrorPath.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0)
+        return 1;
+
+    if ((fstat(fd, &fileStat) == 0) &&
+        (fileStat.st_size >= (off_t)MIRROR_HEADER_SIZE)) {
+        pFileMap = mmap(NULL, (size_t)fileStat.st_size,
+            PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (pFileMap != MAP_FAILED) {
+            pMap = pFileMap;
+            mapSize = (size_t)fileStat.st_size;
+            pHeader = MIRROR_HEADER(pMap);
+
+            // I only trust the mirror if it was closed properly and its
+            // table is exactly the size its header claims.
+            if ((memcmp(pHeader->magic, MIRROR_MAGIC,
+                    MIRROR_MAGIC_SIZE) == 0) &&
+                (pHeader->version == MIRROR_VERSION) &&
+                (pHeader->inUse == 0) && (pHeader->capacity != 0) &&
+                ((pHeader->capacity & (pHeader->capacity - 1)) == 0) &&
+                (mapSize == (MIRROR_HEADER_SIZE +
+                    (size_t)pHeader->capacity * sizeof(struct sMirrorEntry))))
+                valid = true;
+        }
+    }
+
+    if (valid && (MIRROR_HEADER(pMap)->device != deviceKey)) {
+        Unmap();
+        close(fd);
+        fd = -1;
+        return 3;
+    }
+
+    if (valid) {
+        MIRROR_HEADER(pMap)->inUse = 1;
+        msync(pMap, MIRROR_HEADER_SIZE, MS_SYNC);
+        return 0;
+    }
+
+    Unmap();
+    if (Map(MIRROR_INITIAL_CAPACITY, true) != 0) {
+        close(fd);
+        fd = -1;
+        return 2;
+    }
+
+    return 0;
+}
+
+/**
+ * Determine if the mirror is open.
+ *
+ * Determine if a mirror file is currently open.
+ * @return A boolean value representing true (yes) or false (no).
+ */
+bool MirrorType::IsOpen(void) const {
+    return (pMap != NULL);
+}
+
+/**
+ * Close the mirror.
+ *
+ * Flush the mirror to disk, mark it as no longer in use, and close the
+ * mirror file.
+ */
+void MirrorType::Close(void) {
+    if (pMap != NULL) {
+        // I make sure the table is on disk before the header claims the
+        // mirror was closed properly.
+        msync(pMap, mapSize, MS_SYNC);
+        MIRROR_HEADER(pMap)->inUse = 0;
+        msync(pMap, MIRROR_HEADER_SIZE, MS_SYNC);
+        Unmap();
+    }
+
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+/**
+ * Get the number of items in the mirror.
+ *
+ * Get the number of items currently held in the mirror.
+ * @return The number of items in the mirror.
+ */
+unsigned long int MirrorType::GetCount(void) const {
+    if (pMap == NULL)
+        return 0;
+
+    return MIRROR_HEADER(pMap)->count;
+}
+
+/**
+ * Get the content hash of an item.
+ *
+ * Get the content hash the mirror holds for the item with the given sync ID.
+ * @param syncID The sync ID of the item.
+ * @param hash Reference to store the content hash of the item in.
+ * @return A boolean value representing true (found) or false (not found).
+ */
+bool MirrorType::Get(unsigned long int syncID, uint64_t &hash) const {
+    uint32_t slot;
+
+    if (pMap == NULL)
+        return false;
+
+    slot = FindSlot(syncID, false);
+    if (slot == MIRROR_HEADER(pMap)->capacity)
+        return false;
+
+    hash = MIRROR_ENTRIES(pMap)[slot].hash;
+    return true;
+}
+
+/**
+ * Put the content hash of an item.
+ *
+ * Put the content hash of the item with the given sync ID into the mirror,
+ * replacing any content hash already held for it.
+ * @param syncID The sync ID of the item.
+ * @param hash The content hash of the item.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully put the item in the mirror.
+ * @retval 1 The mirror is not open.
+ * @retval 2 Failed to grow the mirror.
+ */
+int MirrorType::Put(unsigned long int syncID, uint64_t hash) {
+    struct sMirrorHeader *pHeader;
+    struct sMirrorEntry *pEntry;
+
+    if (pMap == NULL)
+        return 1;
+
+    // I keep the table at most three quarters full, counting deleted
+    // entries, so that probing stays short and always finds an empty slot.
+    pHeader = MIRROR_HEADER(pMap);
+    if (((uint64_t)pHeader->used + 1) * 4 > (uint64_t)pHeader->capacity * 3) {
+        if (Grow() != 0)
+            return 2;
+        pHeader = MIRROR_HEADER(pMap);
+    }
+
+    pEntry = &MIRROR_ENTRIES(pMap)[FindSlot(syncID, true)];
+    if (pEntry->state != MIRROR_ENTRY_USED) {
+        if (pEntry->state == MIRROR_ENTRY_EMPTY)
+            pHeader->used++;
+        pHeader->count++;
+        pEntry->syncID = syncID;
+        pEntry->state = MIRROR_ENTRY_USED;
+    }
+    pEntry->hash = hash;
+
+    return 0;
+}
+
+/**
+ * Remove an item.
+ *
+ * Remove the item with the given sync ID from the mirror, if it is held.
+ * @param syncID The sync ID of the item.
+ */
+void MirrorType::Remove(unsigned long int syncID) {
+    uint32_t slot;
+
+    if (pMap == NULL)
+        return;
+
+    slot = FindSlot(syncID, false);
+    if (slot == MIRROR_HEADER(pMap)->capacity)
+        return;
+
+    MIRROR_ENTRIES(pMap)[slot].state = MIRROR_ENTRY_DELETED;
+    MIRROR_HEADER(pMap)->count--;
+}
+
+/**
+ * Retain only the given items.
+ *
+ * Remove every item from the mirror whose sync ID is not in the given set.
+ * This is used once the full list of items on the Zaurus is known, to drop
+ * the items which have since disappeared from it.
+ * @param syncIDs The set of sync IDs of the items to retain.
+ */
+void MirrorType::RetainOnly(const std::set<unsigned long int> &syncIDs) {
+    struct sMirrorHeader *pHeader;
+    struct sMirrorEntry *pEntries;
+    uint32_t i;
+
+    if (pMap == NULL)
+        return;
+
+    pHeader = MIRROR_HEADER(pMap);
+    pEntries = MIRROR_ENTRIES(pMap);
+    for (i = 0; i < pHeader->capacity; i++) {
+        if ((pEntries[i].state == MIRROR_ENTRY_USED) &&
+            (syncIDs.find((unsigned long int)pEntries[i].syncID) ==
+                syncIDs.end())) {
+            pEntries[i].state = MIRROR_ENTRY_DELETED;
+            pHeader->count--;
+        }
+    }
+}
+
+/**
+ * Map the mirror file.
+ *
+ * Size the mirror file for a table with the given capacity and map it into
+ * memory. If reset is true the table is started over empty and the mirror is
+ * marked as in use.
+ * @param capacity The number of entries in the table.
+ * @param reset Flag indicating if the table should be started over empty.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully mapped the mirror file.
+ * @retval 1 Failed to size the mirror file.
+ * @retval 2 Failed to map the mirror file.
+ */
+int MirrorType::Map(uint32_t capacity, bool reset) {
+    struct sMirrorHeader *pHeader;
+    size_t size;
+    void *pFileMap;
+
+    size = MIRROR_HEADER_SIZE + (size_t)capacity * sizeof(struct sMirrorEntry);
+
+    if (reset && (ftruncate(fd, 0) != 0))
+        return 1;
+    if (ftruncate(fd, (off_t)size) != 0)
+        return 1;
+
+    pFileMap = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (pFileMap == MAP_FAILED)
+        return 2;
+
+    pMap = pFileMap;
+    mapSize = size;
+
+    if (reset) {
+        memset(pMap, 0, mapSize);
+        pHeader = MIRROR_HEADER(pMap);
+        memcpy(pHeader->magic, MIRROR_MAGIC, MIRROR_MAGIC_SIZE);
+        pHeader->version = MIRROR_VERSION;
+        pHeader->capacity = capacity;
+        pHeader->inUse = 1;
+        pHeader->device = deviceKey;
+        msync(pMap, mapSize, MS_SYNC);
+    }
+
+    return 0;
+}
+
+/**
+ * Unmap the mirror file.
+ *
+ * Unmap the mirror file from memory, if it is mapped.
+ */
+void MirrorType::Unmap(void) {
+    if (pMap != NULL) {
+        munmap(pMap, mapSize);
+        pMap = NULL;
+        mapSize = 0;
+    }
+}
+
+/**
+ * Grow the mirror.
+ *
+ * Double the capacity of the table, rehashing every item held in it. The
+ * deleted entries are dropped in the process.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully grew the mirror.
+ * @retval 1 Failed to map the grown mirror file.
+ */
+int MirrorType::Grow(void) {
+    std::vector<std::pair<uint64_t, uint64_t> > items;
+    struct sMirrorHeader *pHeader;
+    struct sMirrorEntry *pEntries;
+    struct sMirrorEntry *pEntry;
+    uint32_t capacity;
+    uint32_t i;
+
+    pHeader = MIRROR_HEADER(pMap);
+    pEntries = MIRROR_ENTRIES(pMap);
+    capacity = pHeader->capacity;
+
+    items.reserve(pHeader->count);
+    for (i = 0; i < capacity; i++) {
+        if (pEntries[i].state == MIRROR_ENTRY_USED)
+            items.push_back(std::make_pair(pEntries[i].syncID,
+                pEntries[i].hash));
+    }
+
+    Unmap();
+    if (Map(capacity * 2, true) != 0)
+        return 1;
+
+    pHeader = MIRROR_HEADER(pMap);
+    for (i = 0; i < items.size(); i++) {
+        pEntry = &MIRROR_ENTRIES(pMap)[FindSlot(
+            (unsigned long int)items[i].first, true)];
+        pEntry->syncID = items[i].first;
+        pEntry->hash = items[i].second;
+        pEntry->state = MIRROR_ENTRY_USED;
+        pHeader->used++;
+        pHeader->count++;
+    }
+
+    return 0;
+}
+
+/**
+ * Find the slot of an item.
+ *
+ * Find the slot in the table of the item with the given sync ID by linear
+ * probing. When looking an item up the capacity of the table is returned if
+ * it is not held. When finding a slot to insert an item into, the slot of
+ * the item is returned if it is held, otherwise the first deleted or empty
+ * slot along its probe sequence is returned.
+ * @param syncID The sync ID of the item.
+ * @param forInsert Flag indicating if a slot to insert into is wanted.
+ * @return The index of the slot found.
+ */
+uint32_t MirrorType::FindSlot(unsigned long int syncID, bool forInsert) const {
+    struct sMirrorEntry *pEntries;
+    uint32_t capacity;
+    uint32_t mask;
+    uint32_t slot;
+    uint32_t firstFree;
+    uint32_t i;
+
+    pEntries = MIRROR_ENTRIES(pMap);
+    capacity = MIRROR_HEADER(pMap)->capacity;
+    mask = capacity - 1;
+    firstFree = capacity;
+
+    slot = HashSyncID(syncID) & mask;
+    for (i = 0; i < capacity; i++) {
+        if (pEntries[slot].state == MIRROR_ENTRY_EMPTY) {
+            if (!forInsert)
+                return capacity;
+            return (firstFree != capacity) ? firstFree : slot;
+        } else if (pEntries[slot].state == MIRROR_ENTRY_DELETED) {
+            if (firstFree == capacity)
+                firstFree = slot;
+        } else if (pEntries[slot].syncID == (uint64_t)syncID) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    return forInsert ? firstFree : capacity;
+}
+
+/**
+ * Hash a sync ID.
+ *
+ * Hash the given sync ID to pick its home slot in the table. Sync IDs are
+ * handed out sequentially by the Zaurus, so they are mixed first to spread
+ * them over the table.
+ * @param syncID The sync ID to hash.
+ * @return The hash of the sync ID.
+ */
+uint32_t MirrorType::HashSyncID(unsigned long int syncID) {
+    uint64_t x = (uint64_t)syncID;
+
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+
+    return (uint32_t)x;
+}
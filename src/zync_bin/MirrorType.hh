@@ -0,0 +1,88 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file MirrorType.hh
+ * @brief A specifications file for an object mirroring a devices items.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class existing to keep a persistent record of
+ * the items known to be on a Zaurus, so that a full synchronization does not
+ * have to transfer every item again.
+ */
+
+#ifndef MIRRORTYPE_H
+#define MIRRORTYPE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <set>
+#include <string>
+
+/**
+ * @class MirrorType
+ * @brief A type representing a mirror of the items on a Zaurus.
+ *
+ * The MirrorType is a class which represents a persistent mirror of the
+ * items on a Zaurus, holding the content hash of each item keyed by its sync
+ * ID. It is stored as an open addressing hash table in a file which is
+ * memory mapped, so opening it costs nothing no matter how many items it
+ * holds and updates are written straight through to the file. The file is
+ * flagged as in use while it is open. If zync dies without closing it, the
+ * mirror is thrown away the next time it is opened since it can no longer be
+ * trusted. A mirror is only ever used from one thread at a time.
+ */
+class MirrorType {
+public:
+    MirrorType(void);
+    ~MirrorType(void);
+
+    int Open(const std::string &mirrorPath, uint64_t device);
+    bool IsOpen(void) const;
+    void Close(void);
+
+    unsigned long int GetCount(void) const;
+    bool Get(unsigned long int syncID, uint64_t &hash) const;
+    int Put(unsigned long int syncID, uint64_t hash);
+    void Remove(unsigned long int syncID);
+    void RetainOnly(const std::set<unsigned long int> &syncIDs);
+
+private:
+    // The mirror owns its mapping, so it may not be copied.
+    MirrorType(const MirrorType &);
+    MirrorType &operator=(const MirrorType &);
+
+    int Map(uint32_t capacity, bool reset);
+    void Unmap(void);
+    int Grow(void);
+    uint32_t FindSlot(unsigned long int syncID, bool forInsert) const;
+
+    static uint32_t HashSyncID(unsigned long int syncID);
+
+    int fd;
+    void *pMap;
+    size_t mapSize;
+
+    // The key identifying the Zaurus being mirrored.
+    uint64_t deviceKey;
+};
+
+#endif
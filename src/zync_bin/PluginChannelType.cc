@@ -0,0 +1,292 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file PluginChannelType.cc
+ * @brief An implementation file for the channel to a plugin host process.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for a class existing to carry messages between
+ * zync and a plugin host process it forked.
+ */
+
+#include "PluginChannelType.hh"
+
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// The size of the ring in each direction. Items are sent in batches of
+// messages no larger than half of it.
+#define CHANNEL_RING_SIZE (1 << 20)
+
+// The number of milliseconds waited on a ring before checking on the other
+// process.
+#define CHANNEL_POLL_MS 100
+
+/**
+ * Construct a default PluginChannelType object.
+ *
+ * Construct a PluginChannelType object which has not created its rings yet.
+ */
+PluginChannelType::PluginChannelType(void) {
+    pSendRing = NULL;
+    pRecvRing = NULL;
+    isHostSide = false;
+    peerPid = 0;
+    peerExited = false;
+    timeoutSecs = 0;
+}
+
+/**
+ * Create the channel.
+ *
+ * Create the rings of the channel. This has to be done before the host
+ * process is forked.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully created the channel.
+ * @retval 1 Failed to create the rings.
+ */
+int PluginChannelType::Create(void) {
+    if ((toHostRing.Create(CHANNEL_RING_SIZE) != 0) ||
+        (toZyncRing.Create(CHANNEL_RING_SIZE) != 0)) {
+        toHostRing.Destroy();
+        toZyncRing.Destroy();
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Set the side of the channel.
+ *
+ * Tell the channel which side of it this process is, once forked.
+ * @param hostSide True in the host process, false in zync.
+ * @param otherPid The process ID of the other side.
+ */
+void PluginChannelType::SetSide(bool hostSide, pid_t otherPid) {
+    isHostSide = hostSide;
+    peerPid = otherPid;
+    peerExited = false;
+
+    if (isHostSide) {
+        pSendRing = &toZyncRing;
+        pRecvRing = &toHostRing;
+    } else {
+        pSendRing = &toHostRing;
+        pRecvRing = &toZyncRing;
+    }
+}
+
+/**
+ * Set the timeout.
+ *
+ * Set the number of seconds zync waits on the host before killing it. Zero
+ * means zync waits as long as the host is alive.
+ * @param seconds The timeout in seconds.
+ */
+void PluginChannelType::SetTimeout(unsigned int seconds) {
+    timeoutSecs = seconds;
+}
+
+/**
+ * Get the maximum message size.
+ *
+ * Get the size of the largest message which may be sent over the channel.
+ * @return The size of the largest message in bytes.
+ */
+uint32_t PluginChannelType::GetMaxMessageSize(void) const {
+    return toHostRing.GetMaxMessageSize();
+}
+
+/**
+ * Send a message.
+ *
+ * Send the given message to the other side, waiting for room if needed.
+ * @param msg The message to send.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully sent the message.
+ * @retval 1 Failed, the other process is gone.
+ * @retval 2 Failed, the message is too large.
+ * @retval 3 Failed, the host timed out and was killed.
+ */
+int PluginChannelType::Send(const std::string &msg) {
+    uint64_t startMs;
+    int retval;
+
+    if (!pSendRing || peerExited)
+        return 1;
+
+    startMs = SharedRingType::GetTimeMs();
+    while (true) {
+        retval = pSendRing->Write(msg.data(), (uint32_t)msg.size(),
+                                  CHANNEL_POLL_MS);
+        if (retval == 0)
+            return 0;
+        else if (retval == 3)
+            return 2;
+        else if (retval != 2)
+            return 1;
+
+        if (!IsPeerAlive())
+            return 1;
+
+        if (!isHostSide && (timeoutSecs != 0) &&
+            ((SharedRingType::GetTimeMs() - startMs) >=
+                ((uint64_t)timeoutSecs * 1000))) {
+            KillPeer();
+            return 3;
+        }
+    }
+}
+
+/**
+ * Receive a message.
+ *
+ * Receive the next message from the other side, waiting for one if needed.
+ * The message is read in place in the shared memory, the pointer stays
+ * valid until Release or the next Receive.
+ * @param pMsg Reference to store the pointer to the message in.
+ * @param size Reference to store the size of the message in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully received a message.
+ * @retval 1 Failed, the other process is gone or closed the channel.
+ * @retval 3 Failed, the host timed out and was killed.
+ */
+int PluginChannelType::Receive(const char *&pMsg, uint32_t &size) {
+    uint64_t startMs;
+    int retval;
+
+    if (!pRecvRing)
+        return 1;
+
+    startMs = SharedRingType::GetTimeMs();
+    while (true) {
+        retval = pRecvRing->Read(pMsg, size, CHANNEL_POLL_MS);
+        if (retval == 0)
+            return 0;
+        else if (retval != 2)
+            return 1;
+
+        // Messages sent before the other side died are still delivered, I
+        // only give up once the ring has been drained.
+        if (!IsPeerAlive())
+            return 1;
+
+        if (!isHostSide && (timeoutSecs != 0) &&
+            ((SharedRingType::GetTimeMs() - startMs) >=
+                ((uint64_t)timeoutSecs * 1000))) {
+            KillPeer();
+            return 3;
+        }
+    }
+}
+
+/**
+ * Release the message received.
+ *
+ * Hand the space of the last message received back to the other side.
+ */
+void PluginChannelType::Release(void) {
+    if (pRecvRing)
+        pRecvRing->Release();
+}
+
+/**
+ * Close the channel.
+ *
+ * Tell the other side that this side will not send any more messages.
+ */
+void PluginChannelType::Close(void) {
+    if (pSendRing)
+        pSendRing->Close();
+}
+
+/**
+ * Check if the other side is alive.
+ *
+ * Check that the process on the other side of the channel still exists. In
+ * zync this reaps the host if it exited. In the host the parent is gone
+ * once the host has been handed to another parent.
+ * @return True if the other process is alive, false otherwise.
+ */
+bool PluginChannelType::IsPeerAlive(void) {
+    int status;
+
+    if (peerExited)
+        return false;
+
+    if (isHostSide) {
+        if (getppid() != peerPid)
+            peerExited = true;
+    } else {
+        if (waitpid(peerPid, &status, WNOHANG) != 0)
+            peerExited = true;
+    }
+
+    return !peerExited;
+}
+
+/**
+ * Wait for the host to exit.
+ *
+ * Wait for the host process to exit, killing it if it has not exited within
+ * the given number of seconds. Only used by zync.
+ * @param seconds The number of seconds to wait before killing the host.
+ * @return An integer representing how the host exited.
+ * @retval 0 The host exited by itself.
+ * @retval 1 The host had to be killed.
+ */
+int PluginChannelType::WaitPeerExit(unsigned int seconds) {
+    struct timespec delay;
+    unsigned int i;
+
+    delay.tv_sec = 0;
+    delay.tv_nsec = 10000000;
+    for (i = 0; i < (seconds * 100); i++) {
+        if (!IsPeerAlive())
+            return 0;
+        nanosleep(&delay, NULL);
+    }
+
+    if (!IsPeerAlive())
+        return 0;
+
+    KillPeer();
+    return 1;
+}
+
+/**
+ * Kill the host.
+ *
+ * Kill the host process and reap it. Only used by zync.
+ */
+void PluginChannelType::KillPeer(void) {
+    int status;
+
+    if (isHostSide || peerExited)
+        return;
+
+    kill(peerPid, SIGKILL);
+    waitpid(peerPid, &status, 0);
+    peerExited = true;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file PluginChannelType.hh
+ * @brief A specifications file for the channel to a plugin host process.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class existing to carry messages between
+ * zync and a plugin host process it forked.
+ */
+
+#ifndef PLUGINCHANNELTYPE_H
+#define PLUGINCHANNELTYPE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <string>
+
+#include "SharedRingType.hh"
+
+/**
+ * @class PluginChannelType
+ * @brief A type representing the channel between zync and a plugin host.
+ *
+ * The PluginChannelType is a class which represents a two way channel
+ * between zync and a plugin host process, made of one SharedRingType in each
+ * direction. It is created before the fork, after which each side tells it
+ * which side it is. While waiting on the other side it keeps checking that
+ * the other process is still alive, so that neither side waits forever on a
+ * process which died. On the zync side an optional timeout bounds how long
+ * the host may take to answer, after which the host is killed.
+ */
+class PluginChannelType {
+public:
+    PluginChannelType(void);
+
+    int Create(void);
+    void SetSide(bool hostSide, pid_t otherPid);
+    void SetTimeout(unsigned int seconds);
+
+    uint32_t GetMaxMessageSize(void) const;
+
+    int Send(const std::string &msg);
+    int Receive(const char *&pMsg, uint32_t &size);
+    void Release(void);
+    void Close(void);
+
+    bool IsPeerAlive(void);
+    int WaitPeerExit(unsigned int seconds);
+
+private:
+    // The channel owns its rings, so it may not be copied.
+    PluginChannelType(const PluginChannelType &);
+    PluginChannelType &operator=(const PluginChannelType &);
+
+    void KillPeer(void);
+
+    SharedRingType toHostRing;
+    SharedRingType toZyncRing;
+    SharedRingType *pSendRing;
+    SharedRingType *pRecvRing;
+
+    bool isHostSide;
+    pid_t peerPid;
+    bool peerExited;
+    unsigned int timeoutSecs;
+};
+
+#endif
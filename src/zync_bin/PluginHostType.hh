@@ -0,0 +1,680 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file PluginHostType.hh
+ * @brief A specifications file for running a plugin in a host process.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for the class templates existing to run a plugin in
+ * a separate host process, and to use it from zync as if it were loaded
+ * into zync itself.
+ */
+
+#ifndef PLUGINHOSTTYPE_H
+#define PLUGINHOSTTYPE_H
+
+#include <iostream>
+#include <string>
+
+#include "PluginV2Type.hh"
+#include "PluginChannelType.hh"
+#include "ItemCodecType.hh"
+
+// The requests zync sends to the host. Requests carrying a list are split
+// in parts which fit in a message, each flagged whether it is the last.
+#define HOST_OP_INIT 0x01
+#define HOST_OP_CLEANUP 0x02
+#define HOST_OP_EXPORT_ALL 0x03
+#define HOST_OP_EXPORT_NEW 0x04
+#define HOST_OP_EXPORT_MOD 0x05
+#define HOST_OP_GET_DEL 0x06
+#define HOST_OP_ADD 0x07
+#define HOST_OP_MOD 0x08
+#define HOST_OP_DEL 0x09
+#define HOST_OP_MAP 0x0a
+#define HOST_OP_QUIT 0x0b
+
+// The replies the host sends to zync. Every request is answered by a single
+// done reply, which items or IDs the request obtains precede.
+#define HOST_REPLY_HELLO 0x81
+#define HOST_REPLY_DONE 0x82
+#define HOST_REPLY_ITEMS 0x83
+#define HOST_REPLY_IDS 0x84
+
+// The value returned by the proxy when the host could not be reached.
+#define HOST_CALL_FAILED -1
+
+/**
+ * Put an element of a list.
+ *
+ * Append an item or sync ID to a message.
+ * @param codec Reference to the codec building the message.
+ * @param item The item to append.
+ */
+template <class ItemT>
+void PutHostElem(ItemCodecType &codec, const ItemT &item) {
+    codec.PutItem(item);
+}
+
+inline void PutHostElem(ItemCodecType &codec, const unsigned long int &id) {
+    codec.PutULong(id);
+}
+
+/**
+ * Get an element of a list.
+ *
+ * Read an item or sync ID from a message.
+ * @param codec Reference to the codec reading the message.
+ * @param item Reference to store the item read in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ */
+template <class ItemT>
+int GetHostElem(ItemCodecType &codec, ItemT &item) {
+    return codec.GetItem(item);
+}
+
+inline int GetHostElem(ItemCodecType &codec, unsigned long int &id) {
+    return codec.GetULong(id);
+}
+
+/**
+ * Send a list over a plugin channel.
+ *
+ * Send the given list of items or sync IDs in as many messages as needed,
+ * each starting with the given op and a flag set on the last one.
+ * @param channel Reference to the channel to send the list over.
+ * @param op The op of the messages.
+ * @param list The list to send.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully sent the list.
+ * @retval 1 Failed, the other process is gone.
+ * @retval 2 Failed, a single element does not fit in a message.
+ * @retval 3 Failed, the host timed out and was killed.
+ */
+template <class ListType>
+int SendHostList(PluginChannelType &channel, unsigned char op,
+                 const ListType &list) {
+    typename ListType::const_iterator iter;
+    std::string msg;
+    std::string::size_type maxSize;
+    int retval;
+
+    maxSize = channel.GetMaxMessageSize();
+    msg.push_back((char)op);
+    msg.push_back((char)0);
+
+    for (iter = list.begin(); iter != list.end(); ++iter) {
+        ItemCodecType elemCodec;
+
+        PutHostElem(elemCodec, *iter);
+        const std::string &elem = elemCodec.GetData();
+
+        if (((msg.size() + elem.size()) > maxSize) && (msg.size() > 2)) {
+            retval = channel.Send(msg);
+            if (retval != 0)
+                return retval;
+            msg.resize(2);
+        }
+
+        if ((msg.size() + elem.size()) > maxSize)
+            return 2;
+
+        msg.append(elem);
+    }
+
+    msg[1] = (char)1;
+    return channel.Send(msg);
+}
+
+/**
+ * @class HostItemSinkType
+ * @brief A type sending the items exported by a hosted plugin to zync.
+ *
+ * The HostItemSinkType is a class template used in the host process to
+ * send each batch of items the plugin exports over the channel to zync.
+ */
+template <class ItemT>
+class HostItemSinkType : public ItemSinkType<ItemT> {
+public:
+    HostItemSinkType(PluginChannelType &hostChannel) :
+        channel(hostChannel) { }
+
+    int TakeBatch(typename ItemT::List &batch) {
+        int retval;
+
+        retval = SendHostList(channel, HOST_REPLY_ITEMS, batch);
+        batch.clear();
+        return retval;
+    }
+
+private:
+    PluginChannelType &channel;
+};
+
+/**
+ * @class PluginHostType
+ * @brief A type serving the requests for a plugin in the host process.
+ *
+ * The PluginHostType is a class template used in the host process to answer
+ * the requests zync sends for the plugin, of the synchronization type
+ * described by the given traits, until zync asks it to quit or goes away.
+ */
+template <class Traits>
+class PluginHostType {
+public:
+    typedef typename Traits::ItemT ItemT;
+    typedef typename Traits::PluginV2T PluginV2T;
+
+    static void Serve(PluginChannelType &channel, int loadRetval,
+                      const std::string &loadError, bool isV2,
+                      PluginV2T *pPlugin);
+
+private:
+    static int SendDone(PluginChannelType &channel, int retval);
+};
+
+/**
+ * Serve the plugin.
+ *
+ * Tell zync how loading the plugin went, then answer its requests. A list
+ * sent in parts is gathered before the plugin is called with it, so the
+ * plugin sees the same batches as if it were loaded into zync.
+ * @param channel Reference to the channel to zync.
+ * @param loadRetval The value returned by loading the plugin.
+ * @param loadError The error message of loading the plugin, if it failed.
+ * @param isV2 True if the plugin provides the version 2 interface.
+ * @param pPlugin Pointer to the plugin, NULL if it failed to load.
+ */
+template <class Traits>
+void PluginHostType<Traits>::Serve(PluginChannelType &channel,
+                                   int loadRetval,
+                                   const std::string &loadError, bool isV2,
+                                   PluginV2T *pPlugin) {
+    ItemCodecType hello;
+    HostItemSinkType<ItemT> sink(channel);
+    typename ItemT::List itemList;
+    SyncIDListType idList;
+    const char *pMsg;
+    uint32_t size;
+    unsigned char op;
+    unsigned char last;
+    time_t lastTimeSynced;
+    int retval;
+
+    hello.PutUChar(HOST_REPLY_HELLO);
+    hello.PutUInt((unsigned long int)(unsigned int)loadRetval);
+    hello.PutUChar(isV2 ? 1 : 0);
+    hello.PutUInt(pPlugin ? pPlugin->GetBatchSize() : 0);
+    hello.PutString(pPlugin ? pPlugin->GetPluginName() : "");
+    hello.PutString(pPlugin ? pPlugin->GetPluginVersion() : "");
+    hello.PutString(pPlugin ? pPlugin->GetPluginAuthor() : "");
+    hello.PutString(pPlugin ? pPlugin->GetPluginDescription() : "");
+    hello.PutString(loadError);
+    if ((channel.Send(hello.GetData()) != 0) || !pPlugin)
+        return;
+
+    while (channel.Receive(pMsg, size) == 0) {
+        ItemCodecType req(pMsg, size);
+
+        if (req.GetUChar(op) != 0)
+            break;
+
+        if (op == HOST_OP_QUIT) {
+            SendDone(channel, 0);
+            break;
+        }
+
+        retval = 0;
+        switch (op) {
+            case HOST_OP_INIT:
+                retval = pPlugin->Initialize();
+                break;
+            case HOST_OP_CLEANUP:
+                retval = pPlugin->CleanUp();
+                break;
+            case HOST_OP_EXPORT_ALL:
+                channel.Release();
+                retval = pPlugin->ExportAllItems(sink);
+                break;
+            case HOST_OP_EXPORT_NEW:
+            case HOST_OP_EXPORT_MOD:
+            case HOST_OP_GET_DEL:
+                if (req.GetTime(lastTimeSynced) != 0) {
+                    retval = HOST_CALL_FAILED;
+                    break;
+                }
+                channel.Release();
+                if (op == HOST_OP_EXPORT_NEW) {
+                    retval = pPlugin->ExportNewItems(lastTimeSynced, sink);
+                } else if (op == HOST_OP_EXPORT_MOD) {
+                    retval = pPlugin->ExportModItems(lastTimeSynced, sink);
+                } else {
+                    idList.clear();
+                    retval = pPlugin->GetDelItemIDs(lastTimeSynced, idList);
+                    if (SendHostList(channel, HOST_REPLY_IDS, idList) != 0)
+                        return;
+                    idList.clear();
+                }
+                break;
+            case HOST_OP_ADD:
+            case HOST_OP_MOD:
+            case HOST_OP_MAP:
+            case HOST_OP_DEL:
+                // I decode the part straight out of the ring, then wait for
+                // the rest of the list before calling the plugin.
+                if (req.GetUChar(last) != 0) {
+                    retval = HOST_CALL_FAILED;
+                    break;
+                }
+                while (!req.AtEnd() && (retval == 0)) {
+                    if (op == HOST_OP_DEL) {
+                        idList.push_back(0);
+                        retval = GetHostElem(req, idList.back());
+                    } else {
+                        itemList.push_back(ItemT());
+                        retval = GetHostElem(req, itemList.back());
+                    }
+                }
+                if (retval != 0) {
+                    retval = HOST_CALL_FAILED;
+                    itemList.clear();
+                    idList.clear();
+                    break;
+                }
+                if (!last)
+                    continue;
+
+                if (op == HOST_OP_ADD)
+                    retval = pPlugin->AddItems(itemList);
+                else if (op == HOST_OP_MOD)
+                    retval = pPlugin->ModItems(itemList);
+                else if (op == HOST_OP_MAP)
+                    retval = pPlugin->MapItemIDs(itemList);
+                else
+                    retval = pPlugin->DelItems(idList);
+                itemList.clear();
+                idList.clear();
+                break;
+            default:
+                retval = HOST_CALL_FAILED;
+                break;
+        }
+
+        if (SendDone(channel, retval) != 0)
+            break;
+    }
+}
+
+/**
+ * Send the done reply.
+ *
+ * Tell zync that the current request is done.
+ * @param channel Reference to the channel to zync.
+ * @param retval The value returned by the plugin for the request.
+ * @return An integer representing success (zero) or failure (non-zero).
+ */
+template <class Traits>
+int PluginHostType<Traits>::SendDone(PluginChannelType &channel,
+                                     int retval) {
+    ItemCodecType reply;
+
+    reply.PutUChar(HOST_REPLY_DONE);
+    reply.PutUInt((unsigned long int)(unsigned int)retval);
+    return channel.Send(reply.GetData());
+}
+
+/**
+ * @class PluginProxyType
+ * @brief A type standing in for a plugin running in a host process.
+ *
+ * The PluginProxyType is a class template used in zync in place of a plugin
+ * running in a host process. Each member function sends a request over the
+ * channel and waits for the done reply, turning the items and IDs which
+ * precede it back into lists. Items are decoded straight out of the shared
+ * memory. Once the host is gone, whether it crashed or was killed for
+ * taking too long, every member function fails rather than taking zync
+ * down with it.
+ */
+template <class Traits>
+class PluginProxyType : public Traits::PluginV2T {
+public:
+    typedef typename Traits::ItemT ItemT;
+
+    PluginProxyType(PluginChannelType &hostChannel);
+
+    int Connect(std::string &loadError);
+    bool IsHostV2(void) const { return hostV2; }
+    int Quit(void);
+
+    int Initialize(void);
+    int CleanUp(void);
+    unsigned int GetBatchSize(void) const { return batchSize; }
+
+    int ExportAllItems(ItemSinkType<ItemT> &sink);
+    int ExportNewItems(time_t lastTimeSynced, ItemSinkType<ItemT> &sink);
+    int ExportModItems(time_t lastTimeSynced, ItemSinkType<ItemT> &sink);
+    int GetDelItemIDs(time_t lastTimeSynced, SyncIDListType &syncIDList);
+
+    int AddItems(const typename ItemT::List &batch);
+    int ModItems(const typename ItemT::List &batch);
+    int DelItems(const SyncIDListType &batch);
+    int MapItemIDs(const typename ItemT::List &batch);
+
+    std::string GetPluginDescription(void) const { return description; }
+    std::string GetPluginName(void) const { return name; }
+    std::string GetPluginAuthor(void) const { return author; }
+    std::string GetPluginVersion(void) const { return version; }
+
+private:
+    int Request(unsigned char op, bool withTime, time_t lastTimeSynced,
+                ItemSinkType<ItemT> *pSink, SyncIDListType *pIDList);
+    template <class ListType>
+    int RequestWithList(unsigned char op, const ListType &list);
+    int WaitDone(ItemSinkType<ItemT> *pSink, SyncIDListType *pIDList);
+
+    PluginChannelType &channel;
+    bool broken;
+    bool hostV2;
+    unsigned int batchSize;
+    std::string name;
+    std::string version;
+    std::string author;
+    std::string description;
+};
+
+/**
+ * Construct a PluginProxyType object.
+ *
+ * Construct a PluginProxyType object talking to the host over the given
+ * channel, which must outlive it.
+ * @param hostChannel Reference to the channel to the host.
+ */
+template <class Traits>
+PluginProxyType<Traits>::PluginProxyType(PluginChannelType &hostChannel) :
+    channel(hostChannel), broken(false), hostV2(false), batchSize(1) {
+
+}
+
+/**
+ * Connect to the host.
+ *
+ * Wait for the host to tell how loading the plugin went, along with the
+ * information about the plugin.
+ * @param loadError Reference to store the error message of loading the
+ * plugin in.
+ * @return The value returned by loading the plugin in the host, or
+ * HOST_CALL_FAILED if the host could not be reached.
+ */
+template <class Traits>
+int PluginProxyType<Traits>::Connect(std::string &loadError) {
+    const char *pMsg;
+    uint32_t size;
+    unsigned char op;
+    unsigned char isV2;
+    unsigned long int loadRetval;
+    unsigned long int hostBatchSize;
+
+    if (channel.Receive(pMsg, size) != 0) {
+        broken = true;
+        return HOST_CALL_FAILED;
+    }
+
+    ItemCodecType hello(pMsg, size);
+    if ((hello.GetUChar(op) != 0) || (op != HOST_REPLY_HELLO) ||
+        (hello.GetUInt(loadRetval) != 0) || (hello.GetUChar(isV2) != 0) ||
+        (hello.GetUInt(hostBatchSize) != 0) ||
+        (hello.GetString(name) != 0) || (hello.GetString(version) != 0) ||
+        (hello.GetString(author) != 0) ||
+        (hello.GetString(description) != 0) ||
+        (hello.GetString(loadError) != 0)) {
+        channel.Release();
+        broken = true;
+        return HOST_CALL_FAILED;
+    }
+    channel.Release();
+
+    hostV2 = (isV2 != 0);
+    batchSize = (unsigned int)hostBatchSize;
+    if (batchSize == 0)
+        batchSize = 1;
+
+    return (int)(unsigned int)loadRetval;
+}
+
+/**
+ * Ask the host to quit.
+ *
+ * Ask the host to quit and close the channel.
+ * @return An integer representing success (zero) or failure (non-zero).
+ */
+template <class Traits>
+int PluginProxyType<Traits>::Quit(void) {
+    int retval;
+
+    retval = Request(HOST_OP_QUIT, false, 0, NULL, NULL);
+    channel.Close();
+    broken = true;
+
+    return retval;
+}
+
+template <class Traits>
+int PluginProxyType<Traits>::Initialize(void) {
+    return Request(HOST_OP_INIT, false, 0, NULL, NULL);
+}
+
+template <class Traits>
+int PluginProxyType<Traits>::CleanUp(void) {
+    return Request(HOST_OP_CLEANUP, false, 0, NULL, NULL);
+}
+
+template <class Traits>
+int PluginProxyType<Traits>::ExportAllItems(ItemSinkType<ItemT> &sink) {
+    return Request(HOST_OP_EXPORT_ALL, false, 0, &sink, NULL);
+}
+
+template <class Traits>
+int PluginProxyType<Traits>::ExportNewItems(time_t lastTimeSynced,
+                                            ItemSinkType<ItemT> &sink) {
+    return Request(HOST_OP_EXPORT_NEW, true, lastTimeSynced, &sink, NULL);
+}
+
+template <class Traits>
+int PluginProxyType<Traits>::ExportModItems(time_t lastTimeSynced,
+                                            ItemSinkType<ItemT> &sink) {
+    return Request(HOST_OP_EXPORT_MOD, true, lastTimeSynced, &sink, NULL);
+}
+
+template <class Traits>
+int PluginProxyType<Traits>::GetDelItemIDs(time_t lastTimeSynced,
+                                           SyncIDListType &syncIDList) {
+    return Request(HOST_OP_GET_DEL, true, lastTimeSynced, NULL,
+                   &syncIDList);
+}
+
+template <class Traits>
+int PluginProxyType<Traits>::AddItems(const typename ItemT::List &batch) {
+    return RequestWithList(HOST_OP_ADD, batch);
+}
+
+template <class Traits>
+int PluginProxyType<Traits>::ModItems(const typename ItemT::List &batch) {
+    return RequestWithList(HOST_OP_MOD, batch);
+}
+
+template <class Traits>
+int PluginProxyType<Traits>::DelItems(const SyncIDListType &batch) {
+    return RequestWithList(HOST_OP_DEL, batch);
+}
+
+template <class Traits>
+int PluginProxyType<Traits>::MapItemIDs(const typename ItemT::List &batch) {
+    return RequestWithList(HOST_OP_MAP, batch);
+}
+
+/**
+ * Send a request.
+ *
+ * Send a request without a list to the host and wait for it to be done.
+ * @param op The op of the request.
+ * @param withTime True if the request carries the last time synced.
+ * @param lastTimeSynced The last time synced, if carried.
+ * @param pSink Pointer to the sink to hand the items obtained to, or NULL.
+ * @param pIDList Pointer to the list to add the IDs obtained to, or NULL.
+ * @return The value returned by the plugin, or HOST_CALL_FAILED.
+ */
+template <class Traits>
+int PluginProxyType<Traits>::Request(unsigned char op, bool withTime,
+                                     time_t lastTimeSynced,
+                                     ItemSinkType<ItemT> *pSink,
+                                     SyncIDListType *pIDList) {
+    ItemCodecType req;
+
+    if (broken)
+        return HOST_CALL_FAILED;
+
+    req.PutUChar(op);
+    if (withTime)
+        req.PutTime(lastTimeSynced);
+
+    if (channel.Send(req.GetData()) != 0) {
+        broken = true;
+        return HOST_CALL_FAILED;
+    }
+
+    return WaitDone(pSink, pIDList);
+}
+
+/**
+ * Send a request with a list.
+ *
+ * Send a request carrying the given list to the host and wait for it to be
+ * done.
+ * @param op The op of the request.
+ * @param list The list of items or sync IDs to send.
+ * @return The value returned by the plugin, or HOST_CALL_FAILED.
+ */
+template <class Traits>
+template <class ListType>
+int PluginProxyType<Traits>::RequestWithList(unsigned char op,
+                                             const ListType &list) {
+    int retval;
+
+    if (broken)
+        return HOST_CALL_FAILED;
+
+    retval = SendHostList(channel, op, list);
+    if (retval == 2) {
+        // An item too large for a message was not sent, but the parts
+        // already sent leave the host waiting on the rest of the list. The
+        // only way to get back in step is to give up on the host.
+        std::cout << "zync: An item is too large for the plugin host.\n";
+    }
+    if (retval != 0) {
+        broken = true;
+        return HOST_CALL_FAILED;
+    }
+
+    return WaitDone(NULL, NULL);
+}
+
+/**
+ * Wait for the done reply.
+ *
+ * Wait for the host to be done with the request sent, handing the items and
+ * IDs which come before the done reply to the given sink and list.
+ * @param pSink Pointer to the sink to hand the items obtained to, or NULL.
+ * @param pIDList Pointer to the list to add the IDs obtained to, or NULL.
+ * @return The value returned by the plugin, or HOST_CALL_FAILED.
+ */
+template <class Traits>
+int PluginProxyType<Traits>::WaitDone(ItemSinkType<ItemT> *pSink,
+                                      SyncIDListType *pIDList) {
+    typename ItemT::List batchList;
+    const char *pMsg;
+    uint32_t size;
+    unsigned char op;
+    unsigned char last;
+    unsigned long int retval;
+    int sinkRetval = 0;
+
+    while (true) {
+        if (channel.Receive(pMsg, size) != 0) {
+            broken = true;
+            return HOST_CALL_FAILED;
+        }
+
+        ItemCodecType reply(pMsg, size);
+        if (reply.GetUChar(op) != 0)
+            break;
+
+        if (op == HOST_REPLY_DONE) {
+            if (reply.GetUInt(retval) != 0)
+                break;
+            channel.Release();
+            if ((retval == 0) && (sinkRetval != 0))
+                return sinkRetval;
+            return (int)(unsigned int)retval;
+        }
+
+        if (((op != HOST_REPLY_ITEMS) && (op != HOST_REPLY_IDS)) ||
+            (reply.GetUChar(last) != 0))
+            break;
+
+        if (op == HOST_REPLY_ITEMS) {
+            while (!reply.AtEnd()) {
+                batchList.push_back(ItemT());
+                if (GetHostElem(reply, batchList.back()) != 0)
+                    break;
+            }
+            if (!reply.AtEnd())
+                break;
+            channel.Release();
+
+            // A batch the sink did not take is dropped, the host is told by
+            // the done reply instead.
+            if (last) {
+                if (pSink && (sinkRetval == 0))
+                    sinkRetval = pSink->TakeBatch(batchList);
+                batchList.clear();
+            }
+        } else {
+            unsigned long int syncID;
+
+            while (!reply.AtEnd()) {
+                if (GetHostElem(reply, syncID) != 0)
+                    break;
+                if (pIDList)
+                    pIDList->push_back(syncID);
+            }
+            if (!reply.AtEnd())
+                break;
+            channel.Release();
+        }
+    }
+
+    // The reply could not be made sense of, so the channel is out of step.
+    channel.Release();
+    broken = true;
+    return HOST_CALL_FAILED;
+}
+
+#endif
@@ -0,0 +1,605 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file PluginLoaderType.hh
+ * @brief A specifications file for loading version 1 and 2 plugins.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for the class templates existing to load a plugin
+ * of either version of the plugin interface and to present both through the
+ * version 2 interface, handing items over in the batches the plugin asks
+ * for. The plugin may be loaded into zync itself or into a separate host
+ * process.
+ */
+
+#ifndef PLUGINLOADERTYPE_H
+#define PLUGINLOADERTYPE_H
+
+#include <time.h>
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+
+#include "PluginV2Type.hh"
+#include "PluginHostType.hh"
+
+/**
+ * @class ItemListSinkType
+ * @brief A type receiving the items exported by a plugin into a list.
+ *
+ * The ItemListSinkType is a class template which swaps every batch of
+ * items exported by a plugin onto the end of a list.
+ */
+template <class ItemT>
+class ItemListSinkType : public ItemSinkType<ItemT> {
+public:
+    ItemListSinkType(typename ItemT::List &itemList) : list(itemList) { }
+
+    int TakeBatch(typename ItemT::List &batch) {
+        SpliceItems(list, batch);
+        return 0;
+    }
+
+private:
+    typename ItemT::List &list;
+};
+
+/**
+ * @class PluginV1AdapterType
+ * @brief A type presenting a version 1 plugin as a version 2 plugin.
+ *
+ * The PluginV1AdapterType is a class template which wraps a version 1
+ * plugin, of the synchronization type described by the given traits, so
+ * that it may be used through the version 2 interface. A version 1 plugin
+ * takes and returns whole lists by value, so it asks for every item in a
+ * single batch. The adapter owns the plugin and destroys it with the
+ * destroy function of its library.
+ */
+template <class Traits>
+class PluginV1AdapterType : public Traits::PluginV2T {
+public:
+    typedef typename Traits::ItemT ItemT;
+
+    PluginV1AdapterType(typename Traits::PluginT *pV1Plugin,
+                        typename Traits::DestroyFuncT pV1DestroyFunc) :
+        pPlugin(pV1Plugin), pDestroyFunc(pV1DestroyFunc) { }
+    ~PluginV1AdapterType(void) { pDestroyFunc(pPlugin); }
+
+    int Initialize(void) { return pPlugin->Initialize(); }
+    int CleanUp(void) { return pPlugin->CleanUp(); }
+    unsigned int GetBatchSize(void) const { return (unsigned int)-1; }
+
+    int ExportAllItems(ItemSinkType<ItemT> &sink) {
+        typename ItemT::List items = Traits::GetAllItems(pPlugin);
+        return sink.TakeBatch(items);
+    }
+    int ExportNewItems(time_t lastTimeSynced, ItemSinkType<ItemT> &sink) {
+        typename ItemT::List items = Traits::GetNewItems(pPlugin,
+                                                         lastTimeSynced);
+        return sink.TakeBatch(items);
+    }
+    int ExportModItems(time_t lastTimeSynced, ItemSinkType<ItemT> &sink) {
+        typename ItemT::List items = Traits::GetModItems(pPlugin,
+                                                         lastTimeSynced);
+        return sink.TakeBatch(items);
+    }
+    int GetDelItemIDs(time_t lastTimeSynced, SyncIDListType &syncIDList) {
+        SyncIDListType ids = Traits::GetDelItemIDs(pPlugin, lastTimeSynced);
+        syncIDList.splice(syncIDList.end(), ids);
+        return 0;
+    }
+
+    int AddItems(const typename ItemT::List &batch) {
+        return Traits::AddItems(pPlugin, batch);
+    }
+    int ModItems(const typename ItemT::List &batch) {
+        return Traits::ModItems(pPlugin, batch);
+    }
+    int DelItems(const SyncIDListType &batch) {
+        return Traits::DelItems(pPlugin, batch);
+    }
+    int MapItemIDs(const typename ItemT::List &batch) {
+        return pPlugin->MapItemIDs(batch);
+    }
+
+    std::string GetPluginDescription(void) const {
+        return pPlugin->GetPluginDescription();
+    }
+    std::string GetPluginName(void) const { return pPlugin->GetPluginName(); }
+    std::string GetPluginAuthor(void) const {
+        return pPlugin->GetPluginAuthor();
+    }
+    std::string GetPluginVersion(void) const {
+        return pPlugin->GetPluginVersion();
+    }
+
+private:
+    typename Traits::PluginT *pPlugin;
+    typename Traits::DestroyFuncT pDestroyFunc;
+};
+
+/**
+ * @class PluginLoaderType
+ * @brief A type loading the plugin of a synchronization type.
+ *
+ * The PluginLoaderType is a class template which loads the plugin library
+ * of the synchronization type described by the given traits. The version 2
+ * factories are used if the library provides them and the plugin accepts
+ * the version of the interface zync was built with, otherwise the version 1
+ * factories are used and the plugin is wrapped in a PluginV1AdapterType.
+ * Either way the plugin is used through the version 2 interface, and the
+ * member functions below hand lists of items over in batches no larger than
+ * the plugin asks for, by splicing them rather than copying the items.
+ *
+ * A plugin loaded with LoadHosted runs in a host process forked for it and
+ * is used through a PluginProxyType, so that a plugin which crashes or
+ * hangs does not take zync down with it, and the plugin does its work on a
+ * processor of its own.
+ */
+template <class Traits>
+class PluginLoaderType {
+public:
+    typedef typename Traits::ItemT ItemT;
+    typedef typename Traits::PluginV2T PluginV2T;
+
+    PluginLoaderType(void);
+    ~PluginLoaderType(void);
+
+    int Load(const char *pLibPath);
+    int LoadHosted(const char *pLibPath, unsigned int timeoutSecs);
+    void Unload(void);
+
+    PluginV2T *GetPlugin(void) const { return pPlugin; }
+    bool IsV2(void) const { return isV2; }
+    bool IsHosted(void) const { return (pChannel != NULL); }
+    const std::string &GetError(void) const { return error; }
+
+    int GetAllItems(typename ItemT::List &itemList);
+    int GetNewItems(time_t lastTimeSynced, typename ItemT::List &itemList);
+    int GetModItems(time_t lastTimeSynced, typename ItemT::List &itemList);
+    int GetDelItemIDs(time_t lastTimeSynced, SyncIDListType &syncIDList);
+    int AddItems(typename ItemT::List &itemList);
+    int ModItems(typename ItemT::List &itemList);
+    int DelItems(SyncIDListType &syncIDList);
+    int MapItemIDs(typename ItemT::List &itemList);
+
+private:
+    // The loader owns the library and plugin, so it may not be copied.
+    PluginLoaderType(const PluginLoaderType &);
+    PluginLoaderType &operator=(const PluginLoaderType &);
+
+    void SaveDlError(void);
+
+    template <class ListType>
+    int HandInBatches(int (PluginV2T::*pFunc)(const ListType &),
+                      ListType &list);
+
+    void *libHandle;
+    PluginV2T *pPlugin;
+    typename Traits::DestroyV2FuncT pV2DestroyFunc;
+    bool isV2;
+    std::string error;
+
+    // The channel to the host process and the proxy using it, when the
+    // plugin is hosted.
+    PluginChannelType *pChannel;
+    PluginProxyType<Traits> *pProxy;
+};
+
+/**
+ * Construct a default PluginLoaderType object.
+ *
+ * Construct a PluginLoaderType object which has not loaded a plugin.
+ */
+template <class Traits>
+PluginLoaderType<Traits>::PluginLoaderType(void) : libHandle(NULL),
+    pPlugin(NULL), pV2DestroyFunc(NULL), isV2(false), pChannel(NULL),
+    pProxy(NULL) {
+
+}
+
+/**
+ * Destruct the PluginLoaderType object.
+ *
+ * Destruct the PluginLoaderType object by unloading the plugin if one is
+ * loaded.
+ */
+template <class Traits>
+PluginLoaderType<Traits>::~PluginLoaderType(void) {
+    Unload();
+}
+
+/**
+ * Load the plugin.
+ *
+ * Open the plugin library at the given path and create an instance of the
+ * plugin, through the version 2 factories if present.
+ * @param pLibPath The path of the plugin library.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully loaded the plugin.
+ * @retval 1 Failed to open the plugin library.
+ * @retval 2 Failed to find the create symbol in the plugin library.
+ * @retval 3 Failed to find the destroy symbol in the plugin library.
+ * @retval 4 Failed to create an instance of the plugin.
+ */
+template <class Traits>
+int PluginLoaderType<Traits>::Load(const char *pLibPath) {
+    typename Traits::CreateV2FuncT pV2CreateFunc;
+    typename Traits::CreateFuncT pCreateFunc;
+    typename Traits::DestroyFuncT pDestroyFunc;
+    typename Traits::PluginT *pV1Plugin;
+
+    Unload();
+    error.clear();
+
+    libHandle = dlopen(pLibPath, RTLD_LAZY);
+    if (!libHandle) {
+        SaveDlError();
+        return 1;
+    }
+
+    // I first look for the version 2 factories. A plugin which refuses the
+    // version of the interface it is asked for falls back on version 1.
+    pV2CreateFunc = (typename Traits::CreateV2FuncT)dlsym(libHandle,
+        Traits::GetCreateV2Symbol());
+    pV2DestroyFunc = (typename Traits::DestroyV2FuncT)dlsym(libHandle,
+        Traits::GetDestroyV2Symbol());
+    if (pV2CreateFunc && pV2DestroyFunc) {
+        pPlugin = pV2CreateFunc(PLUGIN_API_VERSION);
+        if (pPlugin) {
+            isV2 = true;
+            return 0;
+        }
+    }
+    pV2DestroyFunc = NULL;
+
+    pCreateFunc = (typename Traits::CreateFuncT)dlsym(libHandle,
+        Traits::GetCreateSymbol());
+    if (!pCreateFunc) {
+        SaveDlError();
+        Unload();
+        return 2;
+    }
+
+    pDestroyFunc = (typename Traits::DestroyFuncT)dlsym(libHandle,
+        Traits::GetDestroySymbol());
+    if (!pDestroyFunc) {
+        SaveDlError();
+        Unload();
+        return 3;
+    }
+
+    pV1Plugin = pCreateFunc();
+    if (!pV1Plugin) {
+        Unload();
+        return 4;
+    }
+
+    pPlugin = new PluginV1AdapterType<Traits>(pV1Plugin, pDestroyFunc);
+    return 0;
+}
+
+/**
+ * Load the plugin in a host process.
+ *
+ * Fork a host process which loads the plugin library at the given path the
+ * same way Load does and answers the requests for it, and use the plugin
+ * through a proxy talking to the host over shared memory.
+ * @param pLibPath The path of the plugin library.
+ * @param timeoutSecs The number of seconds the host may take to answer a
+ * request before it is killed, zero to wait as long as it is alive.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully loaded the plugin.
+ * @retval 1 Failed to open the plugin library.
+ * @retval 2 Failed to find the create symbol in the plugin library.
+ * @retval 3 Failed to find the destroy symbol in the plugin library.
+ * @retval 4 Failed to create an instance of the plugin.
+ * @retval 5 Failed to start the host process.
+ */
+template <class Traits>
+int PluginLoaderType<Traits>::LoadHosted(const char *pLibPath,
+                                         unsigned int timeoutSecs) {
+    pid_t parentPid;
+    pid_t hostPid;
+    int retval;
+
+    Unload();
+    error.clear();
+
+    pChannel = new PluginChannelType();
+    if (pChannel->Create() != 0) {
+        error = "Failed to create the plugin host channel.";
+        Unload();
+        return 5;
+    }
+
+    // Anything buffered would otherwise be written out by both processes.
+    std::cout.flush();
+
+    parentPid = getpid();
+    hostPid = fork();
+    if (hostPid < 0) {
+        error = "Failed to fork the plugin host.";
+        Unload();
+        return 5;
+    }
+
+    if (hostPid == 0) {
+        // I am the host. I load the plugin into myself and serve it until
+        // zync is done with it, and never return into the code of zync.
+        PluginLoaderType<Traits> hostLoader;
+
+        pChannel->SetSide(true, parentPid);
+        retval = hostLoader.Load(pLibPath);
+        PluginHostType<Traits>::Serve(*pChannel, retval, hostLoader.error,
+                                      hostLoader.isV2, hostLoader.pPlugin);
+        hostLoader.Unload();
+        std::cout.flush();
+        _exit(0);
+    }
+
+    pChannel->SetSide(false, hostPid);
+    pChannel->SetTimeout(timeoutSecs);
+    pProxy = new PluginProxyType<Traits>(*pChannel);
+    pPlugin = pProxy;
+
+    retval = pProxy->Connect(error);
+    if (retval == HOST_CALL_FAILED) {
+        error = "The plugin host exited before loading the plugin.";
+        Unload();
+        return 5;
+    } else if (retval != 0) {
+        Unload();
+        return retval;
+    }
+
+    isV2 = pProxy->IsHostV2();
+    return 0;
+}
+
+/**
+ * Unload the plugin.
+ *
+ * Destroy the instance of the plugin and close the plugin library, if they
+ * exist.
+ */
+template <class Traits>
+void PluginLoaderType<Traits>::Unload(void) {
+    if (pChannel) {
+        // I ask the host to quit and give it a moment to clean up after the
+        // plugin before killing it.
+        if (pProxy) {
+            pProxy->Quit();
+            delete pProxy;
+            pProxy = NULL;
+            pPlugin = NULL;
+        }
+        pChannel->Close();
+        pChannel->WaitPeerExit(5);
+        delete pChannel;
+        pChannel = NULL;
+    }
+
+    if (pPlugin) {
+        if (pV2DestroyFunc)
+            pV2DestroyFunc(pPlugin);
+        else
+            delete pPlugin;
+        pPlugin = NULL;
+    }
+    pV2DestroyFunc = NULL;
+    isV2 = false;
+
+    if (libHandle) {
+        dlclose(libHandle);
+        libHandle = NULL;
+    }
+}
+
+/**
+ * Save the dynamic linking error.
+ *
+ * Save the description of the last dynamic linking error, so that it may be
+ * obtained later with GetError.
+ */
+template <class Traits>
+void PluginLoaderType<Traits>::SaveDlError(void) {
+    const char *pError;
+
+    pError = dlerror();
+    if (pError)
+        error = pError;
+    else
+        error = "Unknown dynamic linking error.";
+}
+
+/**
+ * Get all items.
+ *
+ * Add all the items of the plugin to the given list.
+ * @param itemList Reference to the list to add the items to.
+ * @return An integer representing success (zero) or failure (non-zero).
+ */
+template <class Traits>
+int PluginLoaderType<Traits>::GetAllItems(typename ItemT::List &itemList) {
+    ItemListSinkType<ItemT> sink(itemList);
+    return pPlugin->ExportAllItems(sink);
+}
+
+/**
+ * Get the new items.
+ *
+ * Add the items of the plugin created since the last synchronization to the
+ * given list.
+ * @param lastTimeSynced The last time synchronized represented as number of
+ * seconds since epoch.
+ * @param itemList Reference to the list to add the items to.
+ * @return An integer representing success (zero) or failure (non-zero).
+ */
+template <class Traits>
+int PluginLoaderType<Traits>::GetNewItems(time_t lastTimeSynced,
+                                          typename ItemT::List &itemList) {
+    ItemListSinkType<ItemT> sink(itemList);
+    return pPlugin->ExportNewItems(lastTimeSynced, sink);
+}
+
+/**
+ * Get the modified items.
+ *
+ * Add the items of the plugin modified since the last synchronization to
+ * the given list.
+ * @param lastTimeSynced The last time synchronized represented as number of
+ * seconds since epoch.
+ * @param itemList Reference to the list to add the items to.
+ * @return An integer representing success (zero) or failure (non-zero).
+ */
+template <class Traits>
+int PluginLoaderType<Traits>::GetModItems(time_t lastTimeSynced,
+                                          typename ItemT::List &itemList) {
+    ItemListSinkType<ItemT> sink(itemList);
+    return pPlugin->ExportModItems(lastTimeSynced, sink);
+}
+
+/**
+ * Get the deleted item IDs.
+ *
+ * Add the sync IDs of the items deleted from the plugin since the last
+ * synchronization to the given list.
+ * @param lastTimeSynced The last time synchronized represented as number of
+ * seconds since epoch.
+ * @param syncIDList Reference to the list to add the sync IDs to.
+ * @return An integer representing success (zero) or failure (non-zero).
+ */
+template <class Traits>
+int PluginLoaderType<Traits>::GetDelItemIDs(time_t lastTimeSynced,
+                                            SyncIDListType &syncIDList) {
+    return pPlugin->GetDelItemIDs(lastTimeSynced, syncIDList);
+}
+
+/**
+ * Add items.
+ *
+ * Add the given items to the plugin in batches.
+ * @param itemList Reference to the list of items to add, it holds the same
+ * items once done.
+ * @return An integer representing success (zero) or failure (non-zero).
+ */
+template <class Traits>
+int PluginLoaderType<Traits>::AddItems(typename ItemT::List &itemList) {
+    return HandInBatches(&PluginV2T::AddItems, itemList);
+}
+
+/**
+ * Modify items.
+ *
+ * Modify the given items in the plugin in batches.
+ * @param itemList Reference to the list of items to modify, it holds the
+ * same items once done.
+ * @return An integer representing success (zero) or failure (non-zero).
+ */
+template <class Traits>
+int PluginLoaderType<Traits>::ModItems(typename ItemT::List &itemList) {
+    return HandInBatches(&PluginV2T::ModItems, itemList);
+}
+
+/**
+ * Delete items.
+ *
+ * Delete the items with the given sync IDs from the plugin in batches.
+ * @param syncIDList Reference to the list of sync IDs of the items to
+ * delete, it holds the same sync IDs once done.
+ * @return An integer representing success (zero) or failure (non-zero).
+ */
+template <class Traits>
+int PluginLoaderType<Traits>::DelItems(SyncIDListType &syncIDList) {
+    return HandInBatches(&PluginV2T::DelItems, syncIDList);
+}
+
+/**
+ * Map the item IDs.
+ *
+ * Map the IDs of the given items in the plugin in batches.
+ * @param itemList Reference to the list of items which need their IDs
+ * mapped, it holds the same items once done.
+ * @return An integer representing success (zero) or failure (non-zero).
+ */
+template <class Traits>
+int PluginLoaderType<Traits>::MapItemIDs(typename ItemT::List &itemList) {
+    return HandInBatches(&PluginV2T::MapItemIDs, itemList);
+}
+
+/**
+ * Hand a list to the plugin in batches.
+ *
+ * Call the given member function of the plugin with successive batches of
+ * the given list, each no larger than the batch size of the plugin. The
+ * batches are swapped out of the list and back into it once handed over,
+ * so no element is copied. The first batch the plugin fails on stops the
+ * hand over.
+ * @param pFunc Pointer to the member function of the plugin to call.
+ * @param list Reference to the list to hand over, it holds the same
+ * elements in the same order once done.
+ * @return The result of the last call of the member function.
+ */
+template <class Traits>
+template <class ListType>
+int PluginLoaderType<Traits>::HandInBatches(
+    int (PluginV2T::*pFunc)(const ListType &), ListType &list) {
+    typedef typename ListType::value_type ElemType;
+    ListType batchList;
+    typename ListType::iterator batchStart, iter;
+    typename ListType::iterator batchIter;
+    unsigned int batchSize;
+    unsigned int i;
+    int retval = 0;
+
+    batchSize = pPlugin->GetBatchSize();
+    if (batchSize == 0)
+        batchSize = 1;
+
+    // A list which fits in a single batch is simply handed over as is.
+    if (list.size() <= batchSize)
+        return (pPlugin->*pFunc)(list);
+
+    batchStart = list.begin();
+    while ((batchStart != list.end()) && (retval == 0)) {
+        // I swap the elements of the batch out of the list, leaving default
+        // ones in their place, and swap them back once handed over.
+        batchList.clear();
+        iter = batchStart;
+        for (i = 0; (i < batchSize) && (iter != list.end()); i++, ++iter) {
+            batchList.push_back(ElemType());
+            std::swap(batchList.back(), *iter);
+        }
+
+        retval = (pPlugin->*pFunc)(batchList);
+
+        for (batchIter = batchList.begin(); batchIter != batchList.end();
+             ++batchIter, ++batchStart)
+            std::swap(*batchStart, *batchIter);
+    }
+
+    return retval;
+}
+
+#endif
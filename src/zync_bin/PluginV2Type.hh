@@ -0,0 +1,287 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file PluginV2Type.hh
+ * @brief A specifications file for the version 2 plugin interface.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for the class templates existing to provide the
+ * base class of version 2 plugins for the ZaurusSync application, for every
+ * type of item. Version 2 plugins hand items over in batches of a size they
+ * choose, by reference or by splicing lists, rather than copying whole lists
+ * of items across the plugin boundary. A plugin library may provide version
+ * 2 factories alongside the version 1 ones, zync uses version 2 if present.
+ */
+
+#ifndef PLUGINV2TYPE_H
+#define PLUGINV2TYPE_H
+
+#include <time.h>
+#include <string>
+#include <zdata_lib/TodoItemType.hh>
+#include <zdata_lib/CalendarItemType.hh>
+#include <zdata_lib/AddrBookItemType.hh>
+
+// The version of the plugin interface described in this file. It is passed
+// to the version 2 create functions so that a plugin may refuse a version it
+// was not built for.
+#define PLUGIN_API_VERSION 2
+
+/**
+ * @class ItemSinkType
+ * @brief A type existing to receive the items exported by a plugin.
+ *
+ * The ItemSinkType is a class template which zync passes to a plugin to
+ * receive the items the plugin exports, one batch at a time. The items of
+ * each batch are swapped out of the list the plugin hands over, so no item
+ * is copied and the list is left empty for the plugin to fill with the next
+ * batch.
+ */
+template <class ItemT>
+class ItemSinkType {
+public:
+    /**
+     * Destruct the ItemSinkType object.
+     *
+     * Destruct the ItemSinkType object.
+     */
+    virtual ~ItemSinkType(void) { };
+
+    /**
+     * Take a batch of items.
+     *
+     * Take all of the items in the passed list, leaving it empty.
+     * @param batch Reference to the list of items to take.
+     * @return An integer representing success (zero) or failure (non-zero).
+     * A plugin should stop exporting if a batch is not taken.
+     */
+    virtual int TakeBatch(typename ItemT::List &batch) = 0;
+};
+
+/**
+ * @class PluginV2Type
+ * @brief A type existing as a template for version 2 plugins.
+ *
+ * The PluginV2Type is a class template which exists to be the base class of
+ * version 2 plugins, for the type of item it is instantiated with. Items are
+ * exported to an ItemSinkType in batches, and are imported from zync by
+ * const reference in batches no larger than the batch size the plugin asks
+ * for.
+ */
+template <class ItemT>
+class PluginV2Type {
+public:
+    /**
+     * Destruct the PluginV2Type object.
+     *
+     * Destruct the PluginV2Type object by freeing any dynamically allocated
+     * memory.
+     */
+    virtual ~PluginV2Type(void) { };
+
+    /**
+     * Initialize the plugin.
+     *
+     * Initialize the plugin in any way needed before the normal
+     * synchronization based member functions start getting called.
+     * @return An integer representing success (zero) or failure (non-zero).
+     */
+    virtual int Initialize(void) = 0;
+
+    /**
+     * Clean up the plugin.
+     *
+     * Clean up the plugin in any way needed after the normal synchronization
+     * based member functions have been called.
+     * @return An integer representing success (zero) or failure (non-zero).
+     */
+    virtual int CleanUp(void) = 0;
+
+    /**
+     * Get the batch size.
+     *
+     * Get the largest number of items the plugin wants handed to it at once.
+     * @return The batch size of the plugin, at least one.
+     */
+    virtual unsigned int GetBatchSize(void) const = 0;
+
+    /**
+     * Export all items.
+     *
+     * Export all the items that exist inside the object which this plugin
+     * represents to the passed sink.
+     * @param sink Reference to the sink to export the items to.
+     * @return An integer representing success (zero) or failure (non-zero).
+     */
+    virtual int ExportAllItems(ItemSinkType<ItemT> &sink) = 0;
+
+    /**
+     * Export the new items.
+     *
+     * Export the items that were created after the last synchronization to
+     * the passed sink.
+     * @param lastTimeSynced The last time synchronized represented as number
+     * of seconds since epoch.
+     * @param sink Reference to the sink to export the items to.
+     * @return An integer representing success (zero) or failure (non-zero).
+     */
+    virtual int ExportNewItems(time_t lastTimeSynced,
+                               ItemSinkType<ItemT> &sink) = 0;
+
+    /**
+     * Export the modified items.
+     *
+     * Export the items that were modified after the last synchronization to
+     * the passed sink.
+     * @param lastTimeSynced The last time synchronized represented as number
+     * of seconds since epoch.
+     * @param sink Reference to the sink to export the items to.
+     * @return An integer representing success (zero) or failure (non-zero).
+     */
+    virtual int ExportModItems(time_t lastTimeSynced,
+                               ItemSinkType<ItemT> &sink) = 0;
+
+    /**
+     * Get the deleted item IDs.
+     *
+     * Obtain the sync IDs of the items that were deleted after the last
+     * synchronization.
+     * @param lastTimeSynced The last time synchronized represented as number
+     * of seconds since epoch.
+     * @param syncIDList Reference to the list to add the sync IDs to.
+     * @return An integer representing success (zero) or failure (non-zero).
+     */
+    virtual int GetDelItemIDs(time_t lastTimeSynced,
+                              SyncIDListType &syncIDList) = 0;
+
+    /**
+     * Add a batch of items.
+     *
+     * Add the items within the passed batch to the component represented by
+     * the plugin.
+     * @param batch Reference to the batch of items to add.
+     * @return An integer representing success (zero) or failure (non-zero).
+     */
+    virtual int AddItems(const typename ItemT::List &batch) = 0;
+
+    /**
+     * Modify a batch of items.
+     *
+     * Modify the items within the passed batch in the component represented
+     * by the plugin.
+     * @param batch Reference to the batch of items to modify.
+     * @return An integer representing success (zero) or failure (non-zero).
+     */
+    virtual int ModItems(const typename ItemT::List &batch) = 0;
+
+    /**
+     * Delete a batch of items.
+     *
+     * Delete the items that have the sync IDs contained in the passed batch
+     * from the component represented by the plugin.
+     * @param batch Reference to the batch of sync IDs of the items to delete.
+     * @return An integer representing success (zero) or failure (non-zero).
+     */
+    virtual int DelItems(const SyncIDListType &batch) = 0;
+
+    /**
+     * Map the Item IDs
+     *
+     * Map the Item IDs between the Zaurus and the Desktop PIM application.
+     * @param batch Reference to the batch of items which need their IDs
+     * mapped.
+     * @return An integer representing success (zero) or failure (non-zero).
+     */
+    virtual int MapItemIDs(const typename ItemT::List &batch) = 0;
+
+    /**
+     * Get plugin description.
+     *
+     * Get the description of the plugin.
+     * @return The plugin's description.
+     */
+    virtual std::string GetPluginDescription(void) const = 0;
+
+    /**
+     * Get plugin name.
+     *
+     * Get the name of the plugin.
+     * @return The plugin's name.
+     */
+    virtual std::string GetPluginName(void) const = 0;
+
+    /**
+     * Get the plugin author.
+     *
+     * Get the author of the plugin.
+     * @return The plugin's author.
+     */
+    virtual std::string GetPluginAuthor(void) const = 0;
+
+    /**
+     * Get the plugin version.
+     *
+     * Get the version of the plugin.
+     * @return The plugin's version.
+     */
+    virtual std::string GetPluginVersion(void) const = 0;
+};
+
+typedef PluginV2Type<TodoItemType> TodoPluginV2Type;
+typedef PluginV2Type<CalendarItemType> CalendarPluginV2Type;
+typedef PluginV2Type<AddrBookItemType> AddrBookPluginV2Type;
+
+typedef TodoPluginV2Type* (*create_todo_v2_t)(unsigned int);
+typedef void (*destroy_todo_v2_t)(TodoPluginV2Type*);
+typedef CalendarPluginV2Type* (*create_cal_v2_t)(unsigned int);
+typedef void (*destroy_cal_v2_t)(CalendarPluginV2Type*);
+typedef AddrBookPluginV2Type* (*create_addr_v2_t)(unsigned int);
+typedef void (*destroy_addr_v2_t)(AddrBookPluginV2Type*);
+
+/**
+ * Create version 2 plugin instances.
+ *
+ * Create an instance of the version 2 plugin of the respective type of item.
+ * These functions exist so that the C++ class object can be obtained from
+ * the library dynamically. A plugin library only has to provide the ones for
+ * the types of items it handles.
+ * @param apiVersion The version of the plugin interface zync was built with.
+ * @return A pointer to the instance of the plugin, or NULL if the plugin
+ * does not support the requested version of the interface.
+ */
+extern "C" TodoPluginV2Type *createTodoPluginV2(unsigned int apiVersion);
+extern "C" CalendarPluginV2Type *createCalendarPluginV2(
+    unsigned int apiVersion);
+extern "C" AddrBookPluginV2Type *createAddrBookPluginV2(
+    unsigned int apiVersion);
+
+/**
+ * Destroy version 2 plugin instances.
+ *
+ * Destroy the instance pointed to by the pointer passed over, which must
+ * have been created by the respective create function.
+ * @param pPlugin A pointer to an object created with the create function.
+ */
+extern "C" void destroyTodoPluginV2(TodoPluginV2Type *pPlugin);
+extern "C" void destroyCalendarPluginV2(CalendarPluginV2Type *pPlugin);
+extern "C" void destroyAddrBookPluginV2(AddrBookPluginV2Type *pPlugin);
+
+#endif
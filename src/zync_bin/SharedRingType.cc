@@ -0,0 +1,346 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file SharedRingType.cc
+ * @brief An implementation file for a message ring shared between processes.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for a class existing to pass messages from one
+ * process to another through shared memory.
+ */
+
+#include "SharedRingType.hh"
+
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+// The smallest ring created, in bytes.
+#define RING_MIN_CAPACITY 4096
+
+// The length stored in place of a record to mark that the rest of the ring
+// up to its end is unused and the next record is at its start.
+#define RING_PAD 0xffffffffU
+
+/**
+ * Construct a default SharedRingType object.
+ *
+ * Construct a SharedRingType object which has not created its ring yet.
+ */
+SharedRingType::SharedRingType(void) {
+    pHeader = NULL;
+    pData = NULL;
+    mapSize = 0;
+    readSize = 0;
+}
+
+/**
+ * Destruct the SharedRingType object.
+ *
+ * Destruct the SharedRingType object by unmapping the ring. The other
+ * process keeps its own mapping of it.
+ */
+SharedRingType::~SharedRingType(void) {
+    Destroy();
+}
+
+/**
+ * Create the ring.
+ *
+ * Create the ring in anonymous shared memory, so that a process forked
+ * afterwards shares it. The capacity is rounded up to a power of two.
+ * @param minCapacity The minimum number of bytes the ring should hold.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully created the ring.
+ * @retval 1 Failed to map the shared memory.
+ */
+int SharedRingType::Create(uint32_t minCapacity) {
+    uint32_t capacity;
+    void *pMap;
+
+    Destroy();
+
+    capacity = RING_MIN_CAPACITY;
+    while (capacity < minCapacity)
+        capacity = capacity << 1;
+
+    mapSize = sizeof(struct sRingHeader) + capacity;
+    pMap = mmap(NULL, mapSize, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (pMap == MAP_FAILED) {
+        mapSize = 0;
+        return 1;
+    }
+
+    pHeader = (struct sRingHeader *)pMap;
+    pData = (char *)pMap + sizeof(struct sRingHeader);
+    pHeader->head = 0;
+    pHeader->tail = 0;
+    pHeader->closed = 0;
+    pHeader->capacity = capacity;
+    readSize = 0;
+
+    return 0;
+}
+
+/**
+ * Destroy the ring.
+ *
+ * Unmap the ring from this process, if it is mapped.
+ */
+void SharedRingType::Destroy(void) {
+    if (pHeader) {
+        munmap((void *)pHeader, mapSize);
+        pHeader = NULL;
+        pData = NULL;
+        mapSize = 0;
+        readSize = 0;
+    }
+}
+
+/**
+ * Get the maximum message size.
+ *
+ * Get the size of the largest message which may be written to the ring. It
+ * is kept to half the ring, so that a message always fits once the ring is
+ * empty no matter where it has to start.
+ * @return The size of the largest message in bytes.
+ */
+uint32_t SharedRingType::GetMaxMessageSize(void) const {
+    if (!pHeader)
+        return 0;
+
+    return (pHeader->capacity / 2) - sizeof(uint32_t);
+}
+
+/**
+ * Write a message.
+ *
+ * Write a copy of the given message to the ring, waiting for room if the
+ * ring is full.
+ * @param pMsg Pointer to the message to write.
+ * @param size The size of the message in bytes.
+ * @param timeoutMs The number of milliseconds to wait for room at most.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully wrote the message.
+ * @retval 1 Failed, the ring has not been created.
+ * @retval 2 Failed, timed out waiting for room.
+ * @retval 3 Failed, the message is larger than the maximum message size.
+ */
+int SharedRingType::Write(const char *pMsg, uint32_t size,
+                          unsigned int timeoutMs) {
+    unsigned int numWaits = 0;
+    uint64_t deadlineMs;
+    uint32_t recSize, contig, needed, offset, head, tail;
+
+    if (!pHeader)
+        return 1;
+
+    if (size > GetMaxMessageSize())
+        return 3;
+
+    recSize = GetRecordSize(size);
+    deadlineMs = GetTimeMs() + timeoutMs;
+
+    while (true) {
+        head = pHeader->head;
+        tail = pHeader->tail;
+        offset = tail & (pHeader->capacity - 1);
+        contig = pHeader->capacity - offset;
+
+        // A record which does not fit before the end of the ring also uses
+        // up the rest of it.
+        needed = recSize;
+        if (contig < recSize)
+            needed = contig + recSize;
+
+        if ((pHeader->capacity - (tail - head)) >= needed)
+            break;
+
+        if (!Backoff(numWaits, deadlineMs))
+            return 2;
+    }
+
+    // I make sure the reader is done with the space it released before I
+    // write over it.
+    __sync_synchronize();
+
+    if (contig < recSize) {
+        *(uint32_t *)(pData + offset) = RING_PAD;
+        tail += contig;
+        offset = 0;
+    }
+
+    *(uint32_t *)(pData + offset) = size;
+    memcpy(pData + offset + sizeof(uint32_t), pMsg, size);
+
+    // The message has to be visible before the position exposing it.
+    __sync_synchronize();
+    pHeader->tail = tail + recSize;
+
+    return 0;
+}
+
+/**
+ * Read a message.
+ *
+ * Obtain the next message in the ring, waiting for one if the ring is
+ * empty. The message is not copied, the pointer handed back points into the
+ * shared memory and stays valid until Release is called. A message which is
+ * still held is released by the next Read.
+ * @param pMsg Reference to store the pointer to the message in.
+ * @param size Reference to store the size of the message in.
+ * @param timeoutMs The number of milliseconds to wait for a message at most.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully read a message.
+ * @retval 1 Failed, the ring is closed and empty or was never created.
+ * @retval 2 Failed, timed out waiting for a message.
+ */
+int SharedRingType::Read(const char *&pMsg, uint32_t &size,
+                         unsigned int timeoutMs) {
+    unsigned int numWaits = 0;
+    uint64_t deadlineMs;
+    uint32_t len, offset, head;
+
+    if (!pHeader)
+        return 1;
+
+    if (readSize != 0)
+        Release();
+
+    deadlineMs = GetTimeMs() + timeoutMs;
+
+    while (true) {
+        head = pHeader->head;
+        if (pHeader->tail != head) {
+            // The message has to be read after the position exposing it.
+            __sync_synchronize();
+
+            offset = head & (pHeader->capacity - 1);
+            len = *(uint32_t *)(pData + offset);
+            if (len == RING_PAD) {
+                pHeader->head = head + (pHeader->capacity - offset);
+                continue;
+            }
+
+            pMsg = pData + offset + sizeof(uint32_t);
+            size = len;
+            readSize = GetRecordSize(len);
+            return 0;
+        }
+
+        if (pHeader->closed) {
+            // The writer publishes its last message before closing, so the
+            // ring is only really empty if it still is now.
+            __sync_synchronize();
+            if (pHeader->tail == head)
+                return 1;
+            continue;
+        }
+
+        if (!Backoff(numWaits, deadlineMs))
+            return 2;
+    }
+}
+
+/**
+ * Release the message read.
+ *
+ * Hand the space of the message obtained by the last Read back to the
+ * writer. The pointer to the message may not be used afterwards.
+ */
+void SharedRingType::Release(void) {
+    if (!pHeader || (readSize == 0))
+        return;
+
+    // I have to be done reading the message before the writer may reuse it.
+    __sync_synchronize();
+    pHeader->head = pHeader->head + readSize;
+    readSize = 0;
+}
+
+/**
+ * Close the ring.
+ *
+ * Mark that the writer will not write any more messages. The reader still
+ * gets the messages already in the ring.
+ */
+void SharedRingType::Close(void) {
+    if (!pHeader)
+        return;
+
+    __sync_synchronize();
+    pHeader->closed = 1;
+}
+
+/**
+ * Get the record size.
+ *
+ * Get the number of bytes of the ring a message of the given size takes up,
+ * its length and contents rounded up to keep records aligned.
+ * @param size The size of the message in bytes.
+ * @return The size of the record in bytes.
+ */
+uint32_t SharedRingType::GetRecordSize(uint32_t size) {
+    return (uint32_t)(sizeof(uint32_t) + ((size + 3) & ~3U));
+}
+
+/**
+ * Get the current time.
+ *
+ * Get the current time in milliseconds, used to time waits.
+ * @return The current time in milliseconds since Epoch.
+ */
+uint64_t SharedRingType::GetTimeMs(void) {
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return ((uint64_t)now.tv_sec * 1000) + (uint64_t)(now.tv_usec / 1000);
+}
+
+/**
+ * Back off while waiting on the other process.
+ *
+ * Give up the processor while waiting on the other side of the ring, the
+ * same way the ItemQueueType does, unless the wait has timed out.
+ * @param numWaits Reference to the number of times the caller has waited.
+ * @param deadlineMs The time in milliseconds at which the wait times out.
+ * @return True if the caller should keep waiting, false if it timed out.
+ */
+bool SharedRingType::Backoff(unsigned int &numWaits, uint64_t deadlineMs) {
+    struct timespec delay;
+
+    if (numWaits < 64) {
+        sched_yield();
+    } else {
+        if (GetTimeMs() >= deadlineMs)
+            return false;
+
+        delay.tv_sec = 0;
+        delay.tv_nsec = 200000;
+        nanosleep(&delay, NULL);
+    }
+
+    numWaits++;
+    return true;
+}
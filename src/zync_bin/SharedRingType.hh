@@ -0,0 +1,94 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file SharedRingType.hh
+ * @brief A specifications file for a message ring shared between processes.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class existing to pass messages from one
+ * process to another through shared memory.
+ */
+
+#ifndef SHAREDRINGTYPE_H
+#define SHAREDRINGTYPE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+/**
+ * @class SharedRingType
+ * @brief A single producer, single consumer ring of messages.
+ *
+ * The SharedRingType is a class which represents a ring buffer of variable
+ * sized messages in anonymous shared memory. It is created before a fork so
+ * that the parent and child processes share it, one of them writing to it
+ * and the other reading from it. Like the ItemQueueType, the read and write
+ * positions are each only ever written by one side and a memory barrier
+ * publishes a message before the position that exposes it. A message is
+ * never split across the end of the ring, so a reader is handed a pointer
+ * straight into the shared memory and nothing is copied until it decodes
+ * the message. Every wait takes a timeout, so that the caller may check
+ * that the other process is still alive.
+ */
+class SharedRingType {
+public:
+    SharedRingType(void);
+    ~SharedRingType(void);
+
+    int Create(uint32_t minCapacity);
+    void Destroy(void);
+
+    uint32_t GetMaxMessageSize(void) const;
+
+    int Write(const char *pMsg, uint32_t size, unsigned int timeoutMs);
+    int Read(const char *&pMsg, uint32_t &size, unsigned int timeoutMs);
+    void Release(void);
+    void Close(void);
+
+    static uint64_t GetTimeMs(void);
+
+private:
+    // The ring owns its shared memory, so it may not be copied.
+    SharedRingType(const SharedRingType &);
+    SharedRingType &operator=(const SharedRingType &);
+
+    struct sRingHeader {
+        // The number of bytes ever read. Only the reader writes it.
+        volatile uint32_t head;
+        // The number of bytes ever written. Only the writer writes it.
+        volatile uint32_t tail;
+        // Set by the writer once it will not write any more messages.
+        volatile uint32_t closed;
+        uint32_t capacity;
+    };
+
+    static uint32_t GetRecordSize(uint32_t size);
+    static bool Backoff(unsigned int &numWaits, uint64_t deadlineMs);
+
+    struct sRingHeader *pHeader;
+    char *pData;
+    size_t mapSize;
+
+    // The size of the record handed out by Read and not yet released.
+    uint32_t readSize;
+};
+
+#endif
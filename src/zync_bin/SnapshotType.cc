@@ -0,0 +1,210 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file SnapshotType.cc
+ * @brief An implementation file for a snapshot of the desktop items.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for a class existing to record the state of the
+ * desktop items at the end of a synchronization, so that the changes made
+ * to them since can be found by comparing against it.
+ */
+
+#include "SnapshotType.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+// The magic bytes and version at the front of every snapshot file.
+#define SNAPSHOT_MAGIC "ZSNP"
+#define SNAPSHOT_MAGIC_SIZE 4
+#define SNAPSHOT_VERSION 0x02
+
+// The layout of the header of the snapshot file, the entries follow it. The
+// snapshot is local to this machine so it is simply stored in host byte
+// order. The device key identifies the Zaurus the snapshot was taken for.
+struct sSnapshotHeader {
+    char magic[SNAPSHOT_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t device;
+};
+
+/**
+ * Construct a default SnapshotType object.
+ *
+ * Construct a SnapshotType object holding an empty snapshot.
+ */
+SnapshotType::SnapshotType(void) {
+
+}
+
+/**
+ * Load the snapshot.
+ *
+ * Load the snapshot from the file at the given path. A snapshot taken for a
+ * different device is refused.
+ * @param snapshotPath The path of the snapshot file.
+ * @param device The key identifying the Zaurus being synchronized.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully loaded the snapshot.
+ * @retval 1 Failed to open the snapshot file, there may not be one yet.
+ * @retval 2 The snapshot file does not hold a valid snapshot.
+ * @retval 3 The snapshot file belongs to a different device.
+ */
+int SnapshotType::Load(const std::string &snapshotPath, uint64_t device) {
+    struct sSnapshotHeader header;
+    struct stat fileStat;
+    size_t size;
+    ssize_t numRead;
+    unsigned int i;
+    int fd;
+
+    entries.clear();
+
+    fd = open(snapshotPath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return 1;
+
+    if ((fstat(fd, &fileStat) != 0) ||
+        (read(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) ||
+        (memcmp(header.magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_SIZE) != 0) ||
+        (header.version != SNAPSHOT_VERSION) ||
+        ((size_t)fileStat.st_size != sizeof(header) +
+            (size_t)header.count * sizeof(struct sEntry))) {
+        close(fd);
+        return 2;
+    }
+
+    if (header.device != device) {
+        close(fd);
+        return 3;
+    }
+
+    entries.resize(header.count);
+    size = (size_t)header.count * sizeof(struct sEntry);
+    numRead = 0;
+    if (size > 0)
+        numRead = read(fd, &entries[0], size);
+    close(fd);
+
+    if (numRead != (ssize_t)size) {
+        entries.clear();
+        return 2;
+    }
+
+    // The diff relies on the entries being sorted, so I do not trust a
+    // snapshot whose entries are not.
+    for (i = 1; i < entries.size(); i++) {
+        if (entries[i].key < entries[i - 1].key) {
+            entries.clear();
+            return 2;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Save the snapshot.
+ *
+ * Save the snapshot to the file at the given path. The snapshot is written
+ * to a new file which then replaces the old one, so the old snapshot is left
+ * untouched if zync dies part way through.
+ * @param snapshotPath The path of the snapshot file.
+ * @param device The key identifying the Zaurus being synchronized.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully saved the snapshot.
+ * @retval 1 Failed to create the new snapshot file.
+ * @retval 2 Failed to write the new snapshot file.
+ * @retval 3 Failed to replace the old snapshot file.
+ */
+int SnapshotType::Save(const std::string &snapshotPath,
+                       uint64_t device) const {
+    struct sSnapshotHeader header;
+    std::string tmpPath;
+    size_t size;
+    int fd;
+
+    tmpPath = snapshotPath + ".tmp";
+    fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        return 1;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_SIZE);
+    header.version = SNAPSHOT_VERSION;
+    header.count = (uint32_t)entries.size();
+    header.device = device;
+
+    size = entries.size() * sizeof(struct sEntry);
+    if ((write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) ||
+        ((size > 0) &&
+            (write(fd, &entries[0], size) != (ssize_t)size)) ||
+        (fsync(fd) != 0)) {
+        close(fd);
+        unlink(tmpPath.c_str());
+        return 2;
+    }
+    close(fd);
+
+    if (rename(tmpPath.c_str(), snapshotPath.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return 3;
+    }
+
+    return 0;
+}
+
+/**
+ * Get the number of items in the snapshot.
+ *
+ * Get the number of items the snapshot holds.
+ * @return The number of items in the snapshot.
+ */
+unsigned long int SnapshotType::GetCount(void) const {
+    return (unsigned long int)entries.size();
+}
+
+/**
+ * Hash an app ID.
+ *
+ * Hash the given app ID into the key the snapshot is sorted by. The hash is
+ * 64 bits wide so that two app IDs of the same plugin do not collide in
+ * practice.
+ * @param appID The app ID to hash.
+ * @return The hash of the app ID.
+ */
+uint64_t SnapshotType::HashAppID(const std::string &appID) {
+    uint64_t hash = ITEM_HASH_SEED;
+    std::string::size_type i;
+
+    for (i = 0; i < appID.size(); i++) {
+        hash ^= (unsigned char)appID[i];
+        hash *= ITEM_HASH_PRIME;
+    }
+
+    return hash;
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file SnapshotType.hh
+ * @brief A specifications file for a snapshot of the desktop items.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class existing to record the state of the
+ * desktop items at the end of a synchronization, so that the changes made
+ * to them since can be found by comparing against it rather than asking the
+ * plugin.
+ */
+
+#ifndef SNAPSHOTTYPE_H
+#define SNAPSHOTTYPE_H
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <zdata_lib/ItemType.hh>
+
+/**
+ * @class SnapshotType
+ * @brief A type representing a snapshot of the desktop items.
+ *
+ * The SnapshotType is a class which represents a compact snapshot of the
+ * items of a plugin. For each item it only holds a hash of its app ID, its
+ * content hash and its sync ID, sorted by the app ID hash. Comparing it with
+ * every item the plugin currently has is a single merge of two sorted
+ * sequences, which yields the items that were added, modified and deleted
+ * since the snapshot was taken. Hence, the plugin only has to be able to
+ * export all of its items. Items without an app ID can not be told apart
+ * from one snapshot to the next, so they are left out.
+ */
+class SnapshotType {
+public:
+    SnapshotType(void);
+
+    int Load(const std::string &snapshotPath, uint64_t device);
+    int Save(const std::string &snapshotPath, uint64_t device) const;
+
+    unsigned long int GetCount(void) const;
+
+    template <class ListType>
+    void Take(const ListType &itemList);
+
+    template <class ListType>
+    void Diff(const ListType &itemList, ListType &newList, ListType &modList,
+              SyncIDListType &delIDList) const;
+
+private:
+    struct sEntry {
+        uint64_t key;
+        uint64_t hash;
+        uint64_t syncID;
+
+        bool operator<(const struct sEntry &other) const {
+            return key < other.key;
+        }
+    };
+
+    // Orders pairs by their first member alone, the key.
+    template <class PairT>
+    struct sKeyLess {
+        bool operator()(const PairT &a, const PairT &b) const {
+            return a.first < b.first;
+        }
+    };
+
+    static uint64_t HashAppID(const std::string &appID);
+
+    std::vector<struct sEntry> entries;
+};
+
+/**
+ * Take a snapshot.
+ *
+ * Replace the snapshot with one of the given items, normally every item the
+ * plugin has at the end of a synchronization.
+ * @param itemList Reference to the list of items to take the snapshot of.
+ */
+template <class ListType>
+void SnapshotType::Take(const ListType &itemList) {
+    typename ListType::const_iterator iter;
+    struct sEntry entry;
+
+    entries.clear();
+    entries.reserve(itemList.size());
+    for (iter = itemList.begin(); iter != itemList.end(); ++iter) {
+        if ((*iter).GetAppID().empty())
+            continue;
+
+        entry.key = HashAppID((*iter).GetAppID());
+        entry.hash = (*iter).ContentHash();
+        entry.syncID = (*iter).GetSyncID();
+        entries.push_back(entry);
+    }
+
+    std::sort(entries.begin(), entries.end());
+}
+
+/**
+ * Diff against the snapshot.
+ *
+ * Compare the given items, normally every item the plugin currently has,
+ * against the snapshot. Items not in the snapshot are added to the new item
+ * list, and items whose content hash differs from the snapshot are added to
+ * the modified item list. The sync IDs of the items in the snapshot which
+ * are no longer there are added to the deleted ID list, unless they were
+ * never on the Zaurus.
+ * @param itemList Reference to the list of current items.
+ * @param newList Reference to the list to add the new items to.
+ * @param modList Reference to the list to add the modified items to.
+ * @param delIDList Reference to the list to add the sync IDs of the deleted
+ * items to.
+ */
+template <class ListType>
+void SnapshotType::Diff(const ListType &itemList, ListType &newList,
+                        ListType &modList, SyncIDListType &delIDList) const {
+    typedef std::pair<uint64_t, typename ListType::const_iterator> KeyPairT;
+    std::vector<KeyPairT> curKeys;
+    typename ListType::const_iterator iter;
+    unsigned int cur = 0;
+    unsigned int snap = 0;
+
+    curKeys.reserve(itemList.size());
+    for (iter = itemList.begin(); iter != itemList.end(); ++iter) {
+        if ((*iter).GetAppID().empty())
+            continue;
+        curKeys.push_back(std::make_pair(HashAppID((*iter).GetAppID()),
+                                         iter));
+    }
+    std::sort(curKeys.begin(), curKeys.end(), sKeyLess<KeyPairT>());
+
+    // Here, I walk the current items and the snapshot side by side, both
+    // sorted by the hash of the app ID.
+    while ((cur < curKeys.size()) || (snap < entries.size())) {
+        if ((snap == entries.size()) ||
+            ((cur < curKeys.size()) && (curKeys[cur].first <
+                entries[snap].key))) {
+            newList.push_back(*(curKeys[cur].second));
+            cur++;
+        } else if ((cur == curKeys.size()) ||
+                   (entries[snap].key < curKeys[cur].first)) {
+            if (entries[snap].syncID != 0)
+                delIDList.push_back((unsigned long int)entries[snap].syncID);
+            snap++;
+        } else {
+            if ((*(curKeys[cur].second)).ContentHash() != entries[snap].hash)
+                modList.push_back(*(curKeys[cur].second));
+            cur++;
+            snap++;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,627 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file SyncStatsType.cc
+ * @brief An implementation file for the statistics of a sync.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for a class existing to record where the time of a
+ * sync goes, both by phase and by protocol exchange with the Zaurus.
+ */
+
+#include "SyncStatsType.hh"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <zmsg.h>
+
+// The upper bounds of the buckets of the round trip histogram, in seconds.
+static const double bucketBounds[STATS_NUM_BUCKETS] = {
+    0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0
+};
+
+/**
+ * Get the time between two times.
+ *
+ * Get the number of seconds from one time to another.
+ * @param pStart Pointer to the earlier time.
+ * @param pEnd Pointer to the later time.
+ * @return The number of seconds between the times.
+ */
+static double GetSeconds(const struct timeval *pStart,
+                         const struct timeval *pEnd) {
+    return (double)(pEnd->tv_sec - pStart->tv_sec) +
+        (double)(pEnd->tv_usec - pStart->tv_usec) / 1000000.0;
+}
+
+/**
+ * Append a quoted string.
+ *
+ * Append a string to the given output in double quotes, escaping it so it
+ * is valid both as a JSON string and as a Prometheus label value.
+ * @param value The string to append.
+ * @param out Reference to the output to append to.
+ */
+static void AppendQuoted(const std::string &value, std::string &out) {
+    std::string::size_type i;
+    char buff[8];
+
+    out += '"';
+    for (i = 0; i < value.size(); i++) {
+        if ((value[i] == '"') || (value[i] == '\\')) {
+            out += '\\';
+            out += value[i];
+        } else if (value[i] == '\n') {
+            out.append("\\n");
+        } else if ((unsigned char)value[i] < 0x20) {
+            snprintf(buff, sizeof(buff), "\\u%04x",
+                     (unsigned int)(unsigned char)value[i]);
+            out.append(buff);
+        } else {
+            out += value[i];
+        }
+    }
+    out += '"';
+}
+
+/**
+ * Append a number of seconds.
+ *
+ * Append a number of seconds to the given output.
+ * @param value The number of seconds to append.
+ * @param out Reference to the output to append to.
+ */
+static void AppendNumber(double value, std::string &out) {
+    char buff[32];
+
+    snprintf(buff, sizeof(buff), "%.6f", value);
+    out.append(buff);
+}
+
+/**
+ * Append a bucket bound.
+ *
+ * Append the upper bound of a bucket of the round trip histogram to the
+ * given output, in its shortest form.
+ * @param value The bound to append.
+ * @param out Reference to the output to append to.
+ */
+static void AppendBound(double value, std::string &out) {
+    char buff[32];
+
+    snprintf(buff, sizeof(buff), "%g", value);
+    out.append(buff);
+}
+
+/**
+ * Append a count.
+ *
+ * Append a count to the given output.
+ * @param value The count to append.
+ * @param out Reference to the output to append to.
+ */
+static void AppendCount(unsigned long int value, std::string &out) {
+    char buff[32];
+
+    snprintf(buff, sizeof(buff), "%lu", value);
+    out.append(buff);
+}
+
+/**
+ * Construct a default SyncStatsType object.
+ *
+ * Construct a default SyncStatsType object, starting the clock of the
+ * sync.
+ */
+SyncStatsType::SyncStatsType(void) {
+    isAttached = false;
+    gettimeofday(&syncStart, NULL);
+    phaseStart = syncStart;
+    current.isOpen = false;
+}
+
+/**
+ * Destruct the SyncStatsType object.
+ *
+ * Destruct the SyncStatsType object, detaching it from the message library
+ * if it is still attached.
+ */
+SyncStatsType::~SyncStatsType(void) {
+    Detach();
+}
+
+/**
+ * Attach to the message library.
+ *
+ * Have the message library report every message sent and received to this
+ * object, so that the exchanges with the Zaurus are recorded. The clock of
+ * the sync is restarted, so that the time spent waiting for the Zaurus to
+ * connect is left out.
+ */
+void SyncStatsType::Attach(void) {
+    gettimeofday(&syncStart, NULL);
+    SetMsgTrace(Trace, this);
+    isAttached = true;
+}
+
+/**
+ * Detach from the message library.
+ *
+ * Stop recording the exchanges with the Zaurus, closing the exchange in
+ * progress if there is one.
+ */
+void SyncStatsType::Detach(void) {
+    if (!isAttached)
+        return;
+
+    SetMsgTrace(NULL, NULL);
+    isAttached = false;
+    CloseExchange();
+}
+
+/**
+ * Set a label.
+ *
+ * Set a label describing the sync, such as the model of the Zaurus, which
+ * is written along with the statistics.
+ * @param pName The name of the label.
+ * @param value The value of the label.
+ */
+void SyncStatsType::SetLabel(const char *pName, const std::string &value) {
+    std::vector<std::pair<std::string, std::string> >::iterator iter;
+
+    for (iter = labels.begin(); iter != labels.end(); ++iter) {
+        if (iter->first == pName) {
+            iter->second = value;
+            return;
+        }
+    }
+
+    labels.push_back(std::make_pair(std::string(pName), value));
+}
+
+/**
+ * Start a phase.
+ *
+ * Start a phase of the sync, ending the one in progress. A phase started
+ * more than once has the time of each run added up.
+ * @param pName The name of the phase.
+ */
+void SyncStatsType::StartPhase(const char *pName) {
+    EndPhase();
+    phaseName.assign(pName);
+    gettimeofday(&phaseStart, NULL);
+}
+
+/**
+ * End a phase.
+ *
+ * End the phase in progress, if there is one, adding the time spent in it
+ * to the time of the phase.
+ */
+void SyncStatsType::EndPhase(void) {
+    std::vector<std::pair<std::string, double> >::iterator iter;
+    struct timeval now;
+    double seconds;
+
+    if (phaseName.empty())
+        return;
+
+    gettimeofday(&now, NULL);
+    seconds = GetSeconds(&phaseStart, &now);
+
+    for (iter = phases.begin(); iter != phases.end(); ++iter) {
+        if (iter->first == phaseName)
+            break;
+    }
+    if (iter == phases.end())
+        phases.push_back(std::make_pair(phaseName, seconds));
+    else
+        iter->second += seconds;
+
+    phaseName.clear();
+}
+
+/**
+ * Format the statistics.
+ *
+ * Format the statistics recorded so far. The phase and exchange in
+ * progress are left out, so the sync should end its last phase and detach
+ * first.
+ * @param format The format, STATS_FORMAT_JSON or STATS_FORMAT_PROMETHEUS.
+ * @param out Reference to the string to append the statistics to.
+ */
+void SyncStatsType::Format(int format, std::string &out) const {
+    if (format == STATS_FORMAT_PROMETHEUS)
+        FormatPrometheus(out);
+    else
+        FormatJSON(out);
+}
+
+/**
+ * Write the statistics.
+ *
+ * Write the statistics recorded so far to the given file. The file is
+ * replaced as a whole, so a reader never sees it half written.
+ * @param statsPath The path of the file to write.
+ * @param format The format, STATS_FORMAT_JSON or STATS_FORMAT_PROMETHEUS.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully wrote the statistics.
+ * @retval 1 Failed to create the new statistics file.
+ * @retval 2 Failed to write the new statistics file.
+ * @retval 3 Failed to replace the old statistics file.
+ */
+int SyncStatsType::Write(const std::string &statsPath, int format) const {
+    std::string tmpPath;
+    std::string out;
+    int fd;
+
+    Format(format, out);
+
+    tmpPath = statsPath + ".tmp";
+    fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return 1;
+
+    if (write(fd, out.data(), out.size()) != (ssize_t)out.size()) {
+        close(fd);
+        unlink(tmpPath.c_str());
+        return 2;
+    }
+    close(fd);
+
+    if (rename(tmpPath.c_str(), statsPath.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return 3;
+    }
+
+    return 0;
+}
+
+/**
+ * Trace a message.
+ *
+ * The function the message library reports messages to, handing them on
+ * to the SyncStatsType object they were attached with.
+ * @param pCtx Pointer to the SyncStatsType object.
+ * @param event The event, one of the MSG_TRACE_ values.
+ * @param pType Pointer to the type of the message, or NULL.
+ * @param numBytes The number of bytes sent or received.
+ * @param waitTime The seconds spent waiting for the message.
+ */
+void SyncStatsType::Trace(void *pCtx, int event, const char *pType,
+                          int numBytes, double waitTime) {
+    ((SyncStatsType *)pCtx)->Record(event, pType, numBytes, waitTime);
+}
+
+/**
+ * Record a message.
+ *
+ * Record a message sent or received in the exchange it belongs to. The
+ * Zaurus asking for a message starts a new exchange, as does a message sent
+ * without being asked for, and the exchange is kept by the type of the
+ * message sent.
+ * @param event The event, one of the MSG_TRACE_ values.
+ * @param pType Pointer to the type of the message, or NULL.
+ * @param numBytes The number of bytes sent or received.
+ * @param waitTime The seconds spent waiting for the message.
+ */
+void SyncStatsType::Record(int event, const char *pType, int numBytes,
+                           double waitTime) {
+    if ((event == MSG_TRACE_RQST) && current.isOpen &&
+        !current.type.empty())
+        CloseExchange();
+    if ((event == MSG_TRACE_SENT) && (pType != NULL) && current.isOpen &&
+        !current.type.empty())
+        CloseExchange();
+    if (!current.isOpen)
+        OpenExchange();
+
+    switch (event) {
+    case MSG_TRACE_SENT:
+        if (pType != NULL)
+            current.type.assign(pType, MSG_TYPE_SIZE);
+        current.bytesOut += numBytes;
+        break;
+    case MSG_TRACE_RQST:
+        current.bytesIn += numBytes;
+        current.rqstWait += waitTime;
+        break;
+    case MSG_TRACE_ACK:
+        current.bytesIn += numBytes;
+        current.ackWait += waitTime;
+        break;
+    case MSG_TRACE_REPLY:
+        current.bytesIn += numBytes;
+        current.replyWait += waitTime;
+        break;
+    }
+}
+
+/**
+ * Open an exchange.
+ *
+ * Start recording a new exchange with the Zaurus.
+ */
+void SyncStatsType::OpenExchange(void) {
+    current.isOpen = true;
+    current.type.clear();
+    current.bytesIn = 0;
+    current.bytesOut = 0;
+    current.rqstWait = 0.0;
+    current.ackWait = 0.0;
+    current.replyWait = 0.0;
+}
+
+/**
+ * Close an exchange.
+ *
+ * Add the exchange in progress to the statistics of its message type. An
+ * exchange in which no message was sent, such as one only answering
+ * requests with Acks, is kept under the type "-".
+ */
+void SyncStatsType::CloseExchange(void) {
+    struct sExchangeStats *pStats;
+    std::map<std::string, struct sExchangeStats>::iterator iter;
+    double roundTrip;
+    unsigned int i;
+
+    if (!current.isOpen)
+        return;
+    current.isOpen = false;
+
+    if (current.type.empty())
+        current.type = "-";
+
+    iter = exchanges.find(current.type);
+    if (iter == exchanges.end()) {
+        pStats = &exchanges[current.type];
+        memset(pStats, 0, sizeof(*pStats));
+    } else {
+        pStats = &iter->second;
+    }
+
+    roundTrip = current.rqstWait + current.ackWait + current.replyWait;
+
+    pStats->count++;
+    pStats->bytesIn += current.bytesIn;
+    pStats->bytesOut += current.bytesOut;
+    pStats->rqstWait += current.rqstWait;
+    pStats->ackWait += current.ackWait;
+    pStats->replyWait += current.replyWait;
+    pStats->roundTrip += roundTrip;
+
+    for (i = 0; i < STATS_NUM_BUCKETS; i++) {
+        if (roundTrip <= bucketBounds[i])
+            break;
+    }
+    pStats->buckets[i]++;
+}
+
+/**
+ * Format the statistics as JSON.
+ *
+ * Format the statistics as a JSON object holding the labels, the total
+ * time, the phases and the exchanges by message type. The buckets of the
+ * round trip histogram count the exchanges falling in each bucket, the last
+ * one having no upper bound.
+ * @param out Reference to the string to append the statistics to.
+ */
+void SyncStatsType::FormatJSON(std::string &out) const {
+    std::vector<std::pair<std::string, std::string> >::const_iterator label;
+    std::vector<std::pair<std::string, double> >::const_iterator phase;
+    std::map<std::string, struct sExchangeStats>::const_iterator iter;
+    struct timeval now;
+    unsigned int i;
+
+    gettimeofday(&now, NULL);
+
+    out.append("{\n  \"labels\": {");
+    for (label = labels.begin(); label != labels.end(); ++label) {
+        out.append((label == labels.begin()) ? "\n    " : ",\n    ");
+        AppendQuoted(label->first, out);
+        out.append(": ");
+        AppendQuoted(label->second, out);
+    }
+    out.append((labels.empty()) ? "},\n" : "\n  },\n");
+
+    out.append("  \"total_seconds\": ");
+    AppendNumber(GetSeconds(&syncStart, &now), out);
+    out.append(",\n");
+
+    out.append("  \"phases\": [");
+    for (phase = phases.begin(); phase != phases.end(); ++phase) {
+        out.append((phase == phases.begin()) ? "\n    " : ",\n    ");
+        out.append("{\"name\": ");
+        AppendQuoted(phase->first, out);
+        out.append(", \"seconds\": ");
+        AppendNumber(phase->second, out);
+        out += '}';
+    }
+    out.append((phases.empty()) ? "],\n" : "\n  ],\n");
+
+    out.append("  \"exchanges\": [");
+    for (iter = exchanges.begin(); iter != exchanges.end(); ++iter) {
+        out.append((iter == exchanges.begin()) ? "\n    " : ",\n    ");
+        out.append("{\"type\": ");
+        AppendQuoted(iter->first, out);
+        out.append(", \"count\": ");
+        AppendCount(iter->second.count, out);
+        out.append(", \"bytes_in\": ");
+        AppendCount(iter->second.bytesIn, out);
+        out.append(", \"bytes_out\": ");
+        AppendCount(iter->second.bytesOut, out);
+        out.append(",\n     \"rqst_wait_seconds\": ");
+        AppendNumber(iter->second.rqstWait, out);
+        out.append(", \"ack_wait_seconds\": ");
+        AppendNumber(iter->second.ackWait, out);
+        out.append(", \"reply_wait_seconds\": ");
+        AppendNumber(iter->second.replyWait, out);
+        out.append(",\n     \"round_trip_seconds\": ");
+        AppendNumber(iter->second.roundTrip, out);
+        out.append(", \"round_trip_buckets\": [");
+        for (i = 0; i <= STATS_NUM_BUCKETS; i++) {
+            if (i > 0)
+                out.append(", ");
+            out.append("{\"le\": ");
+            if (i < STATS_NUM_BUCKETS)
+                AppendBound(bucketBounds[i], out);
+            else
+                out.append("null");
+            out.append(", \"count\": ");
+            AppendCount(iter->second.buckets[i], out);
+            out += '}';
+        }
+        out.append("]}");
+    }
+    out.append((exchanges.empty()) ? "]\n}\n" : "\n  ]\n}\n");
+}
+
+/**
+ * Format the statistics for Prometheus.
+ *
+ * Format the statistics in the Prometheus text format, suitable for the
+ * text file collector of the node exporter. Every sample carries the
+ * labels, and the round trip times are written as a histogram.
+ * @param out Reference to the string to append the statistics to.
+ */
+void SyncStatsType::FormatPrometheus(std::string &out) const {
+    std::vector<std::pair<std::string, std::string> >::const_iterator label;
+    std::vector<std::pair<std::string, double> >::const_iterator phase;
+    std::map<std::string, struct sExchangeStats>::const_iterator iter;
+    std::string common, type;
+    unsigned long int cumulative;
+    struct timeval now;
+    unsigned int i;
+
+    gettimeofday(&now, NULL);
+
+    for (label = labels.begin(); label != labels.end(); ++label) {
+        common.append(label->first);
+        common += '=';
+        AppendQuoted(label->second, common);
+        common += ',';
+    }
+
+    out.append("# HELP zync_sync_seconds Time the sync took.\n");
+    out.append("# TYPE zync_sync_seconds gauge\n");
+    out.append("zync_sync_seconds");
+    if (!common.empty()) {
+        out += '{';
+        out.append(common, 0, common.size() - 1);
+        out += '}';
+    }
+    out += ' ';
+    AppendNumber(GetSeconds(&syncStart, &now), out);
+    out += '\n';
+
+    out.append("# HELP zync_phase_seconds Time spent in each phase of the" \
+               " sync.\n");
+    out.append("# TYPE zync_phase_seconds gauge\n");
+    for (phase = phases.begin(); phase != phases.end(); ++phase) {
+        out.append("zync_phase_seconds{");
+        out.append(common);
+        out.append("phase=");
+        AppendQuoted(phase->first, out);
+        out.append("} ");
+        AppendNumber(phase->second, out);
+        out += '\n';
+    }
+
+    out.append("# HELP zync_exchanges_total Exchanges with the Zaurus by" \
+               " message type.\n");
+    out.append("# TYPE zync_exchanges_total counter\n");
+    for (iter = exchanges.begin(); iter != exchanges.end(); ++iter) {
+        type.assign("type=");
+        AppendQuoted(iter->first, type);
+        out.append("zync_exchanges_total{" + common + type + "} ");
+        AppendCount(iter->second.count, out);
+        out += '\n';
+    }
+
+    out.append("# HELP zync_exchange_bytes_total Bytes sent to and received" \
+               " from the Zaurus by message type.\n");
+    out.append("# TYPE zync_exchange_bytes_total counter\n");
+    for (iter = exchanges.begin(); iter != exchanges.end(); ++iter) {
+        type.assign("type=");
+        AppendQuoted(iter->first, type);
+        out.append("zync_exchange_bytes_total{" + common + type +
+                   ",direction=\"in\"} ");
+        AppendCount(iter->second.bytesIn, out);
+        out += '\n';
+        out.append("zync_exchange_bytes_total{" + common + type +
+                   ",direction=\"out\"} ");
+        AppendCount(iter->second.bytesOut, out);
+        out += '\n';
+    }
+
+    out.append("# HELP zync_exchange_wait_seconds_total Time spent waiting" \
+               " on the Zaurus by message type.\n");
+    out.append("# TYPE zync_exchange_wait_seconds_total counter\n");
+    for (iter = exchanges.begin(); iter != exchanges.end(); ++iter) {
+        type.assign("type=");
+        AppendQuoted(iter->first, type);
+        out.append("zync_exchange_wait_seconds_total{" + common + type +
+                   ",wait=\"rqst\"} ");
+        AppendNumber(iter->second.rqstWait, out);
+        out += '\n';
+        out.append("zync_exchange_wait_seconds_total{" + common + type +
+                   ",wait=\"ack\"} ");
+        AppendNumber(iter->second.ackWait, out);
+        out += '\n';
+        out.append("zync_exchange_wait_seconds_total{" + common + type +
+                   ",wait=\"reply\"} ");
+        AppendNumber(iter->second.replyWait, out);
+        out += '\n';
+    }
+
+    out.append("# HELP zync_exchange_round_trip_seconds Round trip time of" \
+               " the exchanges with the Zaurus by message type.\n");
+    out.append("# TYPE zync_exchange_round_trip_seconds histogram\n");
+    for (iter = exchanges.begin(); iter != exchanges.end(); ++iter) {
+        type.assign("type=");
+        AppendQuoted(iter->first, type);
+        cumulative = 0;
+        for (i = 0; i <= STATS_NUM_BUCKETS; i++) {
+            cumulative += iter->second.buckets[i];
+            out.append("zync_exchange_round_trip_seconds_bucket{" + common +
+                       type + ",le=\"");
+            if (i < STATS_NUM_BUCKETS)
+                AppendBound(bucketBounds[i], out);
+            else
+                out.append("+Inf");
+            out.append("\"} ");
+            AppendCount(cumulative, out);
+            out += '\n';
+        }
+        out.append("zync_exchange_round_trip_seconds_sum{" + common + type +
+                   "} ");
+        AppendNumber(iter->second.roundTrip, out);
+        out += '\n';
+        out.append("zync_exchange_round_trip_seconds_count{" + common +
+                   type + "} ");
+        AppendCount(iter->second.count, out);
+        out += '\n';
+    }
+}
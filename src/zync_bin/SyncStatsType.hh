@@ -0,0 +1,133 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file SyncStatsType.hh
+ * @brief A specifications file for the statistics of a sync.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class existing to record where the time of a
+ * sync goes, both by phase and by protocol exchange with the Zaurus.
+ */
+
+#ifndef SYNCSTATSTYPE_H
+#define SYNCSTATSTYPE_H
+
+#include <sys/time.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Define the formats the statistics may be written in.
+#define STATS_FORMAT_JSON 1
+#define STATS_FORMAT_PROMETHEUS 2
+
+// The number of buckets of the round trip histogram, not counting the last
+// one which holds every round trip longer than the others.
+#define STATS_NUM_BUCKETS 12
+
+/**
+ * @class SyncStatsType
+ * @brief A type recording the statistics of a sync.
+ *
+ * The SyncStatsType is a class which records where the time of a sync
+ * goes. The sync marks the start of each of its phases, such as the
+ * handshake, fetching the changes or writing them to the plugin, and the
+ * time spent in each phase is added up under its name.
+ *
+ * Once attached it is also reported every message sent to and received from
+ * the Zaurus by the message library. The messages are grouped into
+ * exchanges, each starting with the Zaurus asking for a message and ending
+ * with its reply, and kept by the type of the message sent. For each type
+ * the number of exchanges, the bytes sent and received, the time spent
+ * waiting for the Rqst, the Ack and the reply, and a histogram of the round
+ * trip times are kept. Telling the time waiting on the Zaurus apart from the
+ * rest shows whether the device, the desktop or the plugin is slowing a sync
+ * down.
+ *
+ * At the end of the sync the statistics are written as JSON or in the
+ * Prometheus text format.
+ */
+class SyncStatsType {
+public:
+    SyncStatsType(void);
+    ~SyncStatsType(void);
+
+    void Attach(void);
+    void Detach(void);
+
+    void SetLabel(const char *pName, const std::string &value);
+    void StartPhase(const char *pName);
+    void EndPhase(void);
+
+    void Format(int format, std::string &out) const;
+    int Write(const std::string &statsPath, int format) const;
+
+private:
+    // The statistics kept for the exchanges of a message type.
+    struct sExchangeStats {
+        unsigned long int count;
+        unsigned long int bytesIn;
+        unsigned long int bytesOut;
+        double rqstWait;
+        double ackWait;
+        double replyWait;
+        double roundTrip;
+        unsigned long int buckets[STATS_NUM_BUCKETS + 1];
+    };
+
+    // The exchange in progress.
+    struct sExchange {
+        bool isOpen;
+        std::string type;
+        unsigned long int bytesIn;
+        unsigned long int bytesOut;
+        double rqstWait;
+        double ackWait;
+        double replyWait;
+    };
+
+    static void Trace(void *pCtx, int event, const char *pType,
+                      int numBytes, double waitTime);
+    void Record(int event, const char *pType, int numBytes,
+                double waitTime);
+    void OpenExchange(void);
+    void CloseExchange(void);
+
+    void FormatJSON(std::string &out) const;
+    void FormatPrometheus(std::string &out) const;
+
+    bool isAttached;
+    struct timeval syncStart;
+
+    std::vector<std::pair<std::string, std::string> > labels;
+
+    // The time spent in each phase, in the order the phases were started.
+    std::vector<std::pair<std::string, double> > phases;
+    std::string phaseName;
+    struct timeval phaseStart;
+
+    struct sExchange current;
+    std::map<std::string, struct sExchangeStats> exchanges;
+};
+
+#endif
@@ -0,0 +1,227 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file SyncTraitsType.hh
+ * @brief A specifications file for the traits of each synchronization type.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for the classes existing to describe each of the
+ * types of synchronization (To-Do, Calendar, Address Book), so that a single
+ * sync pipeline may be written once and used for all of them.
+ */
+
+#ifndef SYNCTRAITSTYPE_H
+#define SYNCTRAITSTYPE_H
+
+#include <time.h>
+
+#include "TodoPluginType.hh"
+#include "CalendarPluginType.hh"
+#include "AddrBookPluginType.hh"
+#include "PluginV2Type.hh"
+#include "ZaurusType.hh"
+
+/**
+ * @class TodoSyncTraitsType
+ * @brief A type describing the To-Do synchronization.
+ *
+ * The TodoSyncTraitsType is a class which describes the To-Do
+ * synchronization to the sync pipeline. It names the item and plugin types,
+ * the settings used and adapts the plugin member functions to the common
+ * names used by the pipeline.
+ */
+class TodoSyncTraitsType {
+public:
+    typedef TodoItemType ItemT;
+    typedef TodoPluginType PluginT;
+    typedef create_todo_t CreateFuncT;
+    typedef destroy_todo_t DestroyFuncT;
+    typedef TodoPluginV2Type PluginV2T;
+    typedef create_todo_v2_t CreateV2FuncT;
+    typedef destroy_todo_v2_t DestroyV2FuncT;
+
+    static unsigned char GetSyncType(void) { return SYNC_TODO; }
+    static const char *GetName(void) { return "To-Do"; }
+    static const char *GetPluginPathKey(void) { return "todo_plugin_path"; }
+    static const char *GetCreateSymbol(void) { return "createTodoPlugin"; }
+    static const char *GetDestroySymbol(void) { return "destroyTodoPlugin"; }
+    static const char *GetCreateV2Symbol(void) {
+        return "createTodoPluginV2";
+    }
+    static const char *GetDestroyV2Symbol(void) {
+        return "destroyTodoPluginV2";
+    }
+    static const char *GetJournalName(void) { return "todo.journal"; }
+    static const char *GetMirrorName(void) { return "todo.mirror"; }
+    static const char *GetIDMapName(void) { return "todo.idmap"; }
+    static const char *GetSnapshotName(void) { return "todo.snapshot"; }
+
+    static ItemT::List GetAllItems(PluginT *pPlugin) {
+        return pPlugin->GetAllTodoItems();
+    }
+    static ItemT::List GetNewItems(PluginT *pPlugin, time_t lastTimeSynced) {
+        return pPlugin->GetNewTodoItems(lastTimeSynced);
+    }
+    static ItemT::List GetModItems(PluginT *pPlugin, time_t lastTimeSynced) {
+        return pPlugin->GetModTodoItems(lastTimeSynced);
+    }
+    static SyncIDListType GetDelItemIDs(PluginT *pPlugin,
+        time_t lastTimeSynced) {
+        return pPlugin->GetDelTodoItemIDs(lastTimeSynced);
+    }
+    static int AddItems(PluginT *pPlugin, const ItemT::List &items) {
+        return pPlugin->AddTodoItems(items);
+    }
+    static int ModItems(PluginT *pPlugin, const ItemT::List &items) {
+        return pPlugin->ModTodoItems(items);
+    }
+    static int DelItems(PluginT *pPlugin, SyncIDListType syncIDList) {
+        return pPlugin->DelTodoItems(syncIDList);
+    }
+};
+
+/**
+ * @class CalendarSyncTraitsType
+ * @brief A type describing the Calendar synchronization.
+ *
+ * The CalendarSyncTraitsType is a class which describes the Calendar
+ * synchronization to the sync pipeline. It names the item and plugin types,
+ * the settings used and adapts the plugin member functions to the common
+ * names used by the pipeline.
+ */
+class CalendarSyncTraitsType {
+public:
+    typedef CalendarItemType ItemT;
+    typedef CalendarPluginType PluginT;
+    typedef create_cal_t CreateFuncT;
+    typedef destroy_cal_t DestroyFuncT;
+    typedef CalendarPluginV2Type PluginV2T;
+    typedef create_cal_v2_t CreateV2FuncT;
+    typedef destroy_cal_v2_t DestroyV2FuncT;
+
+    static unsigned char GetSyncType(void) { return SYNC_CALENDAR; }
+    static const char *GetName(void) { return "Calendar"; }
+    static const char *GetPluginPathKey(void) { return "cal_plugin_path"; }
+    static const char *GetCreateSymbol(void) {
+        return "createCalendarPlugin";
+    }
+    static const char *GetDestroySymbol(void) {
+        return "destroyCalendarPlugin";
+    }
+    static const char *GetCreateV2Symbol(void) {
+        return "createCalendarPluginV2";
+    }
+    static const char *GetDestroyV2Symbol(void) {
+        return "destroyCalendarPluginV2";
+    }
+    static const char *GetJournalName(void) { return "calendar.journal"; }
+    static const char *GetMirrorName(void) { return "calendar.mirror"; }
+    static const char *GetIDMapName(void) { return "calendar.idmap"; }
+    static const char *GetSnapshotName(void) { return "calendar.snapshot"; }
+
+    static ItemT::List GetAllItems(PluginT *pPlugin) {
+        return pPlugin->GetAllCalendarItems();
+    }
+    static ItemT::List GetNewItems(PluginT *pPlugin, time_t lastTimeSynced) {
+        return pPlugin->GetNewCalendarItems(lastTimeSynced);
+    }
+    static ItemT::List GetModItems(PluginT *pPlugin, time_t lastTimeSynced) {
+        return pPlugin->GetModCalendarItems(lastTimeSynced);
+    }
+    static SyncIDListType GetDelItemIDs(PluginT *pPlugin,
+        time_t lastTimeSynced) {
+        return pPlugin->GetDelCalendarItemIDs(lastTimeSynced);
+    }
+    static int AddItems(PluginT *pPlugin, const ItemT::List &items) {
+        return pPlugin->AddCalendarItems(items);
+    }
+    static int ModItems(PluginT *pPlugin, const ItemT::List &items) {
+        return pPlugin->ModCalendarItems(items);
+    }
+    static int DelItems(PluginT *pPlugin, SyncIDListType syncIDList) {
+        return pPlugin->DelCalendarItems(syncIDList);
+    }
+};
+
+/**
+ * @class AddrBookSyncTraitsType
+ * @brief A type describing the Address Book synchronization.
+ *
+ * The AddrBookSyncTraitsType is a class which describes the Address Book
+ * synchronization to the sync pipeline. It names the item and plugin types,
+ * the settings used and adapts the plugin member functions to the common
+ * names used by the pipeline.
+ */
+class AddrBookSyncTraitsType {
+public:
+    typedef AddrBookItemType ItemT;
+    typedef AddrBookPluginType PluginT;
+    typedef create_addr_t CreateFuncT;
+    typedef destroy_addr_t DestroyFuncT;
+    typedef AddrBookPluginV2Type PluginV2T;
+    typedef create_addr_v2_t CreateV2FuncT;
+    typedef destroy_addr_v2_t DestroyV2FuncT;
+
+    static unsigned char GetSyncType(void) { return SYNC_ADDRESSBOOK; }
+    static const char *GetName(void) { return "Address Book"; }
+    static const char *GetPluginPathKey(void) { return "addr_plugin_path"; }
+    static const char *GetCreateSymbol(void) {
+        return "createAddrBookPlugin";
+    }
+    static const char *GetDestroySymbol(void) {
+        return "destroyAddrBookPlugin";
+    }
+    static const char *GetCreateV2Symbol(void) {
+        return "createAddrBookPluginV2";
+    }
+    static const char *GetDestroyV2Symbol(void) {
+        return "destroyAddrBookPluginV2";
+    }
+    static const char *GetJournalName(void) { return "addrbook.journal"; }
+    static const char *GetMirrorName(void) { return "addrbook.mirror"; }
+    static const char *GetIDMapName(void) { return "addrbook.idmap"; }
+    static const char *GetSnapshotName(void) { return "addrbook.snapshot"; }
+
+    static ItemT::List GetAllItems(PluginT *pPlugin) {
+        return pPlugin->GetAllAddrBookItems();
+    }
+    static ItemT::List GetNewItems(PluginT *pPlugin, time_t lastTimeSynced) {
+        return pPlugin->GetNewAddrBookItems(lastTimeSynced);
+    }
+    static ItemT::List GetModItems(PluginT *pPlugin, time_t lastTimeSynced) {
+        return pPlugin->GetModAddrBookItems(lastTimeSynced);
+    }
+    static SyncIDListType GetDelItemIDs(PluginT *pPlugin,
+        time_t lastTimeSynced) {
+        return pPlugin->GetDelAddrBookItemIDs(lastTimeSynced);
+    }
+    static int AddItems(PluginT *pPlugin, const ItemT::List &items) {
+        return pPlugin->AddAddrBookItems(items);
+    }
+    static int ModItems(PluginT *pPlugin, const ItemT::List &items) {
+        return pPlugin->ModAddrBookItems(items);
+    }
+    static int DelItems(PluginT *pPlugin, SyncIDListType syncIDList) {
+        return pPlugin->DelAddrBookItems(syncIDList);
+    }
+};
+
+#endif
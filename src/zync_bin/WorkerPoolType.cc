@@ -0,0 +1,171 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file WorkerPoolType.cc
+ * @brief An implementation file for an object to run jobs on many threads.
+ * @author Andrew De Ponte
+ *
+ * An implementation file for a class existing to run a number of
+ * independent jobs across a group of worker threads.
+ */
+
+#include "WorkerPoolType.hh"
+
+#include <unistd.h>
+#include <vector>
+
+// The most worker threads a pool will use, no matter the number of CPUs.
+#define WORKER_POOL_MAX_THREADS 8
+
+/**
+ * Construct a default WorkerPoolType object.
+ *
+ * Construct a WorkerPoolType object which uses one thread for each of the
+ * online processors, up to WORKER_POOL_MAX_THREADS.
+ */
+WorkerPoolType::WorkerPoolType(void) {
+    long numCpus;
+
+    numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (numCpus < 1)
+        numCpus = 1;
+    if (numCpus > WORKER_POOL_MAX_THREADS)
+        numCpus = WORKER_POOL_MAX_THREADS;
+
+    maxThreads = (unsigned int)numCpus;
+    totalJobs = 0;
+    nextJob = 0;
+    pJobFunc = NULL;
+    pJobCtx = NULL;
+}
+
+/**
+ * Construct a WorkerPoolType object.
+ *
+ * Construct a WorkerPoolType object which uses the given number of threads,
+ * including the calling thread.
+ * @param numThreads The number of threads to run the jobs on.
+ */
+WorkerPoolType::WorkerPoolType(unsigned int numThreads) {
+    if (numThreads < 1)
+        numThreads = 1;
+
+    maxThreads = numThreads;
+    totalJobs = 0;
+    nextJob = 0;
+    pJobFunc = NULL;
+    pJobCtx = NULL;
+}
+
+/**
+ * Run jobs in parallel.
+ *
+ * Run the given job function once for each job index from zero up to, but
+ * not including, numJobs. The jobs are run across the worker threads and the
+ * calling thread, and this only returns once all of them have finished. The
+ * jobs must not depend on each other as they may run in any order.
+ * @param numJobs The number of jobs to run.
+ * @param pFunc The function to call to run a single job.
+ * @param pCtx Pointer which is passed to each call of the job function.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully ran all of the jobs.
+ * @retval 1 Failed, no job function was given.
+ */
+int WorkerPoolType::RunParallel(unsigned int numJobs, JobFuncType pFunc,
+                                void *pCtx) {
+    std::vector<pthread_t> threads;
+    pthread_t curThread;
+    unsigned int numThreads;
+    unsigned int i;
+
+    if (!pFunc)
+        return 1;
+
+    totalJobs = numJobs;
+    nextJob = 0;
+    pJobFunc = pFunc;
+    pJobCtx = pCtx;
+
+    // There is no point in starting more threads than there are jobs. The
+    // calling thread counts as one of the threads.
+    numThreads = maxThreads;
+    if (numThreads > numJobs)
+        numThreads = numJobs;
+
+    for (i = 1; i < numThreads; i++) {
+        if (pthread_create(&curThread, NULL, WorkerMain, (void *)this) != 0)
+            break;
+        threads.push_back(curThread);
+    }
+
+    // I work on the jobs from this thread as well. If none of the worker
+    // threads could be created this simply runs all of the jobs here.
+    RunJobs();
+
+    for (i = 0; i < threads.size(); i++)
+        pthread_join(threads[i], NULL);
+
+    pJobFunc = NULL;
+    pJobCtx = NULL;
+
+    return 0;
+}
+
+/**
+ * Get the number of threads.
+ *
+ * Get the maximum number of threads, including the calling thread, that the
+ * jobs are run on.
+ * @return The maximum number of threads used to run jobs.
+ */
+unsigned int WorkerPoolType::GetNumThreads(void) const {
+    return maxThreads;
+}
+
+/**
+ * Worker thread entry point.
+ *
+ * This is the function each of the worker threads starts in.
+ * @param pArg Pointer to the WorkerPoolType object the thread works for.
+ * @return Always NULL.
+ */
+void *WorkerPoolType::WorkerMain(void *pArg) {
+    ((WorkerPoolType *)pArg)->RunJobs();
+    return NULL;
+}
+
+/**
+ * Run jobs until none are left.
+ *
+ * Claim the next unclaimed job and run it, repeating until all of the jobs
+ * have been claimed.
+ */
+void WorkerPoolType::RunJobs(void) {
+    unsigned int jobIndex;
+
+    while (1) {
+        jobIndex = __sync_fetch_and_add(&nextJob, 1);
+        if (jobIndex >= totalJobs)
+            break;
+
+        pJobFunc(pJobCtx, jobIndex);
+    }
+}
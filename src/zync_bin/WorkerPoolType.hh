@@ -0,0 +1,70 @@
+/*
+ * Copyright 2006 Andrew De Ponte
+ *
+ * This file is part of zsrep.
+ *
+ * zsrep is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * zsrep is distributed in the hopes that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with zsrep; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * @file WorkerPoolType.hh
+ * @brief A specifications file for an object to run jobs on many threads.
+ * @author Andrew De Ponte
+ *
+ * A specifications file for a class existing to run a number of independent
+ * jobs across a group of worker threads.
+ */
+
+#ifndef WORKERPOOLTYPE_H
+#define WORKERPOOLTYPE_H
+
+#include <pthread.h>
+
+/**
+ * @class WorkerPoolType
+ * @brief A type used to run independent jobs in parallel.
+ *
+ * The WorkerPoolType is a class which runs a number of independent jobs,
+ * identified by their index, across a group of worker threads. Each worker
+ * claims the next unclaimed job until none are left, so uneven jobs are
+ * spread out evenly. The calling thread works on jobs as well, hence the
+ * jobs are all run even if no worker threads could be created.
+ */
+class WorkerPoolType {
+public:
+    // Define the type of function used to run a single job.
+    typedef void (*JobFuncType)(void *pCtx, unsigned int jobIndex);
+
+    WorkerPoolType(void);
+    WorkerPoolType(unsigned int numThreads);
+
+    int RunParallel(unsigned int numJobs, JobFuncType pFunc, void *pCtx);
+
+    unsigned int GetNumThreads(void) const;
+
+private:
+    static void *WorkerMain(void *pArg);
+    void RunJobs(void);
+
+    unsigned int maxThreads;
+
+    // The following variables describe the jobs of the current run.
+    unsigned int totalJobs;
+    volatile unsigned int nextJob;
+    JobFuncType pJobFunc;
+    void *pJobCtx;
+};
+
+#endif
@@ -29,6 +29,19 @@
 
 #include "ZaurusType.hh"
 
+// This structure describes the jobs used to encode the RDW messages for a
+// list of items in parallel. The obtIdFrames and syncIdOffsets are only used
+// when adding items.
+template <class ItemT>
+struct sEncodeJobs {
+    ZaurusType *pZaurus;
+    std::vector<const ItemT *> items;
+    std::vector<RDWMessageType *> obtIdFrames;
+    std::vector<RDWMessageType *> frames;
+    std::vector<unsigned short int> syncIdOffsets;
+    std::vector<int> results;
+};
+
 /**
  * Construct a default Zaurus object.
  *
@@ -47,6 +60,10 @@ ZaurusType::ZaurusType(void) {
     // Set the synchronization type to To-Do for default since it is only one
     // that is implimented at this point.
     syncType = 0x06;
+
+    // By default no journal or mirror is kept.
+    pJournal = NULL;
+    pMirror = NULL;
 }
 
 /**
@@ -135,6 +152,7 @@ int ZaurusType::ListenConnection(void) {
         perror("ListenConnection");
         return 5;
     }
+    address.assign(source_addr);
 //    printf("Received connection from %s, port %d.\n", source_addr,
 //	   ntohs(clntaddr.sin_port));
 
@@ -277,249 +295,320 @@ time_t ZaurusType::GetLastTimeSynced(void) {
 }
 
 /**
- * Obtain all the Todo sync items.
+ * Obtain all the sync items.
  *
- * Obtain all the new, modified, and deleted Todo sync items.
- * @param newItemList A reference to a list to hold the Todo items that are
- * new to the Zaurus. 
- * @param modItemList A reference to a list to hold the Todo items that have
- * been modified from the Zaurus.
- * @param delItemIdList A reference to a list to hold sync IDs of the Todo
- * items that have been deleted from the Zaurus.
+ * Obtain all the new, modified, and deleted sync items of the type being
+ * synchronized. Modified items whose content matches the mirror are left
+ * out, since nothing changed.
+ * @param newItemList A reference to a list to hold the items that are new
+ * to the Zaurus.
+ * @param modItemList A reference to a list to hold the items that have been
+ * modified from the Zaurus.
+ * @param delItemIdList A reference to a list to hold sync IDs of the items
+ * that have been deleted from the Zaurus.
  * @return An integer representing success (zero) or failure (non-zero).
- * @retval 0 Successfully obtained the Todo sync items.
- * @retval 1 Failed to set the next sync anchor.
+ * @retval 0 Successfully obtained the sync items.
+ * @retval 1 Failed to obtain the sync ID lists.
  */
-int ZaurusType::GetAllTodoSyncItems(TodoItemType::List &newItemList,
-				    TodoItemType::List &modItemList,
-				    SyncIDListType &delItemIdList) {
-
+template <class ItemT>
+int ZaurusType::GetAllSyncItems(std::vector<ItemT> &newItemList,
+				std::vector<ItemT> &modItemList,
+				SyncIDListType &delItemIdList) {
     SyncIDListType::iterator syncIDIter;
     unsigned long int curSyncID;
-    TodoItemType todoItem;
+    ItemT item;
+    uint64_t mirrorHash;
+    bool mirrored;
 
-    if (!obtainedSyncIDLists)
-	ObtainSyncIDLists(syncType);
+    if (!obtainedSyncIDLists) {
+	if (ObtainSyncIDLists(syncType) != 0)
+	    return 1;
+    }
 
-    std::cout << "OBTAINED SYNC ID LIST.\n";
+    // The lists are grown once up front, and each fetched item is swapped
+    // into its place rather than copied.
+    newItemList.reserve(newItemList.size() + newSyncIDList.size());
+    modItemList.reserve(modItemList.size() + modSyncIDList.size());
 
     // Loop through the newSyncIDList and obtain the data for each of the sync
     // IDs and store the data in the newItemList refrenced list.
     for (syncIDIter = newSyncIDList.begin(); syncIDIter != newSyncIDList.end();
 	 syncIDIter++) {
 	curSyncID = *(syncIDIter);
-	std::cout << "GETTING DATA FOR " << curSyncID << std::endl;
 
-	todoItem = GetTodoItem(syncType, curSyncID);
+	// Items which were added to the Zaurus from the plugin during an
+	// interrupted sync already exist in the plugin.
+	if (pJournal && pJournal->IsMappedSyncID(curSyncID))
+	    continue;
 
-	std::cout << "GOT DATA FOR " << curSyncID << std::endl;
-	newItemList.push_front(todoItem);
+	item = FetchItem<ItemT>(curSyncID);
+	newItemList.push_back(ItemT());
+	std::swap(newItemList.back(), item);
     }
 
-    std::cout << "FINISHED LOOPIND NEW ITEMS\n";
-
     // Loop through the modSyncIDList and obtain the data for each of the sync
     // IDs and store the data in the modItemList referenced list.
     for (syncIDIter = modSyncIDList.begin(); syncIDIter != modSyncIDList.end();
 	 syncIDIter++) {
 	curSyncID = *(syncIDIter);
 
-	todoItem = GetTodoItem(syncType, curSyncID);
-	modItemList.push_front(todoItem);
+	// Modifications which leave the item as the mirror last saw it, such
+	// as an item being touched without any real change, are dropped.
+	mirrored = (pMirror && pMirror->Get(curSyncID, mirrorHash));
+
+	item = FetchItem<ItemT>(curSyncID);
+	if (mirrored && (item.ContentHash() == mirrorHash))
+	    continue;
+
+	modItemList.push_back(ItemT());
+	std::swap(modItemList.back(), item);
     }
 
     // Set the delItemIdList equal to the list of sync ids of the deleted
-    // items.
+    // items. They are no longer on the Zaurus, so they leave the mirror.
     delItemIdList = delSyncIDList;
+    if (pMirror) {
+	for (syncIDIter = delSyncIDList.begin();
+	     syncIDIter != delSyncIDList.end(); syncIDIter++)
+	    pMirror->Remove(*syncIDIter);
+    }
 
     return 0;
 }
 
 /**
- * Obtain all the Calendar sync items.
+ * Stream the new items.
  *
- * Obtain all the new, modified, and deleted Calendar sync items.
- * @param newItemList A reference to a list to hold the Calendar items that
- * are new to the Zaurus. 
- * @param modItemList A reference to a list to hold the Calendar items that
- * have been modified from the Zaurus.
- * @param delItemIdList A reference to a list to hold sync IDs of the Calendar
- * items that have been deleted from the Zaurus.
+ * Obtain each of the items that are new to the Zaurus and push them onto
+ * the passed queue as soon as they have been obtained, rather than
+ * collecting them all first. The queue is closed once the last item has been
+ * pushed, or if the items could not be obtained. This is intended to be run
+ * from a thread other than the one consuming the queue, so that the
+ * consumer may process items while the rest are still being fetched.
+ * @param itemQueue A reference to the queue to push the new items onto.
  * @return An integer representing success (zero) or failure (non-zero).
- * @retval 0 Successfully obtained the Todo sync items.
- * @retval 1 Failed to set the next sync anchor.
+ * @retval 0 Successfully streamed the new items.
+ * @retval 1 Failed to obtain the sync ID lists.
  */
-int ZaurusType::GetAllCalendarSyncItems(CalendarItemType::List &newItemList,
-					CalendarItemType::List &modItemList,
-					SyncIDListType &delItemIdList) {
+template <class ItemT>
+int ZaurusType::StreamNewItems(ItemQueueType<ItemT> &itemQueue) {
     SyncIDListType::iterator syncIDIter;
-    unsigned long int curSyncID;
-    CalendarItemType calItem;
+    ItemT item;
 
-    if (!obtainedSyncIDLists)
-	ObtainSyncIDLists(syncType);
+    if (!obtainedSyncIDLists) {
+	if (ObtainSyncIDLists(syncType) != 0) {
+	    itemQueue.Close();
+	    return 1;
+	}
+    }
 
     // Loop through the newSyncIDList and obtain the data for each of the sync
-    // IDs and store the data in the newItemList refrenced list.
+    // IDs, handing each item off to the consumer as soon as it is decoded.
     for (syncIDIter = newSyncIDList.begin(); syncIDIter != newSyncIDList.end();
 	 syncIDIter++) {
-	curSyncID = *(syncIDIter);
+	if (pJournal && pJournal->IsMappedSyncID(*syncIDIter))
+	    continue;
 
-	calItem = GetCalendarItem(syncType, curSyncID);
-	newItemList.push_front(calItem);
-    }
-
-    // Loop through the modSyncIDList and obtain the data for each of the sync
-    // IDs and store the data in the modItemList referenced list.
-    for (syncIDIter = modSyncIDList.begin(); syncIDIter != modSyncIDList.end();
-	 syncIDIter++) {
-	curSyncID = *(syncIDIter);
+	// Items left out of the sync are not transferred.
+	if (skippedSyncIDs.find(*syncIDIter) != skippedSyncIDs.end())
+	    continue;
 
-	calItem = GetCalendarItem(syncType, curSyncID);
-	modItemList.push_front(calItem);
+	item = FetchItem<ItemT>(*syncIDIter);
+	itemQueue.Push(item);
     }
 
-    // Set the delItemIdList equal to the list of sync ids of the deleted
-    // items.
-    delItemIdList = delSyncIDList;
+    itemQueue.Close();
 
     return 0;
 }
 
 /**
- * Add the Todo items.
+ * Add the items.
  *
- * Add the Todo items to the Zaurus with the data in the items in the
- * passed list.
- * @param todoItems The list of items to add and their data.
- * @return A list of To-Do items which need their IDs mapped.
+ * Add the items to the Zaurus with the data in the items in the passed
+ * list. The RDW messages for all of the items are encoded up front, in
+ * parallel, so that the exchange with the Zaurus only has to perform I/O.
+ * Each item is added to the passed list of items which need their IDs
+ * mapped, given the sync ID the Zaurus assigned it. Items which failed to be
+ * added are still mapped, with no data.
+ * @param items The list of items to add and their data.
+ * @param mapIdList Reference to the list to add the items which need their
+ * IDs mapped to.
+ * @return The number of items failed, hence a value of zero is success.
+ * @retval 0 Successfully added all items contained in the passed list.
  */
-TodoItemType::List ZaurusType::AddTodoItems(TodoItemType::List todoItems) {
-    std::cout << "Entered the AddTodoItems() function.\n";
-    TodoItemType::List::iterator pTodoItem;
-    TodoItemType todoItem;
-    TodoItemType::List mapIdList;
-    std::cout << "Created function scoped variables.\n";
-
-    // Here, I iterate through the list of items that should be added and
-    // add them all.
-    for (pTodoItem = todoItems.begin(); pTodoItem != todoItems.end();
-	 pTodoItem++) {
-	std::cout << "Began iteration.\n";
-	todoItem = *(pTodoItem);
-	std::cout << "Set the Current Todo Item.\n";
-
-	std::cout << "About to add, " << todoItem.GetDescription();
-	std::cout << std::endl;
-
-	mapIdList.push_front(AddTodoItem(syncType, todoItem));
+template <class ItemT>
+int ZaurusType::AddItems(const std::vector<ItemT> &items,
+			 std::vector<ItemT> &mapIdList) {
+    struct sEncodeJobs<ItemT> jobs;
+    typename std::vector<ItemT>::const_iterator pItem;
+    ItemT addedItem;
+    unsigned long int syncId;
+    unsigned int i;
+    int numFailed = 0;
+    int retval;
 
-	std::cout << "Pushed item ID onto mapIdList.\n";
+    jobs.pZaurus = this;
+    mapIdList.reserve(mapIdList.size() + items.size());
+    for (pItem = items.begin(); pItem != items.end(); pItem++) {
+	// Items which were added to the Zaurus during an interrupted sync
+	// are not added again, their recorded IDs are mapped instead.
+	if (pJournal && ((*pItem).GetAppID().size() > 0) &&
+	    pJournal->GetMappedSyncID((*pItem).GetAppID(), syncId)) {
+	    addedItem = *pItem;
+	    addedItem.SetSyncID(syncId);
+	    if (pMirror)
+		pMirror->Put(syncId, addedItem.ContentHash());
+	    mapIdList.push_back(ItemT());
+	    std::swap(mapIdList.back(), addedItem);
+	    continue;
+	}
 
-	std::cout << "Ended iteration.\n";
+	jobs.items.push_back(&(*pItem));
     }
+    jobs.obtIdFrames.resize(jobs.items.size(), NULL);
+    jobs.frames.resize(jobs.items.size(), NULL);
+    jobs.syncIdOffsets.resize(jobs.items.size(), 0);
+    jobs.results.resize(jobs.items.size(), 0);
+
+    encodePool.RunParallel(jobs.items.size(), EncodeAddJob<ItemT>,
+			   (void *)&jobs);
+
+    // Here, I iterate through the encoded messages and add each of the items
+    // to the Zaurus. Items which failed before a sync ID was obtained are
+    // mapped with no data, as they always have been.
+    for (i = 0; i < jobs.items.size(); i++) {
+	addedItem = ItemT();
+
+	retval = jobs.results[i];
+	if (retval == 0) {
+	    retval = SendAddFrames(jobs.obtIdFrames[i], jobs.frames[i],
+				   jobs.syncIdOffsets[i], syncId);
+	    if ((retval == 0) || (retval >= 4)) {
+		addedItem = *(jobs.items[i]);
+		addedItem.SetSyncID(syncId);
+		if (pJournal)
+		    pJournal->RecordMapped(syncId, addedItem.GetAppID());
+		if (pMirror)
+		    pMirror->Put(syncId, addedItem.ContentHash());
+	    }
+	}
 
-    return mapIdList;
-}
+	if (retval != 0)
+	    numFailed++;
 
-/**
- * Add the Calendar items.
- *
- * Add the Calendar items to the Zaurus with the data in the items in the
- * passed list.
- * @param calItems The list of items to add and their data.
- * @return A list of Calendar items which need their IDs mapped.
- */
-CalendarItemType::List ZaurusType::AddCalendarItems(CalendarItemType::List calItems) {
-    CalendarItemType::List::iterator pCalItem;
-    CalendarItemType calItem;
-    CalendarItemType::List mapIdList;
-
-    // Here, I iterate through the list of items that should be added and
-    // add them all.
-    for (pCalItem = calItems.begin(); pCalItem != calItems.end();
-	 pCalItem++) {
-	calItem = *(pCalItem);
+	mapIdList.push_back(ItemT());
+	std::swap(mapIdList.back(), addedItem);
 
-	mapIdList.push_front(AddCalendarItem(syncType, calItem));
+	delete jobs.obtIdFrames[i];
+	delete jobs.frames[i];
     }
 
-    return mapIdList;
+    return numFailed;
 }
 
 /**
- * Modify the Todo items.
+ * Modify the items.
  *
- * Modify the Todo items on the Zaurus with the data in the items in the
- * passed list.
- * @param todoItems The list of items to modify and their data.
+ * Modify the items on the Zaurus with the data in the items in the passed
+ * list. Items the mirror shows the Zaurus already holds with the same
+ * content are skipped. If the items have no field for some parameters, the
+ * items not read from the Zaurus during this sync are read first, so that
+ * those parameters are written back as they are. The RDW messages for the
+ * rest of the items are encoded up front, in parallel, so that the exchange
+ * with the Zaurus only has to perform I/O.
+ * @param items The list of items to modify and their data.
  * @return The number of items failed, hence a value of zero is success.
  * @retval 0 Successfully modified all items contained in the passed list.
  */
-int ZaurusType::ModTodoItems(TodoItemType::List todoItems) {
-    TodoItemType::List::iterator pTodoItem;
-    TodoItemType todoItem;
+template <class ItemT>
+int ZaurusType::ModItems(const std::vector<ItemT> &items) {
+    struct sEncodeJobs<ItemT> jobs;
+    typename std::vector<ItemT>::const_iterator pItem;
+    uint64_t mirrorHash;
+    unsigned int i;
 
     int retval = 0;
 
-    // Here, I iterate through the list of items that should be modified and
-    // modify them all.
-    for (pTodoItem = todoItems.begin(); pTodoItem != todoItems.end();
-	 pTodoItem++) {
-	todoItem = *(pTodoItem);
-
-	if (ModifyTodoItem(syncType, todoItem) != 0)
-	    retval++;
+    jobs.pZaurus = this;
+    for (pItem = items.begin(); pItem != items.end(); pItem++) {
+	// Items which were modified during an interrupted sync are skipped,
+	// unless they changed again since.
+	if (pJournal && pJournal->WasWritten((*pItem).GetSyncID(),
+					     (*pItem).ContentHash()))
+	    continue;
+
+	// Items the Zaurus already holds with the same content are skipped,
+	// since modifying them would change nothing.
+	if (pMirror && pMirror->Get((*pItem).GetSyncID(), mirrorHash) &&
+	    (mirrorHash == (*pItem).ContentHash()))
+	    continue;
+
+	jobs.items.push_back(&(*pItem));
     }
 
-    return retval;
-}
-
-/**
- * Modify the Calendar items.
- *
- * Modify the Calendar items on the Zaurus with the data in the items in the
- * passed list.
- * @param calItems The list of items to modify and their data.
- * @return The number of items failed, hence a value of zero is success.
- * @retval 0 Successfully modified all items contained in the passed list.
- */
-int ZaurusType::ModCalendarItems(CalendarItemType::List calItems) {
-    CalendarItemType::List::iterator pCalItem;
-    CalendarItemType calItem;
+    if (HasKeptParams<ItemT>()) {
+	for (i = 0; i < jobs.items.size(); i++) {
+	    if (keptParams.find(jobs.items[i]->GetSyncID()) ==
+		keptParams.end())
+		GetItem<ItemT>(syncType, jobs.items[i]->GetSyncID());
+	}
+    }
 
-    int retval = 0;
+    jobs.frames.resize(jobs.items.size(), NULL);
+    jobs.results.resize(jobs.items.size(), 0);
 
-    // Here, I iterate through the list of items that should be modified and
-    // modify them all.
-    for (pCalItem = calItems.begin(); pCalItem != calItems.end();
-	 pCalItem++) {
-	calItem = *(pCalItem);
+    encodePool.RunParallel(jobs.items.size(), EncodeModJob<ItemT>,
+			   (void *)&jobs);
 
-	if (ModifyCalendarItem(syncType, calItem) != 0)
+    // Here, I iterate through the encoded messages and send each of them to
+    // the Zaurus, modifying the items.
+    for (i = 0; i < jobs.items.size(); i++) {
+	if (jobs.results[i] != 0)
+	    retval++;
+	else if (SendModFrame(jobs.frames[i]) != 0)
 	    retval++;
+	else {
+	    if (pJournal)
+		pJournal->RecordWritten(jobs.items[i]->GetSyncID(),
+					jobs.items[i]->ContentHash());
+	    if (pMirror)
+		pMirror->Put(jobs.items[i]->GetSyncID(),
+			     jobs.items[i]->ContentHash());
+	}
+
+	delete jobs.frames[i];
     }
 
     return retval;
 }
 
 /**
- * Delete the Todo items.
+ * Delete the items.
  *
- * Delete the Todo items that have sync IDs contained in the passed list.
- * @param todoItemIDs The Todo Item IDs of the items to remove.
+ * Delete the items that have sync IDs contained in the passed list.
+ * @param itemIDs The sync IDs of the items to remove.
  * @return The number of items failed, hence a value of zero is success.
  * @retval 0 Successfully removed all items contained in the passed list.
  */
-int ZaurusType::DelTodoItems(SyncIDListType todoItemIDs) {
-    SyncIDListType::iterator it;
+int ZaurusType::DelItems(const SyncIDListType &itemIDs) {
+    SyncIDListType::const_iterator it;
     int retval;
     int numDelsFailed = 0;
 
-    for (it = todoItemIDs.begin(); it != todoItemIDs.end(); it++) {
+    for (it = itemIDs.begin(); it != itemIDs.end(); it++) {
+	// Items which were deleted during an interrupted sync are skipped.
+	if (pJournal && pJournal->WasWritten(*(it), 0))
+	    continue;
+
 	retval = DeleteItem(syncType, *(it));
 	if (retval != 0) {
 	    numDelsFailed++;
+	} else {
+	    if (pJournal)
+		pJournal->RecordWritten(*(it), 0);
+	    if (pMirror)
+		pMirror->Remove(*(it));
 	}
     }
 
@@ -527,26 +616,153 @@ int ZaurusType::DelTodoItems(SyncIDListType todoItemIDs) {
 }
 
 /**
- * Delete the Calendar items.
+ * Set the journal.
  *
- * Delete the Calendar items that have sync IDs contained in the passed list.
- * @param calItemIDs The Calendar Item IDs of the items to remove.
- * @return The number of items failed, hence a value of zero is success.
- * @retval 0 Successfully removed all items contained in the passed list.
+ * Set the journal used to record the progress of the synchronization. When
+ * a journal is set, items it holds are not fetched from the Zaurus again,
+ * and writes it holds are not performed again. Pass NULL to stop keeping a
+ * journal.
+ * @param pSyncJournal Pointer to the open journal to use.
  */
-int ZaurusType::DelCalendarItems(SyncIDListType calItemIDs) {
-    SyncIDListType::iterator it;
-    int retval;
-    int numDelsFailed = 0;
+void ZaurusType::SetJournal(JournalType *pSyncJournal) {
+    pJournal = pSyncJournal;
+}
 
-    for (it = calItemIDs.begin(); it != calItemIDs.end(); it++) {
-	retval = DeleteItem(syncType, *(it));
-	if (retval != 0) {
-	    numDelsFailed++;
-	}
+/**
+ * Set the mirror.
+ *
+ * Set the mirror of the items on the Zaurus. When a mirror is set, every
+ * item read from or written to the Zaurus is recorded in it and every item
+ * deleted from the Zaurus is removed from it. Pass NULL to stop keeping a
+ * mirror.
+ * @param pItemMirror Pointer to the open mirror to use.
+ */
+void ZaurusType::SetMirror(MirrorType *pItemMirror) {
+    pMirror = pItemMirror;
+}
+
+/**
+ * Set the skipped sync IDs.
+ *
+ * Set the sync IDs of the new items which are left out of the sync, such as
+ * the events known to lie outside the sync window. These items are skipped
+ * when the new items are streamed, so they are never transferred from the
+ * Zaurus.
+ * @param syncIDs The set of sync IDs of the items to skip.
+ */
+void ZaurusType::SetSkippedSyncIDs(
+    const std::set<unsigned long int> &syncIDs) {
+    skippedSyncIDs = syncIDs;
+}
+
+/**
+ * Get the new sync IDs.
+ *
+ * Get the sync IDs of the items which are new to the Zaurus, obtaining the
+ * sync ID lists from the Zaurus first if they have not been obtained yet.
+ * When a full sync is being performed this is every item on the Zaurus.
+ * @param syncIDList Reference to the list to store the sync IDs in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully got the new sync IDs.
+ * @retval 1 Failed to obtain the sync ID lists.
+ */
+int ZaurusType::GetNewSyncIDs(SyncIDListType &syncIDList) {
+    if (!obtainedSyncIDLists) {
+	if (ObtainSyncIDLists(syncType) != 0)
+	    return 1;
     }
 
-    return numDelsFailed;
+    syncIDList = newSyncIDList;
+
+    return 0;
+}
+
+/**
+ * Get the model.
+ *
+ * Get the model of the Zaurus as reported in its device information. This
+ * is only valid once the device information has been obtained, which
+ * happens as part of RequiresPassword().
+ * @return The model of the Zaurus.
+ */
+std::string ZaurusType::GetModel(void) const {
+    return model;
+}
+
+/**
+ * Get the address.
+ *
+ * Get the address the Zaurus connected from, in dotted decimal notation.
+ * This is only valid once a connection has been accepted by
+ * ListenConnection().
+ * @return The address of the Zaurus.
+ */
+std::string ZaurusType::GetAddress(void) const {
+    return address;
+}
+
+/**
+ * Get the device identity.
+ *
+ * Get the identity the state kept for the Zaurus between syncs is keyed
+ * by, which is its model and the address it connected from. The Zaurus
+ * reports no serial number, so two handhelds of the same model are told
+ * apart by their addresses. This is only valid once both the model and the
+ * address are known.
+ * @return The identity of the Zaurus.
+ */
+std::string ZaurusType::GetDeviceID(void) const {
+    return model + "@" + address;
+}
+
+/**
+ * Tune the connection.
+ *
+ * Set the options of the socket of the connection to the Zaurus. A receive
+ * or send waiting longer than the timeout fails rather than blocking the
+ * sync forever, the buffer sizes bound how much the kernel queues, and with
+ * Nagle's algorithm disabled each small message of the lock-step exchange
+ * is sent at once.
+ * @param timeout The send and receive timeout in seconds, zero for none.
+ * @param bufferSize The send and receive buffer size in bytes, zero to
+ * keep the default.
+ * @param noDelay True to disable Nagle's algorithm.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully set the options.
+ * @retval 1 Failed to set the timeouts.
+ * @retval 2 Failed to set the buffer sizes.
+ * @retval 3 Failed to disable Nagle's algorithm.
+ */
+int ZaurusType::TuneSocket(unsigned int timeout, int bufferSize,
+			   bool noDelay) {
+    struct timeval tv;
+    int flag = 1;
+
+    if (timeout > 0) {
+	tv.tv_sec = timeout;
+	tv.tv_usec = 0;
+	if ((setsockopt(connfd, SOL_SOCKET, SO_RCVTIMEO, (void *)&tv,
+			sizeof(tv)) != 0) ||
+	    (setsockopt(connfd, SOL_SOCKET, SO_SNDTIMEO, (void *)&tv,
+			sizeof(tv)) != 0))
+	    return 1;
+    }
+
+    if (bufferSize > 0) {
+	if ((setsockopt(connfd, SOL_SOCKET, SO_RCVBUF, (void *)&bufferSize,
+			sizeof(bufferSize)) != 0) ||
+	    (setsockopt(connfd, SOL_SOCKET, SO_SNDBUF, (void *)&bufferSize,
+			sizeof(bufferSize)) != 0))
+	    return 2;
+    }
+
+    if (noDelay) {
+	if (setsockopt(connfd, IPPROTO_TCP, TCP_NODELAY, (void *)&flag,
+		       sizeof(flag)) != 0)
+	    return 3;
+    }
+
+    return 0;
 }
 
 /**
@@ -1150,77 +1366,57 @@ int ZaurusType::ObtainSyncIDLists(const unsigned char type) {
 }
 
 /**
- * Get Todo Item.
+ * Fetch Item.
  *
- * Obtain a Todo item from the Zaurus given the type of sync and the items
- * synchronization id.
- * @param type An identifier representing the type of sync.
- * @param syncID The sync ID of the item to retreive from the Zaurus.
- * @return A TodoItemType object containing the requested items data.
+ * Obtain an item given its synchronization id. If the journal holds the
+ * item from an interrupted sync it is taken from the journal, otherwise it
+ * is obtained from the Zaurus and recorded in the journal. Either way the
+ * item is recorded in the mirror. The journal is only resumed shortly after
+ * the sync was interrupted, so that the items it holds are unlikely to
+ * have changed since.
+ * @param syncID The sync ID of the item to fetch.
+ * @return An item object containing the requested items data.
  */
-TodoItemType ZaurusType::GetTodoItem(unsigned char type,
-				     unsigned long int syncID) {
-    ADRMessageType *pADRMsg;
-    TodoItemType todoItem;
-    CardParamInfoType::List::iterator iter;
-
-    if (RecvRqst(connfd) != 0)
-	return todoItem;
-
-    // Here, I send the RDR to request the data content of an item given the
-    // type (Todo, Calendar, etc) and the synchronization ID (unique ID) of
-    // the item.
-    SendRDR(connfd, type, syncID);
-
-    if (RecvAck(connfd) != 0)
-	return todoItem;
-
-    SendRqst(connfd);
-
-    // Here, I dynamically allocate memory for an ADR message and recv a
-    // message, storing it in the ADR message (the response to the RDR).
-    pADRMsg = new ADRMessageType;
-    if (!pADRMsg)
-	return todoItem;
-
-    if (RecvMessage(connfd, pADRMsg) != 0)
-	return todoItem;
-
-    // Load the Content of the message, if this is not done then
-    // SetTodoItemParam() will cause a segfault because it will be trying to
-    // access a pointer that is set to NULL.
-    pADRMsg->LoadContent();
-
-    // Here I parse the message content to obtain the item data within so that
-    // I may create a Calendar item object with the proper data.
-    for (iter = paramInfoList.begin(); iter != paramInfoList.end(); ++iter) {
-	SetTodoItemParam(todoItem, pADRMsg, (*iter));
+template <class ItemT>
+ItemT ZaurusType::FetchItem(unsigned long int syncID) {
+    ItemT item;
+    std::string itemData;
+
+    if (!pJournal || (pJournal->GetFetched(syncID, itemData) != 0) ||
+	(ItemCodecType::DecodeItem(itemData, item) != 0)) {
+	item = GetItem<ItemT>(syncType, syncID);
+
+	if (pJournal) {
+	    ItemCodecType::EncodeItem(item, itemData);
+	    pJournal->RecordFetched(syncID, itemData);
+	}
     }
 
-    delete pADRMsg;
+    if (pMirror)
+	pMirror->Put(syncID, item.ContentHash());
 
-    SendAck(connfd);
-
-    return todoItem;
+    return item;
 }
 
 /**
- * Get Calendar Item.
+ * Get Item.
  *
- * Obtain a Calendar item from the Zaurus given the type of sync and the items
+ * Obtain an item from the Zaurus given the type of sync and the items
  * synchronization id.
  * @param type An identifier representing the type of sync.
  * @param syncID The sync ID of the item to retreive from the Zaurus.
- * @return A CalendarItemType object containing the requested items data.
+ * @return An item object containing the requested items data.
  */
-CalendarItemType ZaurusType::GetCalendarItem(unsigned char type,
-					     unsigned long int syncID) {
+template <class ItemT>
+ItemT ZaurusType::GetItem(unsigned char type, unsigned long int syncID) {
     ADRMessageType *pADRMsg;
-    CalendarItemType calItem;
-    CardParamInfoType::List::iterator iter;
+    ItemT item;
+    ParamValueListType keptValues;
+    struct sParamValue value;
+    CardParamInfoType::List::size_type i;
 
     if (RecvRqst(connfd) != 0)
-	return calItem;
+	return item;
 
     // Here, I send the RDR to request the data content of an item given the
     // type (Todo, Calendar, etc) and the synchronization ID (unique ID) of
@@ -1228,7 +1424,7 @@ CalendarItemType ZaurusType::GetCalendarItem(unsigned char type,
     SendRDR(connfd, type, syncID);
 
     if (RecvAck(connfd) != 0)
-	return calItem;
+	return item;
 
     SendRqst(connfd);
 
@@ -1236,375 +1432,313 @@ CalendarItemType ZaurusType::GetCalendarItem(unsigned char type,
     // message, storing it in the ADR message (the response to the RDR).
     pADRMsg = new ADRMessageType;
     if (!pADRMsg)
-	return calItem;
+	return item;
 
     if (RecvMessage(connfd, pADRMsg) != 0)
-	return calItem;
+	return item;
 
     // Load the Content of the message, if this is not done then
-    // SetCalendarItemParam() will cause a segfault because it will be trying
-    // to access a pointer that is set to NULL.
+    // SetItemParam() will cause a segfault because it will be trying to
+    // access a pointer that is set to NULL.
     pADRMsg->LoadContent();
 
     // Here I parse the message content to obtain the item data within so that
-    // I may create a Calendar item object with the proper data.
-    for (iter = paramInfoList.begin(); iter != paramInfoList.end(); ++iter) {
-	SetCalendarItemParam(calItem, pADRMsg, (*iter));
+    // I may create an item object with the proper data. The values of the
+    // parameters written when modifying the item, all but the first four,
+    // which the item has no field for are kept in their order.
+    for (i = 0; i < paramInfoList.size(); i++) {
+	SetItemParam(item, pADRMsg, paramInfoList[i], value);
+	if ((i >= 4) && IsKeptParam<ItemT>(paramInfoList[i]))
+	    keptValues.push_back(value);
     }
+    if (!keptValues.empty())
+	keptParams[syncID].swap(keptValues);
 
     delete pADRMsg;
 
     SendAck(connfd);
 
-    return calItem;
-}
-
-/**
- * Modify Todo Item.
- *
- * Modify a Todo item on the Zaurus given the type of sync and the items data.
- * @param type An identifier representing the type of sync. The To-Do item
- * must have the same Sync ID as the item it's data should modify.
- * @param todoItem The todoItem and its data to update on the Zaurus.
- * @return An integer representing success (zero) or failure (non-zero).
- * @retval 0 Successfully, requested item be deleted.
- * @retval 1 Failed to receive a message request.
- * @retval 2 Failed to receive a message acknowledgment.
- * @retval 3 Failed to allocate memory for building message content.
- * @retval 4 Failed to receive a ADW message in response.
- */
-int ZaurusType::ModifyTodoItem(unsigned char type, TodoItemType todoItem) {
-    RDWMessageType RDWMsg;
-    MessageType msg;
-    CardParamInfoType::List::iterator iter;
-    
-    // Initialize the RDW Message object to that of the Modification variation
-    // of the message.
-    if (RDWMsg.InitAsMod(type, todoItem.GetSyncID()))
-	return 1;
-
-    // Iterate through the parameter list and build the RDW message.
-    iter = paramInfoList.begin();
-    for (iter += 4; iter != paramInfoList.end(); ++iter) {
-	if (GetTodoItemParam(todoItem, &RDWMsg, (*iter)))
-	    return 2;
-    }
-
-    // Commit the RDW message content so that it the building is finished and
-    // the message is put into a more usable state.
-    if (RDWMsg.CommitContent())
-	return 3;
-
-    // Now that it has been packed into the RDWMsg the message is now ready to
-    // be sent. However I must handle the rest of the protocol before I can
-    // send the message.
-    if (RecvRqst(connfd))
-	return 4;
-
-    SendMessage(connfd, &RDWMsg);
-
-    if (RecvAck(connfd))
-	return 5;
-
-    SendRqst(connfd);
-
-    if (RecvMessage(connfd, &msg))
-	return 6;
-
-    SendAck(connfd);
-
-    return 0;
+    return item;
 }
 
 /**
- * Modify Calendar Item.
+ * Encode a modification message.
  *
- * Modify a Calendar item on the Zaurus given the type of synchronization and
- * the item data that should be modified.
- * @param type An identifier representing the type of sync. The item
- * must have the same Sync ID as the item it's data should modify.
- * @param calItem The calItem and its data to update on the Zaurus.
+ * Build and commit the RDW message which modifies the given item on the
+ * Zaurus. The parameters the item has no field for are written with the
+ * values kept when the item was read from the Zaurus, and an item which
+ * has not been read is not modified at all rather than having them
+ * blanked. This performs no I/O, hence it may be called from any thread.
+ * @param item The item and its data to update on the Zaurus. The item must
+ * have the same Sync ID as the item it's data should modify.
+ * @param pRDWMsg Pointer to the RDW message to build.
  * @return An integer representing success (zero) or failure (non-zero).
- * @retval 0 Successfully, requested item be deleted.
+ * @retval 0 Successfully encoded the message.
  * @retval 1 Failed to Initialize RDWMessageType object as Mod variation.
- * @retval 2 Failed to Get a calender item parameter and append it.
+ * @retval 2 Failed to Get an item parameter and append it.
  * @retval 3 Failed to Commit the build RDWMessageType objects content.
- * @retval 4 Failed to receive a message request.
- * @retval 5 Failed to receive a message acknowledgment.
- * @retval 6 Failed to allocate memory for building message content.
+ * @retval 4 Failed, no values are kept for the parameters the item has no
+ * field for.
  */
-int ZaurusType::ModifyCalendarItem(unsigned char type,
-				   CalendarItemType calItem) {
-    RDWMessageType RDWMsg;
-    MessageType msg;
-    CardParamInfoType::List::iterator iter;
-    
+template <class ItemT>
+int ZaurusType::EncodeModFrame(const ItemT &item,
+			       RDWMessageType *const pRDWMsg) {
+    std::map<unsigned long int, ParamValueListType>::const_iterator fndIter;
+    const ParamValueListType *pKeptList = NULL;
+    const struct sParamValue *pKeptValue;
+    CardParamInfoType::List::size_type i;
+    ParamValueListType::size_type k = 0;
+
+    fndIter = keptParams.find(item.GetSyncID());
+    if (fndIter != keptParams.end())
+	pKeptList = &(fndIter->second);
+    else if (HasKeptParams<ItemT>())
+	return 4;
+
     // Initialize the RDW Message object to that of the Modification variation
     // of the message.
-    if (RDWMsg.InitAsMod(type, calItem.GetSyncID()))
+    if (pRDWMsg->InitAsMod(syncType, item.GetSyncID()))
 	return 1;
 
     // Iterate through the parameter list and build the RDW message.
-    iter = paramInfoList.begin();
-    for (iter += 4; iter != paramInfoList.end(); ++iter) {
-	if (GetCalendarItemParam(calItem, &RDWMsg, (*iter)))
+    for (i = 4; i < paramInfoList.size(); i++) {
+	pKeptValue = NULL;
+	if (pKeptList && (k < pKeptList->size()) &&
+	    IsKeptParam<ItemT>(paramInfoList[i]))
+	    pKeptValue = &((*pKeptList)[k++]);
+
+	if (GetItemParam(item, pRDWMsg, paramInfoList[i], pKeptValue))
 	    return 2;
     }
 
     // Commit the RDW message content so that it the building is finished and
     // the message is put into a more usable state.
-    if (RDWMsg.CommitContent())
+    if (pRDWMsg->CommitContent())
 	return 3;
 
-    // Now that it has been packed into the RDWMsg the message is now ready to
-    // be sent. However I must handle the rest of the protocol before I can
-    // send the message.
-    if (RecvRqst(connfd))
-	return 4;
-
-    SendMessage(connfd, &RDWMsg);
-
-    if (RecvAck(connfd))
-	return 5;
-
-    SendRqst(connfd);
-
-    if (RecvMessage(connfd, &msg))
-	return 6;
-
-    SendAck(connfd);
-
     return 0;
 }
 
 /**
- * Add Todo Item.
+ * Encode the addition messages.
  *
- * Add a Todo item to the Zaurus given the type of sync and the items data.
- * @param type An identifier representing the type of sync.
- * @param todoItem The todoItem and its data to update on the Zaurus.
- * @return The To-Do item that was just added with its sync ID now set.
+ * Build and commit both of the RDW messages used to add the given item to
+ * the Zaurus. The first requests that the Zaurus allocate space for a new
+ * item and send back its synchronization ID. The second sends the data of
+ * the new item. Since the synchronization ID is not known until the first
+ * message has been answered, the SYID parameter of the second message is
+ * left as a place holder and its offset is stored so that it can be patched
+ * in later. This performs no I/O, hence it may be called from any thread.
+ * @param item The item and its data to add to the Zaurus.
+ * @param pObtIdMsg Pointer to the obtain sync ID RDW message to build.
+ * @param pRDWMsg Pointer to the new item RDW message to build.
+ * @param syncIdOffset Reference to store the offset of the SYID parameter
+ * in, zero if the parameter list has no SYID parameter.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully encoded the messages.
+ * @retval 1 Failed to build the obtain sync ID message.
+ * @retval 2 Failed to build the new item message.
  */
-TodoItemType ZaurusType::AddTodoItem(unsigned char type,
-				     TodoItemType todoItem) {
-    TodoItemType errTodo;
-    RDWMessageType obtIdMsg;
-    ADWMessageType idIsMsg;
+template <class ItemT>
+int ZaurusType::EncodeAddFrames(const ItemT &item,
+				RDWMessageType *const pObtIdMsg,
+				RDWMessageType *const pRDWMsg,
+				unsigned short int &syncIdOffset) {
     CardParamInfoType::List::iterator iter;
-    unsigned long int syncId;
 
-    // Since adding an item to the Zaurus is a two step event I perform the
-    // first step here, which is basically to request that the Zaurus allocate
-    // space for a new item and have it send back the synchronization ID of
-    // the allocated space so that in the second step I can send the data to
-    // the Zaurus.
+    syncIdOffset = 0;
 
     // Initialize the obtIdMsg object to the Obtain Sync ID variation of the
     // RDWMessageType object.
-    if (obtIdMsg.InitAsObt(type))
-	return errTodo;
+    if (pObtIdMsg->InitAsObt(syncType))
+	return 1;
 
     // Build the message content. In this case all the obtain ID variation of
     // the RDW message contains is the ATTR attribute of the message. Since
     // the ATTR attribute (parameter) of the is always the first attribute in
     // the parameter list I just set the iterator to the beginning of the list.
     iter = paramInfoList.begin();
-    if (GetTodoItemParam(todoItem, &obtIdMsg, (*iter)))
-	return errTodo;
-
-    // Commit the RDW message content so that it the building is finished and
-    // the message is put into a more usable state.
-    if (obtIdMsg.CommitContent())
-	return errTodo;
-
-    // At this point the message content has been built and packed into the
-    // correct instance of the RDWMessageType class. Hence, I send the message
-    // and attempt to get a ADW message back containing the sync ID of the
-    // newly requested item.
-    if (RecvRqst(connfd))
-	return errTodo;
+    if (GetItemParam(item, pObtIdMsg, (*iter),
+		     (const struct sParamValue *)NULL))
+	return 1;
 
-    SendMessage(connfd, &obtIdMsg);
+    if (pObtIdMsg->CommitContent())
+	return 1;
 
-    if (RecvAck(connfd))
-	return errTodo;
+    // Initialize the RDWMsg object to the New Item variation of the
+    // RDWMessageType object.
+    if (pRDWMsg->InitAsNew(syncType))
+	return 2;
 
-    SendRqst(connfd);
+    // Iterate through the parameter list and build the RDW message, noting
+    // where the sync ID is stored.
+    for (iter = paramInfoList.begin(); iter != paramInfoList.end(); ++iter) {
+	if ((*iter).GetAbrev() == std::string("SYID"))
+	    syncIdOffset = pRDWMsg->GetBuiltSize();
 
-    if (RecvMessage(connfd, &idIsMsg)) {
-	return errTodo;
+	if (GetItemParam(item, pRDWMsg, (*iter),
+			 (const struct sParamValue *)NULL))
+	    return 2;
     }
 
-    SendAck(connfd);
-
-    // At this point I have requested and have obtained the message containing
-    // the synchronization ID of the new item. Due to this I extract the
-    // synchronization ID from the message and store it for later use when I
-    // update tho item data.
-    syncId = idIsMsg.GetSyncID();
+    if (pRDWMsg->CommitContent())
+	return 2;
 
-    errTodo = todoItem;
-    errTodo.SetSyncID(syncId);
+    return 0;
+}
 
-    // Now that I have obtained the synchronization ID I want to use the
-    // synchronization ID to perform the second phase of the event. In this
-    // phase I build another variation of the RDW message, which is used to
-    // send the data of a new item to the Zaurus, and attempt to receive
-    // an ADW message back stating succes.
-    RDWMessageType RDWMsg;
+/**
+ * Send a modification message.
+ *
+ * Send an already encoded modification RDW message to the Zaurus, handling
+ * the rest of the protocol around it.
+ * @param pRDWMsg Pointer to the encoded RDW message to send.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully modified the item.
+ * @retval 1 Failed to receive a message request.
+ * @retval 2 Failed to receive a message acknowledgment.
+ * @retval 3 Failed to receive a message in response.
+ */
+int ZaurusType::SendModFrame(RDWMessageType *const pRDWMsg) {
     MessageType msg;
 
-    // Initialize the RDWMsg object to the New Item variation of the
-    // RDWMessageType object.
-    if (RDWMsg.InitAsNew(type))
-	return errTodo;
-
-    // Iterate through the parameter list and build the RDW message.
-    for (iter = paramInfoList.begin(); iter != paramInfoList.end(); ++iter) {
-	if (GetTodoItemParam(errTodo, &RDWMsg, (*iter)))
-	    return errTodo;
-    }
-
-    // Commit the RDW message content so that it the building is finished and
-    // the message is put into a more usable state.
-    if (RDWMsg.CommitContent())
-	return errTodo;
-    
-    // Now that it has been packed into the RDWMsg the message is now ready to
-    // be sent. However I must handle the rest of the protocol before I can
-    // send the message.
-    if (RecvRqst(connfd) != 0)
-	return errTodo;
+    if (RecvRqst(connfd))
+	return 1;
 
-    SendMessage(connfd, &RDWMsg);
+    SendMessage(connfd, pRDWMsg);
 
-    if (RecvAck(connfd) != 0)
-	return errTodo;
+    if (RecvAck(connfd))
+	return 2;
 
     SendRqst(connfd);
 
-    if (RecvMessage(connfd, &msg) != 0) {
-	return errTodo;
-    }
+    if (RecvMessage(connfd, &msg))
+	return 3;
 
     SendAck(connfd);
 
-    return errTodo;
+    return 0;
 }
 
 /**
- * Add Calendar Item.
+ * Send the addition messages.
  *
- * Add a Calendar item to the Zaurus given the type of sync and the items data.
- * @param type An identifier representing the type of sync.
- * @param calItem The Calendar Item and its data to update on the Zaurus.
- * @return The calendar item that was just added with its sync ID now set.
+ * Send already encoded addition RDW messages to the Zaurus, handling the
+ * rest of the protocol around them. Once the Zaurus has responded to the
+ * obtain sync ID message with the synchronization ID of the new item, the ID
+ * is patched into the new item message before it is sent.
+ * @param pObtIdMsg Pointer to the encoded obtain sync ID RDW message.
+ * @param pRDWMsg Pointer to the encoded new item RDW message.
+ * @param syncIdOffset The offset of the SYID parameter in the new item
+ * message, or zero if it has none.
+ * @param syncId Reference to store the synchronization ID of the new item
+ * in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * Values of four and above mean the sync ID was obtained.
+ * @retval 0 Successfully added the item.
+ * @retval 1 Failed to receive a message request for the obtain ID message.
+ * @retval 2 Failed to receive an acknowledgment for the obtain ID message.
+ * @retval 3 Failed to receive an ADW message in response.
+ * @retval 4 Failed to patch the sync ID into the new item message.
+ * @retval 5 Failed to receive a message request for the new item message.
+ * @retval 6 Failed to receive an acknowledgment for the new item message.
+ * @retval 7 Failed to receive a message in response.
  */
-CalendarItemType ZaurusType::AddCalendarItem(unsigned char type,
-					     CalendarItemType calItem) {
-    CalendarItemType errCal;
-    RDWMessageType obtIdMsg;
+int ZaurusType::SendAddFrames(RDWMessageType *const pObtIdMsg,
+			      RDWMessageType *const pRDWMsg,
+			      unsigned short int syncIdOffset,
+			      unsigned long int &syncId) {
     ADWMessageType idIsMsg;
-    CardParamInfoType::List::iterator iter;
-    unsigned long int syncId;
+    MessageType msg;
 
     // Since adding an item to the Zaurus is a two step event I perform the
     // first step here, which is basically to request that the Zaurus allocate
     // space for a new item and have it send back the synchronization ID of
     // the allocated space so that in the second step I can send the data to
     // the Zaurus.
-
-    // Initialize the obtIdMsg object to the Obtain Sync ID variation of the
-    // RDWMessageType object.
-    if (obtIdMsg.InitAsObt(type))
-	return errCal;
-
-    // Build the message content. In this case all the obtain ID variation of
-    // the RDW message contains is the ATTR attribute of the message. Since
-    // the ATTR attribute (parameter) of the is always the first attribute in
-    // the parameter list I just set the iterator to the beginning of the list.
-    iter = paramInfoList.begin();
-    if (GetCalendarItemParam(calItem, &obtIdMsg, (*iter)))
-	return errCal;
-
-    // Commit the RDW message content so that it the building is finished and
-    // the message is put into a more usable state.
-    if (obtIdMsg.CommitContent())
-	return errCal;
-
-    // At this point the message content has been built and packed into the
-    // correct instance of the RDWMessageType class. Hence, I send the message
-    // and attempt to get a ADW message back containing the sync ID of the
-    // newly requested item.
     if (RecvRqst(connfd))
-	return errCal;
+	return 1;
 
-    SendMessage(connfd, &obtIdMsg);
+    SendMessage(connfd, pObtIdMsg);
 
     if (RecvAck(connfd))
-	return errCal;
+	return 2;
 
     SendRqst(connfd);
 
-    if (RecvMessage(connfd, &idIsMsg)) {
-	return errCal;
-    }
+    if (RecvMessage(connfd, &idIsMsg))
+	return 3;
 
     SendAck(connfd);
 
     // At this point I have requested and have obtained the message containing
     // the synchronization ID of the new item. Due to this I extract the
-    // synchronization ID from the message and store it for later use when I
-    // update tho item data.
+    // synchronization ID from the message and patch it into the already
+    // built new item message.
     syncId = idIsMsg.GetSyncID();
 
-    errCal = calItem;
-    errCal.SetSyncID(syncId);
-
-    // Now that I have obtained the synchronization ID I want to use the
-    // synchronization ID to perform the second phase of the event. In this
-    // phase I build another variation of the RDW message, which is used to
-    // send the data of a new item to the Zaurus, and attempt to receive
-    // an ADW message back stating succes.
-    RDWMessageType RDWMsg;
-    MessageType msg;
-
-    // Initialize the RDWMsg object to the New Item variation of the
-    // RDWMessageType object.
-    if (RDWMsg.InitAsNew(type))
-	return errCal;
-
-    // Iterate through the parameter list and build the RDW message.
-    for (iter = paramInfoList.begin(); iter != paramInfoList.end(); ++iter) {
-	if (GetCalendarItemParam(calItem, &RDWMsg, (*iter)))
-	    return errCal;
+    if (syncIdOffset) {
+	if (pRDWMsg->PatchULong(syncIdOffset, syncId))
+	    return 4;
     }
 
-    // Commit the RDW message content so that it the building is finished and
-    // the message is put into a more usable state.
-    if (RDWMsg.CommitContent())
-	return errCal;
-    
-    // Now that it has been packed into the RDWMsg the message is now ready to
-    // be sent. However I must handle the rest of the protocol before I can
-    // send the message.
+    // Now I perform the second phase of the event, sending the data of the
+    // new item to the Zaurus.
     if (RecvRqst(connfd) != 0)
-	return errCal;
+	return 5;
 
-    SendMessage(connfd, &RDWMsg);
+    SendMessage(connfd, pRDWMsg);
 
     if (RecvAck(connfd) != 0)
-	return errCal;
+	return 6;
 
     SendRqst(connfd);
 
-    if (RecvMessage(connfd, &msg) != 0) {
-	return errCal;
-    }
+    if (RecvMessage(connfd, &msg) != 0)
+	return 7;
 
     SendAck(connfd);
 
-    return errCal;
+    return 0;
+}
+
+/**
+ * Encode a modification message job.
+ *
+ * The worker pool job function used to encode the modification message for
+ * a single item.
+ * @param pCtx Pointer to the sEncodeJobs describing the jobs.
+ * @param jobIndex The index of the item to encode.
+ */
+template <class ItemT>
+void ZaurusType::EncodeModJob(void *pCtx, unsigned int jobIndex) {
+    struct sEncodeJobs<ItemT> *pJobs = (struct sEncodeJobs<ItemT> *)pCtx;
+
+    pJobs->frames[jobIndex] = new RDWMessageType;
+    pJobs->results[jobIndex] =
+	pJobs->pZaurus->EncodeModFrame(*(pJobs->items[jobIndex]),
+				       pJobs->frames[jobIndex]);
+}
+
+/**
+ * Encode the addition messages job.
+ *
+ * The worker pool job function used to encode the addition messages for a
+ * single item.
+ * @param pCtx Pointer to the sEncodeJobs describing the jobs.
+ * @param jobIndex The index of the item to encode.
+ */
+template <class ItemT>
+void ZaurusType::EncodeAddJob(void *pCtx, unsigned int jobIndex) {
+    struct sEncodeJobs<ItemT> *pJobs = (struct sEncodeJobs<ItemT> *)pCtx;
+
+    pJobs->obtIdFrames[jobIndex] = new RDWMessageType;
+    pJobs->frames[jobIndex] = new RDWMessageType;
+    pJobs->results[jobIndex] =
+	pJobs->pZaurus->EncodeAddFrames(*(pJobs->items[jobIndex]),
+					pJobs->obtIdFrames[jobIndex],
+					pJobs->frames[jobIndex],
+					pJobs->syncIdOffsets[jobIndex]);
 }
 
 /**
@@ -1675,297 +1809,128 @@ int ZaurusType::StateSyncDone(const unsigned char type) {
 }
 
 /**
- * Get Todo Item Parameter.
+ * Check if a parameter is kept.
  *
- * Get a Todo Item Parameter from a Todo object and append it to a
- * previously initialized RDWMessageType object.
- * @param item Reference to TodoItemType object to obtain the data from.
- * @param A pointer to the RDWMessageType object to append parameter to.
- * @param paramInfo A reference to an object containing the param info for the
- * item to write.
- * @return An integer representing success (zero) or failure (non-zero).
+ * Check if the given parameter is one the items of the given type have no
+ * field to write to the Zaurus, either because there is no such field or
+ * because the Zaurus describes it as a different type than the field is.
+ * The values of such parameters are kept as they were read from the Zaurus.
+ * @param paramInfo A reference to the param info of the parameter.
+ * @return A boolean value representing if the parameter is kept.
  */
-int ZaurusType::GetTodoItemParam(const TodoItemType &item,
-				 RDWMessageType *const pRDWMsg,
-				 const CardParamInfoType &paramInfo) {
-    std::string paramAbrev;
-    unsigned char paramTypeID;
+template <class ItemT>
+bool ZaurusType::IsKeptParam(const CardParamInfoType &paramInfo) {
+    const FieldDescType<ItemT> *pDesc;
 
-    paramAbrev = paramInfo.GetAbrev();
-    paramTypeID = paramInfo.GetTypeID();
-
-    switch (paramTypeID) {
-	case DATA_ID_BIT:
-	    if (paramAbrev == std::string("ATTR")) {
-		if (pRDWMsg->AppendBit(item.GetAttribute()))
-		    return 1;
-	    }
-	    break;
-
-	case DATA_ID_TIME:
-	    if (paramAbrev == std::string("CTTM")) {
-		if (pRDWMsg->AppendTime(item.GetCreatedTime()))
-		    return 2;
-	    } else if (paramAbrev == std::string("MDTM")) {
-		if (pRDWMsg->AppendTime(item.GetModifiedTime()))
-		    return 2;
-	    } else if (paramAbrev == std::string("ETDY")) {
-		if (pRDWMsg->AppendTime(item.GetStartDate()))
-		    return 2;
-	    } else if (paramAbrev == std::string("LTDY")) {
-		if (pRDWMsg->AppendTime(item.GetDueDate()))
-		    return 2;
-	    } else if (paramAbrev == std::string("FNDY")) {
-		if (pRDWMsg->AppendTime(item.GetCompletedDate()))
-		    return 2;
-	    }
-	    break;
-
-	case DATA_ID_ULONG:
-	    if (paramAbrev == std::string("SYID")) {
-		if (pRDWMsg->AppendULong(item.GetSyncID()))
-		    return 3;
-	    }
-	    break;
-
-	case DATA_ID_BARRAY:
-	    if (paramAbrev == std::string("CTGR")) {
-		if (pRDWMsg->AppendBarray(item.GetCategory()))
-		    return 4;
-	    }
-	    break;
-
-	case DATA_ID_UTF8:
-	    if (paramAbrev == std::string("TITL")) {
-		if (pRDWMsg->AppendUTF8(item.GetDescription()))
-		    return 5;
-	    } else if (paramAbrev == std::string("MEM1")) {
-		if (pRDWMsg->AppendUTF8(item.GetNotes()))
-		    return 5;
-	    }
-	    break;
-
-	case DATA_ID_UCHAR:
-	    if (paramAbrev == std::string("MARK")) {
-		if (pRDWMsg->AppendUChar(item.GetProgressStatus()))
-		    return 6;
-	    } else if (paramAbrev == std::string("PRTY")) {
-		if (pRDWMsg->AppendUChar(item.GetPriority()))
-		    return 6;
-	    }
-	    break;
-
-	default:
-	    break;
-    }
-
-    return 0;
+    pDesc = FindFieldDesc<ItemT>(paramInfo.GetAbrev(), FIELD_TO_ZAURUS);
+    return (!pDesc || (pDesc->typeID != paramInfo.GetTypeID()));
 }
 
 /**
- * Set Todo Item Parameter.
+ * Check if any parameters are kept.
  *
- * Set a Todo Item Parameter given a reference to the todo item, a
- * pointer to the ADR message to obtain the data from and a reference to the
- * parameter information.
- * @param item Reference to Todo item to set parameter in.
- * @param pADRMsg A pointer to the ADR message to obtain the data.
- * @param paramInfo CardParamInfoType object containing the parameter info.
- * @return An integer representing success (zero) or failure (non-zero).
- * @retval 0 Successfully set the calendar item parameter.
+ * Check if any of the parameters written when modifying an item, which are
+ * all but the first four, are kept rather than written from the item.
+ * @return A boolean value representing if any parameters are kept.
  */
-int ZaurusType::SetTodoItemParam(TodoItemType &item,
-				 ADRMessageType *const pADRMsg,
-				 const CardParamInfoType &paramInfo) {
-    std::string paramAbrev;
-    unsigned char paramTypeID;
-
-    paramAbrev = paramInfo.GetAbrev();
-    paramTypeID = paramInfo.GetTypeID();
+template <class ItemT>
+bool ZaurusType::HasKeptParams(void) const {
+    CardParamInfoType::List::size_type i;
 
-    std::cout << "Entered SetTodoItemParm().\n";
-    std::cout << "Attempting to Set " << paramAbrev << ".\n";
-
-    switch (paramTypeID) {
-	case DATA_ID_BIT:
-	    if (paramAbrev == std::string("ATTR")) {
-		std::cout << "About to set attribute.\n";
-		unsigned char dataBit;
-		dataBit = pADRMsg->GetBit();
-		std::cout << "Obtained the bit.\n";
-		item.SetAttribute(dataBit);
-		std::cout << "Set attribute.\n";
-	    }
-	    break;
-
-	case DATA_ID_TIME:
-	    if (paramAbrev == std::string("CTTM")) {
-		item.SetCreatedTime(pADRMsg->GetTime());
-	    } else if (paramAbrev == std::string("MDTM")) {
-		item.SetModifiedTime(pADRMsg->GetTime());
-	    } else if (paramAbrev == std::string("ETDY")) {
-		item.SetStartDate(pADRMsg->GetTime());
-	    } else if (paramAbrev == std::string("LTDY")) {
-		item.SetDueDate(pADRMsg->GetTime());
-	    } else if (paramAbrev == std::string("FNDY")) {
-		item.SetCompletedDate(pADRMsg->GetTime());
-	    }
-	    break;
-
-	case DATA_ID_ULONG:
-	    if (paramAbrev == std::string("SYID")) {
-		item.SetSyncID(pADRMsg->GetULong());
-	    }
-	    break;
-
-	case DATA_ID_BARRAY:
-	    if (paramAbrev == std::string("CTGR")) {
-		item.SetCategory(pADRMsg->GetBarray());
-	    }
-	    break;
-
-	case DATA_ID_UTF8:
-	    if (paramAbrev == std::string("TITL")) {
-		item.SetDescription(pADRMsg->GetUTF8());
-	    } else if (paramAbrev == std::string("MEM1")) {
-		item.SetNotes(pADRMsg->GetUTF8());
-	    }
-	    break;
-
-	case DATA_ID_UCHAR:
-	    if (paramAbrev == std::string("MARK")) {
-		item.SetProgressStatus(pADRMsg->GetUChar());
-	    } else if (paramAbrev == std::string("PRTY")) {
-		item.SetPriority(pADRMsg->GetUChar());
-	    }
-	    break;
-
-	default:
-	    break;
+    for (i = 4; i < paramInfoList.size(); i++) {
+	if (IsKeptParam<ItemT>(paramInfoList[i]))
+	    return true;
     }
 
-    std::cout << "Set param " << paramAbrev << ".\n";
-    std::cout << "Exiting SetTodoItemParam().\n";
-
-    return 0;
+    return false;
 }
 
 /**
- * Get Calendar Item Parameter.
+ * Get Item Parameter.
  *
- * Get a Calendar Item Parameter from a Calendar object and append it to a
- * previously initialized RDWMessageType object.
- * @param item Reference to CalendarItemType object to obtain the data from.
- * @param A pointer to the RDWMessageType object to append parameter to.
+ * Get an item parameter from an item and append it to a previously
+ * initialized RDWMessageType object. The parameter is mapped to the field of
+ * the item through the field descriptors of its type. Parameters the item
+ * has no field for are appended with the value kept when the item was read
+ * from the Zaurus, or empty if none was kept, such as for a new item, so
+ * that the message still holds every parameter the Zaurus expects.
+ * @param item Reference to the item to obtain the data from.
+ * @param pRDWMsg A pointer to the RDWMessageType object to append parameter
+ * to.
  * @param paramInfo A reference to an object containing the param info for the
  * item to write.
+ * @param pKeptValue Pointer to the value of the parameter kept when the item
+ * was read from the Zaurus, or NULL if none was kept.
  * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully appended the parameter.
+ * @retval 1 Failed to append a bit parameter.
+ * @retval 2 Failed to append a time parameter.
+ * @retval 3 Failed to append an unsigned long parameter.
+ * @retval 4 Failed to append a byte array parameter.
+ * @retval 5 Failed to append a UTF8 parameter.
+ * @retval 6 Failed to append an unsigned char parameter.
+ * @retval 7 Failed to append a word parameter.
  */
-int ZaurusType::GetCalendarItemParam(const CalendarItemType &item,
-				     RDWMessageType *const pRDWMsg,
-				     const CardParamInfoType &paramInfo) {
-    std::string paramAbrev;
+template <class ItemT>
+int ZaurusType::GetItemParam(const ItemT &item,
+			     RDWMessageType *const pRDWMsg,
+			     const CardParamInfoType &paramInfo,
+			     const struct sParamValue *pKeptValue) {
+    const FieldDescType<ItemT> *pDesc;
     unsigned char paramTypeID;
+    uint64_t numVal = 0;
+    std::string strVal;
 
-    paramAbrev = paramInfo.GetAbrev();
     paramTypeID = paramInfo.GetTypeID();
 
+    // Here, I look up the field stored in the parameter. If the Zaurus
+    // describes the parameter as a type other than the field is, I treat it
+    // as a parameter the item has no field for.
+    if (!IsKeptParam<ItemT>(paramInfo)) {
+	pDesc = FindFieldDesc<ItemT>(paramInfo.GetAbrev(), FIELD_TO_ZAURUS);
+	if (pDesc->pGetNumber)
+	    numVal = pDesc->pGetNumber(item);
+	else
+	    strVal = pDesc->pGetString(item);
+    } else if (pKeptValue) {
+	numVal = pKeptValue->numVal;
+	strVal = pKeptValue->strVal;
+    }
+
     switch (paramTypeID) {
 	case DATA_ID_BIT:
-	    if (paramAbrev == std::string("ATTR")) {
-		if (pRDWMsg->AppendBit(item.GetAttribute()))
-		    return 1;
-	    }
+	    if (pRDWMsg->AppendBit((unsigned char)numVal))
+		return 1;
 	    break;
 
 	case DATA_ID_TIME:
-	    if (paramAbrev == std::string("CTTM")) {
-		if (pRDWMsg->AppendTime(item.GetCreatedTime()))
-		    return 2;
-	    } else if (paramAbrev == std::string("MDTM")) {
-		if (pRDWMsg->AppendTime(item.GetModifiedTime()))
-		    return 2;
-	    } else if (paramAbrev == std::string("TLM1")) {
-		if (pRDWMsg->AppendTime(item.GetStartTime()))
-		    return 2;
-	    } else if (paramAbrev == std::string("TLM2")) {
-		if (pRDWMsg->AppendTime(item.GetEndTime()))
-		    return 2;
-	    } else if (paramAbrev == std::string("REDT")) {
-		if (pRDWMsg->AppendTime(item.GetRepeatEndDate()))
-		    return 2;
-	    } else if (paramAbrev == std::string("ALSD")) {
-		if (pRDWMsg->AppendTime(item.GetAllDayStartDate()))
-		    return 2;
-	    } else if (paramAbrev == std::string("ALED")) {
-		if (pRDWMsg->AppendTime(item.GetAllDayEndDate()))
-		    return 2;
-	    }
+	    if (pRDWMsg->AppendTime((time_t)numVal))
+		return 2;
 	    break;
 
 	case DATA_ID_ULONG:
-	    if (paramAbrev == std::string("SYID")) {
-		if (pRDWMsg->AppendULong(item.GetSyncID()))
-		    return 3;
-	    }
+	    if (pRDWMsg->AppendULong((unsigned long int)numVal))
+		return 3;
 	    break;
 
 	case DATA_ID_BARRAY:
-	    if (paramAbrev == std::string("CTGR")) {
-		if (pRDWMsg->AppendBarray(item.GetCategory()))
-		    return 4;
-	    }
+	    if (pRDWMsg->AppendBarray(strVal))
+		return 4;
 	    break;
 
 	case DATA_ID_UTF8:
-	    if (paramAbrev == std::string("DSRP")) {
-		if (pRDWMsg->AppendUTF8(item.GetDescription()))
-		    return 5;
-	    } else if (paramAbrev == std::string("PLCE")) {
-		if (pRDWMsg->AppendUTF8(item.GetLocation()))
-		    return 5;
-	    } else if (paramAbrev == std::string("MEM1")) {
-		if (pRDWMsg->AppendUTF8(item.GetNotes()))
-		    return 5;
-	    }
+	    if (pRDWMsg->AppendUTF8(strVal))
+		return 5;
 	    break;
 
 	case DATA_ID_UCHAR:
-	    if (paramAbrev == std::string("ADAY")) {
-		if (pRDWMsg->AppendUChar(item.GetScheduleType()))
-		    return 6;
-	    } else if (paramAbrev == std::string("ARON")) {
-		if (pRDWMsg->AppendUChar(item.GetAlarm()))
-		    return 6;
-	    } else if (paramAbrev == std::string("ARSD")) {
-		if (pRDWMsg->AppendUChar(item.GetAlarmSetting()))
-		    return 6;
-	    } else if (paramAbrev == std::string("RTYP")) {
-		if (pRDWMsg->AppendUChar(item.GetRepeatType()))
-		    return 6;
-	    } else if (paramAbrev == std::string("RDYS")) {
-		if (pRDWMsg->AppendUChar(item.GetRepeatDate()))
-		    return 6;
-	    } else if (paramAbrev == std::string("REND")) {
-		if (pRDWMsg->AppendUChar(item.GetRepeatEndDateSetting()))
-		    return 6;
-	    } else if (paramAbrev == std::string("MDAY")) {
-		if (pRDWMsg->AppendUChar(item.GetMultipleDaysFlag()))
-		    return 6;
-	    }
+	    if (pRDWMsg->AppendUChar((unsigned char)numVal))
+		return 6;
 	    break;
 
 	case DATA_ID_WORD:
-	    if (paramAbrev == std::string("ARMN")) {
-		if (pRDWMsg->AppendWord(item.GetAlarmTime()))
-		    return 7;
-	    } else if (paramAbrev == std::string("RFRQ")) {
-		if (pRDWMsg->AppendWord(item.GetRepeatPeriod()))
-		    return 7;
-	    } else if (paramAbrev == std::string("RPOS")) {
-		if (pRDWMsg->AppendWord(item.GetRepeatPosition()))
-		    return 8;
-	    }
+	    if (pRDWMsg->AppendWord((unsigned short int)numVal))
+		return 7;
 	    break;
 
 	default:
@@ -1976,121 +1941,76 @@ int ZaurusType::GetCalendarItemParam(const CalendarItemType &item,
 }
 
 /**
- * Set Calendar Item Parameter.
+ * Set Item Parameter.
  *
- * Set a Calendar Item Parameter given a reference to the calendar item, a
- * pointer to the ADR message to obtain the data from and a reference to the
- * parameter information.
- * @param item Reference to calendar item to set parameter in.
+ * Set an item parameter given a reference to the item, a pointer to the ADR
+ * message to obtain the data from and a reference to the parameter
+ * information. The parameter is mapped to the field of the item through the
+ * field descriptors of its type. Parameters the item has no field for are
+ * still read, so that the following parameters are read from the right
+ * place in the message, and their values are handed back so that they may
+ * be kept.
+ * @param item Reference to the item to set the parameter in.
  * @param pADRMsg A pointer to the ADR message to obtain the data.
  * @param paramInfo CardParamInfoType object containing the parameter info.
+ * @param value Reference to store the value of the parameter in.
  * @return An integer representing success (zero) or failure (non-zero).
- * @retval 0 Successfully set the calendar item parameter.
+ * @retval 0 Successfully set the item parameter.
  */
-int ZaurusType::SetCalendarItemParam(CalendarItemType &item,
-				     ADRMessageType *const pADRMsg,
-				     const CardParamInfoType &paramInfo) {
-    // This function is basically a function which maps all of the calendar
-    // item parameters to the associated parameter member functions of the
-    // CalendarItemType. This function allows the mapping to exist in a single
-    // location, eliminating the need to duplicate the mapping in other places
-    // of the ZaurusType. Beyond that it also provides an easier way to write
-    // the GetCalendarItem function.
-
-    std::string paramAbrev;
+template <class ItemT>
+int ZaurusType::SetItemParam(ItemT &item, ADRMessageType *const pADRMsg,
+			     const CardParamInfoType &paramInfo,
+			     struct sParamValue &value) {
+    const FieldDescType<ItemT> *pDesc;
     unsigned char paramTypeID;
 
-    paramAbrev = paramInfo.GetAbrev();
     paramTypeID = paramInfo.GetTypeID();
+    value.numVal = 0;
+    value.strVal.clear();
 
     switch (paramTypeID) {
 	case DATA_ID_BIT:
-	    if (paramAbrev == std::string("ATTR")) {
-		item.SetAttribute(pADRMsg->GetBit());
-	    }
+	    value.numVal = pADRMsg->GetBit();
 	    break;
 
 	case DATA_ID_TIME:
-	    if (paramAbrev == std::string("CTTM")) {
-		item.SetCreatedTime(pADRMsg->GetTime());
-	    } else if (paramAbrev == std::string("MDTM")) {
-		item.SetModifiedTime(pADRMsg->GetTime());
-	    } else if (paramAbrev == std::string("TIM1")) {
-		item.SetStartTime(pADRMsg->GetTime());
-	    } else if (paramAbrev == std::string("TIM2")) {
-		item.SetEndTime(pADRMsg->GetTime());
-	    } else if (paramAbrev == std::string("REDT")) {
-		if (item.GetRepeatEndDateSetting() == 0) {
-		    std::cout << "Repeat End Date is NOT set.\n";
-		    // This is going to fail I am sure, but it still needs to
-		    // obtain the data and adjust the pointers.
-		    pADRMsg->GetTime();
-		} else {
-		    std::cout << "Repeat End Date IS set.\n";
-		    item.SetRepeatEndDate(pADRMsg->GetTime());
-		}
-	    } else if (paramAbrev == std::string("ALSD")) {
-		item.SetAllDayStartDate(pADRMsg->GetTime());
-	    } else if (paramAbrev == std::string("ALED")) {
-		item.SetAllDayEndDate(pADRMsg->GetTime());
-	    }
+	    value.numVal = (uint64_t)pADRMsg->GetTime();
 	    break;
 
 	case DATA_ID_ULONG:
-	    if (paramAbrev == std::string("SYID")) {
-		item.SetSyncID(pADRMsg->GetULong());
-	    }
+	    value.numVal = pADRMsg->GetULong();
 	    break;
 
 	case DATA_ID_BARRAY:
-	    if (paramAbrev == std::string("CTGR")) {
-		item.SetCategory(pADRMsg->GetBarray());
-	    }
+	    value.strVal = pADRMsg->GetBarray();
 	    break;
 
 	case DATA_ID_UTF8:
-	    if (paramAbrev == std::string("DSRP")) {
-		item.SetDescription(pADRMsg->GetUTF8());
-	    } else if (paramAbrev == std::string("PLCE")) {
-		item.SetLocation(pADRMsg->GetUTF8());
-	    } else if (paramAbrev == std::string("MEM1")) {
-		item.SetNotes(pADRMsg->GetUTF8());
-	    }
+	    value.strVal = pADRMsg->GetUTF8();
 	    break;
 
 	case DATA_ID_UCHAR:
-	    if (paramAbrev == std::string("ADAY")) {
-		item.SetScheduleType(pADRMsg->GetUChar());
-	    } else if (paramAbrev == std::string("ARON")) {
-		item.SetAlarm(pADRMsg->GetUChar());
-	    } else if (paramAbrev == std::string("ARSD")) {
-		item.SetAlarmSetting(pADRMsg->GetUChar());
-	    } else if (paramAbrev == std::string("RTYP")) {
-		item.SetRepeatType(pADRMsg->GetUChar());
-	    } else if (paramAbrev == std::string("RDYS")) {
-		item.SetRepeatDate(pADRMsg->GetUChar());
-	    } else if (paramAbrev == std::string("REND")) {
-		item.SetRepeatEndDateSetting(pADRMsg->GetUChar());
-	    } else if (paramAbrev == std::string("MDAY")) {
-		item.SetMultipleDaysFlag(pADRMsg->GetUChar());
-	    }
+	    value.numVal = pADRMsg->GetUChar();
 	    break;
 
 	case DATA_ID_WORD:
-	    if (paramAbrev == std::string("ARMN")) {
-		item.SetAlarmTime(pADRMsg->GetWord());
-	    } else if (paramAbrev == std::string("RFRQ")) {
-		item.SetRepeatPeriod(pADRMsg->GetWord());
-	    } else if (paramAbrev == std::string("RPOS")) {
-		item.SetRepeatPosition(pADRMsg->GetWord());
-	    }
+	    value.numVal = pADRMsg->GetWord();
 	    break;
 
 	default:
-	    break;
+	    return 0;
+    }
+
+    // Here, I look up the field stored in the parameter and set it, leaving
+    // the item untouched if it has no such field.
+    pDesc = FindFieldDesc<ItemT>(paramInfo.GetAbrev(), FIELD_FROM_ZAURUS);
+    if (pDesc && (pDesc->typeID == paramTypeID)) {
+	if (pDesc->pSetNumber)
+	    pDesc->pSetNumber(item, value.numVal);
+	else
+	    pDesc->pSetString(item, value.strVal);
     }
 
-    // Return in success.
     return 0;
 }
 
@@ -2111,3 +2031,27 @@ void ZaurusType::PrintCardParams(void) {
 	std::cout << "TypeID: " << (int)(*iter).GetTypeID() << ".\n";
     }
 }
+
+// The sync pipeline is written once for every type of item, hence it is
+// instantiated here for each of the types of items the Zaurus synchronizes.
+template int ZaurusType::GetAllSyncItems(TodoItemType::List &newItemList,
+	TodoItemType::List &modItemList, SyncIDListType &delItemIdList);
+template int ZaurusType::GetAllSyncItems(CalendarItemType::List &newItemList,
+	CalendarItemType::List &modItemList, SyncIDListType &delItemIdList);
+template int ZaurusType::GetAllSyncItems(AddrBookItemType::List &newItemList,
+	AddrBookItemType::List &modItemList, SyncIDListType &delItemIdList);
+template int ZaurusType::StreamNewItems(
+	ItemQueueType<TodoItemType> &itemQueue);
+template int ZaurusType::StreamNewItems(
+	ItemQueueType<CalendarItemType> &itemQueue);
+template int ZaurusType::StreamNewItems(
+	ItemQueueType<AddrBookItemType> &itemQueue);
+template int ZaurusType::AddItems(const TodoItemType::List &items,
+				  TodoItemType::List &mapIdList);
+template int ZaurusType::AddItems(const CalendarItemType::List &items,
+				  CalendarItemType::List &mapIdList);
+template int ZaurusType::AddItems(const AddrBookItemType::List &items,
+				  AddrBookItemType::List &mapIdList);
+template int ZaurusType::ModItems(const TodoItemType::List &items);
+template int ZaurusType::ModItems(const CalendarItemType::List &items);
+template int ZaurusType::ModItems(const AddrBookItemType::List &items);
@@ -38,10 +38,15 @@
 
 // Memory Comparison, Settings, etc. Includes
 #include <string>
+#include <list>
+#include <vector>
+#include <set>
+#include <map>
 #include <iostream>
 
 // Network Related Includes
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
@@ -51,23 +56,20 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <sys/time.h>
 
 #include <zmsg.h>
 
 #include "CardParamInfoType.hh"
+#include "ItemQueueType.hh"
+#include "WorkerPoolType.hh"
+#include "JournalType.hh"
+#include "ItemCodecType.hh"
+#include "MirrorType.hh"
 
 // The zaurus syncing softwares receiving port.
 #define ZRECVPORT 4245
 
-// Define all the different item parameter type identifiers
-#define DATA_ID_BIT 0x06
-#define DATA_ID_TIME 0x04
-#define DATA_ID_ULONG 0x12
-#define DATA_ID_BARRAY 0x0c
-#define DATA_ID_UTF8 0x11
-#define DATA_ID_UCHAR 0x0b
-#define DATA_ID_WORD 0x08
-
 // Define all the different synchronization types
 #define SYNC_TODO 0x06
 #define SYNC_CALENDAR 0x01
@@ -93,16 +95,17 @@ public:
     int AuthenticatePassword(std::string passwd);
     time_t GetLastTimeSynced(void);
 
-    int GetAllTodoSyncItems(TodoItemType::List &newItemList,
-        TodoItemType::List &modItemList, SyncIDListType &delItemIdList);
-    int GetAllCalendarSyncItems(CalendarItemType::List &newItemList,
-        CalendarItemType::List &modItemList, SyncIDListType &delItemIdList);
-    TodoItemType::List AddTodoItems(TodoItemType::List todoItems);
-    CalendarItemType::List AddCalendarItems(CalendarItemType::List calItems);
-    int ModTodoItems(TodoItemType::List todoItems);
-    int ModCalendarItems(CalendarItemType::List calItems);
-    int DelTodoItems(SyncIDListType todoItemIDs);
-    int DelCalendarItems(SyncIDListType calItemIDs);
+    template <class ItemT>
+    int GetAllSyncItems(std::vector<ItemT> &newItemList,
+        std::vector<ItemT> &modItemList, SyncIDListType &delItemIdList);
+    template <class ItemT>
+    int StreamNewItems(ItemQueueType<ItemT> &itemQueue);
+    template <class ItemT>
+    int AddItems(const std::vector<ItemT> &items,
+                 std::vector<ItemT> &mapIdList);
+    template <class ItemT>
+    int ModItems(const std::vector<ItemT> &items);
+    int DelItems(const SyncIDListType &itemIDs);
 
     int RequiresFullSync(void) const;
     void TerminateSync(void);
@@ -111,6 +114,15 @@ public:
     int SendRSSMsg(void);
     int SetNextSyncAnch(void);
     int ObtainParamInfo(void);
+
+    void SetJournal(JournalType *pSyncJournal);
+    void SetMirror(MirrorType *pItemMirror);
+    void SetSkippedSyncIDs(const std::set<unsigned long int> &syncIDs);
+    int GetNewSyncIDs(SyncIDListType &syncIDList);
+    std::string GetModel(void) const;
+    std::string GetAddress(void) const;
+    std::string GetDeviceID(void) const;
+    int TuneSocket(unsigned int timeout, int bufferSize, bool noDelay);
 private:
     int InitiateSync(void);
     int ObtainDeviceInfo(void);
@@ -118,26 +130,45 @@ private:
     int ObtainLastSyncAnch(void);
     int ObtainSyncIDLists(const unsigned char type);
 
-    TodoItemType GetTodoItem(unsigned char type, unsigned long int syncID);
-    CalendarItemType GetCalendarItem(unsigned char type,
-        unsigned long int syncID);
-    int ModifyTodoItem(unsigned char type, TodoItemType todoItem);
-    int ModifyCalendarItem(unsigned char type, CalendarItemType calItem);
-    TodoItemType AddTodoItem(unsigned char type, TodoItemType todoItem);
-    CalendarItemType AddCalendarItem(unsigned char type,
-        CalendarItemType calItem);
+    template <class ItemT>
+    ItemT FetchItem(unsigned long int syncID);
+    template <class ItemT>
+    ItemT GetItem(unsigned char type, unsigned long int syncID);
+    template <class ItemT>
+    int EncodeModFrame(const ItemT &item, RDWMessageType *const pRDWMsg);
+    template <class ItemT>
+    int EncodeAddFrames(const ItemT &item, RDWMessageType *const pObtIdMsg,
+        RDWMessageType *const pRDWMsg, unsigned short int &syncIdOffset);
+    int SendModFrame(RDWMessageType *const pRDWMsg);
+    int SendAddFrames(RDWMessageType *const pObtIdMsg,
+        RDWMessageType *const pRDWMsg, unsigned short int syncIdOffset,
+        unsigned long int &syncId);
+
+    template <class ItemT>
+    static void EncodeModJob(void *pCtx, unsigned int jobIndex);
+    template <class ItemT>
+    static void EncodeAddJob(void *pCtx, unsigned int jobIndex);
     int DeleteItem(unsigned char type, unsigned long int syncID);
     int StateSyncDone(const unsigned char type);
 
-    int GetTodoItemParam(const TodoItemType &item,
-        RDWMessageType *const pRDWMsg,
-        const CardParamInfoType &paramInfo);
-    int SetTodoItemParam(TodoItemType &item,
-        ADRMessageType *const pADRMsg, const CardParamInfoType &paramInfo);
-    int GetCalendarItemParam(const CalendarItemType &item,
-        RDWMessageType *const pRDWMsg, const CardParamInfoType &paramInfo);
-    int SetCalendarItemParam(CalendarItemType &item,
-        ADRMessageType *const pADRMsg, const CardParamInfoType &paramInfo);
+    // The value of a parameter as read from the Zaurus.
+    struct sParamValue {
+        uint64_t numVal;
+        std::string strVal;
+    };
+    typedef std::vector<struct sParamValue> ParamValueListType;
+
+    template <class ItemT>
+    static bool IsKeptParam(const CardParamInfoType &paramInfo);
+    template <class ItemT>
+    bool HasKeptParams(void) const;
+    template <class ItemT>
+    int GetItemParam(const ItemT &item, RDWMessageType *const pRDWMsg,
+        const CardParamInfoType &paramInfo,
+        const struct sParamValue *pKeptValue);
+    template <class ItemT>
+    int SetItemParam(ItemT &item, ADRMessageType *const pADRMsg,
+        const CardParamInfoType &paramInfo, struct sParamValue &value);
 
     void PrintCardParams(void);
 
@@ -159,6 +190,9 @@ private:
     // the connection to the Zaurus.
     int connfd;
 
+    // This is the address the Zaurus connected from.
+    std::string address;
+
     // This variable is used to store the type of synchronization. This
     // variable should be set before any of the protocol functions are called.
     unsigned char syncType;
@@ -170,6 +204,28 @@ private:
     int reqAddressBookFullSync;
 
     CardParamInfoType::List paramInfoList;
+
+    // These are the values of the parameters the items have no field for,
+    // kept by sync ID for each item read from the Zaurus, so that modifying
+    // an item writes them back unchanged rather than blanking them.
+    std::map<unsigned long int, ParamValueListType> keptParams;
+
+    // This is the pool of threads used to encode outgoing messages before
+    // they are sent, so that encoding stays out of the lock-step exchange.
+    WorkerPoolType encodePool;
+
+    // This is the journal used to record the progress of the sync, or NULL
+    // if no journal is being kept.
+    JournalType *pJournal;
+
+    // This is the mirror of the items on the Zaurus, or NULL if no mirror is
+    // being kept. It is updated with every item read from or written to the
+    // Zaurus.
+    MirrorType *pMirror;
+
+    // This is the set of sync IDs of new items which are not streamed since
+    // they are left out of the sync, such as events outside the sync window.
+    std::set<unsigned long int> skippedSyncIDs;
 };
 
 #endif
@@ -21,28 +21,48 @@
 // Standard Input/Output Includes
 #include <iostream>
 #include <string>
+#include <set>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <limits>
 
 // Includes for fork()
 #include <unistd.h>
 
-// Includes for loading shared objects
-#include <dlfcn.h>
+// Includes for strtoul()
+#include <stdlib.h>
 
-//#include <pthread.h>
+// Includes for snprintf()
+#include <stdio.h>
+
+#include <pthread.h>
 
 // Includes for waitpid()
 #include <sys/types.h>
 #include <sys/wait.h>
 
+// Includes for mkdir()
+#include <sys/stat.h>
+#include <errno.h>
+
 // Zaurus specific Includes.
 #include <zmsg.h>
 #include <zdata_lib/zdata.hh>
+#include <zdata_lib/ItemBatchType.hh>
 
 #include <ConfigManagerType.h>
 
-#include "TodoPluginType.hh"
-#include "CalendarPluginType.hh"
+#include "SyncTraitsType.hh"
+#include "PluginLoaderType.hh"
 #include "ZaurusType.hh"
+#include "MirrorType.hh"
+#include "DuplicateIndexType.hh"
+#include "SnapshotType.hh"
+#include "CalendarWindowType.hh"
+#include "DeviceSettingsType.hh"
+#include "SyncStatsType.hh"
 
 #define APP_VERSION "0.2.6"
 
@@ -50,9 +70,19 @@
 // initiate a synchronization from the Desktop.
 #define ZLISTPORT 4244
 
-#define CONF_WIN_Z 1
-#define CONF_WIN_D 2
-#define CONF_WIN_B 3
+// The number of items that may be waiting between the thread fetching items
+// from the Zaurus and the plugin during a streamed full sync, and the number
+// of items handed to the plugin at a time.
+#define STREAM_QUEUE_SIZE 32
+#define STREAM_BATCH_SIZE 16
+
+// A sorted vector of sync IDs used to find conflicts between the changes on
+// each side in linear time.
+typedef std::vector<unsigned long int> SyncIDIndexType;
+
+// The hashes the mirror held for the plugin items which were matched with
+// items on the Zaurus during a full sync, by sync ID.
+typedef std::map<unsigned long int, uint64_t> HeldHashMapType;
 
 struct sData {
     pthread_mutex_t ready_mutex;
@@ -63,27 +93,366 @@ struct sData {
     unsigned short int conf_winner;
 };
 
+// This structure is shared between the thread fetching the new items from
+// the Zaurus and the thread adding them to the plugin during a streamed full
+// sync.
+template <class ItemT>
+struct sStreamData {
+    ZaurusType *pZaurus;
+    ItemQueueType<ItemT> *pItemQueue;
+    int retval;
+};
+
 void DispWelcomeMsg(void);
 void DispUsageMsg(void);
 void DispVersion(void);
 void DispRetVals(void);
-int PerformTodoSync(unsigned short int confWinner,
-            ConfigManagerType *pConfManager);
-int PerformCalendarSync(unsigned short int confWinner,
-            ConfigManagerType *pConfManager);
-TodoItemType::List::iterator FindSyncID(TodoItemType::List &todoList,
-                    unsigned long int syncID);
-void ResolveDelModConflicts(SyncIDListType &zDelTodoItemIDList,
-                TodoItemType::List &zModTodoItemList,
-                TodoItemType::List &zAddTodoItemList,
-                SyncIDListType &dDelTodoItemIDList,
-                TodoItemType::List &dModTodoItemList,
-                TodoItemType::List &dAddTodoItemList);
-void ResolveModModConflicts(TodoItemType::List &zModTodoItemList,
-                TodoItemType::List &dModTodoItemList,
-                TodoItemType::List &zAddTodoItemList,
-                TodoItemType::List &dAddTodoItemList,
-                unsigned short int conflict_winner);
+template <class Traits>
+int PerformSync(ConfigManagerType *pConfManager);
+int GetStateDir(ConfigManagerType *pConfManager, std::string &stateDir);
+int OpenJournal(JournalType &journal, ConfigManagerType *pConfManager,
+                const char *pName, unsigned char syncType,
+                const std::string &deviceID, unsigned int maxAge);
+int GetDeviceStatePath(ConfigManagerType *pConfManager, const char *pName,
+                       const std::string &deviceID, std::string &statePath);
+uint64_t GetDeviceKey(const std::string &deviceID);
+int OpenMirror(MirrorType &mirror, ConfigManagerType *pConfManager,
+               const char *pName, const std::string &deviceID);
+int OpenIDMap(IDMapType &idMap, ConfigManagerType *pConfManager,
+              const char *pName, const std::string &deviceID);
+void RemoveIDMappings(IDMapType &idMap, const SyncIDListType &idList);
+void DropAppliedIDs(JournalType &journal, SyncIDListType &idList);
+void RecordAppliedIDs(JournalType &journal, const SyncIDListType &idList);
+int EndSyncStats(SyncStatsType &stats, const DeviceSettingsType &settings,
+                 int result);
+void IndexSyncIDs(const SyncIDListType &idList, SyncIDIndexType &idIndex);
+void IndexBatchSyncIDs(const ItemBatchType &batch, SyncIDIndexType &idIndex);
+void IntersectSyncIDs(const SyncIDIndexType &aIndex,
+                      const SyncIDIndexType &bIndex,
+                      SyncIDIndexType &conflictIndex);
+void RemoveSyncIDs(SyncIDListType &idList, const SyncIDIndexType &idIndex);
+int ReadSyncWindow(const DeviceSettingsType &settings,
+                   CalendarWindowType &window);
+bool IsInWindow(const CalendarWindowType &window,
+                const CalendarItemType &item);
+void RecordSpan(CalendarWindowType &window, const CalendarItemType &item);
+
+/**
+ * Check if an item falls within the sync window.
+ *
+ * Only Calendar syncs have a sync window, so every other item falls within
+ * it.
+ * @param window Reference to the sync window.
+ * @param item Reference to the item to check.
+ * @return Always true.
+ */
+template <class ItemT>
+bool IsInWindow(const CalendarWindowType &window, const ItemT &item) {
+    return true;
+}
+
+/**
+ * Record the span of an item.
+ *
+ * Only the spans of Calendar items are recorded, so this does nothing.
+ * @param window Reference to the sync window.
+ * @param item Reference to the item read from or written to the Zaurus.
+ */
+template <class ItemT>
+void RecordSpan(CalendarWindowType &window, const ItemT &item) {
+
+}
+
+/**
+ * Drop the items outside the sync window.
+ *
+ * Remove the items which do not fall within the sync window from the given
+ * list, so that they are neither compared nor written.
+ * @param window Reference to the sync window.
+ * @param itemList Reference to the list of items to drop items from.
+ * @return The number of items dropped.
+ */
+template <class ListType>
+int DropOutsideWindow(const CalendarWindowType &window, ListType &itemList) {
+    std::vector<bool> dropFlags(itemList.size(), false);
+    typename ListType::size_type i;
+
+    for (i = 0; i < itemList.size(); i++)
+        dropFlags[i] = !IsInWindow(window, itemList[i]);
+
+    return (int)EraseItems(itemList, dropFlags);
+}
+
+/**
+ * Record the spans of items.
+ *
+ * Record the spans of the given items, which were just read from or written
+ * to the Zaurus.
+ * @param window Reference to the sync window.
+ * @param itemList Reference to the list of items to record the spans of.
+ */
+template <class ListType>
+void RecordSpans(CalendarWindowType &window, const ListType &itemList) {
+    typename ListType::const_iterator iter;
+
+    for (iter = itemList.begin(); iter != itemList.end(); ++iter)
+        RecordSpan(window, *iter);
+}
+
+/**
+ * Drop applied items.
+ *
+ * Remove the items whose changes the journal records as already applied to
+ * the plugin, so that they are not applied again when resuming a sync. An
+ * item whose content differs from the one applied changed again since, so
+ * it is kept.
+ * @param journal Reference to the journal of the sync.
+ * @param itemList Reference to the list of items to remove applied items
+ * from.
+ */
+template <class ListType>
+void DropAppliedItems(JournalType &journal, ListType &itemList) {
+    std::vector<bool> dropFlags(itemList.size(), false);
+    typename ListType::size_type i;
+
+    for (i = 0; i < itemList.size(); i++)
+        dropFlags[i] = journal.WasApplied(itemList[i].GetSyncID(),
+                                          itemList[i].ContentHash());
+
+    EraseItems(itemList, dropFlags);
+}
+
+/**
+ * Record applied items.
+ *
+ * Record in the journal that the changes to the given items have been
+ * applied to the plugin, and flush the journal to disk.
+ * @param journal Reference to the journal of the sync.
+ * @param itemList Reference to the list of items which were applied.
+ */
+template <class ListType>
+void RecordAppliedItems(JournalType &journal, const ListType &itemList) {
+    typename ListType::const_iterator iter;
+
+    for (iter = itemList.begin(); iter != itemList.end(); ++iter)
+        journal.RecordApplied((*iter).GetSyncID(), (*iter).ContentHash());
+
+    journal.Checkpoint();
+}
+
+/**
+ * Reconcile with the mirror.
+ *
+ * Reconcile the items obtained from the plugin during a full sync with the
+ * mirror of the items on the Zaurus. Every item on the Zaurus is reported as
+ * new during a full sync, so without the mirror every plugin item would be
+ * added to the Zaurus and every Zaurus item would be added to the plugin
+ * again. Plugin items whose sync IDs are both on the Zaurus and in the
+ * mirror are instead held back from the new item list, along with the hash
+ * the mirror holds for them. The mirror is only what the Zaurus held at the
+ * end of the last sync, so the held items are compared with the Zaurus
+ * items once those are fetched, by CompareHeldItems(). Items the mirror
+ * holds which are no longer on the Zaurus are dropped from it.
+ * @param zaurus Reference to the Zaurus being synchronized.
+ * @param mirror Reference to the mirror of the items on the Zaurus.
+ * @param newList Reference to the list of new items from the plugin.
+ * @param heldList Reference to the list to move the held plugin items to.
+ * @param heldHashes Reference to the map to store the mirror hash of each
+ * held item in, by sync ID.
+ * @return The number of plugin items found to already be on the Zaurus, or
+ * -1 if the sync IDs of the items on the Zaurus could not be obtained.
+ */
+template <class ListType>
+int ReconcileWithMirror(ZaurusType &zaurus, MirrorType &mirror,
+                        ListType &newList, ListType &heldList,
+                        HeldHashMapType &heldHashes) {
+    SyncIDListType zSyncIDList;
+    SyncIDIndexType zIdIndex;
+    std::set<unsigned long int> zSyncIDs;
+    std::vector<bool> candFlags;
+    std::vector<bool> dropFlags(newList.size(), false);
+    ItemBatchType newBatch;
+    typename ListType::size_type i;
+    unsigned long int syncID;
+    uint64_t hash;
+
+    if (zaurus.GetNewSyncIDs(zSyncIDList) != 0)
+        return -1;
+
+    zSyncIDs.insert(zSyncIDList.begin(), zSyncIDList.end());
+    mirror.RetainOnly(zSyncIDs);
+
+    // I pick out the plugin items which are on the Zaurus from the sync ID
+    // column alone, and only look at the mirror for those.
+    IndexSyncIDs(zSyncIDList, zIdIndex);
+    newBatch.Load(newList);
+    newBatch.SelectSyncIDs(zIdIndex, candFlags);
+
+    for (i = 0; i < newList.size(); i++) {
+        syncID = newBatch.GetSyncID(i);
+        if (candFlags[i] && (syncID != 0) && mirror.Get(syncID, hash) &&
+            (heldHashes.find(syncID) == heldHashes.end())) {
+            heldHashes[syncID] = hash;
+            heldList.push_back(typename ListType::value_type());
+            std::swap(heldList.back(), newList[i]);
+            dropFlags[i] = true;
+        }
+    }
+
+    EraseItems(newList, dropFlags);
+
+    return (int)heldHashes.size();
+}
+
+/**
+ * Compare held items.
+ *
+ * Compare the plugin items held back by ReconcileWithMirror() with the
+ * Zaurus items of the same sync IDs, which were fetched during the full
+ * sync, against the hashes the mirror held for them. A side whose content
+ * differs from the mirror was changed since the last sync, and its item is
+ * moved to the list of items modified on that side. Items changed on both
+ * sides end up in both lists, so that they are resolved as conflicts, and
+ * items changed on neither side are dropped. Plugin items whose Zaurus item
+ * was not fetched are dropped as well, since nothing is known of it.
+ * @param heldHashes The mirror hash of each held item, by sync ID.
+ * @param zHeldList Reference to the list of fetched Zaurus items.
+ * @param dHeldList Reference to the list of held plugin items.
+ * @param zModList Reference to the list of items modified on the Zaurus.
+ * @param dModList Reference to the list of items modified on the plugin.
+ */
+template <class ListType>
+void CompareHeldItems(const HeldHashMapType &heldHashes, ListType &zHeldList,
+                      ListType &dHeldList, ListType &zModList,
+                      ListType &dModList) {
+    typedef typename ListType::size_type IndexType;
+    std::map<unsigned long int, IndexType> dHeldIndex;
+    typename std::map<unsigned long int, IndexType>::iterator fndIter;
+    HeldHashMapType::const_iterator hashIter;
+    IndexType i;
+    unsigned long int syncID;
+
+    for (i = 0; i < dHeldList.size(); i++)
+        dHeldIndex[dHeldList[i].GetSyncID()] = i;
+
+    for (i = 0; i < zHeldList.size(); i++) {
+        syncID = zHeldList[i].GetSyncID();
+        fndIter = dHeldIndex.find(syncID);
+        hashIter = heldHashes.find(syncID);
+        if ((fndIter == dHeldIndex.end()) || (hashIter == heldHashes.end()))
+            continue;
+
+        if (zHeldList[i].ContentHash() != hashIter->second) {
+            zModList.push_back(typename ListType::value_type());
+            std::swap(zModList.back(), zHeldList[i]);
+        }
+
+        if (dHeldList[fndIter->second].ContentHash() != hashIter->second) {
+            dModList.push_back(typename ListType::value_type());
+            std::swap(dModList.back(), dHeldList[fndIter->second]);
+        }
+    }
+
+    zHeldList.clear();
+    dHeldList.clear();
+}
+
+/**
+ * Drop identical modifications.
+ *
+ * Remove the items modified on both the Zaurus and the plugin whose content
+ * ended up identical on both sides. These are not really conflicts, both
+ * sides already hold the same data, so neither side needs to be written and
+ * no duplicate is created when both sides win conflicts. Both items are at
+ * hand, so they are compared field by field rather than by content hash.
+ * @param zModList Reference to the list of items modified on the Zaurus.
+ * @param dModList Reference to the list of items modified on the plugin.
+ * @return The number of identical modifications dropped.
+ */
+template <class ListType>
+int DropIdenticalMods(ListType &zModList, ListType &dModList) {
+    typedef typename ListType::size_type IndexType;
+    std::map<unsigned long int, IndexType> dModIndex;
+    typename std::map<unsigned long int, IndexType>::iterator fndIter;
+    std::vector<bool> zDropFlags(zModList.size(), false);
+    std::vector<bool> dDropFlags(dModList.size(), false);
+    IndexType i;
+
+    for (i = 0; i < dModList.size(); i++)
+        dModIndex[dModList[i].GetSyncID()] = i;
+
+    for (i = 0; i < zModList.size(); i++) {
+        fndIter = dModIndex.find(zModList[i].GetSyncID());
+        if ((fndIter != dModIndex.end()) &&
+            FieldsEqual(dModList[fndIter->second], zModList[i])) {
+            dDropFlags[fndIter->second] = true;
+            zDropFlags[i] = true;
+            dModIndex.erase(fndIter);
+        }
+    }
+
+    EraseItems(dModList, dDropFlags);
+    return (int)EraseItems(zModList, zDropFlags);
+}
+
+/**
+ * Collapse a duplicate item.
+ *
+ * Find the desktop item which duplicates the given Zaurus item. If there is
+ * one the two are collapsed into a single item, rather than each being added
+ * to the other side. The desktop item is given the sync ID of the Zaurus
+ * item and added to the list of items which need their IDs mapped. The
+ * mirror already holds the Zaurus item, since it was recorded there when it
+ * was fetched.
+ * @param dupIndex Reference to the index of the new desktop items.
+ * @param zItem Reference to the new Zaurus item.
+ * @param mapIdList Reference to the list of items which need their IDs
+ * mapped.
+ * @return A boolean value representing if the item was collapsed.
+ */
+template <class ListType>
+bool CollapseDuplicate(DuplicateIndexType<ListType> &dupIndex,
+                       const typename ListType::value_type &zItem,
+                       ListType &mapIdList) {
+    typename ListType::value_type dupItem;
+
+    if (!dupIndex.Take(zItem, dupItem))
+        return false;
+
+    dupItem.SetSyncID(zItem.GetSyncID());
+    mapIdList.push_back(typename ListType::value_type());
+    std::swap(mapIdList.back(), dupItem);
+
+    return true;
+}
+
+/**
+ * Collapse duplicate items.
+ *
+ * Collapse each new Zaurus item which duplicates a new desktop item into
+ * an ID mapping, removing the two from their new item lists. This is done
+ * before either side is written to, so items which were entered on both
+ * sides, or which ended up the same on both sides when both won a conflict,
+ * are neither added to the plugin nor to the Zaurus a second time.
+ * @param zNewList Reference to the list of new Zaurus items.
+ * @param dNewList Reference to the list of new desktop items.
+ * @param mapIdList Reference to the list of items which need their IDs
+ * mapped.
+ * @return The number of duplicate items collapsed.
+ */
+template <class ListType>
+int CollapseDuplicates(ListType &zNewList, ListType &dNewList,
+                       ListType &mapIdList) {
+    DuplicateIndexType<ListType> dupIndex(dNewList);
+    std::vector<bool> dropFlags(zNewList.size(), false);
+    typename ListType::size_type i;
+
+    for (i = 0; (i < zNewList.size()) && (dupIndex.GetCount() > 0); i++)
+        dropFlags[i] = CollapseDuplicate(dupIndex, zNewList[i], mapIdList);
+
+    dupIndex.EraseTaken();
+    return (int)EraseItems(zNewList, dropFlags);
+}
 
 int main(int argc, char **argv) {
     // Generic Variable used for return values of functions.
@@ -114,8 +483,6 @@ int main(int argc, char **argv) {
     // This variable is used to store the type of synchronization.
     unsigned char syncType;
 
-    // This is a variable used to store the conflict winner.
-    unsigned short int confWinner;
     ConfigManagerType *pConfManager;
 
     // The two variables below are used with getopt() to parse the command
@@ -239,30 +606,9 @@ int main(int argc, char **argv) {
         }
     }
 
-    // If I reach this point I know that the ConfigManager has opened the
-    // file. Hence, I try to load the conflict_winner option.
-    retval = confManager.GetValue("conflict_winner", optVal, 256);
-    if (retval != 0) {
-        std::cout << "A conflict_winner was not specified in the config" \
-            " file. Please specify the conflict_winner option in the config" \
-            " file with one of the three values \"zaurus\", \"desktop\"," \
-            " \"both\".\n";
-        return 14;
-    } else {
-        if (strcmp(optVal, "zaurus") == 0) {
-            confWinner = CONF_WIN_Z;
-        } else if (strcmp(optVal, "desktop") == 0) {
-            confWinner = CONF_WIN_D;
-        } else if (strcmp(optVal, "both") == 0) {
-            confWinner = CONF_WIN_B;
-        } else {
-            std::cout << "The conflict_winner option was specified in the" \
-                " config file with an incorrect value. The value must be" \
-                " one of the following three, \"zaurus\", \"desktop\"," \
-                " \"both\".\n";
-            return 15;
-        }
-    }
+    // The conflict_winner option need not be set outside of the device
+    // profiles, so it is only checked once the Zaurus has connected and the
+    // profiles for it are known.
 
     // After parsing the command line arguments I display the welcome message
     // and then move onto running the proper synchronization process based on
@@ -284,7 +630,7 @@ int main(int argc, char **argv) {
         // sync server which is going to listen for a connection from the
         // Zaurus and perform the synchronization.
 
-            retval = PerformTodoSync(confWinner, pConfManager);
+            retval = PerformSync<TodoSyncTraitsType>(pConfManager);
             exit(retval);
         }
 
@@ -294,6 +640,11 @@ int main(int argc, char **argv) {
             return 4;
         }
     } else if (syncType == 0x07) {
+        // The Address Book goes through the same pipeline as the others,
+        // but its card parameter abbreviations have not been checked
+        // against a Zaurus yet. Until they are it is not run, since a wrong
+        // abbreviation would have items written to the Zaurus with fields
+        // lost.
         std::cout << "Address Book synchronization has NOT been" \
             " implemented yet.\n";
         return 0;
@@ -306,7 +657,7 @@ int main(int argc, char **argv) {
         // sync server which is going to listen for a connection from the
         // Zaurus and perform the synchronization.
 
-            retval = PerformCalendarSync(confWinner, pConfManager);
+            retval = PerformSync<CalendarSyncTraitsType>(pConfManager);
             exit(retval);
         }
 
@@ -460,611 +811,970 @@ void DispRetVals(void) {
     cout << "11: Failed to obtain value of the HOME environment variable.\n";
     cout << "12: Failed to open the .zync.conf file for reading.\n";
     cout << "13: Zaurus IP not set in the .zync.conf file or cmd line.\n";
-    cout << "14: The conflict_winner is not set in the .zync.conf file.\n";
-    cout << "15: The conflict_winner is set to an illegal vaule.\n";
 }
 
 /**
- * Find item with sync ID.
+ * Stream the new items off of the Zaurus.
  *
- * Find an item within a list of To-Do items which has the given
- * synchronization ID. If this function fails to find the item the empty end
- * nodes iterator is returned else the iterator of the item is found. Note:
- * This returns the first instance found.
- * @return The iterator of the item with the matching sync ID if found, empty
- * end node of the passed list if not found.
+ * This is the thread function used to fetch the new items from the Zaurus
+ * during a streamed full sync. It pushes each item onto the queue in the
+ * passed sStreamData as it is fetched and closes the queue when done.
+ * @param pArg Pointer to the sStreamData shared with the consumer.
+ * @return Always NULL, the result is stored in the retval of the data.
  */
-TodoItemType::List::iterator FindSyncID(TodoItemType::List &todoList,
-                    unsigned long int syncID) {
-    TodoItemType::List::iterator iter;
+template <class ItemT>
+void *StreamItemsThread(void *pArg) {
+    struct sStreamData<ItemT> *pData;
 
-    for (iter = todoList.begin(); iter != todoList.end(); ++iter)
-    if ((*iter).GetSyncID() == syncID)
-        return iter;
+    pData = (struct sStreamData<ItemT> *)pArg;
+    pData->retval = pData->pZaurus->StreamNewItems(*(pData->pItemQueue));
 
-    return todoList.end();
+    return NULL;
 }
 
 /**
- * Resolve Deltion/Modification conflicts.
+ * Stream the new items from the Zaurus into the plugin.
  *
- * This function searches for and resolves any conflicts found between
- * deletion of items and modification of items. If a conflict is found it is
- * handled by replacing the deleted item with the modified item.
+ * Fetch the new items from the Zaurus in a separate thread while adding
+ * them to the plugin in small batches as they arrive. This keeps only a
+ * bounded number of items in memory at once and overlaps the plugin writes
+ * with the network fetch. It may only be used when no conflicts need to be
+ * resolved, that is during a full sync. Items which duplicate a new desktop
+ * item are collapsed into an ID mapping rather than being added, and items
+ * the plugin was found to already have are set aside to be compared with
+ * it instead.
+ * @param zaurus Reference to the Zaurus to fetch the items from.
+ * @param plugin Reference to the loader of the plugin to add the items to.
+ * @param journal Reference to the journal of the sync.
+ * @param dupIndex Reference to the index of the new desktop items.
+ * @param mapIdList Reference to the list of items which need their IDs
+ * mapped.
+ * @param window Reference to the sync window, items outside of it are
+ * dropped.
+ * @param heldHashes The mirror hashes of the items the plugin was found to
+ * already have, by sync ID.
+ * @param zHeldList Reference to the list to set those items aside in.
+ * @return The number of items streamed (zero or more), or -1 on failure.
  */
-void ResolveDelModConflicts(SyncIDListType &zDelTodoItemIDList,
-                TodoItemType::List &zModTodoItemList,
-                TodoItemType::List &zAddTodoItemList,
-                SyncIDListType &dDelTodoItemIDList,
-                TodoItemType::List &dModTodoItemList,
-                TodoItemType::List &dAddTodoItemList) {
-
-    //TodoItemType::List::iterator zIter;
-    SyncIDListType::iterator zSyncIDIter;
-    TodoItemType::List::iterator fndItemIter;
-    SyncIDListType::iterator tmpIDIter;
-
-    // Now in this case in this function I am resolving any conflicts between
-    // deletion and modification. This is the only type of conflict that
-    // should ever be created other than a deletion on both ends. Since
-    // deletion is such a harsh action and can cause data loss, which can be
-    // very bad in certain situations, the choice for resolving such conflicts
-    // is that a modification wins in conflict with a delete. Hence, if one
-    // deletes an item from their Desktop PIM software and modifies that same
-    // item on the Zaurus. When the next synchronization is performed the item
-    // should be recreated on their Desktop PIM software with the updated
-    // information.
-
-    std::cout << "Entered the ResolveDelmodConflicts() function.\n";
+template <class Traits>
+int StreamItemsToPlugin(ZaurusType &zaurus,
+                        PluginLoaderType<Traits> &plugin,
+                        JournalType &journal,
+                        DuplicateIndexType<typename Traits::ItemT::List>
+                            &dupIndex,
+                        typename Traits::ItemT::List &mapIdList,
+                        CalendarWindowType &window,
+                        const HeldHashMapType &heldHashes,
+                        typename Traits::ItemT::List &zHeldList) {
+    typedef typename Traits::ItemT ItemT;
+    ItemQueueType<ItemT> itemQueue(STREAM_QUEUE_SIZE);
+    struct sStreamData<ItemT> streamData;
+    pthread_t fetchThread;
+    typename ItemT::List batchList;
+    ItemT curItem;
+    unsigned int maxBatchSize;
+    unsigned int batchSize = 0;
+    int numItems = 0;
+
+    // A version 2 plugin gets the batches it asks for. A version 1 plugin
+    // would take every item at once, which defeats streaming, so it gets
+    // small batches instead.
+    maxBatchSize = plugin.GetPlugin()->GetBatchSize();
+    if ((maxBatchSize == 0) ||
+        (!plugin.IsV2() && (maxBatchSize > STREAM_BATCH_SIZE)))
+        maxBatchSize = STREAM_BATCH_SIZE;
+
+    streamData.pZaurus = &zaurus;
+    streamData.pItemQueue = &itemQueue;
+    streamData.retval = 0;
+
+    if (pthread_create(&fetchThread, NULL, StreamItemsThread<ItemT>,
+        &streamData) != 0) {
+        std::cout << "zync: Failed to create the item fetch thread.\n";
+        return -1;
+    }
 
-    zSyncIDIter = zDelTodoItemIDList.begin();
-    while (zSyncIDIter != zDelTodoItemIDList.end()) {
-
-    // First I want to check if there are any conflicts with the sync ID
-    // of what ever the current deleted item is.
-    fndItemIter = FindSyncID(dModTodoItemList, (*zSyncIDIter));
-    if (fndItemIter != dModTodoItemList.end()) {
-        std::cout << "Found a matching sync ID.\n";
-        // If I have gotten to this point I know that there is a conflict
-        // and that fndItemIter is the iterator for the item in conflict.
-
-        // The first thing I want to do in this case is Add the
-        // Modification of the conflicting item to the appropriate add
-        // list so that it will be added.
-        dAddTodoItemList.push_front(*fndItemIter);
-
-        std::cout << "Added the item to the proper add list.\n";
-
-        // The second thing I want to do is remove the item from the
-        // modification list that it was found in so that after the item
-        // it is not needlessly modified with the same data.
-        dModTodoItemList.erase(fndItemIter);
-
-        std::cout << "Erased the item from the proper Mod list.\n";
-
-        // The third thing I want to do is remove the item from the
-        // deletion list so that it is not deleted after it has been
-        // added again.
-        if (zSyncIDIter == zDelTodoItemIDList.begin()) {
-        zDelTodoItemIDList.erase(zSyncIDIter);
-        zSyncIDIter = zDelTodoItemIDList.begin();
-        } else {
-        tmpIDIter = zSyncIDIter;
-        tmpIDIter--;
-        zDelTodoItemIDList.erase(zSyncIDIter);
-        zSyncIDIter = tmpIDIter;
-        zSyncIDIter++;
+    // The plugin is only ever used from this thread, so plugins do not have
+    // to be thread safe. I simply hand each full batch to the plugin as soon
+    // as it has been filled.
+    while (itemQueue.Pop(curItem)) {
+        // Items whose spans were not known yet are still fetched, they are
+        // only dropped here.
+        RecordSpan(window, curItem);
+
+        // Items the plugin already has are only compared once all of them
+        // have been fetched, wherever they lie.
+        if (heldHashes.find(curItem.GetSyncID()) != heldHashes.end()) {
+            zHeldList.push_back(ItemT());
+            std::swap(zHeldList.back(), curItem);
+            continue;
         }
 
-        std::cout << "Erased the sync id from the deleted list.\n";
-    } else {
-        // If I have gotten to this point I know that there was no
-        // conflict and I want to go to the next item in the list and
-        // check for a conflict.
-        zSyncIDIter++;
-    }
-    }
-
-    // Now that the conflicts have been resolved in the above case I handle
-    // the conflicts in the case where the Desktop PIM application has deleted
-    // an item and the Zaurus has modified an item.
-    zSyncIDIter = dDelTodoItemIDList.begin();
-    while (zSyncIDIter != dDelTodoItemIDList.end()) {
-
-    // First I want to check if there are any conflicts with the sync ID
-    // of what ever the current deleted item is.
-    fndItemIter = FindSyncID(zModTodoItemList, (*zSyncIDIter));
-    if (fndItemIter != zModTodoItemList.end()) {
-        // If I have gotten to this point I know that there is a conflict
-        // and that fndItemIter is the iterator for the item in conflict.
-
-        // The first thing I want to do in this case is Add the
-        // Modification of the conflicting item to the appropriate add
-        // list so that it will be added.
-        zAddTodoItemList.push_front(*fndItemIter);
-
-        // The second thing I want to do is remove the item from the
-        // modification list that it was found in so that after the item
-        // it is not needlessly modified with the same data.
-        zModTodoItemList.erase(fndItemIter);
-
-        // The third thing I want to do is remove the item from the
-        // deletion list so that it is not deleted after it has been
-        // added again.
-        if (zSyncIDIter == dDelTodoItemIDList.begin()) {
-        dDelTodoItemIDList.erase(zSyncIDIter);
-        zSyncIDIter = dDelTodoItemIDList.begin();
-        } else {
-        tmpIDIter = zSyncIDIter;
-        tmpIDIter--;
-        dDelTodoItemIDList.erase(zSyncIDIter);
-        zSyncIDIter = tmpIDIter;
-        zSyncIDIter++;
+        if (!IsInWindow(window, curItem))
+            continue;
+
+        // Items the plugin already has a duplicate of are mapped to it
+        // instead. This is checked first so that the items added to the
+        // plugin during an interrupted sync are mapped as well.
+        if (CollapseDuplicate(dupIndex, curItem, mapIdList))
+            continue;
+
+        // Items applied to the plugin during an interrupted sync are not
+        // applied again, unless they changed again since.
+        if (journal.WasApplied(curItem.GetSyncID(), curItem.ContentHash()))
+            continue;
+
+        // The batch keeps its storage from one batch to the next, and the
+        // item is swapped into it rather than copied.
+        batchList.push_back(ItemT());
+        std::swap(batchList.back(), curItem);
+        batchSize++;
+        numItems++;
+
+        if (batchSize == maxBatchSize) {
+            plugin.AddItems(batchList);
+            RecordAppliedItems(journal, batchList);
+            batchList.clear();
+            batchSize = 0;
         }
-    } else {
-        // If I have gotten to this point I know that there was no
-        // conflict and I want to go to the next item in the list and
-        // check for a conflict.
-        zSyncIDIter++;
     }
+
+    if (batchSize > 0) {
+        plugin.AddItems(batchList);
+        RecordAppliedItems(journal, batchList);
     }
 
-    std::cout << "Exited the ResolveDelmodConflicts() function.\n";
+    pthread_join(fetchThread, NULL);
+
+    if (streamData.retval != 0)
+        return -1;
 
+    return numItems;
 }
 
 /**
- * Resolve Modification/Modification conflicts.
+ * Open the sync journal.
  *
- * This function searches for and resolves any conflicts found between
- * modification of items and modification of items. If a conflict is found it
- * is handled using the conflict winner specified config option.
+ * Open the journal used to record the progress of a sync, so that it can
+ * be resumed if interrupted. The journal is a device state file.
+ * @param journal Reference to the journal to open.
+ * @param pConfManager Pointer to the config manager to obtain options from.
+ * @param pName The suffix of the file name of the journal.
+ * @param syncType The type of synchronization being performed.
+ * @param deviceID The identity of the Zaurus being synchronized.
+ * @param maxAge The number of seconds an interrupted sync may be resumed
+ * for.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully opened the journal.
+ * @retval 1 Failed to determine the journal directory.
+ * @retval 2 Failed to create the journal directory.
+ * @retval 3 Failed to open the journal.
+ * @retval 4 The journal belongs to a different device.
  */
-void ResolveModModConflicts(TodoItemType::List &zModTodoItemList,
-                TodoItemType::List &dModTodoItemList,
-                TodoItemType::List &zAddTodoItemList,
-                TodoItemType::List &dAddTodoItemList,
-                unsigned short int conflict_winner) {
+int OpenJournal(JournalType &journal, ConfigManagerType *pConfManager,
+                const char *pName, unsigned char syncType,
+                const std::string &deviceID, unsigned int maxAge) {
+    std::string journalPath;
+    int retval;
 
-    std::cout << "Entered the ResolveModModConflicts() function.\n";
+    retval = GetDeviceStatePath(pConfManager, pName, deviceID, journalPath);
+    if (retval != 0)
+        return retval;
 
-    TodoItemType::List::iterator fndItemIter;
-    TodoItemType::List::iterator iter;
-    TodoItemType::List::iterator tmpIter;
-
-    iter = zModTodoItemList.begin();
-    while (iter != zModTodoItemList.end()) {
-
-    // First I want to check if there are any conflicts with the sync ID
-    // of what ever the current modified item is.
-    fndItemIter = FindSyncID(dModTodoItemList, (*iter).GetSyncID());
-    if (fndItemIter != dModTodoItemList.end()) {
-        std::cout << "Found a matching sync ID.\n";
-        // If I have gotten to this point I know that there is a conflict
-        // and that fndItemIter is the iterator for the item in conflict.
-
-        if (conflict_winner == CONF_WIN_Z) {
-        dModTodoItemList.erase(fndItemIter);
-        } else if (conflict_winner == CONF_WIN_D) {
-        if (iter == zModTodoItemList.begin()) {
-            zModTodoItemList.erase(iter);
-            iter = zModTodoItemList.begin();
-        } else {
-            tmpIter = iter;
-            tmpIter--;
-            zModTodoItemList.erase(iter);
-            iter = tmpIter;
-            iter++;
-        }
-        } else if (conflict_winner == CONF_WIN_B) {
-        dAddTodoItemList.push_front((*fndItemIter));
-        dModTodoItemList.erase(fndItemIter);
-
-        zAddTodoItemList.push_front((*iter));
-        if (iter == zModTodoItemList.begin()) {
-            zModTodoItemList.erase(iter);
-            iter = zModTodoItemList.begin();
-        } else {
-            tmpIter = iter;
-            tmpIter--;
-            zModTodoItemList.erase(iter);
-            iter = tmpIter;
-            iter++;
-        }
-        }
-    } else {
-        // If I have gotten to this point I know that there was no
-        // conflict and I want to go to the next item in the list and
-        // check for a conflict.
-        iter++;
-    }
+    retval = journal.Open(journalPath, syncType, deviceID, maxAge);
+    if (retval == 3)
+        return 4;
+    else if (retval != 0)
+        return 3;
+
+    return 0;
+}
+
+/**
+ * Get the state directory.
+ *
+ * Get the directory the journals and mirrors are kept in. This is the
+ * directory given by the journal_dir config option, or ~/.zync if it is not
+ * set. The directory is created if it does not exist.
+ * @param pConfManager Pointer to the config manager to obtain options from.
+ * @param stateDir Reference to store the path of the directory in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully got the state directory.
+ * @retval 1 Failed to determine the state directory.
+ * @retval 2 Failed to create the state directory.
+ */
+int GetStateDir(ConfigManagerType *pConfManager, std::string &stateDir) {
+    char *pEnvVarVal;
+
+    if (pConfManager->GetPath("journal_dir", stateDir) != 0) {
+        pEnvVarVal = getenv("HOME");
+        if (pEnvVarVal == NULL)
+            return 1;
+        stateDir.assign(pEnvVarVal);
+        stateDir.append("/.zync");
     }
 
-    std::cout << "Exited the ResolveModModConflicts() function.\n";
+    if ((mkdir(stateDir.c_str(), 0700) != 0) && (errno != EEXIST))
+        return 2;
 
+    return 0;
 }
 
-
 /**
- * Perform a Todo synchronization.
+ * Get the path of a device state file.
  *
- * Perform a Todo synchronization.
+ * Get the path of a state file kept for each Zaurus. It is kept in the state
+ * directory and its file name is prefixed with the identity of the Zaurus,
+ * its model and address, with any character which is not safe in a file
+ * name replaced by an underscore.
+ * @param pConfManager Pointer to the config manager to obtain options from.
+ * @param pName The suffix of the file name of the state file.
+ * @param deviceID The identity of the Zaurus being synchronized.
+ * @param statePath Reference to store the path of the state file in.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully got the path of the state file.
+ * @retval 1 Failed to determine the state directory.
+ * @retval 2 Failed to create the state directory.
  */
-int PerformTodoSync(unsigned short int confWinner,
-            ConfigManagerType *pConfManager) {
-    void *libHandle;
-    create_todo_t pCreateFunc;
-    destroy_todo_t pDestroyFunc;
-    TodoPluginType *pTodoPlugin;
-    char optVal[256];
+int GetDeviceStatePath(ConfigManagerType *pConfManager, const char *pName,
+                       const std::string &deviceID, std::string &statePath) {
+    std::string stateDir;
+    std::string fileName;
+    std::string::size_type i;
+    char c;
     int retval;
-    ZaurusType zaurus;
 
-    // The following three lists exist to contain the new, mod, del item
-    // information obtained from the Zaurus for conflict management and
-    // synchronization.
-    TodoItemType::List zNewTodoItemList;
-    TodoItemType::List zModTodoItemList;
-    SyncIDListType zDelTodoItemIDList;
+    retval = GetStateDir(pConfManager, stateDir);
+    if (retval != 0)
+        return retval;
+
+    for (i = 0; i < deviceID.size(); i++) {
+        c = deviceID[i];
+        if (((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) ||
+            ((c >= '0') && (c <= '9')) || (c == '-') || (c == '.'))
+            fileName += c;
+        else
+            fileName += '_';
+    }
+    fileName += "-";
+    fileName += pName;
 
-    // The following three lists exist to contain the new, mod, del item
-    // information obtain from the Desktop Todo Plugin for conflict management
-    // and synchronization.
-    TodoItemType::List dNewTodoItemList;
-    TodoItemType::List dModTodoItemList;
-    SyncIDListType dDelTodoItemIDList;
+    statePath = stateDir + "/" + fileName;
 
-    TodoItemType::List mapIdList;
+    return 0;
+}
 
-    SyncIDListType::iterator zSyncIDIter;
-    time_t lastTimeSynced;
-    TodoItemType::List::iterator zIter;
-    TodoItemType curItem;
-
-    // Normally the path to the selected Todo synchronization plugin would be
-    // loaded from the configuration file. However, the configuration file has
-    // not been implemented into this application yet. Hence, it is hard coded
-    // into the code right now for development of the first plugin.
-    retval = pConfManager->GetValue("todo_plugin_path", optVal, 256);
-    if (retval != 0) {
-        std::cout << "Error: No todo_plugin_path entry found in the" \
-            " .zync.conf configuration file.\n";
-        return 1;
-    }
+/**
+ * Get the device key.
+ *
+ * Get the key stored in the header of each binary device state file,
+ * identifying the Zaurus it belongs to. Sanitizing the identity for the
+ * file name may map two devices onto one file, so the file itself is
+ * checked against the key before it is trusted.
+ * @param deviceID The identity of the Zaurus being synchronized.
+ * @return The key identifying the Zaurus.
+ */
+uint64_t GetDeviceKey(const std::string &deviceID) {
+    uint64_t key = ITEM_HASH_SEED;
+    std::string::size_type i;
 
-    // Open the plugin and load the creation and destroy symbols.
-    libHandle = dlopen(optVal, RTLD_LAZY);
-    if (!libHandle) {
-        std::cout << "zync: Failed to open the KOrganizer Todo Plugin.\n";
-        std::cout << dlerror() << std::endl;
-        return 2;
+    for (i = 0; i < deviceID.size(); i++) {
+        key ^= (unsigned char)deviceID[i];
+        key *= ITEM_HASH_PRIME;
     }
 
-    pCreateFunc = (create_todo_t)dlsym(libHandle, "createTodoPlugin");
-    if (!pCreateFunc) {
-        std::cout << "zync: Failed to find the create symbol in plugin.\n";
-        std::cout << dlerror() << std::endl;
-        dlclose(libHandle);
+    return key;
+}
+
+/**
+ * Open the item mirror.
+ *
+ * Open the mirror of the items on the Zaurus, used to avoid transferring
+ * every item during a full sync. The mirror is a device state file.
+ * @param mirror Reference to the mirror to open.
+ * @param pConfManager Pointer to the config manager to obtain options from.
+ * @param pName The suffix of the file name of the mirror.
+ * @param deviceID The identity of the Zaurus being synchronized.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully opened the mirror.
+ * @retval 1 Failed to determine the state directory.
+ * @retval 2 Failed to create the state directory.
+ * @retval 3 Failed to open the mirror.
+ * @retval 4 The mirror belongs to a different device.
+ */
+int OpenMirror(MirrorType &mirror, ConfigManagerType *pConfManager,
+               const char *pName, const std::string &deviceID) {
+    std::string mirrorPath;
+    int retval;
+
+    retval = GetDeviceStatePath(pConfManager, pName, deviceID, mirrorPath);
+    if (retval != 0)
+        return retval;
+
+    retval = mirror.Open(mirrorPath, GetDeviceKey(deviceID));
+    if (retval == 3)
+        return 4;
+    else if (retval != 0)
         return 3;
-    }
 
-    pDestroyFunc = (destroy_todo_t)dlsym(libHandle, "destroyTodoPlugin");
-    if (!pDestroyFunc) {
-        std::cout << "zync: Failed to find the destroy symbol in plugin.\n";
-        std::cout << dlerror() << std::endl;
-        dlclose(libHandle);
+    return 0;
+}
+
+/**
+ * Open the ID mapping.
+ *
+ * Open the mapping between the sync IDs of the items on the Zaurus and
+ * their app IDs. The mapping is a device state file.
+ * @param idMap Reference to the mapping to open.
+ * @param pConfManager Pointer to the config manager to obtain options from.
+ * @param pName The suffix of the file name of the mapping.
+ * @param deviceID The identity of the Zaurus being synchronized.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully opened the mapping.
+ * @retval 1 Failed to determine the state directory.
+ * @retval 2 Failed to create the state directory.
+ * @retval 3 Failed to open the mapping.
+ * @retval 4 The mapping belongs to a different device.
+ */
+int OpenIDMap(IDMapType &idMap, ConfigManagerType *pConfManager,
+              const char *pName, const std::string &deviceID) {
+    std::string mapPath;
+    int retval;
+
+    retval = GetDeviceStatePath(pConfManager, pName, deviceID, mapPath);
+    if (retval != 0)
+        return retval;
+
+    retval = idMap.Open(mapPath, GetDeviceKey(deviceID));
+    if (retval == 3)
         return 4;
-    }
+    else if (retval != 0)
+        return 3;
 
-    // Create an instance of the plugin.
-    pTodoPlugin = pCreateFunc();
-    if (!pTodoPlugin) {
-        std::cout << "zync: Failed to create intance of the plugin object.\n";
-        dlclose(libHandle);
-        return 5;
+    return 0;
+}
+
+/**
+ * Remove ID mappings.
+ *
+ * Remove the mappings of the items with the given sync IDs, once the items
+ * have been deleted.
+ * @param idMap Reference to the mapping to remove the items from.
+ * @param idList The list of sync IDs of the deleted items.
+ */
+void RemoveIDMappings(IDMapType &idMap, const SyncIDListType &idList) {
+    SyncIDListType::const_iterator iter;
+
+    for (iter = idList.begin(); iter != idList.end(); ++iter)
+        idMap.Remove(*iter);
+}
+
+/**
+ * Record ID mappings.
+ *
+ * Record the sync ID and app ID of each of the given items in the mapping,
+ * and flush the mapping to disk. Items which are missing either ID, such as
+ * the ones which failed to be added to the Zaurus, are skipped.
+ * @param idMap Reference to the mapping to record the items in.
+ * @param itemList Reference to the list of items which had their IDs mapped.
+ */
+template <class ListType>
+void RecordIDMappings(IDMapType &idMap, const ListType &itemList) {
+    typename ListType::const_iterator iter;
+
+    for (iter = itemList.begin(); iter != itemList.end(); ++iter) {
+        if (((*iter).GetSyncID() != 0) && !(*iter).GetAppID().empty())
+            idMap.Put((*iter).GetSyncID(), (*iter).GetAppID());
     }
 
-    // At this point I have opened the plugin and have loaded the creation and
-    // destroy methods. This means I have the capability to create an instance
-    // of the TodoPluginType class and destroy it. Hence, I know that all the
-    // class functions have been implemented (because they are pure virtual)
-    // and assume that they work correctly. It should be fine to perform the
-    // synchronization now.
+    idMap.Sync();
+}
 
-    // Display the general plugin information.
-    std::cout << "Plugin Information\n";
-    std::cout << "------------------\n";
-    std::cout << "Plugin Name: " << pTodoPlugin->GetPluginName() + "\n";
-    std::cout << "Plugin Version: " << pTodoPlugin->GetPluginVersion() + "\n";
-    std::cout << "Plugin Author: " << pTodoPlugin->GetPluginAuthor() + "\n";
-    std::cout << "Plugin Desc: " << pTodoPlugin->GetPluginDescription() + "\n";
-    std::cout << std::endl;
+/**
+ * Fill in the IDs of items.
+ *
+ * Fill in the ID each of the given items is missing from the mapping. The
+ * items changed on the Zaurus only carry their sync IDs, so they are given
+ * their app IDs before being handed to the plugin. Items from the plugin
+ * which did not carry their sync IDs are given them as well.
+ * @param idMap Reference to the mapping to look the items up in.
+ * @param itemList Reference to the list of items to fill in.
+ */
+template <class ListType>
+void FillItemIDs(const IDMapType &idMap, ListType &itemList) {
+    typename ListType::iterator iter;
+    unsigned long int syncID;
+    std::string appID;
+
+    for (iter = itemList.begin(); iter != itemList.end(); ++iter) {
+        if ((*iter).GetAppID().empty()) {
+            if (((*iter).GetSyncID() != 0) &&
+                idMap.GetAppID((*iter).GetSyncID(), appID))
+                (*iter).SetAppID(appID);
+        } else if ((*iter).GetSyncID() == 0) {
+            if (idMap.GetSyncID((*iter).GetAppID(), syncID))
+                (*iter).SetSyncID(syncID);
+        }
+    }
+}
 
-    // Attempt to initialize the plugin.
-    retval = pTodoPlugin->Initialize();
-    if (retval != 0) {
-        std::cout << "zync: Failed to Initialize To-Do Plugin (" << retval;
-        std::cout << ")." << std::endl;
-        pDestroyFunc(pTodoPlugin);
-        dlclose(libHandle);
-        return 6;
+/**
+ * Drop applied IDs.
+ *
+ * Remove the sync IDs whose deletions the journal records as already
+ * applied to the plugin, so that they are not applied again when resuming a
+ * sync.
+ * @param journal Reference to the journal of the sync.
+ * @param idList Reference to the list of sync IDs to remove applied IDs
+ * from.
+ */
+void DropAppliedIDs(JournalType &journal, SyncIDListType &idList) {
+    SyncIDListType::iterator iter;
+
+    iter = idList.begin();
+    while (iter != idList.end()) {
+        if (journal.WasApplied(*iter, 0))
+            iter = idList.erase(iter);
+        else
+            ++iter;
     }
+}
 
-    std::cout << "Initialized the Todo plugin.\n";
+/**
+ * Record applied IDs.
+ *
+ * Record in the journal that the deletions of the given sync IDs have been
+ * applied to the plugin, and flush the journal to disk.
+ * @param journal Reference to the journal of the sync.
+ * @param idList Reference to the list of sync IDs which were applied.
+ */
+void RecordAppliedIDs(JournalType &journal, const SyncIDListType &idList) {
+    SyncIDListType::const_iterator iter;
 
-    // Tell the Desktop synchronization server to listen for a connection from
-    // a Zaurus.
-    zaurus.ListenConnection();
+    for (iter = idList.begin(); iter != idList.end(); ++iter)
+        journal.RecordApplied(*iter, 0);
 
-    std::cout << "Desktop Sync Server now listening.\n";
+    journal.Checkpoint();
+}
 
-    // Set the type of synchronization to the value that represents the To-Do
-    // synchronization type.
-    zaurus.SetSyncType(0x06);
+/**
+ * End the sync statistics.
+ *
+ * Stop recording the statistics of a sync and write them, if a stats_file
+ * is set, labelled with how the sync turned out. This is called on every
+ * way out of a sync once the statistics are being recorded, so that failed
+ * syncs show up in them as well.
+ * @param stats Reference to the statistics of the sync.
+ * @param settings Reference to the settings of the sync.
+ * @param result The value the sync is returning, zero for success.
+ * @return The given result, so that it may be returned straight away.
+ */
+int EndSyncStats(SyncStatsType &stats, const DeviceSettingsType &settings,
+                 int result) {
+    char resultBuff[16];
+    int retval;
 
-    std::cout << "Set the server sync type to 0x06.\n";
+    stats.EndPhase();
+    stats.Detach();
 
-    // Perform the actual todo synchronization.
-    if(zaurus.RequiresPassword()) {
-        // This first step in the authentication process is to obtain the
-        // password to send to the Zaurus for authentication. In this case the
-        // password should be in the config file. Hence, I try and obtain the
-        // passcode from the config file.
-        retval = pConfManager->GetValue("passcode", optVal, 256);
-        if (retval != 0) {
-            std::cout << "zync: Failed to obtain password from config.\n";
-            zaurus.FinishSync();
-            pDestroyFunc(pTodoPlugin);
-            dlclose(libHandle);
-            return 7;
-        }
+    snprintf(resultBuff, sizeof(resultBuff), "%d", result);
+    stats.SetLabel("outcome", (result == 0) ? "ok" : "failed");
+    stats.SetLabel("result", resultBuff);
 
-        // The second phase of the Authentication process is authenticating
-        // the password with the Zaurus. Hence, I attempt to authenticate the
-        // obtained password.
-        if (zaurus.AuthenticatePassword(optVal) != 0) {
-            std::cout << "zync: Failed to authenticate password.\n";
-            pDestroyFunc(pTodoPlugin);
-            dlclose(libHandle);
-            return 8;
+    if (!settings.GetStatsPath().empty()) {
+        retval = stats.Write(settings.GetStatsPath(),
+                             settings.GetStatsFormat());
+        if (retval != 0) {
+            std::cout << "Warning: Failed to write the sync statistics (";
+            std::cout << retval << ").\n";
+        } else {
+            std::cout << "Wrote the sync statistics.\n";
         }
     }
 
-    lastTimeSynced = zaurus.GetLastTimeSynced();
+    return result;
+}
 
-    std::cout << "Obtained \"Last Time Synced\".\n";
+/**
+ * Index sync IDs.
+ *
+ * Build a sorted index of the given sync IDs with duplicates removed, so
+ * that it may be intersected with other indexes in linear time.
+ * @param idList The list of sync IDs to index.
+ * @param idIndex Reference to the vector to store the sorted sync IDs in.
+ */
+void IndexSyncIDs(const SyncIDListType &idList, SyncIDIndexType &idIndex) {
+    idIndex.assign(idList.begin(), idList.end());
+    std::sort(idIndex.begin(), idIndex.end());
+    idIndex.erase(std::unique(idIndex.begin(), idIndex.end()), idIndex.end());
+}
 
-    // If I move the KOrgTodoPlugin calls here I don't get the segfault with
-    // them. However, if I leave them down below then I still get the
-    // segfault.
+/**
+ * Index batch sync IDs.
+ *
+ * Build a sorted index of the sync IDs of the items in the given batch with
+ * duplicates removed, so that it may be intersected with other indexes in
+ * linear time.
+ * @param batch The batch of items to index.
+ * @param idIndex Reference to the vector to store the sorted sync IDs in.
+ */
+void IndexBatchSyncIDs(const ItemBatchType &batch, SyncIDIndexType &idIndex) {
+    unsigned int i;
+
+    idIndex.clear();
+    idIndex.reserve(batch.GetCount());
+    for (i = 0; i < batch.GetCount(); i++)
+        idIndex.push_back(batch.GetSyncID(i));
+    std::sort(idIndex.begin(), idIndex.end());
+    idIndex.erase(std::unique(idIndex.begin(), idIndex.end()), idIndex.end());
+}
 
-    // Check if the Full Sync is required then try and clear the log, reset
-    // the log and exit with out saving sync state. Hence, all items should be
-    // seen as new items the next time one syncs (we hope).
-    if (zaurus.RequiresFullSync()) {
-        std::cout << "Note: Zaurus Requires Full Sync.\n";
-        zaurus.ResetSyncLog();
-        std::cout << "Reset Sync Log on the Zaurus.\n";
-        zaurus.SetNextSyncAnch();
-        std::cout << "Set the next sync anchor on the Zaurus.\n";
-        zaurus.SendRSSMsg();
-        std::cout << "Sent RSS message to the Zaurus.\n";
-    } else {
-        zaurus.SetNextSyncAnch();
-        std::cout << "Set the next sync anchor on the Zaurus.\n";
-    }
+/**
+ * Intersect sync ID indexes.
+ *
+ * Find the sync IDs which are in both of the given sorted indexes.
+ * @param aIndex The first sorted index of sync IDs.
+ * @param bIndex The second sorted index of sync IDs.
+ * @param conflictIndex Reference to the vector to store the sorted sync IDs
+ * found in both indexes in.
+ */
+void IntersectSyncIDs(const SyncIDIndexType &aIndex,
+                      const SyncIDIndexType &bIndex,
+                      SyncIDIndexType &conflictIndex) {
+    conflictIndex.clear();
+    std::set_intersection(aIndex.begin(), aIndex.end(), bIndex.begin(),
+                          bIndex.end(), std::back_inserter(conflictIndex));
+}
 
-    if (zaurus.ObtainParamInfo() != 0) {
-        std::cout << "Failed to ObtainParamInfo().\n";
+/**
+ * Remove sync IDs.
+ *
+ * Remove every sync ID found in the given sorted index from the given list
+ * of sync IDs.
+ * @param idList Reference to the list of sync IDs to remove from.
+ * @param idIndex The sorted index of the sync IDs to remove.
+ */
+void RemoveSyncIDs(SyncIDListType &idList, const SyncIDIndexType &idIndex) {
+    SyncIDListType::iterator iter;
+
+    if (idIndex.empty())
+        return;
+
+    iter = idList.begin();
+    while (iter != idList.end()) {
+        if (std::binary_search(idIndex.begin(), idIndex.end(), *iter))
+            iter = idList.erase(iter);
+        else
+            ++iter;
     }
-    std::cout << "Obtained parameter info from the Zaurus.\n";
+}
 
-    // Obtain the changes from the Zaurus.
-    if (zaurus.GetAllTodoSyncItems(zNewTodoItemList, zModTodoItemList,
-        zDelTodoItemIDList) != 0) {
-        std::cout << "Failed to get all sync items.\n";
-    }
-    std::cout << "Obtained all Todo sync items from the Zaurus.\n";
-
-    // Display the Zaurus changes information.
-    std::cout << "Zaurus Changes\n";
-    std::cout << "--------------\n";
-    std::cout << "Found " << zNewTodoItemList.size() << " new items on" \
-        " the Zaurus.\n";
-    std::cout << "Found " << zModTodoItemList.size() << " modified items" \
-        " on the Zaurus.\n";
-    std::cout << "Found " << zDelTodoItemIDList.size() << " items deleted" \
-        " from the Zaurus.\n";
-
-    // Obtain the changes from the Desktop PIM application todo plugin.
-    if (zaurus.RequiresFullSync()) {
-        std::cout << "Note: Zaurus Requires Full Sync.\n";
-        dNewTodoItemList = pTodoPlugin->GetAllTodoItems();
-        std::cout << "Obtained Todo items from the PIM Plugin.\n";
-    } else {
-        dNewTodoItemList = pTodoPlugin->GetNewTodoItems(lastTimeSynced);
-        std::cout << "Obtained New Todo Items from PIM Plugin.\n";
-        dModTodoItemList = pTodoPlugin->GetModTodoItems(lastTimeSynced);
-        std::cout << "Obtained Modified Todo Items from PIM Plugin.\n";
-        dDelTodoItemIDList = pTodoPlugin->GetDelTodoItemIDs(lastTimeSynced);
-        std::cout << "Obtained Deleted Todo Item IDs from PIM Plugin.\n";
-    }
+/**
+ * Read the sync window.
+ *
+ * Set the sync window of a Calendar sync from the cal_window_past and
+ * cal_window_future config options, the number of days before and after the
+ * present it covers. A side of the window which is not set is unbounded.
+ * @param settings Reference to the settings of the device being synced.
+ * @param window Reference to the sync window to set.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully set the sync window.
+ * @retval 1 Neither option is set, so there is no sync window.
+ */
+int ReadSyncWindow(const DeviceSettingsType &settings,
+                   CalendarWindowType &window) {
+    time_t now, start, end;
 
-    // Display the To-Do plugin changes.
-    std::cout << "To-Do Plugin Changes\n";
-    std::cout << "--------------------\n";
-    std::cout << "Found " << dNewTodoItemList.size() << " new items on" \
-        " the To-Do plugin.\n";
-    std::cout << "Found " << dModTodoItemList.size() << " modified items" \
-        " on the To-Do plugin.\n";
-    std::cout << "Found " << dDelTodoItemIDList.size() << " items deleted" \
-        " from the To-Do plugin.\n";
+    if (!settings.HasSyncWindow())
+        return 1;
 
-    if (!zaurus.RequiresFullSync()) {
-        std::cout << "Note: Zaurus does NOT require Full Sync.\n";
-        // Compare the todo item lists for conflicts and resolve the conflicts.
-        ResolveDelModConflicts(zDelTodoItemIDList, zModTodoItemList,
-            zNewTodoItemList, dDelTodoItemIDList,
-            dModTodoItemList, dNewTodoItemList);
-        std::cout << "Compared DelMod Conflicts and resolved them.\n";
+    now = time(NULL);
+    start = std::numeric_limits<time_t>::min();
+    end = std::numeric_limits<time_t>::max();
 
-        ResolveModModConflicts(zModTodoItemList, dModTodoItemList,
-            zNewTodoItemList, dNewTodoItemList,
-            confWinner);
-        std::cout << "Compared ModMod Conflicts and resolved them.\n";
-    }
+    if (settings.GetWindowPast() >= 0)
+        start = now - (time_t)settings.GetWindowPast() * 86400;
 
-    // I then want to do what I just did above but for the opposite
-    // component. Once I do that the deletion conflicts should all be handled.
+    if (settings.GetWindowFuture() >= 0)
+        end = now + (time_t)settings.GetWindowFuture() * 86400;
 
-    if (!zaurus.RequiresFullSync()) {
-        std::cout << "Note: Zaurus does NOT require Full Sync.\n";
-        // Perform the Desktop side of the synchronization.
-        std::cout << "Plugin About to Del Todo Items.\n";
-        pTodoPlugin->DelTodoItems(zDelTodoItemIDList);
-        std::cout << "Plugin Deleted Todo Items.\n";
-        std::cout << "Plugin About to Mod Todo Items.\n";
-        pTodoPlugin->ModTodoItems(zModTodoItemList);
-        std::cout << "Plugin Modified Todo Items.\n";
-        std::cout << "Plugin About to Add Todo Items.\n";
-        pTodoPlugin->AddTodoItems(zNewTodoItemList);
-        std::cout << "Plugin Added Todo Items.\n";
+    window.SetWindow(start, end);
 
-        // Perform the Zaurus side of the synchronization.
-        zaurus.DelTodoItems(dDelTodoItemIDList);
-        std::cout << "Zaurus deleted Del Todo Items.\n";
-        zaurus.ModTodoItems(dModTodoItemList);
-        std::cout << "Zaurus modified Mod Todo Items.\n";
-        mapIdList = zaurus.AddTodoItems(dNewTodoItemList);
-        std::cout << "Zaurus added Add Todo Items.\n";
+    return 0;
+}
 
-        // Map the proper IDs.
-        pTodoPlugin->MapItemIDs(mapIdList);
-        std::cout << "Mapped item IDs.\n";
-    } else {
-        std::cout << "Note: Zaurus DOES require Full Sync.\n";
-        std::cout << "Attempting to add todo items to the plugin.\n";
-        pTodoPlugin->AddTodoItems(zNewTodoItemList);
-        std::cout << "Added the todo items to the plugin.\n";
+/**
+ * Check if an event falls within the sync window.
+ *
+ * Check if the given event overlaps the sync window of the Calendar sync.
+ * @param window Reference to the sync window.
+ * @param item Reference to the event to check.
+ * @return True if the event falls within the window, false otherwise.
+ */
+bool IsInWindow(const CalendarWindowType &window,
+                const CalendarItemType &item) {
+    return window.Contains(item);
+}
 
-        std::cout << "Attempting to add todo items to the Zaurus.\n";
-        mapIdList = zaurus.AddTodoItems(dNewTodoItemList);
-        std::cout << "Added the todo items to the Zaurus.\n";
+/**
+ * Record the span of an event.
+ *
+ * Record the span of the given event, which was just read from or written
+ * to the Zaurus, so that the next full sync knows whether to fetch it.
+ * @param window Reference to the sync window.
+ * @param item Reference to the event read from or written to the Zaurus.
+ */
+void RecordSpan(CalendarWindowType &window, const CalendarItemType &item) {
+    if (window.IsEnabled())
+        window.Record(item);
+}
 
-        std::cout << "Attempting to Map Item IDs.\n";
-        pTodoPlugin->MapItemIDs(mapIdList);
-        std::cout << "Mapped item IDs.\n";
+/**
+ * Move items.
+ *
+ * Remove every item whose sync ID is found in the given sorted index from
+ * the given list, adding each removed item to the end of the destination
+ * list if one is given. The items are picked out by the batch loaded from
+ * the list, so only those moved are touched.
+ * @param fromList Reference to the list of items to remove from.
+ * @param pToList Pointer to the list to add removed items to, or NULL if
+ * removed items should simply be dropped.
+ * @param batch The batch loaded from the list of items to remove from.
+ * @param idIndex The sorted index of the sync IDs of the items to move.
+ */
+template <class ListType>
+void MoveItems(ListType &fromList, ListType *pToList,
+               const ItemBatchType &batch, const SyncIDIndexType &idIndex) {
+    std::vector<bool> moveFlags;
+    typename ListType::size_type i;
+
+    if (batch.SelectSyncIDs(idIndex, moveFlags) == 0)
+        return;
+
+    if (pToList) {
+        for (i = 0; i < fromList.size(); i++) {
+            if (moveFlags[i]) {
+                pToList->push_back(typename ListType::value_type());
+                std::swap(pToList->back(), fromList[i]);
+            }
+        }
     }
 
-    zaurus.TerminateSync();
-    std::cout << "Terminated the Synchronization with the Zaurus.\n";
+    EraseItems(fromList, moveFlags);
+}
 
-    /////////////////////////////////////////////////////////////////////////
-    // The code below needs to stay to handle destruction of the plugin and
-    // closing of the shared object that is the plugin.
-    /////////////////////////////////////////////////////////////////////////
+/**
+ * Resolve Deltion/Modification conflicts.
+ *
+ * This function searches for and resolves any conflicts found between
+ * deletion of items and modification of items. If a conflict is found it is
+ * handled by replacing the deleted item with the modified item. The
+ * conflicts are found by intersecting sorted indexes of the sync IDs on each
+ * side, rather than searching one list for each entry of the other.
+ */
+template <class ListType>
+void ResolveDelModConflicts(SyncIDListType &zDelItemIDList,
+                            ListType &zModItemList,
+                            ListType &zAddItemList,
+                            SyncIDListType &dDelItemIDList,
+                            ListType &dModItemList,
+                            ListType &dAddItemList) {
+    SyncIDIndexType delIndex;
+    SyncIDIndexType modIndex;
+    SyncIDIndexType conflictIndex;
+    ItemBatchType modBatch;
 
-    retval = pTodoPlugin->CleanUp();
-    if (retval != 0) {
-        std::cout << "ERROR: Failed to Clean up To-Do Plugin (" << retval;
-        std::cout << ")." << std::endl;
-        pDestroyFunc(pTodoPlugin);
-        dlclose(libHandle);
-        return 9;
-    }
-    std::cout << "Performed the Plugin Clean Up.\n";
+    // Now in this case in this function I am resolving any conflicts between
+    // deletion and modification. This is the only type of conflict that
+    // should ever be created other than a deletion on both ends. Since
+    // deletion is such a harsh action and can cause data loss, which can be
+    // very bad in certain situations, the choice for resolving such conflicts
+    // is that a modification wins in conflict with a delete. Hence, if one
+    // deletes an item from their Desktop PIM software and modifies that same
+    // item on the Zaurus. When the next synchronization is performed the item
+    // should be recreated on their Desktop PIM software with the updated
+    // information.
 
-    // Destroy the plugin object and close the plugin.
-    pDestroyFunc(pTodoPlugin);
-    dlclose(libHandle);
+    std::cout << "Entered the ResolveDelmodConflicts() function.\n";
 
-    std::cout << "Closed the plugin.\n";
-    std::cout << "Exiting the PerformTodoSync() function.\n";
+    // First I handle the items deleted from the Zaurus and modified on the
+    // Desktop. The modification of each is moved to the add list so that it
+    // is added again, and it is taken out of the deletion list so that it is
+    // not deleted after it has been added.
+    IndexSyncIDs(zDelItemIDList, delIndex);
+    modBatch.Load(dModItemList);
+    IndexBatchSyncIDs(modBatch, modIndex);
+    IntersectSyncIDs(delIndex, modIndex, conflictIndex);
+    MoveItems(dModItemList, &dAddItemList, modBatch, conflictIndex);
+    RemoveSyncIDs(zDelItemIDList, conflictIndex);
+
+    std::cout << "Resolved " << conflictIndex.size() << " Zaurus deletion" \
+        " conflicts.\n";
+
+    // Now I handle the conflicts in the case where the Desktop PIM
+    // application has deleted an item and the Zaurus has modified it.
+    IndexSyncIDs(dDelItemIDList, delIndex);
+    modBatch.Load(zModItemList);
+    IndexBatchSyncIDs(modBatch, modIndex);
+    IntersectSyncIDs(delIndex, modIndex, conflictIndex);
+    MoveItems(zModItemList, &zAddItemList, modBatch, conflictIndex);
+    RemoveSyncIDs(dDelItemIDList, conflictIndex);
+
+    std::cout << "Resolved " << conflictIndex.size() << " Desktop deletion" \
+        " conflicts.\n";
 
-    return 0;
+    std::cout << "Exited the ResolveDelmodConflicts() function.\n";
 }
 
 /**
- * Perform a Calendar synchronization.
+ * Resolve Modification/Modification conflicts.
  *
- * Perform a Calendar synchronization.
+ * This function searches for and resolves any conflicts found between
+ * modification of items and modification of items. If a conflict is found it
+ * is handled using the conflict winner specified config option. The
+ * conflicts are found by intersecting sorted indexes of the sync IDs on each
+ * side, rather than searching one list for each entry of the other.
  */
-int PerformCalendarSync(unsigned short int confWinner,
-            ConfigManagerType *pConfManager) {
-    void *libHandle;
-    create_cal_t pCreateFunc;
-    destroy_cal_t pDestroyFunc;
-    CalendarPluginType *pPlugin;
-    char optVal[256];
+template <class ListType>
+void ResolveModModConflicts(ListType &zModItemList,
+                            ListType &dModItemList,
+                            ListType &zAddItemList,
+                            ListType &dAddItemList,
+                            unsigned short int conflict_winner) {
+    SyncIDIndexType zModIndex;
+    SyncIDIndexType dModIndex;
+    SyncIDIndexType conflictIndex;
+    ItemBatchType zModBatch;
+    ItemBatchType dModBatch;
+
+    std::cout << "Entered the ResolveModModConflicts() function.\n";
+
+    zModBatch.Load(zModItemList);
+    dModBatch.Load(dModItemList);
+    IndexBatchSyncIDs(zModBatch, zModIndex);
+    IndexBatchSyncIDs(dModBatch, dModIndex);
+    IntersectSyncIDs(zModIndex, dModIndex, conflictIndex);
+
+    std::cout << "Found " << conflictIndex.size() << " conflicting" \
+        " modifications.\n";
+
+    if (conflict_winner == CONF_WIN_Z) {
+        // The Zaurus wins, so the Desktop modifications are dropped.
+        MoveItems(dModItemList, (ListType *)NULL, dModBatch,
+                  conflictIndex);
+    } else if (conflict_winner == CONF_WIN_D) {
+        // The Desktop wins, so the Zaurus modifications are dropped.
+        MoveItems(zModItemList, (ListType *)NULL, zModBatch,
+                  conflictIndex);
+    } else if (conflict_winner == CONF_WIN_B) {
+        // Both win, so each modification is added to the other side as a
+        // new item.
+        MoveItems(dModItemList, &dAddItemList, dModBatch, conflictIndex);
+        MoveItems(zModItemList, &zAddItemList, zModBatch, conflictIndex);
+    }
+
+    std::cout << "Exited the ResolveModModConflicts() function.\n";
+}
+
+
+/**
+ * Perform a synchronization.
+ *
+ * Perform a synchronization of the type described by the given traits. The
+ * same pipeline is used for every type of synchronization (To-Do, Calendar,
+ * Address Book), only the items and plugin differ. The settings of the sync
+ * are resolved from the profiles of the Zaurus once it has connected, so
+ * the plugin is only loaded after that.
+ * @param pConfManager Pointer to the config manager to obtain options from.
+ * @return An integer representing success (zero) or failure (non-zero).
+ * @retval 0 Successfully performed the synchronization.
+ * @retval 1 Failed, the plugin path is not set in the config.
+ * @retval 2 Failed to open the plugin.
+ * @retval 3 Failed to find the create symbol in the plugin.
+ * @retval 4 Failed to find the destroy symbol in the plugin.
+ * @retval 5 Failed to create an instance of the plugin.
+ * @retval 6 Failed to initialize the plugin.
+ * @retval 7 Failed to obtain the passcode from the config.
+ * @retval 8 Failed to authenticate the passcode.
+ * @retval 9 Failed to clean up the plugin.
+ * @retval 10 Failed to start the plugin host process.
+ * @retval 11 Failed to obtain the items from the plugin.
+ * @retval 12 Failed to resolve the settings of the Zaurus.
+ */
+template <class Traits>
+int PerformSync(ConfigManagerType *pConfManager) {
+    typedef typename Traits::ItemT ItemT;
+    typedef typename Traits::PluginV2T PluginV2T;
+    PluginLoaderType<Traits> plugin;
+    PluginV2T *pPlugin;
+    std::string pluginPath;
+    bool requiresPassword;
     int retval;
     ZaurusType zaurus;
 
+    // These are the settings of the sync, resolved from the profiles of the
+    // Zaurus once it has connected.
+    DeviceSettingsType settings;
+
+    // These are the statistics of where the time of the sync goes.
+    SyncStatsType stats;
+
     // The following three lists exist to contain the new, mod, del item
     // information obtained from the Zaurus for conflict management and
     // synchronization.
-    CalendarItemType::List zNewCalItemList;
-    CalendarItemType::List zModCalItemList;
-    SyncIDListType zDelCalItemIDList;
+    typename ItemT::List zNewItemList;
+    typename ItemT::List zModItemList;
+    SyncIDListType zDelItemIDList;
 
     // The following three lists exist to contain the new, mod, del item
-    // information obtain from the Desktop Todo Plugin for conflict management
+    // information obtain from the Desktop plugin for conflict management
     // and synchronization.
-    CalendarItemType::List dNewCalItemList;
-    CalendarItemType::List dModCalItemList;
-    SyncIDListType dDelCalItemIDList;
+    typename ItemT::List dNewItemList;
+    typename ItemT::List dModItemList;
+    SyncIDListType dDelItemIDList;
+
+    typename ItemT::List mapIdList;
+    typename ItemT::List addedIdList;
+
+    // The following two lists hold the items both sides already had during
+    // a full sync, until they have been compared with the mirror.
+    typename ItemT::List zHeldItemList;
+    typename ItemT::List dHeldItemList;
+    HeldHashMapType heldHashes;
+    HeldHashMapType::const_iterator heldIter;
+
+    // This is the journal used to resume the sync if it is interrupted.
+    JournalType journal;
+
+    // This is the identity of the Zaurus, along with the key stored in its
+    // state files, which the state kept between syncs is keyed by.
+    std::string deviceID;
+    uint64_t deviceKey;
+
+    // This is the mirror of the items on the Zaurus, used to avoid
+    // transferring every item during a full sync.
+    MirrorType mirror;
+
+    // This is the mapping between the sync IDs and app IDs of the items,
+    // shared with the plugin.
+    IDMapType idMap;
+
+    // This is the snapshot of the plugin items, used to find the changes to
+    // them when change_detection is set to snapshot.
+    SnapshotType snapshot;
+    std::string snapshotPath;
+    bool useSnapshot = false;
+    bool hasSnapshot = false;
+    typename ItemT::List allItemList;
+
+    // This is the window a Calendar sync is limited to, along with the
+    // spans of the events on the Zaurus.
+    CalendarWindowType window;
+    std::string spansPath;
+    std::set<unsigned long int> skippedSyncIDs;
+    SyncIDListType zSyncIDList;
 
-    CalendarItemType::List mapIdList;
-
-    SyncIDListType::iterator zSyncIDIter;
     time_t lastTimeSynced;
-    CalendarItemType::List::iterator zIter;
-    CalendarItemType curItem;
 
-    retval = pConfManager->GetValue("cal_plugin_path", optVal, 256);
+    // Tell the Desktop synchronization server to listen for a connection from
+    // a Zaurus.
+    zaurus.ListenConnection();
+
+    std::cout << "Desktop Sync Server now listening.\n";
+
+    // From here on every exchange with the Zaurus is recorded, and the time
+    // of each phase of the sync is added up.
+    stats.Attach();
+    stats.SetLabel("sync", Traits::GetName());
+    stats.StartPhase("handshake");
+
+    // Set the type of synchronization to the value that represents the type
+    // being synchronized.
+    zaurus.SetSyncType(Traits::GetSyncType());
+
+    std::cout << "Set the server sync type to 0x" << std::hex \
+        << (unsigned int)Traits::GetSyncType() << std::dec << ".\n";
+
+    // Obtaining the device information tells me the model of the Zaurus,
+    // which together with the address it connected from picks the profiles
+    // the settings of this sync are resolved from.
+    requiresPassword = zaurus.RequiresPassword();
+    stats.SetLabel("model", zaurus.GetModel());
+    stats.SetLabel("address", zaurus.GetAddress());
+
+    retval = settings.Resolve(*pConfManager, zaurus.GetAddress(),
+                              zaurus.GetModel());
     if (retval != 0) {
-        std::cout << "Error: No cal_plugin_path entry found in the" \
-            " .zync.conf configuration file.\n";
-        return 1;
+        std::cout << "zync: Invalid " << settings.GetBadOption() \
+            << " setting for the Zaurus " << zaurus.GetModel() << " at " \
+            << zaurus.GetAddress() << ".\n";
+        zaurus.FinishSync();
+        return EndSyncStats(stats, settings, 12);
     }
+    if (!settings.GetProfiles().empty())
+        std::cout << "Using the device profiles " << settings.GetProfiles() \
+            << ".\n";
 
-    // Open the plugin and load the creation and destroy symbols.
-    libHandle = dlopen(optVal, RTLD_LAZY);
-    if (!libHandle) {
-        std::cout << "zync: Failed to open the Calendar Plugin.\n";
-        std::cout << dlerror() << std::endl;
-        return 2;
+    retval = zaurus.TuneSocket(settings.GetSocketTimeout(),
+                               settings.GetSocketBuffer(),
+                               settings.GetNoDelay());
+    if (retval != 0) {
+        std::cout << "Warning: Failed to tune the connection (" << retval;
+        std::cout << ").\n";
     }
 
-    pCreateFunc = (create_cal_t)dlsym(libHandle, "createCalendarPlugin");
-    if (!pCreateFunc) {
-        std::cout << "zync: Failed to find the create symbol in plugin.\n";
-        std::cout << dlerror() << std::endl;
-        dlclose(libHandle);
-        return 3;
+    retval = settings.GetPluginPath(Traits::GetPluginPathKey(), pluginPath);
+    if (retval != 0) {
+        std::cout << "Error: No " << Traits::GetPluginPathKey() << " entry" \
+            " found in the .zync.conf configuration file.\n";
+        zaurus.FinishSync();
+        return EndSyncStats(stats, settings, 1);
     }
 
-    pDestroyFunc = (destroy_cal_t)dlsym(libHandle, "destroyCalendarPlugin");
-    if (!pDestroyFunc) {
+    stats.StartPhase("plugin_load");
+
+    // Open the plugin, load the creation and destroy symbols and create an
+    // instance of the plugin. The version 2 interface is used if the plugin
+    // provides it, otherwise the version 1 plugin is adapted to it. With
+    // plugin_host set to process the plugin runs in a host process of its
+    // own, optionally killed if it takes longer than plugin_timeout seconds
+    // to answer. Either way the Zaurus is let go if it fails.
+    if (settings.IsPluginHosted())
+        retval = plugin.LoadHosted(pluginPath.c_str(),
+                                   settings.GetPluginTimeout());
+    else
+        retval = plugin.Load(pluginPath.c_str());
+    if (retval != 0)
+        zaurus.FinishSync();
+    if (retval == 1) {
+        std::cout << "zync: Failed to open the " << Traits::GetName() \
+            << " Plugin.\n";
+        std::cout << plugin.GetError() << std::endl;
+        return EndSyncStats(stats, settings, 2);
+    } else if (retval == 2) {
+        std::cout << "zync: Failed to find the create symbol in plugin.\n";
+        std::cout << plugin.GetError() << std::endl;
+        return EndSyncStats(stats, settings, 3);
+    } else if (retval == 3) {
         std::cout << "zync: Failed to find the destroy symbol in plugin.\n";
-        std::cout << dlerror() << std::endl;
-        dlclose(libHandle);
-        return 4;
-    }
-
-    // Create an instance of the plugin.
-    pPlugin = pCreateFunc();
-    if (!pPlugin) {
+        std::cout << plugin.GetError() << std::endl;
+        return EndSyncStats(stats, settings, 4);
+    } else if (retval == 4) {
         std::cout << "zync: Failed to create intance of the plugin object.\n";
-        dlclose(libHandle);
-        return 5;
+        return EndSyncStats(stats, settings, 5);
+    } else if (retval != 0) {
+        std::cout << "zync: Failed to start the plugin host.\n";
+        std::cout << plugin.GetError() << std::endl;
+        return EndSyncStats(stats, settings, 10);
     }
+    pPlugin = plugin.GetPlugin();
 
     // At this point I have opened the plugin and have loaded the creation and
     // destroy methods. This means I have the capability to create an instance
-    // of the CalendarPluginType class and destroy it. Hence, I know that all
-    // the class functions have been implemented (because they are pure
-    // virtual) and assume that they work correctly. It should be fine to
-    // perform the synchronization now.
+    // of the plugin class and destroy it. Hence, I know that all the class
+    // functions have been implemented (because they are pure virtual) and
+    // assume that they work correctly. It should be fine to perform the
+    // synchronization now.
 
     // Display the general plugin information.
     std::cout << "Plugin Information\n";
@@ -1073,225 +1783,478 @@ int PerformCalendarSync(unsigned short int confWinner,
     std::cout << "Plugin Version: " << pPlugin->GetPluginVersion() + "\n";
     std::cout << "Plugin Author: " << pPlugin->GetPluginAuthor() + "\n";
     std::cout << "Plugin Desc: " << pPlugin->GetPluginDescription() + "\n";
+    std::cout << "Plugin Interface: " << (plugin.IsV2() ? 2 : 1) << "\n";
+    if (plugin.IsHosted())
+        std::cout << "Plugin Host: process\n";
     std::cout << std::endl;
 
     // Attempt to initialize the plugin.
     retval = pPlugin->Initialize();
     if (retval != 0) {
-        std::cout << "zync: Failed to Initialize Plugin (" << retval;
-        std::cout << ")." << std::endl;
-        pDestroyFunc(pPlugin);
-        dlclose(libHandle);
-        return 6;
+        std::cout << "zync: Failed to Initialize " << Traits::GetName() \
+            << " Plugin (" << retval << ")." << std::endl;
+        zaurus.FinishSync();
+        return EndSyncStats(stats, settings, 6);
     }
 
-    std::cout << "zync: Initialized the plugin.\n";
+    std::cout << "Initialized the " << Traits::GetName() << " plugin.\n";
 
-    // Tell the Desktop synchronization server to listen for a connection from
-    // a Zaurus.
-    zaurus.ListenConnection();
+    // Perform the actual synchronization.
+    stats.StartPhase("handshake");
+    if (requiresPassword) {
+        // This first step in the authentication process is to obtain the
+        // password to send to the Zaurus for authentication. In this case the
+        // password should be in the config file, resolved with the rest of
+        // the settings.
+        if (!settings.HasPasscode()) {
+            std::cout << "zync: Failed to obtain password from config.\n";
+            zaurus.FinishSync();
+            return EndSyncStats(stats, settings, 7);
+        }
 
-    // Set the type of synchronization to the value that represents the
-    // Calendar synchronization type.
-    zaurus.SetSyncType(0x01);
+        // The second phase of the Authentication process is authenticating
+        // the password with the Zaurus. Hence, I attempt to authenticate the
+        // obtained password.
+        if (zaurus.AuthenticatePassword(settings.GetPasscode()) != 0) {
+            std::cout << "zync: Failed to authenticate password.\n";
+            return EndSyncStats(stats, settings, 8);
+        }
+    }
 
-    // Perform the actual synchronization.
-    if(zaurus.RequiresPassword()) {
-    // This first step in the authentication process is to obtain the
-    // password to send to the Zaurus for authentication. In this case the
-    // password should be in the config file. Hence, I try and obtain the
-    // passcode from the config file.
-    retval = pConfManager->GetValue("passcode", optVal, 256);
+    lastTimeSynced = zaurus.GetLastTimeSynced();
+
+    std::cout << "Obtained \"Last Time Synced\".\n";
+
+    stats.StartPhase("state_load");
+
+    // The state kept between syncs belongs to this particular Zaurus, so
+    // that handhelds of the same model never share it.
+    deviceID = zaurus.GetDeviceID();
+    deviceKey = GetDeviceKey(deviceID);
+
+    // Open the journal, picking up where an interrupted sync left off if
+    // there was one. A sync can still be performed without a journal, it
+    // just can not be resumed.
+    retval = OpenJournal(journal, pConfManager, Traits::GetJournalName(),
+                         Traits::GetSyncType(), deviceID,
+                         settings.GetJournalMaxAge());
     if (retval != 0) {
-        std::cout << "zync: Failed to obtain passcode from config.\n";
-        zaurus.FinishSync();
-        pDestroyFunc(pPlugin);
-        dlclose(libHandle);
-        return 7;
+        std::cout << "Warning: Failed to open the sync journal (" << retval;
+        std::cout << ").\n";
+    } else {
+        zaurus.SetJournal(&journal);
+        if (journal.IsResumed())
+            std::cout << "Resuming an interrupted " << Traits::GetName() \
+                << " sync.\n";
     }
 
-    std::cout << "zync: Obtained passcode from config.\n";
-
-    // The second phase of the Authentication process is authenticating
-    // the password with the Zaurus. Hence, I attempt to authenticate the
-    // obtained password.
-    if (zaurus.AuthenticatePassword(optVal) != 0) {
-        std::cout << "zync: Failed to authenticate password.\n";
-        pDestroyFunc(pPlugin);
-        dlclose(libHandle);
-        return 8;
+    // Open the mirror of the items on the Zaurus. Without it a full sync
+    // simply transfers every item.
+    retval = OpenMirror(mirror, pConfManager, Traits::GetMirrorName(),
+                        deviceID);
+    if (retval != 0) {
+        std::cout << "Warning: Failed to open the item mirror (" << retval;
+        std::cout << ").\n";
+    } else {
+        zaurus.SetMirror(&mirror);
     }
 
-    std::cout << "zync: Successfully authenticated the passcode.\n";
+    // Open the mapping between sync IDs and app IDs and share it with the
+    // plugin. Without it plugins fall back on their own mappings.
+    retval = OpenIDMap(idMap, pConfManager, Traits::GetIDMapName(),
+                       deviceID);
+    if (retval != 0) {
+        std::cout << "Warning: Failed to open the ID mapping (" << retval;
+        std::cout << ").\n";
+    } else {
+        IDMapType::SetShared(&idMap);
     }
 
-    lastTimeSynced = zaurus.GetLastTimeSynced();
+    // Determine how the changes to the plugin items are found. By default
+    // the plugin is asked for them, with change_detection set to snapshot
+    // they are found by comparing all the plugin items to a snapshot.
+    if (settings.UsesSnapshot()) {
+        retval = GetDeviceStatePath(pConfManager, Traits::GetSnapshotName(),
+                                    deviceID, snapshotPath);
+        if (retval != 0) {
+            std::cout << "Warning: Failed to locate the item snapshot (";
+            std::cout << retval << ").\n";
+        } else {
+            // A snapshot of another Zaurus is left alone rather than
+            // diffed against or saved over.
+            retval = snapshot.Load(snapshotPath, deviceKey);
+            if (retval == 3) {
+                std::cout << "Warning: The item snapshot belongs to another" \
+                    " Zaurus.\n";
+            } else {
+                useSnapshot = true;
+                hasSnapshot = (retval == 0);
+            }
+        }
+    }
 
-    std::cout << "zync: Obtained the Last Time Synchronized Anchor.\n";
+    // Limit a Calendar sync to the events within the sync window, if one is
+    // set. The spans of the events on the Zaurus may not have been saved
+    // yet, in which case every event is fetched once to find them.
+    if ((Traits::GetSyncType() == SYNC_CALENDAR) &&
+        (ReadSyncWindow(settings, window) == 0)) {
+        retval = GetDeviceStatePath(pConfManager, "calendar.spans",
+                                    deviceID, spansPath);
+        if (retval != 0) {
+            std::cout << "Warning: Failed to locate the event spans (";
+            std::cout << retval << ").\n";
+        } else if (window.Load(spansPath, deviceKey) == 3) {
+            std::cout << "Warning: The event spans belong to another" \
+                " Zaurus.\n";
+            spansPath.clear();
+        }
+    }
 
-    // If I move the KOrgTodoPlugin calls here I don't get the segfault with
-    // them. However, if I leave them down below then I still get the
-    // segfault.
+    stats.StartPhase("handshake");
 
     // Check if the Full Sync is required then try and clear the log, reset
     // the log and exit with out saving sync state. Hence, all items should be
     // seen as new items the next time one syncs (we hope).
     if (zaurus.RequiresFullSync()) {
-        std::cout << "zync: Zaurus claimed that Full Sync is required.\n";
+        std::cout << "Note: Zaurus Requires Full Sync.\n";
         zaurus.ResetSyncLog();
-        std::cout << "zync: Reset the synchronization log.\n";
+        std::cout << "Reset Sync Log on the Zaurus.\n";
         zaurus.SetNextSyncAnch();
-        std::cout << "zync: Set the next synchronization anchor.\n";
+        std::cout << "Set the next sync anchor on the Zaurus.\n";
         zaurus.SendRSSMsg();
-        std::cout << "zync: Sent the RSS message.\n";
+        std::cout << "Sent RSS message to the Zaurus.\n";
     } else {
-        std::cout << "zync: Zaurus claimed that Normal Sync is required.\n";
         zaurus.SetNextSyncAnch();
-        std::cout << "zync: Set the nexct synchronization anchor.\n";
+        std::cout << "Set the next sync anchor on the Zaurus.\n";
     }
 
+    stats.StartPhase("param_info");
     if (zaurus.ObtainParamInfo() != 0) {
-        std::cout << "zync: Failed to ObtainParamInfo().\n";
+        std::cout << "Failed to ObtainParamInfo().\n";
     }
-    std::cout << "zync: Obtained the parameter info for the sync.\n";
+    std::cout << "Obtained parameter info from the Zaurus.\n";
 
-    // Obtain the changes from the Zaurus.
-    if (zaurus.GetAllCalendarSyncItems(zNewCalItemList, zModCalItemList,
-                       zDelCalItemIDList) != 0) {
-        std::cout << "zync: Failed to get all sync items.\n";
+    // Obtain the changes from the Zaurus. In a full sync there is nothing to
+    // resolve, so rather than fetching every item up front the items are
+    // streamed into the plugin further below.
+    if (!zaurus.RequiresFullSync()) {
+        stats.StartPhase("fetch");
+        if (zaurus.GetAllSyncItems(zNewItemList, zModItemList,
+            zDelItemIDList) != 0) {
+            std::cout << "Failed to get all sync items.\n";
+        }
+        std::cout << "Obtained all " << Traits::GetName() << " sync items" \
+            " from the Zaurus.\n";
+
+        // Display the Zaurus changes information.
+        std::cout << "Zaurus Changes\n";
+        std::cout << "--------------\n";
+        std::cout << "Found " << zNewItemList.size() << " new items on" \
+            " the Zaurus.\n";
+        std::cout << "Found " << zModItemList.size() << " modified" \
+            " items on the Zaurus.\n";
+        std::cout << "Found " << zDelItemIDList.size() << " items" \
+            " deleted from the Zaurus.\n";
+
+        // The items are checked against the spans they had before they
+        // were changed, so that items moved out of the window are still
+        // changed on the plugin.
+        if (window.IsEnabled()) {
+            retval = DropOutsideWindow(window, zNewItemList);
+            retval += DropOutsideWindow(window, zModItemList);
+            std::cout << "Left out " << retval << " Zaurus items outside" \
+                " the sync window.\n";
+        }
+        RecordSpans(window, zNewItemList);
+        RecordSpans(window, zModItemList);
+        window.Forget(zDelItemIDList);
     }
 
-    std::cout << "zync: Obtained all the items from the Zaurus.\n";
-
-    // Display the Zaurus changes information.
-    std::cout << "Zaurus Changes\n";
-    std::cout << "--------------\n";
-    std::cout << "Found " << zNewCalItemList.size() << " new items on" \
-    " the Zaurus.\n";
-    std::cout << "Found " << zModCalItemList.size() << " modified items" \
-    " on the Zaurus.\n";
-    std::cout << "Found " << zDelCalItemIDList.size() << " items deleted" \
-    " from the Zaurus.\n";
-
-    // Obtain the changes from the Desktop PIM application todo plugin.
+    // Obtain the changes from the Desktop PIM application plugin.
+    stats.StartPhase("plugin_fetch");
     if (zaurus.RequiresFullSync()) {
-        std::cout << "zync: In Full Sync mode.\n";
-        std::cout << "zync: Attemting to get all plugin items.\n";
-        dNewCalItemList = pPlugin->GetAllCalendarItems();
-        std::cout << "zync: Obtained all plugin items.\n";
+        retval = plugin.GetAllItems(dNewItemList);
+        std::cout << "Obtained all items from the PIM Plugin.\n";
+    } else if (hasSnapshot) {
+        retval = plugin.GetAllItems(allItemList);
+        if (retval == 0) {
+            FillItemIDs(idMap, allItemList);
+            snapshot.Diff(allItemList, dNewItemList, dModItemList,
+                          dDelItemIDList);
+        }
+        allItemList.clear();
+        std::cout << "Obtained changes by diffing all items from the PIM" \
+            " Plugin against the snapshot.\n";
     } else {
-        std::cout << "zync: In Normal Sync mode.\n";
-        std::cout << "zync: Obtaining New Items from plugin.\n";
-        dNewCalItemList = pPlugin->GetNewCalendarItems(lastTimeSynced);
-        std::cout << "zync: Obtained New Items from plugin.\n";
-        std::cout << "zync: Obtaining Mod Items from plugin.\n";
-        dModCalItemList = pPlugin->GetModCalendarItems(lastTimeSynced);
-        std::cout << "zync: Obtained Mod Items from plugin.\n";
-        std::cout << "zync: Obtaining Del Items from plugin.\n";
-        dDelCalItemIDList = pPlugin->GetDelCalendarItemIDs(lastTimeSynced);
-        std::cout << "zync: Obtained Del Items from plugin.\n";
+        retval = plugin.GetNewItems(lastTimeSynced, dNewItemList);
+        std::cout << "Obtained New Items from PIM Plugin.\n";
+        if (retval == 0)
+            retval = plugin.GetModItems(lastTimeSynced, dModItemList);
+        std::cout << "Obtained Modified Items from PIM Plugin.\n";
+        if (retval == 0)
+            retval = plugin.GetDelItemIDs(lastTimeSynced, dDelItemIDList);
+        std::cout << "Obtained Deleted Item IDs from PIM Plugin.\n";
     }
 
-    std::cout << "zync: Obtained items from plugin.\n";
+    // Going on with only part of the plugin items would have the missing
+    // ones treated as deleted or never synced, so I give up on the sync
+    // instead. The Zaurus keeps its changes for the next sync.
+    if (retval != 0) {
+        std::cout << "zync: Failed to obtain the items from the " \
+            << Traits::GetName() << " Plugin (" << retval << ").\n";
+        zaurus.FinishSync();
+        zaurus.SetJournal(NULL);
+        zaurus.SetMirror(NULL);
+        IDMapType::SetShared(NULL);
+        return EndSyncStats(stats, settings, 11);
+    }
+
+    // Plugin items which do not carry their sync IDs are looked up in the
+    // mapping, so that they are matched with their Zaurus items.
+    FillItemIDs(idMap, dNewItemList);
+    FillItemIDs(idMap, dModItemList);
+
+    // Deletions are still passed on whatever the window, an item being
+    // deleted is never a problem.
+    if (window.IsEnabled()) {
+        retval = DropOutsideWindow(window, dNewItemList);
+        retval += DropOutsideWindow(window, dModItemList);
+        std::cout << "Left out " << retval << " plugin items outside the" \
+            " sync window.\n";
+    }
 
     // Display the plugin changes.
-    std::cout << "Calendar Plugin Changes\n";
-    std::cout << "-----------------------\n";
-    std::cout << "Found " << dNewCalItemList.size() << " new items on" \
-    " the plugin.\n";
-    std::cout << "Found " << dModCalItemList.size() << " modified items" \
-    " on the plugin.\n";
-    std::cout << "Found " << dDelCalItemIDList.size() << " items deleted" \
-    " from the plugin.\n";
+    std::cout << Traits::GetName() << " Plugin Changes\n";
+    std::cout << "--------------------\n";
+    std::cout << "Found " << dNewItemList.size() << " new items on" \
+        " the plugin.\n";
+    std::cout << "Found " << dModItemList.size() << " modified items" \
+        " on the plugin.\n";
+    std::cout << "Found " << dDelItemIDList.size() << " items deleted" \
+        " from the plugin.\n";
 
-    /*
     if (!zaurus.RequiresFullSync()) {
-    // Compare the todo item lists for conflicts and resolve the conflicts.
-    ResolveDelModConflicts(zDelCalItemIDList, zModCalItemList,
-                   zNewCalItemList, dDelCalItemIDList,
-                   dModCalItemList, dNewCalItemList);
-
-    ResolveModModConflicts(zModCalItemList, dModCalItemList,
-                   zNewCalItemList, dNewCalItemList,
-                   confWinner);
-    }
-    */
+        std::cout << "Note: Zaurus does NOT require Full Sync.\n";
+        stats.StartPhase("conflict_resolution");
+        retval = DropIdenticalMods(zModItemList, dModItemList);
+        std::cout << "Dropped " << retval << " identical modifications.\n";
+
+        // Compare the item lists for conflicts and resolve the conflicts.
+        ResolveDelModConflicts(zDelItemIDList, zModItemList,
+            zNewItemList, dDelItemIDList,
+            dModItemList, dNewItemList);
+        std::cout << "Compared DelMod Conflicts and resolved them.\n";
 
-    // I then want to do what I just did above but for the opposite
-    // component. Once I do that the deletion conflicts should all be handled.
+        ResolveModModConflicts(zModItemList, dModItemList,
+            zNewItemList, dNewItemList,
+            settings.GetConflictWinner());
+        std::cout << "Compared ModMod Conflicts and resolved them.\n";
 
-    if (!zaurus.RequiresFullSync()) {
-    std::cout << "zync: In Normal Sync mode.\n";
-    // Perform the Desktop side of the synchronization.
-    std::cout << "Plugin About to Del Items.\n";
-    pPlugin->DelCalendarItems(zDelCalItemIDList);
-    std::cout << "Plugin Deleted Items.\n";
-    std::cout << "Plugin About to Mod Items.\n";
-    pPlugin->ModCalendarItems(zModCalItemList);
-    std::cout << "Plugin Modified Items.\n";
-    std::cout << "Plugin About to Add Items.\n";
-    pPlugin->AddCalendarItems(zNewCalItemList);
-    std::cout << "Plugin Added Todo Items.\n";
-
-    // Perform the Zaurus side of the synchronization.
-    std::cout << "zync: Zaurus about to delete items.\n";
-    zaurus.DelCalendarItems(dDelCalItemIDList);
-    std::cout << "zync: Zaurus deleted items.\n";
-    std::cout << "zync: Zaurus about to mod items.\n";
-    zaurus.ModCalendarItems(dModCalItemList);
-    std::cout << "zync: Zaurus modified items.\n";
-    std::cout << "zync: Zaurus about to Add items.\n";
-    mapIdList = zaurus.AddCalendarItems(dNewCalItemList);
-    std::cout << "zync: Zaurus added items.\n";
-
-    std::cout << "zync: About to map IDs.\n";
-    // Map the proper IDs.
-    pPlugin->MapItemIDs(mapIdList);
-    std::cout << "zync: Plugin mapped IDs.\n";
+        retval = CollapseDuplicates(zNewItemList, dNewItemList, mapIdList);
+        std::cout << "Collapsed " << retval << " duplicate items.\n";
+
+        // Perform the Desktop side of the synchronization.
+        // Changes applied to the plugin during an interrupted sync are not
+        // applied again.
+        stats.StartPhase("plugin_writes");
+        DropAppliedIDs(journal, zDelItemIDList);
+        DropAppliedItems(journal, zModItemList);
+        DropAppliedItems(journal, zNewItemList);
+        FillItemIDs(idMap, zModItemList);
+
+        std::cout << "Plugin About to Del Items.\n";
+        plugin.DelItems(zDelItemIDList);
+        RecordAppliedIDs(journal, zDelItemIDList);
+        RemoveIDMappings(idMap, zDelItemIDList);
+        std::cout << "Plugin Deleted Items.\n";
+        std::cout << "Plugin About to Mod Items.\n";
+        plugin.ModItems(zModItemList);
+        RecordAppliedItems(journal, zModItemList);
+        std::cout << "Plugin Modified Items.\n";
+        std::cout << "Plugin About to Add Items.\n";
+        plugin.AddItems(zNewItemList);
+        RecordAppliedItems(journal, zNewItemList);
+        std::cout << "Plugin Added Items.\n";
+
+        // Perform the Zaurus side of the synchronization.
+        stats.StartPhase("device_writes");
+        zaurus.DelItems(dDelItemIDList);
+        RemoveIDMappings(idMap, dDelItemIDList);
+        window.Forget(dDelItemIDList);
+        std::cout << "Zaurus deleted Del Items.\n";
+        zaurus.ModItems(dModItemList);
+        RecordSpans(window, dModItemList);
+        std::cout << "Zaurus modified Mod Items.\n";
+        zaurus.AddItems(dNewItemList, addedIdList);
+        RecordSpans(window, addedIdList);
+        SpliceItems(mapIdList, addedIdList);
+        std::cout << "Zaurus added Add Items.\n";
+
+        // Map the proper IDs.
+        stats.StartPhase("plugin_writes");
+        plugin.MapItemIDs(mapIdList);
+        RecordIDMappings(idMap, mapIdList);
+        std::cout << "Mapped item IDs.\n";
     } else {
-    std::cout << "zync: In Full Sync Mode.\n";
-    std::cout << "Attempting to add items to the plugin.\n";
-    pPlugin->AddCalendarItems(zNewCalItemList);
-    std::cout << "Added the items to the plugin.\n";
-
-    std::cout << "Attempting to add items to the Zaurus.\n";
-    mapIdList = zaurus.AddCalendarItems(dNewCalItemList);
-    std::cout << "Added the items to the Zaurus.\n";
-
-    std::cout << "Attempting to Map Item IDs.\n";
-    pPlugin->MapItemIDs(mapIdList);
-    std::cout << "Mapped item IDs.\n";
+        std::cout << "Note: Zaurus DOES require Full Sync.\n";
+        stats.StartPhase("conflict_resolution");
+        retval = ReconcileWithMirror(zaurus, mirror, dNewItemList,
+                                     dHeldItemList, heldHashes);
+        if (retval > 0) {
+            std::cout << "Found " << retval << " items already on the" \
+                " Zaurus.\n";
+        }
+
+        // The events on the Zaurus whose spans are known to lie outside the
+        // window are not fetched at all. The items the plugin already has
+        // are fetched regardless, so that they can be compared.
+        if (window.IsEnabled() && (zaurus.GetNewSyncIDs(zSyncIDList) == 0)) {
+            window.RetainOnly(std::set<unsigned long int>(
+                zSyncIDList.begin(), zSyncIDList.end()));
+            window.GetOutsideSyncIDs(skippedSyncIDs);
+            for (heldIter = heldHashes.begin(); heldIter != heldHashes.end();
+                 ++heldIter)
+                skippedSyncIDs.erase(heldIter->first);
+            zaurus.SetSkippedSyncIDs(skippedSyncIDs);
+            std::cout << "Skipping " << skippedSyncIDs.size() << " Zaurus" \
+                " items outside the sync window.\n";
+        }
+
+        // The new desktop items left are indexed, so that the Zaurus items
+        // which duplicate them are collapsed as they are streamed.
+        DuplicateIndexType<typename ItemT::List> dupIndex(dNewItemList);
+
+        // The Zaurus items are fetched and written to the plugin at the
+        // same time, so the two are timed together.
+        stats.StartPhase("stream");
+        std::cout << "Attempting to stream items to the plugin.\n";
+        retval = StreamItemsToPlugin<Traits>(zaurus, plugin, journal,
+                                             dupIndex, mapIdList, window,
+                                             heldHashes,
+                                             zHeldItemList);
+        dupIndex.EraseTaken();
+        if (retval < 0) {
+            std::cout << "Failed to stream items to the plugin.\n";
+        } else {
+            std::cout << "Streamed " << retval << " items to the plugin.\n";
+        }
+        std::cout << "Collapsed " << mapIdList.size() << " duplicate" \
+            " items.\n";
+
+        // The items both sides already had are only written to the side
+        // which was not changed since the last sync, anything else is a
+        // conflict.
+        stats.StartPhase("conflict_resolution");
+        CompareHeldItems(heldHashes, zHeldItemList, dHeldItemList,
+                         zModItemList, dModItemList);
+        std::cout << "Found " << zModItemList.size() << " items modified" \
+            " on the Zaurus and " << dModItemList.size() << " items" \
+            " modified on the plugin since the last sync.\n";
+
+        retval = DropIdenticalMods(zModItemList, dModItemList);
+        std::cout << "Dropped " << retval << " identical modifications.\n";
+
+        ResolveModModConflicts(zModItemList, dModItemList,
+            zNewItemList, dNewItemList,
+            settings.GetConflictWinner());
+        std::cout << "Compared ModMod Conflicts and resolved them.\n";
+
+        stats.StartPhase("plugin_writes");
+        DropAppliedItems(journal, zModItemList);
+        DropAppliedItems(journal, zNewItemList);
+        FillItemIDs(idMap, zModItemList);
+
+        std::cout << "Plugin About to Mod Items.\n";
+        plugin.ModItems(zModItemList);
+        RecordAppliedItems(journal, zModItemList);
+        std::cout << "Plugin Modified Items.\n";
+        std::cout << "Plugin About to Add Items.\n";
+        plugin.AddItems(zNewItemList);
+        RecordAppliedItems(journal, zNewItemList);
+        std::cout << "Plugin Added Items.\n";
+
+        stats.StartPhase("device_writes");
+        std::cout << "Attempting to modify items on the Zaurus.\n";
+        zaurus.ModItems(dModItemList);
+        RecordSpans(window, dModItemList);
+        std::cout << "Modified the items on the Zaurus.\n";
+
+        std::cout << "Attempting to add items to the Zaurus.\n";
+        zaurus.AddItems(dNewItemList, addedIdList);
+        RecordSpans(window, addedIdList);
+        SpliceItems(mapIdList, addedIdList);
+        std::cout << "Added the items to the Zaurus.\n";
+
+        stats.StartPhase("plugin_writes");
+        std::cout << "Attempting to Map Item IDs.\n";
+        plugin.MapItemIDs(mapIdList);
+        RecordIDMappings(idMap, mapIdList);
+        std::cout << "Mapped item IDs.\n";
     }
 
-    std::cout << "zync: About to Terminate Sync.\n";
+    stats.StartPhase("finish");
     zaurus.TerminateSync();
-    std::cout << "zync: Terminated Sync.\n";
+    std::cout << "Terminated the Synchronization with the Zaurus.\n";
+
+    stats.StartPhase("state_save");
+
+    // The plugin items now hold what the next sync should be compared to, so
+    // I take a new snapshot of them.
+    if (useSnapshot) {
+        retval = plugin.GetAllItems(allItemList);
+        if (retval == 0) {
+            FillItemIDs(idMap, allItemList);
+            snapshot.Take(allItemList);
+            retval = snapshot.Save(snapshotPath, deviceKey);
+        } else {
+            // A snapshot missing items would have them show up as new next
+            // time, so the old one is left as it is.
+            retval = -1;
+        }
+        if (retval != 0) {
+            std::cout << "Warning: Failed to save the item snapshot (";
+            std::cout << retval << ").\n";
+        } else {
+            std::cout << "Saved a snapshot of " << snapshot.GetCount() \
+                << " items.\n";
+        }
+    }
+
+    if (window.IsEnabled() && !spansPath.empty()) {
+        retval = window.Save(spansPath, deviceKey);
+        if (retval != 0) {
+            std::cout << "Warning: Failed to save the event spans (";
+            std::cout << retval << ").\n";
+        }
+    }
+
+    // The sync completed, so there is nothing left to resume.
+    zaurus.SetJournal(NULL);
+    journal.Finish();
+    zaurus.SetMirror(NULL);
+    mirror.Close();
+    IDMapType::SetShared(NULL);
+    idMap.Close();
 
     /////////////////////////////////////////////////////////////////////////
     // The code below needs to stay to handle destruction of the plugin and
     // closing of the shared object that is the plugin.
     /////////////////////////////////////////////////////////////////////////
 
-    std::cout << "zync: About to clean up plugin.\n";
+    stats.StartPhase("cleanup");
     retval = pPlugin->CleanUp();
     if (retval != 0) {
-    std::cout << "ERROR: Failed to Clean up Plugin (" << retval;
-    std::cout << ")." << std::endl;
-    pDestroyFunc(pPlugin);
-    dlclose(libHandle);
-    return 9;
+        std::cout << "ERROR: Failed to Clean up " << Traits::GetName() \
+            << " Plugin (" << retval << ")." << std::endl;
+        return EndSyncStats(stats, settings, 9);
     }
-    std::cout << "zync: Cleaned up the plugin.\n";
+    std::cout << "Performed the Plugin Clean Up.\n";
 
-    std::cout << "zync: About to destroy plugin instance.\n";
     // Destroy the plugin object and close the plugin.
-    pDestroyFunc(pPlugin);
-    std::cout << "zync: Destroyed the plugin instance.\n";
-    std::cout << "zync: About to close share object.\n";
-    dlclose(libHandle);
-    std::cout << "zync: Closed the shared object.\n";
-    
-    std::cout << "zync: FINISHED SYNC PROCESS.\n";
+    plugin.Unload();
 
-    return 0;
+    std::cout << "Closed the plugin.\n";
+    std::cout << "Exiting the PerformSync() function.\n";
+
+    return EndSyncStats(stats, settings, 0);
 }